@@ -44,7 +44,7 @@ function(add_tng_io_library NAME)
         list(APPEND _sources ${TNG_ROOT_SOURCE_DIR}/src/lib/tng_io_fortran.c)
     endif()
 
-    set(_options OBJECT OWN_ZLIB)
+    set(_options OBJECT OWN_ZLIB OPENMP MPI)
     cmake_parse_arguments(ARG "${_options}" "" "" ${ARGN})
 
     set(_build_target ${NAME})
@@ -97,6 +97,33 @@ function(add_tng_io_library NAME)
         target_link_libraries(${NAME} ${_link_type} ZLIB::ZLIB)
     endif()
 
+    if (ARG_OPENMP)
+        find_package(OpenMP)
+        if (TARGET OpenMP::OpenMP_C)
+            if (ARG_OBJECT)
+                # Object libraries cannot link to imported targets in all
+                # supported CMake versions, so only the flags are added here.
+                separate_arguments(_openmp_c_flags UNIX_COMMAND "${OpenMP_C_FLAGS}")
+                target_compile_options(${_build_target} PRIVATE ${_openmp_c_flags})
+            endif()
+            target_link_libraries(${NAME} ${_link_type} OpenMP::OpenMP_C)
+        else()
+            message(WARNING "OpenMP was requested, but no OpenMP support for C was found.")
+        endif()
+    endif()
+
+    if (ARG_MPI)
+        find_package(MPI)
+        if (MPI_C_FOUND)
+            target_compile_definitions(${NAME} INTERFACE TNG_HAVE_MPI)
+            set_property(SOURCE ${TNG_ROOT_SOURCE_DIR}/src/lib/tng_io.c
+                         APPEND PROPERTY COMPILE_DEFINITIONS TNG_HAVE_MPI)
+            target_include_directories(${_build_target} PRIVATE ${MPI_C_INCLUDE_DIRS} ${MPI_C_INCLUDE_PATH})
+            target_include_directories(${NAME} INTERFACE ${MPI_C_INCLUDE_DIRS} ${MPI_C_INCLUDE_PATH})
+            target_link_libraries(${NAME} ${_link_type} ${MPI_C_LIBRARIES})
+        endif()
+    endif()
+
     if (TNG_HAVE_INTTYPES_H)
         target_compile_definitions(${NAME} INTERFACE USE_STD_INTTYPES_H)
         set_property(SOURCE ${TNG_ROOT_SOURCE_DIR}/src/lib/tng_io.c
@@ -469,6 +469,18 @@ within a frame set, e.g. when faster parallel writes or memory
 considerations are needed. In that case a separate particle mapping
 block is needed for each of the trajectory/velocities etc. blocks.
 
+BLOCK: compression algorithms block (optional)
+----------------------------------------------
+
+1.  64 bit number of values describing a TNG compression algorithm (N)
+2.  64 bit array of the algorithm used for positions (N values, -1 if
+    not determined)
+3.  64 bit array of the algorithm used for velocities (N values, -1 if
+    not determined)
+
+The block comes after the other non-trajectory blocks. Readers that do
+not recognise it skip it.
+
 Relation between trajectory blocks:
 ===================================
 
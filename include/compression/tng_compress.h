@@ -168,6 +168,57 @@ int DECLSPECDLLEXPORT tng_compress_uncompress_float(char *data,float *posvel);
 
 int DECLSPECDLLEXPORT tng_compress_uncompress_int(char *data,int *posvel, unsigned long *prec_hi, unsigned long *prec_lo);
 
+/* Scratch memory for the uncompression routines. Uncompressing needs
+   memory for the quantized values of a block, which is otherwise allocated
+   and freed for every block. Passing the same scratch memory to consecutive
+   calls lets the memory be reused. The scratch memory must not be used by
+   several threads at the same time. tng_compress_scratch_init returns NULL
+   if memory cannot be allocated. */
+struct tng_compress_scratch;
+
+struct tng_compress_scratch DECLSPECDLLEXPORT *tng_compress_scratch_init(void);
+
+void DECLSPECDLLEXPORT tng_compress_scratch_deinit(struct tng_compress_scratch *scratch);
+
+/* Uncompresses any tng compress block or keyframe container, like
+   tng_compress_uncompress, directly into posvel using the scratch memory
+   (which may be NULL). posvel must hold natoms*nframes*3 values, see
+   tng_compress_inquire. The return value is 0 if ok, and 1 if not. */
+int DECLSPECDLLEXPORT tng_compress_uncompress_scratch(char *data,double *posvel,
+						      struct tng_compress_scratch *scratch);
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_float_scratch(char *data,float *posvel,
+							    struct tng_compress_scratch *scratch);
+
+/* Combines nblocks separately compressed blocks (positions or velocities,
+   as returned by the compression routines above) into a keyframe
+   container. Block i must hold frames i*keyframe_interval up to
+   (i+1)*keyframe_interval-1 (the last block may be shorter), and nframes
+   is the total number of frames. Since every block starts with an
+   independently coded frame, a range of frames can later be decoded
+   without decoding the frames before the nearest preceding keyframe.
+   The container can be passed to all the uncompression routines.
+   The returned pointer is malloced and the number of chars is put into
+   *nitems. NULL is returned if memory cannot be allocated. */
+char DECLSPECDLLEXPORT *tng_compress_keyframes_pack(char **blocks, const int *block_lengths,
+						    const int nblocks, const int nframes,
+						    const int keyframe_interval,
+						    int *nitems);
+
+/* Uncompresses only the frames first_frame to first_frame+nframes-1 of a
+   tng compress block or keyframe container into posvel, which must hold
+   nframes frames. For keyframe containers only the blocks covering the
+   requested frames are decoded. The return value is 0 if ok, and 1 if not. */
+int DECLSPECDLLEXPORT tng_compress_uncompress_frames(char *data, const int first_frame,
+						     const int nframes, double *posvel);
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_frames_float(char *data, const int first_frame,
+							   const int nframes, float *posvel);
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_frames_int(char *data, const int first_frame,
+							 const int nframes, int *posvel,
+							 unsigned long *prec_hi, unsigned long *prec_lo);
+
 /* This converts a block of integers, as obtained from tng_compress_uncompress_int, to floating point values
    either double precision or single precision. */
 void DECLSPECDLLEXPORT tng_compress_int_to_double(int *posvel_int, const unsigned long prec_hi, const unsigned long prec_lo,
@@ -300,6 +300,12 @@
  * To compile the fortran example -DTNG_BUILD_FORTRAN=ON needs to be specified when
  * running cmake.
  *
+ * @subsection mpi_subsec MPI
+ *
+ * Frame sets can be written collectively by several MPI processes, each
+ * writing the particles it handles, using tng_frame_set_mpi_write(). To
+ * build it -DTNG_BUILD_MPI=ON needs to be specified when running cmake.
+ *
  */
 
 #ifndef TNG_IO_H
@@ -359,6 +365,10 @@ typedef unsigned __int64 uint64_t;
 
 #endif /* USE_STD_INTTYPES_H */
 
+#ifdef TNG_HAVE_MPI
+#include <mpi.h>
+#endif
+
 #ifndef USE_WINDOWS
 #if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
 #define USE_WINDOWS
@@ -429,6 +439,7 @@ typedef enum {TNG_NON_TRAJECTORY_BLOCK, TNG_TRAJECTORY_BLOCK} tng_block_type;
 #define TNG_MOLECULES                   0x0000000000000001LL
 #define TNG_TRAJECTORY_FRAME_SET        0x0000000000000002LL
 #define TNG_PARTICLE_MAPPING            0x0000000000000003LL
+#define TNG_COMPRESSION_ALGORITHMS      0x0000000000000004LL
 /** @} */
 
 /** @defgroup def2 Standard trajectory blocks
@@ -587,6 +598,40 @@ union data_values {
     char *c;
 };
 
+/** Statistics of the file I/O and the compression of a trajectory, see
+ *  tng_statistics_get(). Times are measured in ticks, see ticks_per_second. */
+struct tng_statistics {
+    /** The number of bytes read from the input file */
+    int64_t bytes_read;
+    /** The number of bytes written to the output file */
+    int64_t bytes_written;
+    /** The number of seeks in the input and output files */
+    int64_t n_seeks;
+    /** The number of block headers read */
+    int64_t n_block_headers_read;
+    /** The number of frame set blocks read, including the ones visited when
+     *  searching for a frame set */
+    int64_t n_frame_sets_read;
+    /** The number of searches for a frame set by number or by frame */
+    int64_t n_frame_set_searches;
+    /** The number of allocations of data arrays */
+    int64_t n_allocations;
+    /** The time spent calculating MD5 hashes */
+    int64_t md5_ticks;
+    /** The time spent in TNG and XTC compression */
+    int64_t compress_ticks;
+    /** The time spent in TNG and XTC uncompression */
+    int64_t uncompress_ticks;
+    /** The time spent in gzip compression */
+    int64_t gzip_compress_ticks;
+    /** The time spent in gzip uncompression */
+    int64_t gzip_uncompress_ticks;
+    /** The time spent swapping the byte order of data arrays */
+    int64_t byte_swap_ticks;
+    /** The number of ticks per second, or 0 if it is not known */
+    int64_t ticks_per_second;
+};
+
 
 #ifdef __cplusplus
 extern "C"
@@ -680,6 +725,15 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy
  * parallel i/o. This can be used inside pragma omp for setting up a thread
  * local copy of src. It can be freed (using tng_trajectory_destroy) at the
  * end of the parallel block.
+ * The molecules of src, with their chains, residues, atoms, bonds and the
+ * strings holding their names, are shared with dest without copying them, as
+ * described for tng_molecule_system_copy(). Neither trajectory sees changes
+ * the other makes to them. The molecule counts, the file names (including
+ * the list of files of a trajectory split into several files), the
+ * compression algorithms, the keyframe interval and whether statistics are
+ * collected are copied. Open files, frame set contents, non trajectory data
+ * blocks, the compression precision and distance unit and the collected
+ * statistics are not copied.
  * @param src the original trajectory.
  * @param dest_p a pointer to memory to initialise as a trajectory.
  * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
@@ -725,6 +779,37 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_set
                 (const tng_trajectory_t tng_data,
                  const char *file_name);
 
+/**
+ * @brief Set the input files of a trajectory split into several files, e.g.
+ * the parts of a simulation that has been restarted, to read them as one
+ * trajectory.
+ * @param tng_data the trajectory of which to set the input files.
+ * @param file_names the names of the input files, in the order of their
+ * frames.
+ * @param n_files the number of input files.
+ * @param max_open_files the maximum number of input files to keep open at
+ * the same time.
+ * @details The files must contain the same molecular system, which is read
+ * from the first file, and the frame numbers must continue from one file to
+ * the next. Only the general info block and the first and last frame sets
+ * of each file are read here. When reading frame sets the file containing
+ * them is opened when it is first needed, closing the least recently used
+ * file if max_open_files files are already open.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code file_names != 0 \endcode The pointer to the file names must
+ * not be a NULL pointer.
+ * @pre \code n_files > 0 \endcode There must be at least one file.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a file
+ * contains no frame sets or if the frames of the files do not follow each
+ * other or TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_input_file_segments_set
+                (const tng_trajectory_t tng_data,
+                 const char **file_names,
+                 const int64_t n_files,
+                 const int64_t max_open_files);
+
 /**
  * @brief Get the name of the output file.
  * @param tng_data the trajectory of which to get the input file name.
@@ -1240,6 +1325,217 @@ tng_function_status DECLSPECDLLEXPORT tng_compression_precision_set
                 (const tng_trajectory_t tng_data,
                  const double precision);
 
+/**
+ * @brief Get the number of frames between keyframes in TNG compressed data
+ * blocks.
+ * @param tng_data is the trajectory of which to get the keyframe interval.
+ * @param interval will be pointing to the retrieved keyframe interval.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code interval != 0 \endcode The pointer to interval must not be a
+ * NULL pointer.
+ * @details See tng_compression_keyframe_interval_set().
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_keyframe_interval_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *interval);
+
+/**
+ * @brief Set the number of frames between keyframes in TNG compressed data
+ * blocks.
+ * @param tng_data is the trajectory of which to set the keyframe interval.
+ * @param interval is the new keyframe interval. 0 (the default) disables
+ * keyframes.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code interval >= 0 \endcode The keyframe interval must be >= 0.
+ * @details When writing TNG compressed position and velocity blocks with more
+ * frames than the keyframe interval, every interval frames are compressed
+ * as an independent block, preceded by a table of block offsets. A single
+ * frame can then be uncompressed (see tng_compress_uncompress_frames())
+ * by decoding only the block it belongs to instead of all frames of the
+ * frame set, at the cost of slightly worse compression. This is done when
+ * reading frames of a frame set that has not been read, e.g. using
+ * tng_util_pos_read_range() or tng_util_vel_read_range(). Files written with
+ * keyframes cannot be read by TNG library versions without keyframe
+ * support.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_keyframe_interval_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t interval);
+
+/**
+ * @brief Get the number of particles used when determining the TNG
+ * compression algorithm.
+ * @param tng_data is the trajectory of which to get the sample size.
+ * @param n_particles will be pointing to the retrieved number of particles.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code n_particles != 0 \endcode The pointer to n_particles must not
+ * be a NULL pointer.
+ * @details See tng_compression_algo_sample_set().
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_algo_sample_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *n_particles);
+
+/**
+ * @brief Set the number of particles used when determining the TNG
+ * compression algorithm.
+ * @param tng_data is the trajectory of which to set the sample size.
+ * @param n_particles is the number of particles to use. 0 (the default)
+ * means that all particles are used.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code n_particles >= 0 \endcode The number of particles must be >= 0.
+ * @details The first time positions or velocities are TNG compressed all
+ * available algorithms are tried to find the one giving the best compression.
+ * For large systems this is slow. If n_particles is set, only the first
+ * n_particles particles are used for finding the algorithm, which is then
+ * used for compressing all particles. This can give a slightly worse
+ * compression ratio, but the compressed data is always valid.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_algo_sample_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t n_particles);
+
+/**
+ * @brief Get the TNG compression algorithm used for positions or velocities.
+ * @param tng_data is the trajectory of which to get the algorithm.
+ * @param block_id is the ID of the data block, TNG_TRAJ_POSITIONS or
+ * TNG_TRAJ_VELOCITIES.
+ * @param algo is an array of four ints (initial coding, initial coding
+ * parameter, coding and coding parameter), which will be filled with the
+ * algorithm. Parameters that have not been determined yet are -1.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code algo != 0 \endcode The pointer to algo must not be a
+ * NULL pointer.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the block ID
+ * is not supported or if no algorithm has been determined.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 int *algo);
+
+/**
+ * @brief Set the TNG compression algorithm used for positions or velocities.
+ * @param tng_data is the trajectory of which to set the algorithm.
+ * @param block_id is the ID of the data block, TNG_TRAJ_POSITIONS or
+ * TNG_TRAJ_VELOCITIES.
+ * @param algo is an array of four ints, as retrieved by
+ * tng_compression_algorithm_get(). Parameters set to -1 are determined when
+ * compressing. If algo is a NULL pointer the algorithm is reset and will be
+ * determined again.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @details Setting an algorithm determined earlier, e.g. when writing a
+ * previous part of the simulation, avoids the slow search for the best
+ * algorithm when compressing the first frame set.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the block ID
+ * is not supported or TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const int *algo);
+
+/**
+ * @brief Get whether the TNG compression algorithms are stored in the
+ * file header.
+ * @param tng_data is the trajectory of which to get the setting.
+ * @param store will be pointing to TNG_TRUE if the algorithms are stored,
+ * otherwise TNG_FALSE.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code store != 0 \endcode The pointer to store must not be a
+ * NULL pointer.
+ * @details See tng_compression_algorithm_store_set().
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_store_get
+                (const tng_trajectory_t tng_data,
+                 char *store);
+
+/**
+ * @brief Set whether the TNG compression algorithms are stored in the
+ * file header.
+ * @param tng_data is the trajectory of which to set the setting.
+ * @param store is TNG_TRUE to store the algorithms, TNG_FALSE (the default)
+ * not to store them.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @details If set, the position and velocity compression algorithms are
+ * stored in a separate block (TNG_COMPRESSION_ALGORITHMS) after the other
+ * non-trajectory blocks and updated when frame sets are written. When reading the file headers, stored algorithms are
+ * loaded, so that a trajectory appended to (or a copy made with
+ * tng_trajectory_init_from_src()) can compress without searching for the
+ * algorithm again. The setting is enabled automatically when reading a file
+ * with stored algorithms. It must be set before the file headers are
+ * written.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_store_set
+                (const tng_trajectory_t tng_data,
+                 const char store);
+
+/**
+ * @brief Enable or disable collecting statistics of the file I/O and the
+ * compression of a trajectory.
+ * @param tng_data is the trajectory of which to collect statistics.
+ * @param enabled is TNG_TRUE to collect statistics, TNG_FALSE (the default)
+ * not to collect them.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @details Enabling the statistics resets them. The statistics are counted
+ * in the trajectory container, without locking, so trajectories used in
+ * different threads (e.g. created by tng_trajectory_init_from_src()) have
+ * separate statistics, which can be added up when needed. The threads that
+ * encode or decode blocks of one trajectory in parallel count in their own
+ * copies of the statistics, which are added up by tng_statistics_get().
+ * Times are measured using the time stamp counter of x86 processors, or
+ * using clock() on other processors, so that the statistics can be left
+ * enabled without slowing down reading or writing noticeably.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_statistics_enabled_set
+                (const tng_trajectory_t tng_data,
+                 const tng_bool enabled);
+
+/**
+ * @brief Get the statistics of the file I/O and the compression of a
+ * trajectory.
+ * @param tng_data is the trajectory of which to get the statistics.
+ * @param statistics will be filled with the statistics collected since they
+ * were enabled or last reset.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code statistics != 0 \endcode The pointer to statistics must not be
+ * a NULL pointer.
+ * @details The number of ticks per second is estimated from the time passed
+ * since the statistics were enabled or reset.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_statistics_get
+                (const tng_trajectory_t tng_data,
+                 struct tng_statistics *statistics);
+
+/**
+ * @brief Reset the statistics of the file I/O and the compression of a
+ * trajectory to zero.
+ * @param tng_data is the trajectory of which to reset the statistics.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_statistics_reset
+                (const tng_trajectory_t tng_data);
+
 /**
  * @brief Set the number of particles, in the case no molecular system is used.
  * @param tng_data is the trajectory of which to get the number of particles.
@@ -1714,6 +2010,12 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_of_index_get
  * @pre \code tng_data_dest != 0 \endcode The trajectory container (tng_data_dest)
  * must be initialised before using it.
  * @details The molecular system in tng_data_dest will be overwritten.
+ * The molecules are not copied until one of the trajectories modifies them,
+ * until then both trajectories use the same molecules. A trajectory that
+ * modifies the molecules gets its own copy of them first, so molecules,
+ * chains, residues and atoms retrieved from it before the modification do not
+ * show the change. They can still be passed to functions modifying the same
+ * trajectory, but should be retrieved again before reading from them.
  * @return TNG_SUCCESS(0) if the copying is successful, TNG_FAILURE if a minor
  * error has occured or TNG_CRITICAL(2) if a major error has occured.
  */
@@ -2323,6 +2625,74 @@ tng_function_status DECLSPECDLLEXPORT tng_molsystem_bonds_get
                  int64_t **from_atoms,
                  int64_t **to_atoms);
 
+/**
+ * @brief Get the bonded neighbours of all particles of the current molecular
+ * system in compressed sparse row format.
+ * @param tng_data is the trajectory data container containing the molecular
+ * system.
+ * @param n_particles is set to the number of particles in the molecular
+ * system.
+ * @param offsets is set to point at a list of n_particles + 1 positions in
+ * neighbors. The neighbours of particle i are neighbors[offsets[i]] to
+ * neighbors[offsets[i + 1] - 1] and offsets[n_particles] is the total
+ * number of neighbours.
+ * @param neighbors is set to point at the list of the neighbours (number of
+ * atom in mol system) of all particles, sorted for each particle. Each bond
+ * is listed for both of its atoms.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code n_particles != 0 \endcode The pointer to n_particles must not
+ * be a NULL pointer.
+ * @pre \code offsets != 0 \endcode The pointer to offsets must not be a NULL
+ * pointer.
+ * @pre \code neighbors != 0 \endcode The pointer to neighbors must not be a
+ * NULL pointer.
+ * @details The lists are built from the bonds of each molecule type the
+ * first time this function is called and are kept by the trajectory, so
+ * they must not be freed or modified. They remain valid until the molecules,
+ * their bonds or the molecule counts are changed (including reading a frame
+ * set with a different number of molecules), or the trajectory is destroyed.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred (e.g. if there are no molecule counts or a bond refers to an
+ * atom outside its molecule) or TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_molsystem_connectivity_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *n_particles,
+                 const int64_t **offsets,
+                 const int64_t **neighbors);
+
+/**
+ * @brief Get the bonded neighbours of all particles of the current molecular
+ * system in compressed sparse row format, using 32 bit integers.
+ * @param tng_data is the trajectory data container containing the molecular
+ * system.
+ * @param n_particles is set to the number of particles in the molecular
+ * system.
+ * @param offsets is set to point at a list of n_particles + 1 positions in
+ * neighbors.
+ * @param neighbors is set to point at the list of the neighbours of all
+ * particles.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code n_particles != 0 \endcode The pointer to n_particles must not
+ * be a NULL pointer.
+ * @pre \code offsets != 0 \endcode The pointer to offsets must not be a NULL
+ * pointer.
+ * @pre \code neighbors != 0 \endcode The pointer to neighbors must not be a
+ * NULL pointer.
+ * @details See tng_molsystem_connectivity_get(). The lists are kept by the
+ * trajectory in the same way.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred (including if the numbers do not fit in 32 bit integers) or
+ * TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_molsystem_connectivity_int32_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *n_particles,
+                 const int32_t **offsets,
+                 const int32_t **neighbors);
+
 /**
  * @brief Get the chain name of real particle number (number in mol system).
  * @param tng_data is the trajectory data container containing the atom.
@@ -2437,6 +2807,175 @@ tng_function_status DECLSPECDLLEXPORT tng_atom_type_of_particle_nr_get
                  char *type,
                  const int max_len);
 
+/**
+ * @brief Get the molecule ids of a range of real particle numbers (numbers
+ * in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param ids is an array of n_particles elements, which will be set to the
+ * IDs. Memory must be reserved beforehand.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code ids != 0 \endcode The pointer to ids must not be a NULL pointer.
+ * @details The molecule of each particle is found from an index of the
+ * molecular system, which is built the first time it is needed. This is much
+ * faster than calling tng_molecule_id_of_particle_nr_get() for each particle.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_molecule_ids_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 int64_t *ids);
+
+/**
+ * @brief Get the residue ids (based on other molecules and molecule counts)
+ * of a range of real particle numbers (numbers in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param ids is an array of n_particles elements, which will be set to the
+ * IDs. Memory must be reserved beforehand. Particles that are not part of a
+ * residue get the ID -1.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code ids != 0 \endcode The pointer to ids must not be a NULL pointer.
+ * @details See tng_molecule_ids_of_particles_get().
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_global_residue_ids_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 int64_t *ids);
+
+/**
+ * @brief Get the molecule names of a range of real particle numbers (numbers
+ * in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param names is an array of n_particles elements, which will be set to
+ * point to the names. The names are owned by the
+ * molecular system and must not be freed or modified.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code names != 0 \endcode The pointer to names must not be a NULL
+ * pointer.
+ * @details See tng_molecule_ids_of_particles_get().
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_molecule_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names);
+
+/**
+ * @brief Get the chain names of a range of real particle numbers (numbers
+ * in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param names is an array of n_particles elements, which will be set to
+ * point to the names. Particles that are not
+ * part of a chain get a NULL pointer. The names are owned by the
+ * molecular system and must not be freed or modified.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code names != 0 \endcode The pointer to names must not be a NULL
+ * pointer.
+ * @details See tng_molecule_ids_of_particles_get().
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_chain_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names);
+
+/**
+ * @brief Get the residue names of a range of real particle numbers (numbers
+ * in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param names is an array of n_particles elements, which will be set to
+ * point to the names. Particles that are not
+ * part of a residue get a NULL pointer. The names are owned by the
+ * molecular system and must not be freed or modified.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code names != 0 \endcode The pointer to names must not be a NULL
+ * pointer.
+ * @details See tng_molecule_ids_of_particles_get().
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_residue_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names);
+
+/**
+ * @brief Get the atom names of a range of real particle numbers (numbers
+ * in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param names is an array of n_particles elements, which will be set to
+ * point to the names. The names are owned by the
+ * molecular system and must not be freed or modified.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code names != 0 \endcode The pointer to names must not be a NULL
+ * pointer.
+ * @details See tng_molecule_ids_of_particles_get().
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_atom_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names);
+
+/**
+ * @brief Get the atom types of a range of real particle numbers (numbers
+ * in mol system).
+ * @param tng_data is the trajectory data container containing the atoms.
+ * @param first_nr is the real number of the first particle in the molecular
+ * system.
+ * @param n_particles is the number of particles.
+ * @param types is an array of n_particles elements, which will be set to
+ * point to the atom types. The types are owned by the molecular system and
+ * must not be freed or modified.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code types != 0 \endcode The pointer to types must not be a NULL
+ * pointer.
+ * @details See tng_molecule_ids_of_particles_get().
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particles
+ * are not in the molecular system.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_atom_types_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **types);
+
 /**
  * @brief Add a particle mapping table.
  * @details Each particle mapping table will be written as a separate block,
@@ -2657,6 +3196,76 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_premature_write
                 (const tng_trajectory_t tng_data,
                  const char hash_mode);
 
+#ifdef TNG_HAVE_MPI
+/**
+ * @brief Write the current frame set collectively from several processes,
+ * each writing the particles it handles, using MPI-IO.
+ * @param tng_data is a trajectory data container. Each process has its own.
+ * @param comm is the MPI communicator of the processes. This function must
+ * be called by all of them.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash for each block will be generated.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @details The trajectory of the process with rank 0 in comm must have an
+ * output file, to which the frame set is appended, and it writes the frame
+ * set block itself as well as its non-particle data blocks. The trajectories
+ * of the other processes have the same molecular system and frame sets, but
+ * no output file, and no non-particle data. Each process adds one particle
+ * mapping (see tng_particle_mapping_add()) of the particles it handles, and
+ * stores the values of those particles only, e.g. using
+ * tng_util_generic_frame_acquire(). The processes encode their particle
+ * mapping and data blocks concurrently and write them after each other,
+ * in the order of their ranks.
+ * Call this function when the frame set is finished, before storing frames
+ * of the next frame set. If it is not finished, e.g. at the end of the
+ * trajectory, only the frames stored so far are written.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured. The same
+ * status is returned by all processes.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_mpi_write
+                (const tng_trajectory_t tng_data,
+                 const MPI_Comm comm,
+                 const char hash_mode);
+#endif
+
+/**
+ * @brief Copy the current frame set of one trajectory, with its particle
+ * mapping and data blocks, to the end of the output file of another
+ * trajectory, without decompressing and compressing the data.
+ * @param tng_data_in is the trajectory data container to copy from. Its
+ * current frame set must have been read from its input file, e.g. by
+ * tng_frame_set_of_frame_find() or tng_frame_set_nr_find().
+ * @param tng_data_out is the trajectory data container to copy to. It must
+ * have the same molecular system as tng_data_in and an output file of the
+ * same byte order as the input file of tng_data_in.
+ * @param first_frame is the frame number of the first frame of the frame set
+ * in tng_data_out. The frame numbers of the data blocks are changed
+ * accordingly.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the md5 hashes of the blocks are kept or
+ * generated, otherwise they are left empty.
+ * @details The blocks are copied as they are stored in the file. Only the
+ * frame numbers, the pointers to other frame sets and the md5 hashes are
+ * changed. This makes trimming, subsampling and concatenating trajectories
+ * about as fast as reading and writing the files.
+ * The file headers are written to the output file first if it is empty.
+ * @pre \code tng_data_in != 0 \endcode The trajectory container (tng_data_in)
+ * must be initialised before using it.
+ * @pre \code tng_data_out != 0 \endcode The trajectory container (tng_data_out)
+ * must be initialised before using it.
+ * @pre \code first_frame >= 0 \endcode The first frame must not be negative.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred (such as no frame set having been read or the files having
+ * different byte order) or TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_raw_copy
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 const int64_t first_frame,
+                 const char hash_mode);
+
 /**
  * @brief Create and initialise a frame set.
  * @details Particle mappings are retained from previous frame set (if any).
@@ -3144,6 +3753,63 @@ tng_function_status DECLSPECDLLEXPORT tng_data_vector_interval_get
                  int64_t *n_values_per_frame,
                  char *type);
 
+/**
+ * @brief Read a time series of non-particle data, such as energies or the
+ * box shape, in a specific interval.
+ * @details Only the requested data block of each frame set is read. All
+ * other blocks, e.g. coordinates, are skipped using their block headers.
+ * Blocks are uncompressed concurrently if the library is built with OpenMP.
+ * Frame sets that do not contain the data block are skipped, so the
+ * returned frames are not necessarily evenly spaced.
+ * @param tng_data is a trajectory data container. tng_data->input_file_path specifies
+ * which file to read from. If the file (input_file) is not open it will be
+ * opened.
+ * @param block_id is the id number of the data block to read.
+ * @param start_frame_nr is the index number of the first frame to read.
+ * @param end_frame_nr is the index number of the last frame to read.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @param values is a pointer to a 1-dimensional array, which will be
+ * (re)allocated and filled with the values of all frames with data, i.e.
+ * the length of the array will be n_frames * n_values_per_frame. It is the
+ * callers responsibility to free the memory.
+ * @param frame_nrs is a pointer to a 1-dimensional array, which will be
+ * (re)allocated and filled with the frame number of each frame with data.
+ * It is the callers responsibility to free the memory. If frame_nrs is NULL
+ * the frame numbers are not returned.
+ * @param n_frames is set to the number of frames with data.
+ * @param n_values_per_frame is set to the number of values per frame in the data.
+ * @param type is set to the data type of the data in the array.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+ * the last frame.
+ * @pre \code values != 0 \endcode The pointer to the values array must not
+ * be a NULL pointer.
+ * @pre \code n_frames != 0 \endcode The pointer to the number of frames
+ * must not be a NULL pointer.
+ * @pre \code n_values_per_frame != 0 \endcode The pointer to the number of
+ * values per frame must not be a NULL pointer.
+ * @pre \code type != 0 \endcode The pointer to the data type must not
+ * be a NULL pointer.
+ * @details This does only work for numerical (int, float, double) data.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred, e.g. if there is no data in the interval, or TNG_CRITICAL (2)
+ * if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_data_series_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 void **values,
+                 int64_t **frame_nrs,
+                 int64_t *n_frames,
+                 int64_t *n_values_per_frame,
+                 char *type);
+
 /**
  * @brief Retrieve particle data, from the last read frame set. Obsolete!
  * @details The particle dimension of the returned values array is translated
@@ -3342,6 +4008,99 @@ tng_function_status DECLSPECDLLEXPORT tng_particle_data_vector_interval_get
                  int64_t *n_values_per_frame,
                  char *type);
 
+/**
+ * @brief Set up an iterator over the frames with data of a data block, in a
+ * specific interval.
+ * @details Unlike tng_data_vector_interval_get() and
+ * tng_particle_data_vector_interval_get() the data of the whole interval is
+ * never stored in one array. Instead tng_data_iterator_next() returns the
+ * frames one at a time, reading only the requested data block (and the
+ * particle mapping blocks) of one frame set at a time. This makes reading
+ * sparse data (with a long stride length) over long intervals cheap.
+ * @param tng_data is a trajectory data container. tng_data->input_file_path specifies
+ * which file to read from. If the file (input_file) is not open it will be
+ * opened.
+ * @param block_id is the id number of the data block to read. It can be
+ * either a particle data block or a non-particle data block.
+ * @param start_frame_nr is the index number of the first frame to read.
+ * @param end_frame_nr is the index number of the last frame to read.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @param iterator_p is a pointer to the iterator, which is allocated by
+ * this function. It must be freed using tng_data_iterator_destroy().
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+ * the last frame.
+ * @pre \code iterator_p != 0 \endcode The pointer to the iterator must
+ * not be a NULL pointer.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_data_iterator_init
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 tng_data_iterator_t *iterator_p);
+
+/**
+ * @brief Get the next frame with data from a data block iterator.
+ * @param tng_data is the trajectory data container the iterator was set up
+ * with.
+ * @param iterator is the iterator.
+ * @param frame_nr is set to the frame number of the returned data.
+ * @param values is set to point to the data of the frame. For particle data
+ * the particles are in real particle numbering, i.e. the numbering of the
+ * actual molecular system. The data is owned by the library and is only
+ * valid until the next call to this function or until another frame set is
+ * read.
+ * @param n_particles is set to the number of particles in the returned data,
+ * or 0 if it is not particle data.
+ * @param n_values_per_frame is set to the number of values per frame (and
+ * particle) in the data.
+ * @param type is set to the data type of the data.
+ * @details Frame sets that do not contain the data block are skipped.
+ * This does only work for numerical (int, float, double) data.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code iterator != 0 \endcode The iterator must be set up before
+ * using it.
+ * @pre \code frame_nr != 0 \endcode The pointer to the frame number must
+ * not be a NULL pointer.
+ * @pre \code values != 0 \endcode The pointer to the values must not be a
+ * NULL pointer.
+ * @pre \code n_particles != 0 \endcode The pointer to the number of particles must
+ * not be a NULL pointer.
+ * @pre \code n_values_per_frame != 0 \endcode The pointer to the number of
+ * values per frame must not be a NULL pointer.
+ * @pre \code type != 0 \endcode The pointer to the data type must not
+ * be a NULL pointer.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if there are no
+ * more frames with data in the interval or if a minor error has occurred or
+ * TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_data_iterator_next
+                (const tng_trajectory_t tng_data,
+                 const tng_data_iterator_t iterator,
+                 int64_t *frame_nr,
+                 const void **values,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type);
+
+/**
+ * @brief Free the memory of a data block iterator.
+ * @param iterator_p is a pointer to the iterator. It is set to NULL.
+ * @pre \code iterator_p != 0 \endcode The pointer to the iterator must
+ * not be a NULL pointer.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_data_iterator_destroy
+                (tng_data_iterator_t *iterator_p);
+
 /**
  * @brief Get the stride length of a specific data (particle dependency does not matter)
  * block, either in the current frame set or of a specific frame.
@@ -3392,6 +4151,10 @@ tng_function_status DECLSPECDLLEXPORT tng_time_get_str
  * @param tng_data_p is a pointer to the opened trajectory. This will be
  * allocated by the TNG library. The trajectory must be
  * closed by the user, whereby memory is freed.
+ * @details When appending, the file is opened once for both reading and
+ * writing. Of the last frame set only the frame set block, the particle
+ * mappings and the definitions of the data blocks are read, so the data
+ * values of the last frame set are not available.
  * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
  * must be initialised before using it.
  * @pre \code filename != 0 \endcode The pointer to the filename must not be a
@@ -3405,6 +4168,34 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open
                  const char mode,
                  tng_trajectory_t *tng_data_p);
 
+/**
+ * @brief High-level function for opening a TNG trajectory split into
+ * several files for reading, as if it was one file.
+ * @param file_names are the names of the files, in the order of their
+ * frames.
+ * @param n_files is the number of files.
+ * @param max_open_files is the maximum number of files to keep open at the
+ * same time.
+ * @param tng_data_p is a pointer to the opened trajectory. This will be
+ * allocated by the TNG library. The trajectory must be
+ * closed by the user, whereby memory is freed.
+ * @details See tng_input_file_segments_set(). The file headers, e.g. the
+ * molecular system, are read from the first file. Frames are read from the
+ * file containing them, e.g. by tng_util_pos_read_range() or
+ * tng_util_particle_data_next_frame_read(), also across file boundaries.
+ * @pre \code file_names != 0 \endcode The pointer to the file names must
+ * not be a NULL pointer.
+ * @pre \code n_files > 0 \endcode There must be at least one file.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured (such as files not following each other) or TNG_CRITICAL (2)
+ * if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_segments_open
+                (const char **file_names,
+                 const int64_t n_files,
+                 const int64_t max_open_files,
+                 tng_trajectory_t *tng_data_p);
+
 /**
  * @brief High-level function for closing a TNG trajectory.
  * @param tng_data_p is a pointer to the trajectory to close. The memory
@@ -3414,6 +4205,82 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open
 tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_close
                 (tng_trajectory_t *tng_data_p);
 
+/**
+ * @brief High-level function for copying frame sets from one trajectory to
+ * another without decompressing and compressing the data, e.g. to trim,
+ * subsample or concatenate trajectories.
+ * @param tng_data_in is the trajectory to copy from.
+ * @param tng_data_out is the trajectory to copy to, e.g. opened by
+ * tng_util_trajectory_open() in mode 'w' or 'a'. It must have the same
+ * molecular system as tng_data_in.
+ * @param first_frame is the first frame to copy. The whole frame set
+ * containing it is copied.
+ * @param last_frame is the last frame to copy. The whole frame set
+ * containing it is copied. If it is negative all frame sets until the end
+ * of the trajectory are copied.
+ * @param frame_set_stride specifies how many frame sets to advance between
+ * each copied frame set, e.g. 2 to copy every second frame set.
+ * @details See tng_frame_set_raw_copy(). The copied frames are numbered
+ * consecutively, after the frames already in the output file.
+ * @pre \code tng_data_in != 0 \endcode The trajectory container (tng_data_in)
+ * must be initialised before using it.
+ * @pre \code tng_data_out != 0 \endcode The trajectory container (tng_data_out)
+ * must be initialised before using it.
+ * @pre \code first_frame >= 0 \endcode The first frame must not be negative.
+ * @pre \code frame_set_stride > 0 \endcode The frame set stride must be
+ * positive.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured (such as first_frame not being found) or TNG_CRITICAL (2) if a
+ * major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_frame_sets_copy
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 const int64_t first_frame,
+                 const int64_t last_frame,
+                 const int64_t frame_set_stride);
+
+/**
+ * @brief High-level function for converting a trajectory to another codec,
+ * compression precision or data type, e.g. to convert gzipped trajectories
+ * to TNG compression.
+ * @param tng_data_in is the trajectory to read.
+ * @param tng_data_out is the trajectory to write, e.g. opened by
+ * tng_util_trajectory_open() in mode 'w'. Its compression precision,
+ * keyframe interval and compression algorithms (see
+ * tng_compression_precision_set(), tng_compression_keyframe_interval_set()
+ * and tng_compression_algorithm_set()) are used. If it has no molecular
+ * system the molecular system of tng_data_in is copied.
+ * @param codec_id is the codec (TNG_UNCOMPRESSED, TNG_XTC_COMPRESSION,
+ * TNG_TNG_COMPRESSION or TNG_GZIP_COMPRESSION) to write positions and
+ * velocities with. Other data blocks are only written with it if it is
+ * TNG_UNCOMPRESSED or TNG_GZIP_COMPRESSION, otherwise they keep their codec.
+ * @param datatype is the data type (TNG_FLOAT_DATA or TNG_DOUBLE_DATA) to
+ * store floating point data as, or 0 to keep the data types.
+ * @details All frame sets of tng_data_in, including all its files if it is
+ * split into several files (see tng_util_trajectory_segments_open()), are
+ * read, encoded again and written to tng_data_out with the same frame
+ * numbers. Non-trajectory data blocks are not copied. Data of particles in
+ * particle mapping blocks is written in the real particle numbering, without
+ * the mappings.
+ * If the TNG library is built with OpenMP (TNG_BUILD_OPENMP) the frame sets
+ * are read and encoded by several threads, but still written in order.
+ * Compression algorithms that are not set are determined from the first
+ * frame set, so the output does not depend on the number of threads.
+ * @pre \code tng_data_in != 0 \endcode The trajectory container (tng_data_in)
+ * must be initialised before using it.
+ * @pre \code tng_data_out != 0 \endcode The trajectory container (tng_data_out)
+ * must be initialised before using it.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured (such as an unsupported codec) or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_transcode
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 const int64_t codec_id,
+                 const char datatype);
+
 /**
  * @brief High-level function for getting the time (in seconds) of a frame.
  * @param tng_data is the trajectory containing the frame.
@@ -4229,6 +5096,109 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
                  const char particle_dependency,
                  const char compression);
 
+/**
+ * @brief High-level function for getting where to store the values of one
+ * frame of a data block, so that they can be written there directly instead
+ * of being copied by tng_util_generic_write().
+ * @param tng_data is the trajectory to use.
+ * @param frame_nr is the frame number of the data. If frame_nr < 0 the
+ * data is written as non-trajectory data.
+ * @param n_values_per_frame is the number of values to store per frame. If the
+ * data is particle dependent there will be n_values_per_frame stored per
+ * particle each frame.
+ * @param block_id is the ID of the block.
+ * @param block_name is a string that will be used as name of the block. Only
+ * required if the block did not exist, i.e. a new block is created.
+ * @param particle_dependency should be TNG_NON_PARTICLE_BLOCK_DATA (0) if the
+ * data is not related to specific particles (e.g. box shape) or
+ * TNG_PARTICLE_BLOCK_DATA (1) is it is related to specific particles (e.g.
+ * positions).
+ * @param compression is the compression routine to use when writing the data.
+ * Only required if the block did not exist, i.e. a new block is created.
+ * @param values is set to point to the values of the frame, owned by the
+ * trajectory. n_particles * n_values_per_frame values (or n_values_per_frame
+ * values for non-particle data) should be stored there before calling
+ * tng_util_frame_commit(). If the particles of the frame set are mapped by
+ * one particle mapping (see tng_particle_mapping_add()) n_particles is the
+ * number of mapped particles, otherwise it is the number of particles in the
+ * system.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code values != 0 \endcode The pointer to the values pointer must not
+ * be a NULL pointer.
+ * @details The block data is compressed from where the values are stored
+ * when the frame set is written. If frame_nr is beyond the current frame set
+ * that frame set is written to disk, so values acquired earlier must not be
+ * used after acquiring a frame of a later frame set. A frame that is not
+ * committed is not part of the trajectory and its values may be overwritten
+ * when acquiring the next frame.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured (such as the data block being of another data type) or
+ * TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_frame_acquire
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression,
+                 float **values);
+
+/**
+ * @brief High-level function for getting where to store the values of one
+ * frame of a double precision data block.
+ * @param tng_data is the trajectory to use.
+ * @param frame_nr is the frame number of the data. If frame_nr < 0 the
+ * data is written as non-trajectory data.
+ * @param n_values_per_frame is the number of values to store per frame.
+ * @param block_id is the ID of the block.
+ * @param block_name is a string that will be used as name of the block. Only
+ * required if the block did not exist, i.e. a new block is created.
+ * @param particle_dependency should be TNG_NON_PARTICLE_BLOCK_DATA (0) or
+ * TNG_PARTICLE_BLOCK_DATA (1).
+ * @param compression is the compression routine to use when writing the data.
+ * Only required if the block did not exist, i.e. a new block is created.
+ * @param values is set to point to the values of the frame, owned by the
+ * trajectory.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @pre \code values != 0 \endcode The pointer to the values pointer must not
+ * be a NULL pointer.
+ * @details See tng_util_generic_frame_acquire().
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured (such as the data block being of another data type) or
+ * TNG_CRITICAL (2) if a major error has occured.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_frame_acquire
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression,
+                 double **values);
+
+/**
+ * @brief Mark a frame, whose values have been stored where
+ * tng_util_generic_frame_acquire() pointed, as written.
+ * @param tng_data is the trajectory to use.
+ * @param frame_nr is the frame number. It must be in the current frame set.
+ * If frame_nr < 0 nothing is done.
+ * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+ * must be initialised before using it.
+ * @details All data blocks of a frame can be committed at once after storing
+ * their values. N.b. the data is not actually written to disk until the frame
+ * set is finished or the TNG trajectory is closed.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the frame is
+ * not in the current frame set.
+ */
+tng_function_status DECLSPECDLLEXPORT tng_util_frame_commit
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr);
+
 /**
  * @brief High-level function for adding data to positions data blocks.
  * @param tng_data is the trajectory to use.
@@ -33,5 +33,7 @@ typedef struct tng_particle_mapping *tng_particle_mapping_t;
 typedef struct tng_trajectory_frame_set *tng_trajectory_frame_set_t;
 /** A pointer to a data container. */
 typedef struct tng_data *tng_data_t;
+/** A pointer to an iterator over the frames of a data block. */
+typedef struct tng_data_iterator *tng_data_iterator_t;
 
 #endif
@@ -21,40 +21,23 @@ static void comp_conv_to_mtf_byte(unsigned char *vals, const int nvals,
                                   unsigned char *valsmtf)
 {
   int i;
-  /* Indices into a linked list */
-  int list[256];
-  int dict[256];
-  /* Head of the linked list */
-  int head;
+  /* The dictionary in move to front order. Keeping it in a
+     contiguous array lets memchr and memmove do the searching and
+     shifting, instead of walking a linked list. */
+  unsigned char order[256];
   for (i=0; i<256; i++)
-    dict[i]=i;
-  for (i=0; i<255; i++)
-    list[i]=i+1;
-  list[255]=-1; /* end. */
-  head=0;
+    order[i]=(unsigned char)i;
   for (i=0; i<nvals; i++)
     {
-      int v=(int)vals[i];
+      unsigned char v=vals[i];
       /* Find how early in the dict the value is */
-      int ptr=head;
-      int oldptr=-1;
-      int r=0;
-      while (dict[ptr]!=v)
-        {
-          oldptr=ptr;
-          ptr=list[ptr];
-          r++;
-        }
+      int r=(int)((unsigned char *)memchr(order,v,256)-order);
       valsmtf[i]=(unsigned char)r;
-      /* Move it to front in list */
-      /* Is it the head? Then it is already at the front. */
-      if (oldptr!=-1)
+      /* Move it to front */
+      if (r)
         {
-          /* Remove it from inside the list */
-          list[oldptr]=list[ptr];
-          /* Move it to the front. */
-          list[ptr]=head;
-          head=ptr;
+          memmove(order+1,order,r);
+          order[0]=v;
         }
     }
 }
@@ -97,40 +80,21 @@ static void comp_conv_from_mtf_byte(unsigned char *valsmtf, const int nvals,
                              unsigned char *vals)
 {
   int i;
-  /* Indices into a linked list */
-  int list[256];
-  int dict[256];
-  /* Head of the linked list */
-  int head;
+  /* The dictionary in move to front order. */
+  unsigned char order[256];
   for (i=0; i<256; i++)
-    dict[i]=i;
-  for (i=0; i<255; i++)
-    list[i]=i+1;
-  list[255]=-1; /* end. */
-  head=0;
+    order[i]=(unsigned char)i;
   for (i=0; i<nvals; i++)
     {
       int r=(int)valsmtf[i];
-      /* Find value at position r in the list */
-      int ptr=head;
-      int oldptr=-1;
-      int cnt=0;
-      while (cnt<r)
+      /* Find value at position r */
+      unsigned char v=order[r];
+      vals[i]=v;
+      /* Move it to front */
+      if (r)
         {
-          oldptr=ptr;
-          ptr=list[ptr];
-          cnt++;
-        }
-      vals[i]=(unsigned int)dict[ptr];
-      /* Move it to front in list */
-      /* Is it the head? Then it is already at the front. */
-      if (oldptr!=-1)
-        {
-          /* Remove it from inside the list */
-          list[oldptr]=list[ptr];
-          /* Move it to the front. */
-          list[ptr]=head;
-          head=ptr;
+          memmove(order+1,order,r);
+          order[0]=v;
         }
     }
 }
@@ -178,40 +142,55 @@ void Ptngc_comp_conv_to_mtf(unsigned int *vals, const int nvals,
                       unsigned int *valsmtf)
 {
   int i;
-  /* Indices into a linked list */
-  int *list=warnmalloc(ndict*sizeof *list);
-  /* Head of the linked list */
-  int head;
-  for (i=0; i<ndict-1; i++)
-    list[i]=i+1;
-  list[ndict-1]=-1; /* end. */
-  head=0;
+  /* The dictionary can be large (0x20004 entries), so a linear search
+     would be slow for rare values. Instead each value occupies a slot,
+     the dictionary in slots nvals to nvals+ndict-1 and every value moved
+     to the front in the slot before the current front. The rank of a
+     value is then the number of occupied slots before its slot, which
+     is counted with a Fenwick tree. */
+  const int nslots=nvals+ndict;
+  int front=nvals;
+  unsigned int maxval=0;
+  int *tree=warnmalloc((nslots+1)*sizeof *tree);
+  int *slot;
+  for (i=0; i<ndict; i++)
+    if (dict[i]>maxval)
+      maxval=dict[i];
+  slot=warnmalloc((maxval+1)*sizeof *slot);
+  for (i=0; i<ndict; i++)
+    slot[dict[i]]=nvals+i;
+  /* Build the tree of the occupied slots in linear time. */
+  for (i=1; i<=nslots; i++)
+    tree[i]=(i>nvals);
+  for (i=1; i<=nslots; i++)
+    {
+      int parent=i+(i&(-i));
+      if (parent<=nslots)
+        tree[parent]+=tree[i];
+    }
   for (i=0; i<nvals; i++)
     {
-      int v=vals[i];
-      /* Find how early in the dict the value is */
-      int ptr=head;
-      int oldptr=-1;
+      unsigned int v=vals[i];
+      int s=slot[v];
       int r=0;
-      while (dict[ptr]!=v)
+      int j;
+      if (s!=front)
         {
-          oldptr=ptr;
-          ptr=list[ptr];
-          r++;
+          /* Find how early in the dict the value is */
+          for (j=s; j>0; j-=j&(-j))
+            r+=tree[j];
+          /* Move it to front */
+          for (j=s+1; j<=nslots; j+=j&(-j))
+            tree[j]--;
+          front--;
+          for (j=front+1; j<=nslots; j+=j&(-j))
+            tree[j]++;
+          slot[v]=front;
         }
       valsmtf[i]=r;
-      /* Move it to front in list */
-      /* Is it the head? Then it is already at the front. */
-      if (oldptr!=-1)
-        {
-          /* Remove it from inside the list */
-          list[oldptr]=list[ptr];
-          /* Move it to the front. */
-          list[ptr]=head;
-          head=ptr;
-        }
     }
-  free(list);
+  free(slot);
+  free(tree);
 }
 
 /* Move to front decoding */
@@ -220,39 +199,22 @@ void Ptngc_comp_conv_from_mtf(unsigned int *valsmtf, const int nvals,
                         unsigned int *vals)
 {
   int i;
-  /* Indices into a linked list */
-  int *list=warnmalloc(ndict*sizeof *list);
-  /* Head of the linked list */
-  int head;
-  for (i=0; i<ndict-1; i++)
-    list[i]=i+1;
-  list[ndict-1]=-1; /* end. */
-  head=0;
+  /* The dictionary in move to front order. */
+  unsigned int *order=warnmalloc(ndict*sizeof *order);
+  memcpy(order,dict,ndict*sizeof *order);
   for (i=0; i<nvals; i++)
     {
       int r=valsmtf[i];
-      /* Find value at position r in the list */
-      int ptr=head;
-      int oldptr=-1;
-      int cnt=0;
-      while (cnt<r)
-        {
-          oldptr=ptr;
-          ptr=list[ptr];
-          cnt++;
-        }
-      vals[i]=dict[ptr];
-      /* Move it to front in list */
-      /* Is it the head? Then it is already at the front. */
-      if (oldptr!=-1)
+      /* Find value at position r */
+      unsigned int v=order[r];
+      vals[i]=v;
+      /* Move it to front */
+      if (r)
         {
-          /* Remove it from inside the list */
-          list[oldptr]=list[ptr];
-          /* Move it to the front. */
-          list[ptr]=head;
-          head=ptr;
+          memmove(order+1,order,r*sizeof *order);
+          order[0]=v;
         }
     }
-  free(list);
+  free(order);
 }
 
@@ -40,31 +40,18 @@ void Ptngc_comp_conv_to_rle(unsigned int *vals, const int nvals,
                             unsigned int *rle, int *nrle,
                             const int min_rle)
 {
-  int i;
+  int i=0;
   int j=0;
-  int nsim=0;
-  int v=-1;
-  for (i=0; i<nvals; i++)
+  while (i<nvals)
     {
-      if (!nsim)
-        {
-          v=vals[i];
-          nsim=1;
-        }
-      else
-        {
-          if (v==vals[i])
-            nsim++;
-          else
-            {
-              add_rle(rle,v,nsim,&j,min_rle);
-              nsim=1;
-              v=vals[i];
-            }
-        }
+      unsigned int v=vals[i];
+      /* Find the end of the run in a tight loop. */
+      int k=i+1;
+      while ((k<nvals) && (vals[k]==v))
+        k++;
+      add_rle(rle,(int)v,k-i,&j,min_rle);
+      i=k;
     }
-  if (nsim!=0)
-    add_rle(rle,v,nsim,&j,min_rle);
   *nrle=j;
 }
 
@@ -92,8 +79,12 @@ void Ptngc_comp_conv_from_rle(unsigned int *rle,
         len=1;
       else
         len|=mask;
+      /* Fill the run without touching i in the loop, so that the
+         compiler can vectorize it. */
+      v-=2;
       for (k=0; k<(int)len; k++)
-        vals[i++]=v-2;
+        vals[i+k]=v;
+      i+=(int)len;
     }
 }
 
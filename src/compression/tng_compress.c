@@ -20,6 +20,10 @@
 /* This becomes TNGP for positions (little endian) and TNGV for velocities. In ASCII. */
 #define MAGIC_INT_POS 0x50474E54
 #define MAGIC_INT_VEL 0x56474E54
+/* TNGK: A keyframe container of independently compressed position or velocity blocks. */
+#define MAGIC_INT_KEYFRAMES 0x4B474E54
+/* Magic, number of frames, keyframe interval and number of blocks. */
+#define KEYFRAMES_HEADER_LEN 16
 
 #define SPEED_DEFAULT 2 /* Default to relatively fast compression. For very good compression it makes sense to
                            choose speed=4 or speed=5 */
@@ -502,9 +506,9 @@ static void compress_quantized_vel(int *quant, int *quant_inter,
   if (data && datablock)
     {
       memcpy(data+bufloc,datablock,length);
-      free(datablock);
       bufloc+=length;
     }
+  free(datablock);
   /* The remaining frames */
   if (nframes>1)
     {
@@ -543,27 +547,54 @@ static void compress_quantized_vel(int *quant, int *quant_inter,
   *nitems=bufloc;
 }
 
-static int determine_best_coding_stop_bits(struct coder *coder,int *input, int *length,
-                                           int *coding_parameter, const int natoms)
+#define MAX_CODING_PARAMETER 20
+
+/* Find the coding parameter (number of bits) giving the shortest output for
+   stopbit or triplet coding. The trials are independent of each other, so
+   they are run concurrently if OpenMP is enabled. */
+static int determine_best_coding_parameter(struct coder *coder,int *input, int *length,
+                                           int *coding_parameter, const int natoms,
+                                           const int coding)
 {
   int bits;
-  unsigned char *packed;
   int best_length=0;
   int new_parameter=-1;
-  int io_length;
-  for (bits=1; bits<20; bits++)
+  int io_length[MAX_CODING_PARAMETER];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (bits=1; bits<MAX_CODING_PARAMETER; bits++)
     {
-      io_length=*length;
-      packed=Ptngc_pack_array(coder,input,&io_length,
-                                  TNG_COMPRESS_ALGO_STOPBIT,bits,natoms,0);
+      unsigned char *packed;
+#ifdef _OPENMP
+      /* The coder keeps state while packing, so each trial needs its own. */
+      struct coder *trial_coder=Ptngc_coder_init();
+#else
+      struct coder *trial_coder=coder;
+#endif
+      io_length[bits]=*length;
+      packed=Ptngc_pack_array(trial_coder,input,&io_length[bits],
+                              coding,bits,natoms,0);
       if (packed)
+        free(packed);
+      else
+        io_length[bits]=-1;
+#ifdef _OPENMP
+      Ptngc_coder_deinit(trial_coder);
+#endif
+    }
+#ifdef _OPENMP
+  (void)coder;
+#endif
+  /* Pick the smallest parameter giving the shortest output, as when the
+     trials are run in order. */
+  for (bits=1; bits<MAX_CODING_PARAMETER; bits++)
+    {
+      if ((io_length[bits]!=-1) &&
+          ((new_parameter==-1) || (io_length[bits]<best_length)))
         {
-          if ((new_parameter==-1) || (io_length<best_length))
-            {
-              new_parameter=bits;
-              best_length=io_length;
-            }
-          free(packed);
+          new_parameter=bits;
+          best_length=io_length[bits];
         }
     }
   if (new_parameter==-1)
@@ -574,35 +605,63 @@ static int determine_best_coding_stop_bits(struct coder *coder,int *input, int *
   return 0;
 }
 
+static int determine_best_coding_stop_bits(struct coder *coder,int *input, int *length,
+                                           int *coding_parameter, const int natoms)
+{
+  return determine_best_coding_parameter(coder,input,length,coding_parameter,natoms,
+                                         TNG_COMPRESS_ALGO_STOPBIT);
+}
+
 static int determine_best_coding_triple(struct coder *coder,int *input, int *length,
                                         int *coding_parameter, const int natoms)
 {
-  int bits;
-  unsigned char *packed;
-  int best_length=0;
-  int new_parameter=-1;
-  int io_length;
-  for (bits=1; bits<20; bits++)
+  return determine_best_coding_parameter(coder,input,length,coding_parameter,natoms,
+                                         TNG_COMPRESS_ALGO_TRIPLET);
+}
+
+/* The result of compressing with one candidate algorithm. */
+struct coding_trial
+{
+  int coding;
+  int coding_parameter;
+  int code_size;
+  int ok;
+};
+
+/* Find the best coding parameter of a stopbit or triplet candidate. */
+static void coding_trial_parameter(struct coding_trial *trial, int *input, const int length,
+                                   const int natoms, const int coding)
+{
+  struct coder *coder=Ptngc_coder_init();
+  trial->code_size=length;
+  trial->coding_parameter=0;
+  trial->ok=!determine_best_coding_parameter(coder,input,&trial->code_size,
+                                             &trial->coding_parameter,natoms,coding);
+  Ptngc_coder_deinit(coder);
+}
+
+/* Pick the candidate giving the shortest output. On ties the earliest
+   candidate is picked, so the result does not depend on the order in which
+   the trials finished. */
+static void pick_best_coding_trial(const struct coding_trial *trials, const int ntrials,
+                                   int *coding, int *coding_parameter)
+{
+  int i;
+  int best=-1;
+  for (i=0; i<ntrials; i++)
+    if ((trials[i].ok) &&
+        ((best==-1) || (trials[i].code_size<trials[best].code_size)))
+      best=i;
+  if (best==-1)
     {
-      io_length=*length;
-      packed=Ptngc_pack_array(coder,input,&io_length,
-                                  TNG_COMPRESS_ALGO_TRIPLET,bits,natoms,0);
-      if (packed)
-        {
-          if ((new_parameter==-1) || (io_length<best_length))
-            {
-              new_parameter=bits;
-              best_length=io_length;
-            }
-          free(packed);
-        }
+      *coding=-1;
+      *coding_parameter=-1;
+    }
+  else
+    {
+      *coding=trials[best].coding;
+      *coding_parameter=trials[best].coding_parameter;
     }
-  if (new_parameter==-1)
-    return 1;
-
-  *coding_parameter=new_parameter;
-  *length=best_length;
-  return 0;
 }
 
 static void determine_best_pos_initial_coding(int *quant, int *quant_intra, const int natoms, const int speed,
@@ -611,86 +670,39 @@ static void determine_best_pos_initial_coding(int *quant, int *quant_intra, cons
 {
   if (*initial_coding==-1)
     {
-      /* Determine all parameters automatically */
-      int best_coding;
-      int best_coding_parameter;
-      int best_code_size;
-      int current_coding;
-      int current_coding_parameter;
-      int current_code_size;
-      struct coder *coder;
-      /* Start with XTC2, it should always work. */
-      current_coding=TNG_COMPRESS_ALGO_POS_XTC2;
-      current_coding_parameter=0;
-      compress_quantized_pos(quant,NULL,quant_intra,natoms,1,speed,
-                             current_coding,current_coding_parameter,
-                             0,0,prec_hi,prec_lo,&current_code_size,NULL);
-      best_coding=current_coding;
-      best_coding_parameter=current_coding_parameter;
-      best_code_size=current_code_size;
-
-      /* Determine best parameter for triplet intra. */
-      current_coding=TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3;
-      current_coding_parameter=0;
-      if (!determine_best_coding_triple(coder,quant_intra,&current_code_size,&current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Determine best parameter for triplet one-to-one. */
-      current_coding=TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3;
-      current_coding_parameter=0;
-      if (!determine_best_coding_triple(coder,quant,&current_code_size,&current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
+      /* Determine all parameters automatically. The candidates are
+         compressed concurrently if OpenMP is enabled, each into its own
+         buffer. XTC2 is first, since it should always work. */
+      struct coding_trial trials[5];
+      int ntrials=0;
+      int i;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_XTC2;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE;
       if (speed>=2)
-        {
-          current_coding=TNG_COMPRESS_ALGO_POS_XTC3;
-          current_coding_parameter=0;
-          compress_quantized_pos(quant,NULL,quant_intra,natoms,1,speed,
-                                 current_coding,current_coding_parameter,
-                                 0,0,prec_hi,prec_lo,&current_code_size,NULL);
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      /* Test BWLZH intra */
+        trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_XTC3;
       if (speed>=6)
+        trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_BWLZH_INTRA;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (i=0; i<ntrials; i++)
         {
-          current_coding=TNG_COMPRESS_ALGO_POS_BWLZH_INTRA;
-          current_coding_parameter=0;
-          compress_quantized_pos(quant,NULL,quant_intra,natoms,1,speed,
-                                 current_coding,current_coding_parameter,
-                                 0,0,prec_hi,prec_lo,&current_code_size,NULL);
-          if (current_code_size<best_code_size)
+          struct coding_trial *trial=&trials[i];
+          if (trial->coding==TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA)
+            coding_trial_parameter(trial,quant_intra,natoms*3,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else if (trial->coding==TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE)
+            coding_trial_parameter(trial,quant,natoms*3,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else
             {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
+              trial->coding_parameter=0;
+              compress_quantized_pos(quant,NULL,quant_intra,natoms,1,speed,
+                                     trial->coding,trial->coding_parameter,
+                                     0,0,prec_hi,prec_lo,&trial->code_size,NULL);
+              trial->ok=1;
             }
         }
-      *initial_coding=best_coding;
-      *initial_coding_parameter=best_coding_parameter;
+      pick_best_coding_trial(trials,ntrials,initial_coding,initial_coding_parameter);
     }
   else
     {
@@ -724,135 +736,54 @@ static void determine_best_pos_coding(int *quant, int *quant_inter, int *quant_i
 {
   if (*coding==-1)
     {
-      /* Determine all parameters automatically */
-      int best_coding;
-      int best_coding_parameter;
-      int best_code_size;
-      int current_coding;
-      int current_coding_parameter;
-      int current_code_size;
+      /* Determine all parameters automatically. The candidates are
+         compressed concurrently if OpenMP is enabled, each into its own
+         buffer. XTC2 is first, since it should always work. */
+      struct coding_trial trials[7];
+      int ntrials=0;
+      int i;
       int initial_code_size;
-      struct coder *coder;
       /* Always use XTC2 for the initial coding. */
       compress_quantized_pos(quant,quant_inter,quant_intra,natoms,1,speed,
                              TNG_COMPRESS_ALGO_POS_XTC2,0,
                              0,0,
                              prec_hi,prec_lo,&initial_code_size,NULL);
-      /* Start with XTC2, it should always work. */
-      current_coding=TNG_COMPRESS_ALGO_POS_XTC2;
-      current_coding_parameter=0;
-      compress_quantized_pos(quant,quant_inter,quant_intra,natoms,nframes,speed,
-                             TNG_COMPRESS_ALGO_POS_XTC2,0,
-                             current_coding,current_coding_parameter,
-                             prec_hi,prec_lo,&current_code_size,NULL);
-      best_coding=current_coding;
-      best_coding_parameter=current_coding_parameter;
-      best_code_size=current_code_size-initial_code_size; /* Correct for the use of XTC2 for the first frame. */
-
-      /* Determine best parameter for stopbit interframe coding. */
-      current_coding=TNG_COMPRESS_ALGO_POS_STOPBIT_INTER;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      if (!determine_best_coding_stop_bits(coder,quant_inter+natoms*3,&current_code_size,
-                                           &current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Determine best parameter for triplet interframe coding. */
-      current_coding=TNG_COMPRESS_ALGO_POS_TRIPLET_INTER;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      if (!determine_best_coding_triple(coder,quant_inter+natoms*3,&current_code_size,
-                                        &current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Determine best parameter for triplet intraframe coding. */
-      current_coding=TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      if (!determine_best_coding_triple(coder,quant_intra+natoms*3,&current_code_size,
-                                        &current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Determine best parameter for triplet one-to-one coding. */
-      current_coding=TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      if (!determine_best_coding_triple(coder,quant+natoms*3,&current_code_size,
-                                        &current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Test BWLZH inter */
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_XTC2;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_STOPBIT_INTER;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_TRIPLET_INTER;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE;
       if (speed>=4)
-        {
-          current_coding=TNG_COMPRESS_ALGO_POS_BWLZH_INTER;
-          current_coding_parameter=0;
-          compress_quantized_pos(quant,quant_inter,quant_intra,natoms,nframes,speed,
-                                 TNG_COMPRESS_ALGO_POS_XTC2,0,
-                                 current_coding,current_coding_parameter,
-                                 prec_hi,prec_lo,&current_code_size,NULL);
-          current_code_size-=initial_code_size; /* Correct for the use of XTC2 for the first frame. */
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-
-      /* Test BWLZH intra */
+        trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_BWLZH_INTER;
       if (speed>=6)
+        trials[ntrials++].coding=TNG_COMPRESS_ALGO_POS_BWLZH_INTRA;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (i=0; i<ntrials; i++)
         {
-          current_coding=TNG_COMPRESS_ALGO_POS_BWLZH_INTRA;
-          current_coding_parameter=0;
-          compress_quantized_pos(quant,quant_inter,quant_intra,natoms,nframes,speed,
-                                 TNG_COMPRESS_ALGO_POS_XTC2,0,
-                                 current_coding,current_coding_parameter,
-                                 prec_hi,prec_lo,&current_code_size,NULL);
-          current_code_size-=initial_code_size; /* Correct for the use of XTC2 for the first frame. */
-          if (current_code_size<best_code_size)
+          struct coding_trial *trial=&trials[i];
+          const int length=natoms*3*(nframes-1);
+          if (trial->coding==TNG_COMPRESS_ALGO_POS_STOPBIT_INTER)
+            coding_trial_parameter(trial,quant_inter+natoms*3,length,natoms,TNG_COMPRESS_ALGO_STOPBIT);
+          else if (trial->coding==TNG_COMPRESS_ALGO_POS_TRIPLET_INTER)
+            coding_trial_parameter(trial,quant_inter+natoms*3,length,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else if (trial->coding==TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA)
+            coding_trial_parameter(trial,quant_intra+natoms*3,length,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else if (trial->coding==TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE)
+            coding_trial_parameter(trial,quant+natoms*3,length,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else
             {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
+              trial->coding_parameter=0;
+              compress_quantized_pos(quant,quant_inter,quant_intra,natoms,nframes,speed,
+                                     TNG_COMPRESS_ALGO_POS_XTC2,0,
+                                     trial->coding,trial->coding_parameter,
+                                     prec_hi,prec_lo,&trial->code_size,NULL);
+              trial->code_size-=initial_code_size; /* Correct for the use of XTC2 for the first frame. */
+              trial->ok=1;
             }
         }
-      *coding=best_coding;
-      *coding_parameter=best_coding_parameter;
+      pick_best_coding_trial(trials,ntrials,coding,coding_parameter);
     }
   else if (*coding_parameter==-1)
     {
@@ -902,60 +833,36 @@ static void determine_best_vel_initial_coding(int *quant, const int natoms, cons
 {
   if (*initial_coding==-1)
     {
-      /* Determine all parameters automatically */
-      int best_coding=-1;
-      int best_coding_parameter=-1;
-      int best_code_size=-1;
-      int current_coding;
-      int current_coding_parameter;
-      int current_code_size;
-      struct coder *coder;
-      /* Start to determine best parameter for stopbit one-to-one. */
-      current_coding=TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE;
-      current_code_size=natoms*3;
-      current_coding_parameter=0;
-      coder=Ptngc_coder_init();
-      if (!determine_best_coding_stop_bits(coder,quant,&current_code_size,
-                                           &current_coding_parameter,natoms))
-        {
-          best_coding=current_coding;
-          best_coding_parameter=current_coding_parameter;
-          best_code_size=current_code_size;
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Determine best parameter for triplet one-to-one. */
-      current_coding=TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE;
-      coder=Ptngc_coder_init();
-      current_code_size=natoms*3;
-      current_coding_parameter=0;
-      if (!determine_best_coding_triple(coder,quant,&current_code_size,&current_coding_parameter,natoms))
-        {
-          if ((best_coding==-1) || (current_code_size<best_code_size))
-            {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
-              best_code_size=current_code_size;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Test BWLZH one-to-one */
+      /* Determine all parameters automatically. The candidates are
+         compressed concurrently if OpenMP is enabled, each into its own
+         buffer. */
+      struct coding_trial trials[3];
+      int ntrials=0;
+      int i;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE;
       if (speed>=4)
+        trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (i=0; i<ntrials; i++)
         {
-          current_coding=TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE;
-          current_coding_parameter=0;
-          compress_quantized_vel(quant,NULL,natoms,1,speed,
-                                 current_coding,current_coding_parameter,
-                                 0,0,prec_hi,prec_lo,&current_code_size,NULL);
-          if ((best_coding==-1) || (current_code_size<best_code_size))
+          struct coding_trial *trial=&trials[i];
+          if (trial->coding==TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE)
+            coding_trial_parameter(trial,quant,natoms*3,natoms,TNG_COMPRESS_ALGO_STOPBIT);
+          else if (trial->coding==TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE)
+            coding_trial_parameter(trial,quant,natoms*3,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else
             {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
+              trial->coding_parameter=0;
+              compress_quantized_vel(quant,NULL,natoms,1,speed,
+                                     trial->coding,trial->coding_parameter,
+                                     0,0,prec_hi,prec_lo,&trial->code_size,NULL);
+              trial->ok=1;
             }
         }
-      *initial_coding=best_coding;
-      *initial_coding_parameter=best_coding_parameter;
+      pick_best_coding_trial(trials,ntrials,initial_coding,initial_coding_parameter);
     }
   else if (*initial_coding_parameter==-1)
     {
@@ -985,117 +892,59 @@ static void determine_best_vel_coding(int *quant, int *quant_inter, const int na
 {
   if (*coding==-1)
     {
-      /* Determine all parameters automatically */
-      int best_coding;
-      int best_coding_parameter;
-      int best_code_size;
-      int current_coding;
-      int current_coding_parameter;
-      int current_code_size;
+      /* Determine all parameters automatically. The candidates are
+         compressed concurrently if OpenMP is enabled, each into its own
+         buffer. */
+      struct coding_trial trials[6];
+      int ntrials=0;
+      int i;
       int initial_code_size;
       int initial_numbits=5;
-      struct coder *coder;
       /* Use stopbits one-to-one coding for the initial coding. */
       compress_quantized_vel(quant,NULL,natoms,1,speed,
                              TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE,initial_numbits,
                              0,0,prec_hi,prec_lo,&initial_code_size,NULL);
-
-      /* Test stopbit one-to-one */
-      current_coding=TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE;
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      coder=Ptngc_coder_init();
-      determine_best_coding_stop_bits(coder,quant+natoms*3,&current_code_size,
-                                      &current_coding_parameter,natoms);
-      Ptngc_coder_deinit(coder);
-      best_coding=current_coding;
-      best_code_size=current_code_size;
-      best_coding_parameter=current_coding_parameter;
-
-      /* Test triplet interframe */
-      current_coding=TNG_COMPRESS_ALGO_VEL_TRIPLET_INTER;
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      coder=Ptngc_coder_init();
-      if (!determine_best_coding_triple(coder,quant_inter+natoms*3,&current_code_size,
-                                        &current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_code_size=current_code_size;
-              best_coding_parameter=current_coding_parameter;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Test triplet one-to-one */
-      current_coding=TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE;
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      coder=Ptngc_coder_init();
-      if (!determine_best_coding_triple(coder,quant+natoms*3,&current_code_size,
-                                        &current_coding_parameter,natoms))
-        {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_code_size=current_code_size;
-              best_coding_parameter=current_coding_parameter;
-            }
-        }
-      Ptngc_coder_deinit(coder);
-
-      /* Test stopbit interframe */
-      current_coding=TNG_COMPRESS_ALGO_VEL_STOPBIT_INTER;
-      current_code_size=natoms*3*(nframes-1);
-      current_coding_parameter=0;
-      coder=Ptngc_coder_init();
-      if (!determine_best_coding_stop_bits(coder,quant_inter+natoms*3,&current_code_size,
-                                           &current_coding_parameter,natoms))
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_TRIPLET_INTER;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE;
+      trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_STOPBIT_INTER;
+      if (speed>=4)
         {
-          if (current_code_size<best_code_size)
-            {
-              best_coding=current_coding;
-              best_code_size=current_code_size;
-              best_coding_parameter=current_coding_parameter;
-            }
+          trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_BWLZH_INTER;
+          trials[ntrials++].coding=TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE;
         }
-      Ptngc_coder_deinit(coder);
-
-      if (speed>=4)
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (i=0; i<ntrials; i++)
         {
-          /* Test BWLZH inter */
-          current_coding=TNG_COMPRESS_ALGO_VEL_BWLZH_INTER;
-          current_coding_parameter=0;
-          compress_quantized_vel(quant,quant_inter,natoms,nframes,speed,
-                                 TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE,initial_numbits,
-                                 current_coding,current_coding_parameter,
-                                 prec_hi,prec_lo,&current_code_size,NULL);
-          current_code_size-=initial_code_size; /* Correct for the initial frame */
-          if (current_code_size<best_code_size)
+          struct coding_trial *trial=&trials[i];
+          const int length=natoms*3*(nframes-1);
+          if (trial->coding==TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE)
             {
-              best_coding=current_coding;
-              best_code_size=current_code_size;
-              best_coding_parameter=current_coding_parameter;
+              coding_trial_parameter(trial,quant+natoms*3,length,natoms,TNG_COMPRESS_ALGO_STOPBIT);
+              /* Stopbit one-to-one is the fallback, also if no parameter
+                 was found. */
+              trial->ok=1;
             }
-
-          /* Test BWLZH one-to-one */
-          current_coding=TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE;
-          current_coding_parameter=0;
-          compress_quantized_vel(quant,quant_inter,natoms,nframes,speed,
-                                 TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE,initial_numbits,
-                                 current_coding,current_coding_parameter,
-                                 prec_hi,prec_lo,&current_code_size,NULL);
-          current_code_size-=initial_code_size; /* Correct for the initial frame */
-          if (current_code_size<best_code_size)
+          else if (trial->coding==TNG_COMPRESS_ALGO_VEL_TRIPLET_INTER)
+            coding_trial_parameter(trial,quant_inter+natoms*3,length,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else if (trial->coding==TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE)
+            coding_trial_parameter(trial,quant+natoms*3,length,natoms,TNG_COMPRESS_ALGO_TRIPLET);
+          else if (trial->coding==TNG_COMPRESS_ALGO_VEL_STOPBIT_INTER)
+            coding_trial_parameter(trial,quant_inter+natoms*3,length,natoms,TNG_COMPRESS_ALGO_STOPBIT);
+          else
             {
-              best_coding=current_coding;
-              best_coding_parameter=current_coding_parameter;
+              trial->coding_parameter=0;
+              compress_quantized_vel(quant,quant_inter,natoms,nframes,speed,
+                                     TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE,initial_numbits,
+                                     trial->coding,trial->coding_parameter,
+                                     prec_hi,prec_lo,&trial->code_size,NULL);
+              trial->code_size-=initial_code_size; /* Correct for the initial frame */
+              trial->ok=1;
             }
         }
-      *coding=best_coding;
-      *coding_parameter=best_coding_parameter;
+      pick_best_coding_trial(trials,ntrials,coding,coding_parameter);
     }
   else if (*coding_parameter==-1)
     {
@@ -1303,6 +1152,37 @@ int DECLSPECDLLEXPORT tng_compress_nalgo(void)
  4) One parameter to the algorithm for the remaining frames (the coding parameter). */
 }
 
+char DECLSPECDLLEXPORT *tng_compress_keyframes_pack(char **blocks, const int *block_lengths,
+                                                    const int nblocks, const int nframes,
+                                                    const int keyframe_interval,
+                                                    int *nitems)
+{
+  int i, bufloc;
+  char *data;
+  int length=KEYFRAMES_HEADER_LEN+(nblocks+1)*4;
+  for (i=0; i<nblocks; i++)
+    length+=block_lengths[i];
+  data=malloc(length);
+  if (!data)
+    return NULL;
+  bufferfix((unsigned char*)data,(fix_t)MAGIC_INT_KEYFRAMES,4);
+  bufferfix((unsigned char*)data+4,(fix_t)nframes,4);
+  bufferfix((unsigned char*)data+8,(fix_t)keyframe_interval,4);
+  bufferfix((unsigned char*)data+12,(fix_t)nblocks,4);
+  /* The offset table has one extra entry holding the total length, so that
+     the length of every block is known. */
+  bufloc=KEYFRAMES_HEADER_LEN+(nblocks+1)*4;
+  for (i=0; i<nblocks; i++)
+    {
+      bufferfix((unsigned char*)data+KEYFRAMES_HEADER_LEN+i*4,(fix_t)bufloc,4);
+      memcpy(data+bufloc,blocks[i],block_lengths[i]);
+      bufloc+=block_lengths[i];
+    }
+  bufferfix((unsigned char*)data+KEYFRAMES_HEADER_LEN+nblocks*4,(fix_t)bufloc,4);
+  *nitems=bufloc;
+  return data;
+}
+
 char DECLSPECDLLEXPORT *tng_compress_vel_int(int *vel, const int natoms, const int nframes,
                                              const unsigned long prec_hi, const unsigned long prec_lo,
                                              int speed, int *algo,
@@ -1464,6 +1344,15 @@ int DECLSPECDLLEXPORT tng_compress_inquire(char *data,int *vel, int *natoms,
   int magic_int;
   magic_int=(int)readbufferfix((unsigned char *)data+bufloc,4);
   bufloc+=4;
+  if (magic_int==MAGIC_INT_KEYFRAMES)
+    {
+      /* Report the first block, but with the total number of frames. */
+      int offset=(int)readbufferfix((unsigned char *)data+KEYFRAMES_HEADER_LEN,4);
+      if (tng_compress_inquire(data+offset,vel,natoms,nframes,precision,algo))
+        return 1;
+      *nframes=(int)readbufferfix((unsigned char *)data+4,4);
+      return 0;
+    }
   if (magic_int==MAGIC_INT_POS)
     *vel=0;
   else if (magic_int==MAGIC_INT_VEL)
@@ -1500,7 +1389,73 @@ int DECLSPECDLLEXPORT tng_compress_inquire(char *data,int *vel, int *natoms,
   return 0;
 }
 
-static int tng_compress_uncompress_pos_gen(char *data,double *posd,float *posf,int *posi,unsigned long *prec_hi, unsigned long *prec_lo)
+struct tng_compress_scratch
+{
+  int *quant;
+  size_t quant_len;
+  char *frames;
+  size_t frames_len;
+};
+
+struct tng_compress_scratch DECLSPECDLLEXPORT *tng_compress_scratch_init(void)
+{
+  struct tng_compress_scratch *scratch=malloc(sizeof *scratch);
+  if (scratch)
+    {
+      scratch->quant=NULL;
+      scratch->quant_len=0;
+      scratch->frames=NULL;
+      scratch->frames_len=0;
+    }
+  return scratch;
+}
+
+void DECLSPECDLLEXPORT tng_compress_scratch_deinit(struct tng_compress_scratch *scratch)
+{
+  if (scratch)
+    {
+      free(scratch->quant);
+      free(scratch->frames);
+      free(scratch);
+    }
+}
+
+/* Get memory for n quantized values, from the scratch memory if there is one. */
+static int *scratch_quant_get(struct tng_compress_scratch *scratch,const size_t n)
+{
+  int *quant;
+  if (!scratch)
+    return malloc(n*sizeof *quant);
+  if (scratch->quant_len<n)
+    {
+      quant=realloc(scratch->quant,n*sizeof *quant);
+      if (!quant)
+        return NULL;
+      scratch->quant=quant;
+      scratch->quant_len=n;
+    }
+  return scratch->quant;
+}
+
+/* Get memory for len bytes of uncompressed frames, from the scratch memory if there is one. */
+static char *scratch_frames_get(struct tng_compress_scratch *scratch,const size_t len)
+{
+  char *frames;
+  if (!scratch)
+    return malloc(len);
+  if (scratch->frames_len<len)
+    {
+      frames=realloc(scratch->frames,len);
+      if (!frames)
+        return NULL;
+      scratch->frames=frames;
+      scratch->frames_len=len;
+    }
+  return scratch->frames;
+}
+
+static int tng_compress_uncompress_pos_gen(char *data,double *posd,float *posf,int *posi,unsigned long *prec_hi, unsigned long *prec_lo,
+                                           struct tng_compress_scratch *scratch)
 {
   int bufloc=0;
   int length;
@@ -1543,7 +1498,12 @@ static int tng_compress_uncompress_pos_gen(char *data,double *posd,float *posf,i
   *prec_hi=readbufferfix((unsigned char *)data+bufloc,4);
   bufloc+=4;
   /* Allocate the memory for the quantized positions */
-  quant=malloc(natoms*nframes*3*sizeof *quant);
+  quant=scratch_quant_get(scratch,(size_t)natoms*nframes*3);
+  if (!quant)
+    {
+      rval=1;
+      goto error;
+    }
   /* The data block length. */
   length=(int)readbufferfix((unsigned char *)data+bufloc,4);
   bufloc+=4;
@@ -1626,28 +1586,30 @@ static int tng_compress_uncompress_pos_gen(char *data,double *posd,float *posf,i
         }
     }
  error:
-  free(quant);
+  if (!scratch)
+    free(quant);
   return rval;
 }
 
 static int tng_compress_uncompress_pos(char *data,double *pos)
 {
   unsigned long prec_hi, prec_lo;
-  return tng_compress_uncompress_pos_gen(data,pos,NULL,NULL,&prec_hi,&prec_lo);
+  return tng_compress_uncompress_pos_gen(data,pos,NULL,NULL,&prec_hi,&prec_lo,NULL);
 }
 
 static int tng_compress_uncompress_pos_float(char *data,float *pos)
 {
   unsigned long prec_hi, prec_lo;
-  return tng_compress_uncompress_pos_gen(data,NULL,pos,NULL,&prec_hi,&prec_lo);
+  return tng_compress_uncompress_pos_gen(data,NULL,pos,NULL,&prec_hi,&prec_lo,NULL);
 }
 
 static int tng_compress_uncompress_pos_int(char *data,int *pos, unsigned long *prec_hi, unsigned long *prec_lo)
 {
-  return tng_compress_uncompress_pos_gen(data,NULL,NULL,pos,prec_hi,prec_lo);
+  return tng_compress_uncompress_pos_gen(data,NULL,NULL,pos,prec_hi,prec_lo,NULL);
 }
 
-static int tng_compress_uncompress_vel_gen(char *data,double *veld,float *velf,int *veli,unsigned long *prec_hi, unsigned long *prec_lo)
+static int tng_compress_uncompress_vel_gen(char *data,double *veld,float *velf,int *veli,unsigned long *prec_hi, unsigned long *prec_lo,
+                                           struct tng_compress_scratch *scratch)
 {
   int bufloc=0;
   int length;
@@ -1690,7 +1652,12 @@ static int tng_compress_uncompress_vel_gen(char *data,double *veld,float *velf,i
   *prec_hi=readbufferfix((unsigned char *)data+bufloc,4);
   bufloc+=4;
   /* Allocate the memory for the quantized positions */
-  quant=malloc(natoms*nframes*3*sizeof *quant);
+  quant=scratch_quant_get(scratch,(size_t)natoms*nframes*3);
+  if (!quant)
+    {
+      rval=1;
+      goto error;
+    }
   /* The data block length. */
   length=(int)readbufferfix((unsigned char *)data+bufloc,4);
   bufloc+=4;
@@ -1752,25 +1719,133 @@ static int tng_compress_uncompress_vel_gen(char *data,double *veld,float *velf,i
         }
     }
  error:
-  free(quant);
+  if (!scratch)
+    free(quant);
   return rval;
 }
 
 static int tng_compress_uncompress_vel(char *data,double *vel)
 {
   unsigned long prec_hi, prec_lo;
-  return tng_compress_uncompress_vel_gen(data,vel,NULL,NULL,&prec_hi,&prec_lo);
+  return tng_compress_uncompress_vel_gen(data,vel,NULL,NULL,&prec_hi,&prec_lo,NULL);
 }
 
 static int tng_compress_uncompress_vel_float(char *data,float *vel)
 {
   unsigned long prec_hi, prec_lo;
-  return tng_compress_uncompress_vel_gen(data,NULL,vel,NULL,&prec_hi,&prec_lo);
+  return tng_compress_uncompress_vel_gen(data,NULL,vel,NULL,&prec_hi,&prec_lo,NULL);
 }
 
 static int tng_compress_uncompress_vel_int(char *data,int *vel, unsigned long *prec_hi, unsigned long *prec_lo)
 {
-  return tng_compress_uncompress_vel_gen(data,NULL,NULL,vel,prec_hi,prec_lo);
+  return tng_compress_uncompress_vel_gen(data,NULL,NULL,vel,prec_hi,prec_lo,NULL);
+}
+
+/* Uncompress a single (non keyframe) block into the one output array that is not NULL. */
+static int uncompress_block_gen(char *data,double *posvel_d,float *posvel_f,int *posvel_i,
+                                unsigned long *prec_hi, unsigned long *prec_lo,
+                                struct tng_compress_scratch *scratch)
+{
+  int magic_int;
+  magic_int=(int)readbufferfix((unsigned char *)data,4);
+  if (magic_int==MAGIC_INT_POS)
+    return tng_compress_uncompress_pos_gen(data,posvel_d,posvel_f,posvel_i,prec_hi,prec_lo,scratch);
+  else if (magic_int==MAGIC_INT_VEL)
+    return tng_compress_uncompress_vel_gen(data,posvel_d,posvel_f,posvel_i,prec_hi,prec_lo,scratch);
+  else
+    return 1;
+}
+
+/* Uncompress the frames of a single block, whose first frame is block_first_frame,
+   that overlap the frames first_frame to first_frame+nframes-1. */
+static int uncompress_block_frames_gen(char *data,const int block_first_frame,
+                                       const int first_frame,const int nframes,
+                                       double *posvel_d,float *posvel_f,int *posvel_i,
+                                       unsigned long *prec_hi, unsigned long *prec_lo,
+                                       struct tng_compress_scratch *scratch)
+{
+  int vel, natoms, block_nframes, lo, hi, rval;
+  int algo[4];
+  double precision;
+  size_t elem_size, frame_size;
+  char *out, *tmp;
+  if (tng_compress_inquire(data,&vel,&natoms,&block_nframes,&precision,algo))
+    return 1;
+  lo=first_frame>block_first_frame ? first_frame : block_first_frame;
+  hi=first_frame+nframes<block_first_frame+block_nframes ?
+    first_frame+nframes : block_first_frame+block_nframes;
+  if (lo>=hi)
+    return 0;
+  if (posvel_d)
+    elem_size=sizeof *posvel_d;
+  else if (posvel_f)
+    elem_size=sizeof *posvel_f;
+  else
+    elem_size=sizeof *posvel_i;
+  frame_size=(size_t)natoms*3*elem_size;
+  if (posvel_d)
+    out=(char *)posvel_d;
+  else if (posvel_f)
+    out=(char *)posvel_f;
+  else
+    out=(char *)posvel_i;
+  out+=(size_t)(lo-first_frame)*frame_size;
+  /* Decode directly into the output if all frames of the block are wanted. */
+  if ((lo==block_first_frame) && (hi==block_first_frame+block_nframes))
+    return uncompress_block_gen(data,
+                                posvel_d ? (double *)out : NULL,
+                                posvel_f ? (float *)out : NULL,
+                                posvel_i ? (int *)out : NULL,
+                                prec_hi,prec_lo,scratch);
+  tmp=scratch_frames_get(scratch,block_nframes*frame_size);
+  if (!tmp)
+    return 1;
+  rval=uncompress_block_gen(data,
+                            posvel_d ? (double *)tmp : NULL,
+                            posvel_f ? (float *)tmp : NULL,
+                            posvel_i ? (int *)tmp : NULL,
+                            prec_hi,prec_lo,scratch);
+  if (!rval)
+    memcpy(out,tmp+(size_t)(lo-block_first_frame)*frame_size,(size_t)(hi-lo)*frame_size);
+  if (!scratch)
+    free(tmp);
+  return rval;
+}
+
+static int uncompress_frames_gen(char *data,const int first_frame,const int nframes,
+                                 double *posvel_d,float *posvel_f,int *posvel_i,
+                                 unsigned long *prec_hi, unsigned long *prec_lo,
+                                 struct tng_compress_scratch *scratch)
+{
+  int magic_int;
+  int total_nframes, keyframe_interval, nblocks, iblock;
+  magic_int=(int)readbufferfix((unsigned char *)data,4);
+  if (magic_int!=MAGIC_INT_KEYFRAMES)
+    {
+      int vel, natoms, algo[4];
+      double precision;
+      if (tng_compress_inquire(data,&vel,&natoms,&total_nframes,&precision,algo) ||
+          (first_frame<0) || (nframes<0) || (first_frame+nframes>total_nframes))
+        return 1;
+      return uncompress_block_frames_gen(data,0,first_frame,nframes,
+                                         posvel_d,posvel_f,posvel_i,prec_hi,prec_lo,scratch);
+    }
+  total_nframes=(int)readbufferfix((unsigned char *)data+4,4);
+  keyframe_interval=(int)readbufferfix((unsigned char *)data+8,4);
+  nblocks=(int)readbufferfix((unsigned char *)data+12,4);
+  if ((first_frame<0) || (nframes<0) || (first_frame+nframes>total_nframes) ||
+      (keyframe_interval<1))
+    return 1;
+  /* Only the blocks starting at the keyframes covering the requested frames are decoded. */
+  for (iblock=first_frame/keyframe_interval;
+       (iblock<nblocks) && (iblock*keyframe_interval<first_frame+nframes); iblock++)
+    {
+      int offset=(int)readbufferfix((unsigned char *)data+KEYFRAMES_HEADER_LEN+iblock*4,4);
+      if (uncompress_block_frames_gen(data+offset,iblock*keyframe_interval,first_frame,nframes,
+                                      posvel_d,posvel_f,posvel_i,prec_hi,prec_lo,scratch))
+        return 1;
+    }
+  return 0;
 }
 
 /* Uncompresses any tng compress block, positions or velocities. It determines whether it is positions or velocities from the data buffer. The return value is 0 if ok, and 1 if not.
@@ -1779,7 +1854,13 @@ int DECLSPECDLLEXPORT tng_compress_uncompress(char *data,double *posvel)
 {
   int magic_int;
   magic_int=(int)readbufferfix((unsigned char *)data,4);
-  if (magic_int==MAGIC_INT_POS)
+  if (magic_int==MAGIC_INT_KEYFRAMES)
+    {
+      unsigned long prec_hi, prec_lo;
+      return uncompress_frames_gen(data,0,(int)readbufferfix((unsigned char *)data+4,4),
+                                   posvel,NULL,NULL,&prec_hi,&prec_lo,NULL);
+    }
+  else if (magic_int==MAGIC_INT_POS)
     return tng_compress_uncompress_pos(data,posvel);
   else if (magic_int==MAGIC_INT_VEL)
     return tng_compress_uncompress_vel(data,posvel);
@@ -1791,7 +1872,13 @@ int DECLSPECDLLEXPORT tng_compress_uncompress_float(char *data,float *posvel)
 {
   int magic_int;
   magic_int=(int)readbufferfix((unsigned char *)data,4);
-  if (magic_int==MAGIC_INT_POS)
+  if (magic_int==MAGIC_INT_KEYFRAMES)
+    {
+      unsigned long prec_hi, prec_lo;
+      return uncompress_frames_gen(data,0,(int)readbufferfix((unsigned char *)data+4,4),
+                                   NULL,posvel,NULL,&prec_hi,&prec_lo,NULL);
+    }
+  else if (magic_int==MAGIC_INT_POS)
     return tng_compress_uncompress_pos_float(data,posvel);
   else if (magic_int==MAGIC_INT_VEL)
     return tng_compress_uncompress_vel_float(data,posvel);
@@ -1803,7 +1890,10 @@ int DECLSPECDLLEXPORT tng_compress_uncompress_int(char *data,int *posvel, unsign
 {
   int magic_int;
   magic_int=(int)readbufferfix((unsigned char *)data,4);
-  if (magic_int==MAGIC_INT_POS)
+  if (magic_int==MAGIC_INT_KEYFRAMES)
+    return uncompress_frames_gen(data,0,(int)readbufferfix((unsigned char *)data+4,4),
+                                 NULL,NULL,posvel,prec_hi,prec_lo,NULL);
+  else if (magic_int==MAGIC_INT_POS)
     return tng_compress_uncompress_pos_int(data,posvel,prec_hi,prec_lo);
   else if (magic_int==MAGIC_INT_VEL)
     return tng_compress_uncompress_vel_int(data,posvel,prec_hi,prec_lo);
@@ -1811,6 +1901,51 @@ int DECLSPECDLLEXPORT tng_compress_uncompress_int(char *data,int *posvel, unsign
     return 1;
 }
 
+int DECLSPECDLLEXPORT tng_compress_uncompress_scratch(char *data,double *posvel,
+                                                      struct tng_compress_scratch *scratch)
+{
+  unsigned long prec_hi, prec_lo;
+  int magic_int;
+  magic_int=(int)readbufferfix((unsigned char *)data,4);
+  if (magic_int==MAGIC_INT_KEYFRAMES)
+    return uncompress_frames_gen(data,0,(int)readbufferfix((unsigned char *)data+4,4),
+                                 posvel,NULL,NULL,&prec_hi,&prec_lo,scratch);
+  return uncompress_block_gen(data,posvel,NULL,NULL,&prec_hi,&prec_lo,scratch);
+}
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_float_scratch(char *data,float *posvel,
+                                                            struct tng_compress_scratch *scratch)
+{
+  unsigned long prec_hi, prec_lo;
+  int magic_int;
+  magic_int=(int)readbufferfix((unsigned char *)data,4);
+  if (magic_int==MAGIC_INT_KEYFRAMES)
+    return uncompress_frames_gen(data,0,(int)readbufferfix((unsigned char *)data+4,4),
+                                 NULL,posvel,NULL,&prec_hi,&prec_lo,scratch);
+  return uncompress_block_gen(data,NULL,posvel,NULL,&prec_hi,&prec_lo,scratch);
+}
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_frames(char *data,const int first_frame,
+                                                     const int nframes,double *posvel)
+{
+  unsigned long prec_hi, prec_lo;
+  return uncompress_frames_gen(data,first_frame,nframes,posvel,NULL,NULL,&prec_hi,&prec_lo,NULL);
+}
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_frames_float(char *data,const int first_frame,
+                                                           const int nframes,float *posvel)
+{
+  unsigned long prec_hi, prec_lo;
+  return uncompress_frames_gen(data,first_frame,nframes,NULL,posvel,NULL,&prec_hi,&prec_lo,NULL);
+}
+
+int DECLSPECDLLEXPORT tng_compress_uncompress_frames_int(char *data,const int first_frame,
+                                                         const int nframes,int *posvel,
+                                                         unsigned long *prec_hi, unsigned long *prec_lo)
+{
+  return uncompress_frames_gen(data,first_frame,nframes,NULL,NULL,posvel,prec_hi,prec_lo,NULL);
+}
+
 void DECLSPECDLLEXPORT tng_compress_int_to_double(int *posvel_int, const unsigned long prec_hi, const unsigned long prec_lo,
                                                   const int natoms, const int nframes,
                                                   double *posvel_double)
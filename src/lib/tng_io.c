@@ -29,6 +29,22 @@
 #include <time.h>
 #include <math.h>
 #include <zlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define TNG_HAVE_TSC
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define TNG_HAVE_TSC
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 
 #include "tng/md5.h"
 #include "compression/tng_compress.h"
@@ -59,10 +75,11 @@ struct tng_atom {
     tng_residue_t residue;
     /** A unique (per molecule) ID number of the atom */
     int64_t id;
-    /** The atom_type (depending on the forcefield) */
-    char *atom_type;
-    /** The name of the atom */
-    char *name;
+    /** The atom_type (depending on the forcefield), stored in the string
+     *  pool of the trajectory */
+    const char *atom_type;
+    /** The name of the atom, stored in the string pool of the trajectory */
+    const char *name;
 };
 
 struct tng_residue {
@@ -70,8 +87,9 @@ struct tng_residue {
     tng_chain_t chain;
     /** A unique (per chain) ID number of the residue */
     int64_t id;
-    /** The name of the residue */
-    char *name;
+    /** The name of the residue, stored in the string pool of the
+     *  trajectory */
+    const char *name;
     /** The number of atoms in the residue */
     int64_t n_atoms;
     /** A list of atoms in the residue */
@@ -83,8 +101,8 @@ struct tng_chain {
     tng_molecule_t molecule;
     /** A unique (per molecule) ID number of the chain */
     int64_t id;
-    /** The name of the chain */
-    char *name;
+    /** The name of the chain, stored in the string pool of the trajectory */
+    const char *name;
     /** The number of residues in the chain */
     int64_t n_residues;
     /** A list of residues in the chain */
@@ -109,8 +127,9 @@ struct tng_molecule {
     /** The number of bonds in the molecule. If the bonds are not specified this
      * value can be 0. */
     int64_t n_bonds;
-    /** The name of the molecule */
-    char *name;
+    /** The name of the molecule, stored in the string pool of the
+     *  trajectory */
+    const char *name;
     /** A list of chains in the molecule */
     tng_chain_t chains;
     /** A list of residues in the molecule */
@@ -119,6 +138,39 @@ struct tng_molecule {
     tng_atom_t atoms;
     /** A list of the bonds in the molecule */
     tng_bond_t bonds;
+    /** The number of chains that fit in the memory allocated for chains */
+    int64_t chains_capacity;
+    /** The number of residues that fit in the memory allocated for
+     *  residues */
+    int64_t residues_capacity;
+    /** The number of atoms that fit in the memory allocated for atoms */
+    int64_t atoms_capacity;
+    /** The number of bonds that fit in the memory allocated for bonds */
+    int64_t bonds_capacity;
+};
+
+/** The minimum size of a memory chunk of a string pool */
+#define TNG_STRING_POOL_CHUNK_SIZE 4096
+
+struct tng_string_pool_chunk {
+    /** The previously allocated chunk */
+    struct tng_string_pool_chunk *next;
+    /** The number of bytes used in the chunk */
+    size_t used;
+    /** The number of bytes available in the chunk. The strings are stored
+     *  directly after this header */
+    size_t size;
+};
+
+struct tng_string_pool {
+    /** The number of different strings in the pool */
+    int64_t n_strings;
+    /** The number of slots in the hash table, always a power of 2 */
+    int64_t table_size;
+    /** Hash table (using linear probing) of the strings in the pool */
+    const char **table;
+    /** The memory chunks holding the strings */
+    struct tng_string_pool_chunk *chunks;
 };
 
 struct tng_gen_block {
@@ -163,6 +215,11 @@ struct tng_trajectory_frame_set {
     int64_t n_mapping_blocks;
     /** The atom mappings of this frame set */
     struct tng_particle_mapping *mappings;
+    /** The real particle number of each particle in this frame set, built
+     *  from the mapping blocks when first needed (0 if not built) */
+    int64_t *mapping_table;
+    /** The number of particles in mapping_table */
+    int64_t mapping_table_n_particles;
     /** The first frame of this frame set */
     int64_t first_frame;
     /** The number of frames in this frame set */
@@ -243,6 +300,108 @@ struct tng_data {
 };
 
 
+struct tng_data_iterator {
+    /** The ID of the data block to iterate over */
+    int64_t block_id;
+    /** The last frame of the interval */
+    int64_t end_frame_nr;
+    /** The first frame that has not been visited yet */
+    int64_t next_frame_nr;
+    /** The file position of the frame set that was last read by the
+     *  iterator, -1 if none has been read yet */
+    int64_t frame_set_file_pos;
+    /** The input file of that frame set, if the trajectory is split into
+     *  several input files */
+    int64_t input_segment;
+    /** TNG_TRUE if the data block is present in that frame set */
+    tng_bool has_data;
+    /** Whether to use the md5 hash when reading data blocks */
+    char hash_mode;
+    /** One frame of particle data translated to real particle numbering */
+    void *frame_values;
+    /** The size of frame_values in bytes */
+    int64_t frame_values_size;
+};
+
+struct tng_data_series_block {
+    /** The contents of the data block, as read from the file */
+    char *contents;
+    /** The length of contents */
+    int64_t contents_len;
+    /** The position of the data values in contents */
+    int64_t data_offset;
+    /** The length of the data values when uncompressed */
+    int64_t data_len;
+    /** ID of the CODEC used for compression */
+    int64_t codec_id;
+    /** The index of the first frame with data to extract from the block */
+    int64_t first_value;
+    /** The number of frames with data to extract from the block */
+    int64_t n_frames;
+    /** The frame number of the first frame to extract */
+    int64_t first_frame_nr;
+    /** The number of frames between each data point */
+    int64_t stride_length;
+    /** The position of the first extracted frame in the output */
+    int64_t output_offset;
+    /** The md5 hash of the block contents */
+    char md5_hash[TNG_MD5_HASH_LEN];
+};
+
+struct tng_block_encoding {
+    /** The data block to encode, or NULL if encoding a particle mapping block */
+    tng_data_t data;
+    /** TNG_TRUE if the data block contains particle data */
+    tng_bool is_particle_data;
+    /** The particle mapping block to encode, or the particle mapping relevant
+     *  for the data block (particle data only) */
+    tng_particle_mapping_t mapping;
+    /** The block, containing the block header */
+    tng_gen_block_t block;
+    /** ID of the CODEC used for compression */
+    int64_t codec_id;
+    /** TNG_TRUE if the block has been encoded */
+    tng_bool is_encoded;
+    /** The result of encoding the block */
+    tng_function_status stat;
+    /** The encoded block, including its block header */
+    char *encoded;
+    /** The length of the encoded block */
+    int64_t encoded_len;
+};
+
+struct tng_input_segment {
+    /** The path of the file */
+    char *path;
+    /** A handle to the file, or NULL if it is not open */
+    FILE *file;
+    /** The length of the file */
+    int64_t file_len;
+    /** The first frame in the file */
+    int64_t first_frame;
+    /** The number of frames from the first frame to the end of the file */
+    int64_t n_frames;
+    /** The number of frame sets in the file */
+    int64_t n_frame_sets;
+    /** The pos in the file of the first frame set */
+    int64_t first_frame_set_pos;
+    /** The pos in the file of the last frame set */
+    int64_t last_frame_set_pos;
+    /** The number of frames in each frame set, as set in the file */
+    int64_t frame_set_n_frames;
+    /** The number of frame sets in a medium stride step, as set in the file */
+    int64_t medium_stride_length;
+    /** The number of frame sets in a long stride step, as set in the file */
+    int64_t long_stride_length;
+    /** Function to swap 32 bit values from the endianness of the file */
+    tng_function_status (*endianness_swap_func_32)(const tng_trajectory_t, uint32_t *);
+    /** Function to swap 64 bit values from the endianness of the file */
+    tng_function_status (*endianness_swap_func_64)(const tng_trajectory_t, uint64_t *);
+    /** When the file was last used, for closing the least recently used
+     *  files first */
+    int64_t last_used;
+};
+
 struct tng_trajectory {
     /** The path of the input trajectory file */
     char *input_file_path;
@@ -250,6 +409,33 @@ struct tng_trajectory {
     FILE *input_file;
     /** The length of the input file */
     int64_t input_file_len;
+    /** A buffer for reading block headers, which are read from the input
+     *  file all at once and then decoded */
+    char *input_header_buffer;
+    /** The size of input_header_buffer */
+    int64_t input_header_buffer_size;
+    /** Scratch memory for uncompressing TNG and XTC compressed blocks, reused
+     *  between blocks */
+    struct tng_compress_scratch *compress_scratch;
+    /** A buffer for uncompressed data that cannot be uncompressed directly
+     *  into the data arrays, reused between blocks */
+    char *uncompress_buffer;
+    /** The size of uncompress_buffer */
+    int64_t uncompress_buffer_size;
+    /** The files of a trajectory split into several input files, in the
+     *  order of their frames (NULL if it is read from one file). One of them
+     *  at a time is used as input_file. */
+    struct tng_input_segment *input_segments;
+    /** The number of files in input_segments */
+    int64_t n_input_segments;
+    /** The index of the file in input_segments used as input_file */
+    int64_t current_input_segment;
+    /** The number of files in input_segments that are open */
+    int64_t n_open_input_segments;
+    /** The maximum number of files in input_segments to keep open */
+    int64_t max_open_input_segments;
+    /** The number of times files in input_segments have been used */
+    int64_t input_segment_use_count;
     /** The path of the output trajectory file */
     char *output_file_path;
     /** A handle to the output file */
@@ -319,6 +505,42 @@ struct tng_trajectory {
     /** A list of the count of each molecule - if using variable number of
      *  particles this will be specified in each frame set */
     int64_t *molecule_cnt_list;
+    /** The number of molecules that fit in the memory allocated for
+     *  molecules and molecule_cnt_list */
+    int64_t molecules_capacity;
+    /** The names and atom types of the molecular system. Each different
+     *  string is only stored once (0 until the first string is added) */
+    struct tng_string_pool *name_pool;
+    /** The number of trajectories sharing the molecules (and name_pool),
+     *  allocated together with the molecules. The molecular system is
+     *  copied before modifying it if it is shared */
+    int64_t *molecules_ref_count;
+    /** The molecular system (molecules, their number, their names and their
+     *  reference count) that was used before the last copy-on-write. A
+     *  reference to it is kept, so that molecules, chains, residues and atoms
+     *  retrieved before the copy can still be found in the copy */
+    tng_molecule_t detached_molecules;
+    int64_t n_detached_molecules;
+    struct tng_string_pool *detached_name_pool;
+    int64_t *detached_molecules_ref_count;
+    /** The number of the first particle of each molecule type, followed by
+     *  the total number of particles, for finding the molecule of a
+     *  particle. Built when first needed (0 if not built) */
+    int64_t *topology_particle_offsets;
+    /** The number of residues before the first molecule of each molecule
+     *  type. Built together with topology_particle_offsets */
+    int64_t *topology_residue_offsets;
+    /** The bonded neighbours of all particles in compressed sparse row
+     *  format: the neighbours of particle i are connectivity_neighbors
+     *  [connectivity_offsets[i]] to connectivity_neighbors
+     *  [connectivity_offsets[i + 1] - 1]. Built when first needed and freed
+     *  together with the topology index (0 if not built) */
+    int64_t *connectivity_offsets;
+    int64_t *connectivity_neighbors;
+    /** The same as connectivity_offsets and connectivity_neighbors, but
+     *  using 32 bit integers. Built when first needed (0 if not built) */
+    int32_t *connectivity_offsets_32;
+    int32_t *connectivity_neighbors_32;
     /** The total number of particles/atoms. If using variable number of
      *  particles this will be specified in each frame set */
     int64_t n_particles;
@@ -358,6 +580,34 @@ struct tng_trajectory {
     int *compress_algo_vel;
     /** The precision used for lossy compression */
     double compression_precision;
+    /** The number of frames between keyframes in TNG compressed blocks
+     *  (0 if the whole block is compressed as one stream) */
+    int64_t compression_keyframe_interval;
+    /** The number of particles used when determining the TNG compression
+     *  algorithm (0 to use all particles) */
+    int64_t compression_algo_sample_n_particles;
+    /** If TNG_TRUE the TNG compression algorithms are stored in the
+     *  general info block */
+    char compress_algo_store;
+    /** The position of the compression algorithms block in the output file,
+     *  0 if the file has no such block or -1 if it has not been looked for */
+    int64_t compress_algo_block_output_file_pos;
+
+    /** If TNG_TRUE statistics of the file I/O and compression are collected */
+    char statistics_enabled;
+    /** The statistics collected since they were enabled or reset */
+    struct tng_statistics statistics;
+    /** The statistics counted by the other threads of the OpenMP parallel
+     *  regions of the library, one per thread after the first */
+    struct tng_statistics *thread_statistics;
+    /** The number of threads in thread_statistics */
+    int n_thread_statistics;
+    /** If TNG_TRUE the threads count their statistics in thread_statistics */
+    char thread_statistics_active;
+    /** The ticks when the statistics were enabled or reset */
+    int64_t statistics_start_ticks;
+    /** The time (in seconds) when the statistics were enabled or reset */
+    double statistics_start_time;
 };
 
 #ifndef USE_WINDOWS
@@ -389,6 +639,303 @@ static TNG_INLINE int64_t tng_max_i64(const int64_t a, const int64_t b)
     return (a > b ? a : b);
 }
 
+/**
+ * @brief Atomically add a value to a reference count, so that trajectories
+ * sharing data can be created and destroyed in different threads.
+ * @param count is the reference count.
+ * @param delta is the value to add.
+ * @return The new value of the reference count.
+ */
+static TNG_INLINE int64_t tng_ref_count_add(int64_t *count, const int64_t delta)
+{
+#if defined(__GNUC__)
+    return(__atomic_add_fetch(count, delta, __ATOMIC_ACQ_REL));
+#elif defined(_MSC_VER)
+    return(_InterlockedExchangeAdd64((volatile __int64 *)count, delta) + delta);
+#else
+    *count += delta;
+    return(*count);
+#endif
+}
+
+/**
+ * @brief Get the current time in ticks, for the statistics of a trajectory.
+ * @return The time stamp counter of x86 processors, or the processor time
+ * used by the program (from clock()) on other processors.
+ */
+static TNG_INLINE int64_t tng_ticks_get(void)
+{
+#ifdef TNG_HAVE_TSC
+    return((int64_t)__rdtsc());
+#else
+    return((int64_t)clock());
+#endif
+}
+
+/**
+ * @brief Get the current time in seconds, for calibrating the ticks of the
+ * statistics of a trajectory.
+ * @return The current time or 0 if it is not available.
+ */
+static double tng_statistics_time_get(void)
+{
+#ifdef TIME_UTC
+    struct timespec ts;
+
+    if(timespec_get(&ts, TIME_UTC) == TIME_UTC)
+    {
+        return((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+    }
+#endif
+    return(0);
+}
+
+/**
+ * @brief Add to a statistics counter of a trajectory, if statistics are
+ * enabled.
+ * @param tng_data is a trajectory data container.
+ * @param counter is the counter in tng_data->statistics.
+ * @param n is the value to add.
+ * @details Blocks of one trajectory can be encoded and decoded by several
+ * OpenMP threads. Between tng_statistics_threads_begin() and
+ * tng_statistics_threads_end() each thread after the first counts in its
+ * own copy of the statistics, so that the counters are not shared between
+ * threads. The copies are added up by tng_statistics_get().
+ */
+static TNG_INLINE void tng_statistics_count(const tng_trajectory_t tng_data,
+                                            int64_t *counter,
+                                            const int64_t n)
+{
+#ifdef _OPENMP
+    int thread;
+#endif
+
+    if(tng_data->statistics_enabled)
+    {
+#ifdef _OPENMP
+        if(tng_data->thread_statistics_active)
+        {
+            thread = omp_get_thread_num();
+            if(thread > 0)
+            {
+                /* The same counter in the statistics of this thread */
+                counter = (int64_t *)((char *)&tng_data->thread_statistics[thread - 1] +
+                                      ((char *)counter -
+                                       (char *)&tng_data->statistics));
+            }
+        }
+#endif
+        *counter += n;
+    }
+}
+
+/**
+ * @brief Let the threads of the next OpenMP parallel region count the
+ * statistics of a trajectory in their own copies of the statistics.
+ * @param tng_data is a trajectory data container.
+ * @details Must be called outside of the parallel region, and
+ * tng_statistics_threads_end() must be called after it.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured (memory allocation failure).
+ */
+static tng_function_status tng_statistics_threads_begin(const tng_trajectory_t tng_data)
+{
+#ifdef _OPENMP
+    struct tng_statistics *temp;
+    int n_threads = omp_get_max_threads() - 1;
+
+    if(!tng_data->statistics_enabled)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    if(n_threads > tng_data->n_thread_statistics)
+    {
+        temp = realloc(tng_data->thread_statistics,
+                       sizeof(struct tng_statistics) * n_threads);
+        if(!temp)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+        memset(temp + tng_data->n_thread_statistics, 0,
+               sizeof(struct tng_statistics) *
+               (n_threads - tng_data->n_thread_statistics));
+        tng_data->thread_statistics = temp;
+        tng_data->n_thread_statistics = n_threads;
+    }
+    tng_data->thread_statistics_active = TNG_TRUE;
+#else
+    (void)tng_data;
+#endif
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Count the statistics of a trajectory in tng_data->statistics
+ * again, after an OpenMP parallel region.
+ * @param tng_data is a trajectory data container.
+ */
+static void tng_statistics_threads_end(const tng_trajectory_t tng_data)
+{
+    tng_data->thread_statistics_active = TNG_FALSE;
+}
+
+/**
+ * @brief Start timing an operation for the statistics of a trajectory.
+ * @param tng_data is a trajectory data container.
+ * @return The current time in ticks, or 0 if statistics are not enabled.
+ */
+static TNG_INLINE int64_t tng_statistics_timer_start(const tng_trajectory_t tng_data)
+{
+    return(tng_data->statistics_enabled ? tng_ticks_get() : 0);
+}
+
+/**
+ * @brief Stop timing an operation for the statistics of a trajectory.
+ * @param tng_data is a trajectory data container.
+ * @param ticks is the time counter in tng_data->statistics to which to add
+ * the time of the operation.
+ * @param start is the time returned by tng_statistics_timer_start().
+ */
+static TNG_INLINE void tng_statistics_timer_stop(const tng_trajectory_t tng_data,
+                                                 int64_t *ticks,
+                                                 const int64_t start)
+{
+    if(tng_data->statistics_enabled)
+    {
+        tng_statistics_count(tng_data, ticks, tng_ticks_get() - start);
+    }
+}
+
+/**
+ * @brief Add statistics counters to others, except ticks_per_second.
+ * @param d is the statistics to which to add.
+ * @param s is the statistics to add.
+ */
+static void tng_statistics_add(struct tng_statistics *d,
+                               const struct tng_statistics *s)
+{
+    d->bytes_read += s->bytes_read;
+    d->bytes_written += s->bytes_written;
+    d->n_seeks += s->n_seeks;
+    d->n_block_headers_read += s->n_block_headers_read;
+    d->n_frame_sets_read += s->n_frame_sets_read;
+    d->n_frame_set_searches += s->n_frame_set_searches;
+    d->n_allocations += s->n_allocations;
+    d->md5_ticks += s->md5_ticks;
+    d->compress_ticks += s->compress_ticks;
+    d->uncompress_ticks += s->uncompress_ticks;
+    d->gzip_compress_ticks += s->gzip_compress_ticks;
+    d->gzip_uncompress_ticks += s->gzip_uncompress_ticks;
+    d->byte_swap_ticks += s->byte_swap_ticks;
+}
+
+/**
+ * @brief Add the statistics of a trajectory to those of another, e.g. to
+ * collect the statistics of trajectory containers used in different threads.
+ * @param dest is the trajectory to which to add the statistics.
+ * @param src is the trajectory of which to add the statistics.
+ */
+static void tng_statistics_merge(const tng_trajectory_t dest,
+                                 const tng_trajectory_t src)
+{
+    struct tng_statistics s;
+
+    if(!dest->statistics_enabled || !src->statistics_enabled)
+    {
+        return;
+    }
+
+    tng_statistics_get(src, &s);
+    tng_statistics_add(&dest->statistics, &s);
+}
+
+/**
+ * @brief Read from a file of a trajectory, like fread(), counting the bytes
+ * read in the statistics.
+ * @param tng_data is a trajectory data container.
+ * @param ptr is where to store the data.
+ * @param size is the size of each item.
+ * @param n is the number of items.
+ * @param file is the file to read from.
+ * @return The number of items read.
+ */
+static TNG_INLINE size_t tng_fread(const tng_trajectory_t tng_data,
+                                   void *ptr,
+                                   const size_t size,
+                                   const size_t n,
+                                   FILE *file)
+{
+    size_t n_read = fread(ptr, size, n, file);
+
+    tng_statistics_count(tng_data, &tng_data->statistics.bytes_read,
+                         (int64_t)(n_read * size));
+    return(n_read);
+}
+
+/**
+ * @brief Write to a file of a trajectory, like fwrite(), counting the bytes
+ * written in the statistics.
+ * @param tng_data is a trajectory data container.
+ * @param ptr is the data to write.
+ * @param size is the size of each item.
+ * @param n is the number of items.
+ * @param file is the file to write to.
+ * @return The number of items written.
+ */
+static TNG_INLINE size_t tng_fwrite(const tng_trajectory_t tng_data,
+                                    const void *ptr,
+                                    const size_t size,
+                                    const size_t n,
+                                    FILE *file)
+{
+    size_t n_written = fwrite(ptr, size, n, file);
+
+    tng_statistics_count(tng_data, &tng_data->statistics.bytes_written,
+                         (int64_t)(n_written * size));
+    return(n_written);
+}
+
+/**
+ * @brief Seek in a file of a trajectory, like fseeko(), counting the seek in
+ * the statistics.
+ * @param tng_data is a trajectory data container.
+ * @param file is the file in which to seek.
+ * @param offset is the offset from whence.
+ * @param whence is SEEK_SET, SEEK_CUR or SEEK_END.
+ * @return 0 if successful, otherwise -1.
+ */
+static TNG_INLINE int tng_fseeko(const tng_trajectory_t tng_data,
+                                 FILE *file,
+                                 const int64_t offset,
+                                 const int whence)
+{
+    tng_statistics_count(tng_data, &tng_data->statistics.n_seeks, 1);
+    return(fseeko(file, offset, whence));
+}
+
+/**
+ * @brief Append data to an md5 hash, timing it in the statistics of a
+ * trajectory.
+ * @param tng_data is a trajectory data container.
+ * @param md5_state is the md5 storage.
+ * @param data is the data to append.
+ * @param len is the length of the data.
+ */
+static TNG_INLINE void tng_md5_append(const tng_trajectory_t tng_data,
+                                      md5_state_t *md5_state,
+                                      const md5_byte_t *data,
+                                      const int64_t len)
+{
+    int64_t start = tng_statistics_timer_start(tng_data);
+
+    md5_append(md5_state, data, (int)len);
+    tng_statistics_timer_stop(tng_data, &tng_data->statistics.md5_ticks, start);
+}
+
 /**
  * @brief This function swaps the byte order of a 32 bit numerical variable
  * to big endian.
@@ -580,972 +1127,1620 @@ static tng_function_status tng_swap_byte_order_little_endian_64
 }
 
 /**
- * @brief Read a NULL terminated string from a file.
- * @param tng_data is a trajectory data container
- * @param str is a pointer to the character string that will
- * contain the read string. *str is reallocated in the function
- * and must be NULL or pointing at already allocated memory.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
+ * @brief Reverse the byte order of a 32 bit value.
+ * @param v is the value.
+ * @return The value with its bytes in reversed order.
  */
-static tng_function_status tng_freadstr(const tng_trajectory_t tng_data,
-                                        char **str,
-                                        const char hash_mode,
-                                        md5_state_t *md5_state,
-                                        const int line_nr)
+static TNG_INLINE uint32_t tng_byte_reverse_32(const uint32_t v)
 {
-    char temp[TNG_MAX_STR_LEN], *temp_alloc;
-    int c, count = 0;
+#if defined(__GNUC__)
+    return(__builtin_bswap32(v));
+#elif defined(_MSC_VER)
+    return(_byteswap_ulong(v));
+#else
+    return(((v & 0xFF000000) >> 24) |
+           ((v & 0x00FF0000) >> 8) |
+           ((v & 0x0000FF00) << 8) |
+           ((v & 0x000000FF) << 24));
+#endif
+}
 
-    do
+/**
+ * @brief Reverse the byte order of a 64 bit value.
+ * @param v is the value.
+ * @return The value with its bytes in reversed order.
+ */
+static TNG_INLINE uint64_t tng_byte_reverse_64(const uint64_t v)
+{
+#if defined(__GNUC__)
+    return(__builtin_bswap64(v));
+#elif defined(_MSC_VER)
+    return(_byteswap_uint64(v));
+#else
+    return(((uint64_t)tng_byte_reverse_32((uint32_t)v) << 32) |
+           tng_byte_reverse_32((uint32_t)(v >> 32)));
+#endif
+}
+
+/**
+ * @brief Swap the byte order of an array of 32 bit numerical values, in
+ * place, using a byte order swapping function of the trajectory.
+ * @param tng_data is a trajectory data container.
+ * @param swap_func is the function swapping the byte order of one value,
+ * i.e. tng_data->input_endianness_swap_func_32 or
+ * tng_data->output_endianness_swap_func_32 (if NULL nothing is done).
+ * @param values is the array of values (floats or integers).
+ * @param n_values is the number of values in the array.
+ * @details Converting between big and little endian, which is by far the
+ * most common case, reverses the bytes of whole vectors of values at a time
+ * instead of calling swap_func for each value.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the current
+ * byte order is not recognised.
+ */
+static tng_function_status tng_swap_byte_order_array_32
+                (const tng_trajectory_t tng_data,
+                 tng_function_status (*swap_func)(const tng_trajectory_t, uint32_t *),
+                 void *values,
+                 const int64_t n_values)
+{
+    uint32_t *v = (uint32_t *)values;
+    int64_t i = 0, start;
+#ifdef __SSSE3__
+    const __m128i reverse = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                          11, 10, 9, 8, 15, 14, 13, 12);
+#endif
+
+    if(!swap_func)
     {
-        c = fgetc(tng_data->input_file);
+        return(TNG_SUCCESS);
+    }
 
-        if (c == EOF)
+    start = tng_statistics_timer_start(tng_data);
+
+    if((swap_func == tng_swap_byte_order_big_endian_32 &&
+        tng_data->endianness_32 == TNG_LITTLE_ENDIAN_32) ||
+       (swap_func == tng_swap_byte_order_little_endian_32 &&
+        tng_data->endianness_32 == TNG_BIG_ENDIAN_32))
+    {
+#ifdef __SSSE3__
+        for(; i + 4 <= n_values; i += 4)
         {
-            /* Clear file error flag and return -1 if EOF is read.*/
-            clearerr(tng_data->input_file);
-            return TNG_FAILURE;
+            _mm_storeu_si128((__m128i *)(v + i),
+                             _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(v + i)),
+                                              reverse));
         }
-        else
+#endif
+        for(; i < n_values; i++)
         {
-            /* Cast c to char */
-            temp[count++] = (char) c;
+            v[i] = tng_byte_reverse_32(v[i]);
         }
-    } while ((temp[count-1] != '\0') && (count < TNG_MAX_STR_LEN));
-
-    temp_alloc = (char *)realloc(*str, count);
-    if(!temp_alloc)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, line_nr);
-        free(*str);
-        *str = 0;
-        return TNG_FAILURE;
+        tng_statistics_timer_stop(tng_data, &tng_data->statistics.byte_swap_ticks, start);
+        return(TNG_SUCCESS);
     }
-    *str = temp_alloc;
-
-    strncpy(*str, temp, count);
 
-    if(hash_mode == TNG_USE_HASH)
+    for(; i < n_values; i++)
     {
-        md5_append(md5_state, (md5_byte_t *)*str, count);
+        if(swap_func(tng_data, &v[i]) != TNG_SUCCESS)
+        {
+            return(TNG_FAILURE);
+        }
     }
-
-    return TNG_SUCCESS;
+    tng_statistics_timer_stop(tng_data, &tng_data->statistics.byte_swap_ticks, start);
+    return(TNG_SUCCESS);
 }
 
 /**
- * @brief Write a NULL terminated string to a file.
- * @param tng_data is a trajectory data container
- * @param str is a pointer to the character string should be written.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
+ * @brief Swap the byte order of an array of 64 bit numerical values, in
+ * place, using a byte order swapping function of the trajectory.
+ * @param tng_data is a trajectory data container.
+ * @param swap_func is the function swapping the byte order of one value,
+ * i.e. tng_data->input_endianness_swap_func_64 or
+ * tng_data->output_endianness_swap_func_64 (if NULL nothing is done).
+ * @param values is the array of values (doubles or integers).
+ * @param n_values is the number of values in the array.
+ * @details See tng_swap_byte_order_array_32().
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the current
+ * byte order is not recognised.
  */
-static TNG_INLINE tng_function_status tng_fwritestr(tng_trajectory_t tng_data,
-                                                const char *str,
-                                                const char hash_mode,
-                                                md5_state_t *md5_state,
-                                                const int line_nr)
-{
-    size_t len;
-
-    len = tng_min_size(strlen(str) + 1, TNG_MAX_STR_LEN);
+static tng_function_status tng_swap_byte_order_array_64
+                (const tng_trajectory_t tng_data,
+                 tng_function_status (*swap_func)(const tng_trajectory_t, uint64_t *),
+                 void *values,
+                 const int64_t n_values)
+{
+    uint64_t *v = (uint64_t *)values;
+    int64_t i = 0, start;
+#ifdef __SSSE3__
+    const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                                          15, 14, 13, 12, 11, 10, 9, 8);
+#endif
 
-    if(fwrite(str, len, 1, tng_data->output_file) != 1)
+    if(!swap_func)
     {
-        fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, line_nr);
-        return(TNG_CRITICAL);
+        return(TNG_SUCCESS);
     }
 
-    if(hash_mode == TNG_USE_HASH)
-    {
-        md5_append(md5_state, (md5_byte_t *)str, len);
-    }
+    start = tng_statistics_timer_start(tng_data);
 
+    if((swap_func == tng_swap_byte_order_big_endian_64 &&
+        tng_data->endianness_64 == TNG_LITTLE_ENDIAN_64) ||
+       (swap_func == tng_swap_byte_order_little_endian_64 &&
+        tng_data->endianness_64 == TNG_BIG_ENDIAN_64))
+    {
+#ifdef __SSSE3__
+        for(; i + 2 <= n_values; i += 2)
+        {
+            _mm_storeu_si128((__m128i *)(v + i),
+                             _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(v + i)),
+                                              reverse));
+        }
+#endif
+        for(; i < n_values; i++)
+        {
+            v[i] = tng_byte_reverse_64(v[i]);
+        }
+        tng_statistics_timer_stop(tng_data, &tng_data->statistics.byte_swap_ticks, start);
+        return(TNG_SUCCESS);
+    }
+
+    for(; i < n_values; i++)
+    {
+        if(swap_func(tng_data, &v[i]) != TNG_SUCCESS)
+        {
+            return(TNG_FAILURE);
+        }
+    }
+    tng_statistics_timer_stop(tng_data, &tng_data->statistics.byte_swap_ticks, start);
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Read a numerical value from file.
- * The byte order will be swapped if need be.
- * @param tng_data is a trajectory data container
- * @param dest is a pointer to where to store the read data.
- * @param len is the length (in bytes) of the numerical data type. Should
- * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
+ * @brief Make sure that an array has room for at least n_needed elements.
+ * The capacity is doubled when growing, so that adding elements one at a time
+ * only reallocates the array a logarithmic number of times.
+ * @param array is the array to grow (or NULL).
+ * @param capacity is a pointer to the number of elements that fit in array.
+ * It is updated if the array is grown.
+ * @param n_needed is the number of elements the array must have room for.
+ * @param element_size is the size of each element.
+ * @return The (possibly moved) array or NULL if memory could not be
+ * allocated, in which case array and capacity are left untouched.
  */
-static TNG_INLINE tng_function_status tng_file_input_numerical
-                (const tng_trajectory_t tng_data,
-                 void *dest,
-                 const size_t len,
-                 const char hash_mode,
-                 md5_state_t *md5_state,
-                 const int line_nr)
+static void *tng_array_grow(void *array,
+                            int64_t *capacity,
+                            const int64_t n_needed,
+                            const size_t element_size)
 {
-    if(fread(dest, len, 1, tng_data->input_file) == 0)
+    int64_t new_capacity;
+    void *new_array;
+
+    if(array && *capacity >= n_needed)
     {
-        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, line_nr);
-        return(TNG_CRITICAL);
+        return(array);
     }
-    if(hash_mode == TNG_USE_HASH)
+
+    new_capacity = *capacity > 4 ? *capacity : 4;
+    while(new_capacity < n_needed)
     {
-        md5_append(md5_state, (md5_byte_t *)dest, len);
+        new_capacity *= 2;
     }
-    switch(len)
+
+    new_array = realloc(array, element_size * new_capacity);
+    if(!new_array)
     {
-    case 8:
-        if(tng_data->input_endianness_swap_func_64 &&
-           tng_data->input_endianness_swap_func_64(tng_data, (uint64_t *)dest) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                    __FILE__, line_nr);
-        }
-        break;
-    case 4:
-        if(tng_data->input_endianness_swap_func_32 &&
-           tng_data->input_endianness_swap_func_32(tng_data, (uint32_t *)dest) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                    __FILE__, line_nr);
-        }
-        break;
-    default:
-        break;
+        return(0);
     }
+    *capacity = new_capacity;
 
-    return(TNG_SUCCESS);
+    return(new_array);
 }
 
 /**
- * @brief Write a numerical value to file.
- * The byte order will be swapped if need be.
- * @param tng_data is a trajectory data container
- * @param src is a pointer to the data to write.
- * @param len is the length (in bytes) of the numerical data type. Should
- * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
+ * @brief Calculate a hash (FNV-1a) of a string.
+ * @param str is the string.
+ * @param len is the number of characters of str to include.
+ * @return The hash value.
  */
-static TNG_INLINE tng_function_status tng_file_output_numerical
-                (const tng_trajectory_t tng_data,
-                 const void *src,
-                 const size_t len,
-                 const char hash_mode,
-                 md5_state_t *md5_state,
-                 const int line_nr)
+static TNG_INLINE uint32_t tng_string_hash(const char *str, const size_t len)
 {
-    uint32_t temp_i32;
-    uint64_t temp_i64;
+    uint32_t hash = 2166136261U;
+    size_t i;
 
-    switch(len)
+    for(i = 0; i < len; i++)
     {
-        case 8:
-            temp_i64 = *((uint64_t *)src);
-            if(tng_data->output_endianness_swap_func_64 &&
-            tng_data->output_endianness_swap_func_64(tng_data, &temp_i64) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                        __FILE__, line_nr);
-            }
-            if(fwrite(&temp_i64, len, 1, tng_data->output_file) != 1)
-            {
-                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
-                return(TNG_CRITICAL);
-            }
-            if(hash_mode == TNG_USE_HASH)
-            {
-                md5_append(md5_state, (md5_byte_t *)&temp_i64, len);
-            }
-            break;
-        case 4:
-            temp_i32 = *((uint32_t *)src);
-            if(tng_data->output_endianness_swap_func_32 &&
-            tng_data->output_endianness_swap_func_32(tng_data, &temp_i32) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                        __FILE__, line_nr);
-            }
-            if(fwrite(&temp_i32, len, 1, tng_data->output_file) != 1)
-            {
-                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
-                return(TNG_CRITICAL);
-            }
-            if(hash_mode == TNG_USE_HASH)
-            {
-                md5_append(md5_state, (md5_byte_t *)&temp_i32, len);
-            }
-            break;
-        default:
-            if(fwrite(src, len, 1, tng_data->output_file) != 1)
-            {
-                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
-                return(TNG_CRITICAL);
-            }
-            if(hash_mode == TNG_USE_HASH)
-            {
-                md5_append(md5_state, (md5_byte_t *)src, len);
-            }
-            break;
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619U;
     }
 
-    return(TNG_SUCCESS);
+    return(hash);
 }
 
 /**
- * @brief Generate the md5 hash of a block.
- * The hash is created based on the actual block contents.
- * @param block is a general block container.
- * @return TNG_SUCCESS (0) if successful.
+ * @brief Free a string pool and all strings stored in it.
+ * @param pool_p is a pointer to the string pool. *pool_p is set to NULL.
  */
-static tng_function_status tng_block_md5_hash_generate(const tng_gen_block_t block)
+static void tng_string_pool_free(struct tng_string_pool **pool_p)
 {
-    md5_state_t md5_state;
+    struct tng_string_pool *pool = *pool_p;
+    struct tng_string_pool_chunk *chunk, *next;
 
-    md5_init(&md5_state);
-    md5_append(&md5_state, (md5_byte_t *)block->block_contents,
-               (int)block->block_contents_size);
-    md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
+    if(!pool)
+    {
+        return;
+    }
 
-    return(TNG_SUCCESS);
+    for(chunk = pool->chunks; chunk; chunk = next)
+    {
+        next = chunk->next;
+        free(chunk);
+    }
+    if(pool->table)
+    {
+        free(pool->table);
+    }
+    free(pool);
+
+    *pool_p = 0;
 }
 
 /**
- * @brief If there is data left in the block read that to append that to the MD5 hash.
- * @param tng_data is a trajectory data container.
- * @param block is the data block that is being read.
- * @param start_pos is the file position where the block started.
- * @param md5_state is the md5 to which the md5 of the remaining block
- * will be appended.
+ * @brief Double the size of the hash table of a string pool.
+ * @param pool is the string pool.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_md5_remaining_append(const tng_trajectory_t tng_data,
-                                                    const tng_gen_block_t block,
-                                                    const int64_t start_pos,
-                                                    md5_state_t *md5_state)
+static tng_function_status tng_string_pool_table_grow(struct tng_string_pool *pool)
 {
-    int64_t curr_file_pos;
-    char *temp_data;
+    const char **new_table;
+    int64_t i, new_size, mask, slot;
 
-    curr_file_pos = ftello(tng_data->input_file);
-    if(curr_file_pos < start_pos + block->block_contents_size)
+    new_size = pool->table_size ? pool->table_size * 2 : 256;
+    mask = new_size - 1;
+
+    new_table = (const char **)calloc(new_size, sizeof(char *));
+    if(!new_table)
     {
-        temp_data = (char *)malloc(start_pos + block->block_contents_size - curr_file_pos);
-        if(!temp_data)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
-        if(fread(temp_data, start_pos + block->block_contents_size - curr_file_pos,
-                    1, tng_data->input_file) == 0)
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    for(i = 0; i < pool->table_size; i++)
+    {
+        if(pool->table[i])
         {
-            fprintf(stderr, "TNG library: Cannot read remaining part of block to generate MD5 sum. %s: %d\n", __FILE__, __LINE__);
-            free(temp_data);
-            return(TNG_CRITICAL);
+            slot = tng_string_hash(pool->table[i], strlen(pool->table[i])) & mask;
+            while(new_table[slot])
+            {
+                slot = (slot + 1) & mask;
+            }
+            new_table[slot] = pool->table[i];
         }
-        md5_append(md5_state, (md5_byte_t *)temp_data,
-                   start_pos + block->block_contents_size - curr_file_pos);
-        free(temp_data);
     }
 
+    if(pool->table)
+    {
+        free(pool->table);
+    }
+    pool->table = new_table;
+    pool->table_size = new_size;
+
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Open the input file if it is not already opened.
- * @param tng_data is a trajectory data container.
+ * @brief Get the copy of a string stored in a string pool, adding it to the
+ * pool if it is not already there. The strings are not freed until the pool
+ * is freed, so names that occur many times (such as the names of atoms in a
+ * solvent) only take memory once.
+ * @param pool_p is a pointer to the string pool. The pool is created if
+ * *pool_p is NULL.
+ * @param str is the string to look up. Strings longer than TNG_MAX_STR_LEN
+ * are truncated.
+ * @param interned is set to point at the stored string.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_input_file_init(const tng_trajectory_t tng_data)
+static tng_function_status tng_string_pool_intern(struct tng_string_pool **pool_p,
+                                                  const char *str,
+                                                  const char **interned)
 {
-    int64_t file_pos;
+    struct tng_string_pool *pool;
+    struct tng_string_pool_chunk *chunk;
+    size_t len, chunk_size;
+    int64_t slot, mask;
+    char *stored;
 
-    if(!tng_data->input_file)
+    len = tng_min_size(strlen(str), TNG_MAX_STR_LEN - 1);
+
+    if(!*pool_p)
     {
-        if(!tng_data->input_file_path)
+        *pool_p = (struct tng_string_pool *)calloc(1, sizeof(struct tng_string_pool));
+        if(!*pool_p)
         {
-            fprintf(stderr, "TNG library: No file specified for reading. %s: %d\n",
-                   __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
             return(TNG_CRITICAL);
         }
-        tng_data->input_file = fopen(tng_data->input_file_path, "rb");
-        if(!tng_data->input_file)
+    }
+    pool = *pool_p;
+
+    /* Keep the hash table at most half full. */
+    if((pool->n_strings + 1) * 2 > pool->table_size)
+    {
+        if(tng_string_pool_table_grow(pool) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
-                   tng_data->input_file_path, __FILE__, __LINE__);
             return(TNG_CRITICAL);
         }
     }
 
-    if(!tng_data->input_file_len)
+    mask = pool->table_size - 1;
+    slot = tng_string_hash(str, len) & mask;
+    while(pool->table[slot])
     {
-        file_pos = ftello(tng_data->input_file);
-        fseeko(tng_data->input_file, 0, SEEK_END);
-        tng_data->input_file_len = ftello(tng_data->input_file);
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        if(strncmp(pool->table[slot], str, len) == 0 && pool->table[slot][len] == 0)
+        {
+            *interned = pool->table[slot];
+            return(TNG_SUCCESS);
+        }
+        slot = (slot + 1) & mask;
     }
 
-    return(TNG_SUCCESS);
-}
-
-/**
- * @brief Open the output file if it is not already opened
- * @param tng_data is a trajectory data container.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_output_file_init(const tng_trajectory_t tng_data)
-{
-    if(!tng_data->output_file)
+    chunk = pool->chunks;
+    if(!chunk || chunk->size - chunk->used < len + 1)
     {
-        if(!tng_data->output_file_path)
+        chunk_size = len + 1 > TNG_STRING_POOL_CHUNK_SIZE ?
+                     len + 1 : TNG_STRING_POOL_CHUNK_SIZE;
+        chunk = (struct tng_string_pool_chunk *)malloc(sizeof(struct tng_string_pool_chunk) +
+                                                       chunk_size);
+        if(!chunk)
         {
-            fprintf(stderr, "TNG library: No file specified for writing. %s: %d\n",
-                   __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
             return(TNG_CRITICAL);
         }
+        chunk->used = 0;
+        chunk->size = chunk_size;
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+    }
 
-        tng_data->output_file = fopen(tng_data->output_file_path, "wb+");
+    stored = (char *)(chunk + 1) + chunk->used;
+    memcpy(stored, str, len);
+    stored[len] = 0;
+    chunk->used += len + 1;
+
+    pool->table[slot] = stored;
+    pool->n_strings++;
+
+    *interned = stored;
 
-        if(!tng_data->output_file)
-        {
-            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
-                   tng_data->output_file_path, __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
-    }
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Setup a file block container.
- * @param block_p a pointer to memory to initialise as a file block container.
- * @details Memory is allocated during initialisation.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Read a NULL terminated string from a file.
+ * @param tng_data is a trajectory data container
+ * @param str is a pointer to the character string that will
+ * contain the read string. *str is reallocated in the function
+ * and must be NULL or pointing at already allocated memory.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param md5_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
  */
-static tng_function_status tng_block_init(struct tng_gen_block **block_p)
+static tng_function_status tng_freadstr(const tng_trajectory_t tng_data,
+                                        char **str,
+                                        const char hash_mode,
+                                        md5_state_t *md5_state,
+                                        const int line_nr)
 {
-    tng_gen_block_t block;
+    char temp[TNG_MAX_STR_LEN], *temp_alloc;
+    int c, count = 0;
 
-    *block_p = (struct tng_gen_block *)malloc(sizeof(struct tng_gen_block));
-    if(!*block_p)
+    do
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-    }
+        c = fgetc(tng_data->input_file);
 
-    block = *block_p;
+        if (c == EOF)
+        {
+            /* Clear file error flag and return -1 if EOF is read.*/
+            clearerr(tng_data->input_file);
+            return TNG_FAILURE;
+        }
+        else
+        {
+            /* Cast c to char */
+            temp[count++] = (char) c;
+        }
+    } while ((temp[count-1] != '\0') && (count < TNG_MAX_STR_LEN));
 
-    block->id = -1;
-    /* Reset the md5_hash */
-    memset(block->md5_hash, '\0', TNG_MD5_HASH_LEN);
-    block->name = 0;
-    block->block_version = TNG_API_VERSION;
-    block->header_contents = 0;
-    block->header_contents_size = 0;
-    block->block_contents = 0;
-    block->block_contents_size = 0;
+    tng_statistics_count(tng_data, &tng_data->statistics.bytes_read, count);
 
-    return(TNG_SUCCESS);
+    temp_alloc = (char *)realloc(*str, count);
+    if(!temp_alloc)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, line_nr);
+        free(*str);
+        *str = 0;
+        return TNG_FAILURE;
+    }
+    *str = temp_alloc;
+
+    strncpy(*str, temp, count);
+
+    if(hash_mode == TNG_USE_HASH)
+    {
+        tng_md5_append(tng_data, md5_state, (md5_byte_t *)*str, count);
+    }
+
+    return TNG_SUCCESS;
 }
 
 /**
- * @brief Clean up a file block container.
- * @param block_p a pointer to the file block container to destroy.
- * @details All allocated memory in the data structure is freed, as well as
- * block_p itself.
- * @return TNG_SUCCESS (0) if successful.
+ * @brief Read a NULL terminated string from a file and store it in the
+ * string pool of the molecular system.
+ * @param tng_data is a trajectory data container
+ * @param str is a pointer to the character string that will point at the
+ * read string in the string pool. The previous string is not freed.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param md5_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
  */
-static tng_function_status tng_block_destroy(struct tng_gen_block **block_p)
+static tng_function_status tng_freadstr_interned(const tng_trajectory_t tng_data,
+                                                 const char **str,
+                                                 const char hash_mode,
+                                                 md5_state_t *md5_state,
+                                                 const int line_nr)
 {
-    tng_gen_block_t block = *block_p;
+    char temp[TNG_MAX_STR_LEN];
+    int c, count = 0;
 
-    if(!*block_p)
+    do
     {
-        return(TNG_SUCCESS);
-    }
+        c = fgetc(tng_data->input_file);
 
-/*     fprintf(stderr, "TNG library: Destroying block\n"); */
-    if(block->name)
-    {
-        free(block->name);
-        block->name = 0;
-    }
-    if(block->header_contents)
+        if (c == EOF)
+        {
+            /* Clear file error flag and return -1 if EOF is read.*/
+            clearerr(tng_data->input_file);
+            return TNG_FAILURE;
+        }
+        else
+        {
+            /* Cast c to char */
+            temp[count++] = (char) c;
+        }
+    } while ((temp[count-1] != '\0') && (count < TNG_MAX_STR_LEN));
+
+    tng_statistics_count(tng_data, &tng_data->statistics.bytes_read, count);
+
+    if(hash_mode == TNG_USE_HASH)
     {
-        free(block->header_contents);
-        block->header_contents = 0;
+        tng_md5_append(tng_data, md5_state, (md5_byte_t *)temp, count);
     }
-    if(block->block_contents)
+
+    temp[count-1] = 0;
+
+    if(tng_string_pool_intern(&tng_data->name_pool, temp, str) != TNG_SUCCESS)
     {
-        free(block->block_contents);
-        block->block_contents = 0;
+        fprintf(stderr, "TNG library: Cannot store string. %s: %d\n", __FILE__, line_nr);
+        return TNG_CRITICAL;
     }
 
-    free(*block_p);
-    *block_p = 0;
+    return TNG_SUCCESS;
+}
 
-    return(TNG_SUCCESS);
+/**
+ * @brief Get the number of bytes tng_fwritestr() writes for a string.
+ * @param str is a pointer to the character string (or NULL, which is
+ * written as an empty string).
+ * @return the length of the string, including the terminating NULL
+ * character, limited to TNG_MAX_STR_LEN.
+ */
+static TNG_INLINE size_t tng_str_written_len(const char *str)
+{
+    return(str ? tng_min_size(strlen(str) + 1, TNG_MAX_STR_LEN) : 1);
 }
 
 /**
- * @brief Read the header of a data block, regardless of its type
- * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @return TNG_SUCCESS (0) if successful, TNG_FAILURE(1) if a minor
- * error has occured (not able to read the header size, thus skipping
- * the block) or TNG_CRITICAL (2) if a major error has occured.
+ * @brief Write a NULL terminated string to a file.
+ * @param tng_data is a trajectory data container
+ * @param str is a pointer to the character string should be written. If it
+ * is NULL an empty string is written.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param md5_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
  */
-static tng_function_status tng_block_header_read
-                (const tng_trajectory_t tng_data, const tng_gen_block_t block)
+static TNG_INLINE tng_function_status tng_fwritestr(tng_trajectory_t tng_data,
+                                                const char *str,
+                                                const char hash_mode,
+                                                md5_state_t *md5_state,
+                                                const int line_nr)
 {
-    int64_t start_pos;
+    size_t len;
 
-    TNG_ASSERT(block != 0, "TNG library: Trying to read to uninitialized block (NULL pointer).");
+    if(!str)
+    {
+        str = "";
+    }
+    len = tng_str_written_len(str);
 
-    if(tng_input_file_init(tng_data) != TNG_SUCCESS)
+    if(tng_fwrite(tng_data, str, len, 1, tng_data->output_file) != 1)
     {
+        fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, line_nr);
         return(TNG_CRITICAL);
     }
 
-    start_pos = ftello(tng_data->input_file);
+    if(hash_mode == TNG_USE_HASH)
+    {
+        tng_md5_append(tng_data, md5_state, (md5_byte_t *)str, len);
+    }
 
-    /* First read the header size to be able to read the whole header. */
-    if(fread(&block->header_contents_size, sizeof(block->header_contents_size),
-        1, tng_data->input_file) == 0)
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Read a numerical value from file.
+ * The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param dest is a pointer to where to store the read data.
+ * @param len is the length (in bytes) of the numerical data type. Should
+ * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param md5_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
+ */
+static TNG_INLINE tng_function_status tng_file_input_numerical
+                (const tng_trajectory_t tng_data,
+                 void *dest,
+                 const size_t len,
+                 const char hash_mode,
+                 md5_state_t *md5_state,
+                 const int line_nr)
+{
+    if(tng_fread(tng_data, dest, len, 1, tng_data->input_file) == 0)
     {
-        fprintf(stderr, "TNG library: Cannot read header size. %s: %d\n",
-               __FILE__, __LINE__);
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, line_nr);
         return(TNG_CRITICAL);
     }
-
-    if(block->header_contents_size == 0)
+    if(hash_mode == TNG_USE_HASH)
     {
-        block->id = -1;
-        return(TNG_FAILURE);
+        tng_md5_append(tng_data, md5_state, (md5_byte_t *)dest, len);
     }
-
-    /* If this was the size of the general info block check the endianness */
-    if(ftello(tng_data->input_file) < 9)
+    switch(len)
     {
-        /* File is little endian */
-        if ( *((const char*)&block->header_contents_size) != 0x00 &&
-             *((const char*)(&block->header_contents_size) + 7) == 0x00)
+    case 8:
+        if(tng_data->input_endianness_swap_func_64 &&
+           tng_data->input_endianness_swap_func_64(tng_data, (uint64_t *)dest) != TNG_SUCCESS)
         {
-            /* If the architecture endianness is little endian no byte swap
-             * will be needed. Otherwise use the functions to swap to little
-             * endian */
-            if(tng_data->endianness_32 == TNG_LITTLE_ENDIAN_32)
-            {
-                tng_data->input_endianness_swap_func_32 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_32 =
-                &tng_swap_byte_order_little_endian_32;
-            }
-            if(tng_data->endianness_64 == TNG_LITTLE_ENDIAN_64)
-            {
-                tng_data->input_endianness_swap_func_64 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_64 =
-                &tng_swap_byte_order_little_endian_64;
-            }
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                    __FILE__, line_nr);
         }
-        /* File is big endian */
-        else
+        break;
+    case 4:
+        if(tng_data->input_endianness_swap_func_32 &&
+           tng_data->input_endianness_swap_func_32(tng_data, (uint32_t *)dest) != TNG_SUCCESS)
         {
-            /* If the architecture endianness is big endian no byte swap
-             * will be needed. Otherwise use the functions to swap to big
-             * endian */
-            if(tng_data->endianness_32 == TNG_BIG_ENDIAN_32)
-            {
-                tng_data->input_endianness_swap_func_32 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_32 =
-                &tng_swap_byte_order_big_endian_32;
-            }
-            if(tng_data->endianness_64 == TNG_BIG_ENDIAN_64)
-            {
-                tng_data->input_endianness_swap_func_64 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_64 =
-                &tng_swap_byte_order_big_endian_64;
-            }
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                    __FILE__, line_nr);
         }
+        break;
+    default:
+        break;
     }
 
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Get a 64 bit numerical value from a buffer read from the input file.
+ * The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param dest is a pointer to where to store the value.
+ * @param src is a pointer to the value in the buffer. It does not need to be
+ * aligned.
+ */
+static TNG_INLINE void tng_buffer_numerical_64_get
+                (const tng_trajectory_t tng_data,
+                 void *dest,
+                 const char *src)
+{
+    memcpy(dest, src, sizeof(int64_t));
     if(tng_data->input_endianness_swap_func_64 &&
-       tng_data->input_endianness_swap_func_64(tng_data, (uint64_t *)&block->header_contents_size) != TNG_SUCCESS)
+       tng_data->input_endianness_swap_func_64(tng_data, (uint64_t *)dest) != TNG_SUCCESS)
     {
         fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
                 __FILE__, __LINE__);
     }
+}
 
-    if(tng_file_input_numerical(tng_data, &block->block_contents_size,
-                                sizeof(block->block_contents_size),
-                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
-
-    if(tng_file_input_numerical(tng_data, &block->id,
-                                sizeof(block->id),
-                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
-
-    if(fread(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->input_file) == 0)
-    {
-        fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-    }
-
-    tng_freadstr(tng_data, &block->name, TNG_SKIP_HASH, 0, __LINE__);
-
-    if(tng_file_input_numerical(tng_data, &block->block_version,
-                                sizeof(block->block_version),
-                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+/**
+ * @brief Write a numerical value to file.
+ * The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param src is a pointer to the data to write.
+ * @param len is the length (in bytes) of the numerical data type. Should
+ * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param md5_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
+ */
+static TNG_INLINE tng_function_status tng_file_output_numerical
+                (const tng_trajectory_t tng_data,
+                 const void *src,
+                 const size_t len,
+                 const char hash_mode,
+                 md5_state_t *md5_state,
+                 const int line_nr)
+{
+    uint32_t temp_i32;
+    uint64_t temp_i64;
 
-    fseeko(tng_data->input_file, start_pos + block->header_contents_size, SEEK_SET);
+    switch(len)
+    {
+        case 8:
+            temp_i64 = *((uint64_t *)src);
+            if(tng_data->output_endianness_swap_func_64 &&
+            tng_data->output_endianness_swap_func_64(tng_data, &temp_i64) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, line_nr);
+            }
+            if(tng_fwrite(tng_data, &temp_i64, len, 1, tng_data->output_file) != 1)
+            {
+                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
+                return(TNG_CRITICAL);
+            }
+            if(hash_mode == TNG_USE_HASH)
+            {
+                tng_md5_append(tng_data, md5_state, (md5_byte_t *)&temp_i64, len);
+            }
+            break;
+        case 4:
+            temp_i32 = *((uint32_t *)src);
+            if(tng_data->output_endianness_swap_func_32 &&
+            tng_data->output_endianness_swap_func_32(tng_data, &temp_i32) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, line_nr);
+            }
+            if(tng_fwrite(tng_data, &temp_i32, len, 1, tng_data->output_file) != 1)
+            {
+                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
+                return(TNG_CRITICAL);
+            }
+            if(hash_mode == TNG_USE_HASH)
+            {
+                tng_md5_append(tng_data, md5_state, (md5_byte_t *)&temp_i32, len);
+            }
+            break;
+        default:
+            if(tng_fwrite(tng_data, src, len, 1, tng_data->output_file) != 1)
+            {
+                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
+                return(TNG_CRITICAL);
+            }
+            if(hash_mode == TNG_USE_HASH)
+            {
+                tng_md5_append(tng_data, md5_state, (md5_byte_t *)src, len);
+            }
+            break;
+    }
 
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Write a whole block, both header and contents, regardless of it type
+ * @brief Put a numerical value in a buffer that will be written to the
+ * output file. The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param dest is a pointer to where to put the value in the buffer. It does
+ * not need to be aligned.
+ * @param src is a pointer to the value.
+ * @param len is the length (in bytes) of the numerical data type. Should
+ * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
+ * @return A pointer to the position in the buffer after the value.
+ */
+static TNG_INLINE char *tng_buffer_numerical_put
+                (const tng_trajectory_t tng_data,
+                 char *dest,
+                 const void *src,
+                 const size_t len)
+{
+    uint32_t temp_i32;
+    uint64_t temp_i64;
+
+    switch(len)
+    {
+        case 8:
+            memcpy(&temp_i64, src, len);
+            if(tng_data->output_endianness_swap_func_64 &&
+            tng_data->output_endianness_swap_func_64(tng_data, &temp_i64) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, __LINE__);
+            }
+            memcpy(dest, &temp_i64, len);
+            break;
+        case 4:
+            memcpy(&temp_i32, src, len);
+            if(tng_data->output_endianness_swap_func_32 &&
+            tng_data->output_endianness_swap_func_32(tng_data, &temp_i32) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, __LINE__);
+            }
+            memcpy(dest, &temp_i32, len);
+            break;
+        default:
+            memcpy(dest, src, len);
+            break;
+    }
+
+    return(dest + len);
+}
+
+/**
+ * @brief Generate the md5 hash of a block.
+ * The hash is created based on the actual block contents.
  * @param tng_data is a trajectory data container.
  * @param block is a general block container.
- * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
- * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ * @return TNG_SUCCESS (0) if successful.
  */
-/* Disabled until it is used.*/
-/*
-// static tng_function_status tng_block_verbatim_write(tng_trajectory_t tng_data,
-//                                                     tng_gen_block_t block)
-// {
-//     if(!block->header_contents)
-//     {
-//         fprintf(stderr, "TNG library: No contents to write. %s: %d\n", __FILE__, __LINE__);
-//         return(TNG_FAILURE);
-//     }
-//     if(fwrite(block->header_contents, block->header_contents_size, 1,
-//                 tng_data->output_file) != 1)
-//     {
-//         fprintf(stderr, "TNG library: Could not write all header data. %s: %d\n",
-//                 __FILE__, __LINE__);
-//         return(TNG_CRITICAL);
-//     }
-//
-//     if(!block->block_contents)
-//     {
-//         fprintf(stderr, "TNG library: No block data to write. %s: %d\n",
-//                 __FILE__, __LINE__);
-//         return(TNG_FAILURE);
-//     }
-//     if(fwrite(block->block_contents, block->block_contents_size, 1,
-//                 tng_data->output_file) != 1)
-//     {
-//         fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n",
-//                 __FILE__, __LINE__);
-//         return(TNG_CRITICAL);
-//     }
-//     return(TNG_SUCCESS);
-// }
-*/
+static tng_function_status tng_block_md5_hash_generate(const tng_trajectory_t tng_data,
+                                                       const tng_gen_block_t block)
+{
+    md5_state_t md5_state;
+
+    md5_init(&md5_state);
+    tng_md5_append(tng_data, &md5_state, (md5_byte_t *)block->block_contents,
+                   (int)block->block_contents_size);
+    md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
+
+    return(TNG_SUCCESS);
+}
 
 /**
- * @brief Update the md5 hash of a block already written to the file
+ * @brief If there is data left in the block read that to append that to the MD5 hash.
  * @param tng_data is a trajectory data container.
- * @param block is the block, of which to update the md5 hash.
- * @param header_start_pos is the file position where the block header starts.
- * @param contents_start_pos is the file position where the block contents
- * start.
+ * @param block is the data block that is being read.
+ * @param start_pos is the file position where the block started.
+ * @param md5_state is the md5 to which the md5 of the remaining block
+ * will be appended.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_md5_hash_update(const tng_trajectory_t tng_data,
-                                               const tng_gen_block_t block,
-                                               const int64_t header_start_pos,
-                                               const int64_t contents_start_pos)
+static tng_function_status tng_md5_remaining_append(const tng_trajectory_t tng_data,
+                                                    const tng_gen_block_t block,
+                                                    const int64_t start_pos,
+                                                    md5_state_t *md5_state)
 {
-    if(block->block_contents)
-    {
-        free(block->block_contents);
-    }
-
-    block->block_contents = (char *)malloc(block->block_contents_size);
-    if(!block->block_contents)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-    }
+    int64_t curr_file_pos;
+    char *temp_data;
 
-    fseeko(tng_data->output_file, contents_start_pos, SEEK_SET);
-    if(fread(block->block_contents, block->block_contents_size, 1,
-            tng_data->output_file) == 0)
+    curr_file_pos = ftello(tng_data->input_file);
+    if(curr_file_pos < start_pos + block->block_contents_size)
     {
-        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
-        return(TNG_CRITICAL);
+        temp_data = (char *)malloc(start_pos + block->block_contents_size - curr_file_pos);
+        if(!temp_data)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+        if(tng_fread(tng_data, temp_data, start_pos + block->block_contents_size - curr_file_pos,
+                        1, tng_data->input_file) == 0)
+        {
+            fprintf(stderr, "TNG library: Cannot read remaining part of block to generate MD5 sum. %s: %d\n", __FILE__, __LINE__);
+            free(temp_data);
+            return(TNG_CRITICAL);
+        }
+        tng_md5_append(tng_data, md5_state, (md5_byte_t *)temp_data,
+                       start_pos + block->block_contents_size - curr_file_pos);
+        free(temp_data);
     }
 
-    tng_block_md5_hash_generate(block);
-
-    fseeko(tng_data->output_file, header_start_pos + 3 * sizeof(int64_t),
-          SEEK_SET);
-    fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file);
-
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Update the frame set pointers in the file header (general info block),
- * already written to disk
+ * @brief Open the input file if it is not already opened.
  * @param tng_data is a trajectory data container.
- * @param hash_mode specifies whether to update the block md5 hash when
- * updating the pointers.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_header_pointers_update
-                (const tng_trajectory_t tng_data, const char hash_mode)
+static tng_function_status tng_input_file_init(const tng_trajectory_t tng_data)
 {
-    tng_gen_block_t block;
-    FILE *temp = tng_data->input_file;
-    uint64_t output_file_pos, pos, contents_start_pos;
+    int64_t file_pos;
 
-    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+    if(!tng_data->input_file)
     {
-        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
-               __FILE__, __LINE__);
-        return(TNG_CRITICAL);
+        if(!tng_data->input_file_path)
+        {
+            fprintf(stderr, "TNG library: No file specified for reading. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+        tng_data->input_file = fopen(tng_data->input_file_path, "rb");
+        if(!tng_data->input_file)
+        {
+            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
+                   tng_data->input_file_path, __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
     }
 
-    tng_data->input_file = tng_data->output_file;
-
-    tng_block_init(&block);
-
-    output_file_pos = ftello(tng_data->output_file);
-    fseeko(tng_data->output_file, 0, SEEK_SET);
-
-    if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+    if(!tng_data->input_file_len)
     {
-        fprintf(stderr, "TNG library: Cannot read general info header. %s: %d\n",
-               __FILE__, __LINE__);
-        tng_data->input_file = temp;
-        tng_block_destroy(&block);
-        return(TNG_CRITICAL);
+        file_pos = ftello(tng_data->input_file);
+        tng_fseeko(tng_data, tng_data->input_file, 0, SEEK_END);
+        tng_data->input_file_len = ftello(tng_data->input_file);
+        tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
     }
 
-    contents_start_pos = ftello(tng_data->output_file);
-
-    fseeko(tng_data->output_file, block->block_contents_size - 5 *
-           sizeof(int64_t), SEEK_CUR);
-
-    tng_data->input_file = temp;
-
-    pos = tng_data->first_trajectory_frame_set_output_file_pos;
+    return(TNG_SUCCESS);
+}
 
-    if(tng_data->input_endianness_swap_func_64)
+/**
+ * @brief Open the output file if it is not already opened
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_output_file_init(const tng_trajectory_t tng_data)
+{
+    if(!tng_data->output_file)
     {
-        if(tng_data->input_endianness_swap_func_64(tng_data,
-                                                    &pos)
-            != TNG_SUCCESS)
+        if(!tng_data->output_file_path)
         {
-            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                    __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: No file specified for writing. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+
+        tng_data->output_file = fopen(tng_data->output_file_path, "wb+");
+
+        if(!tng_data->output_file)
+        {
+            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
+                   tng_data->output_file_path, __FILE__, __LINE__);
+            return(TNG_CRITICAL);
         }
     }
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Setup a file block container.
+ * @param block_p a pointer to memory to initialise as a file block container.
+ * @details Memory is allocated during initialisation.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_block_init(struct tng_gen_block **block_p)
+{
+    tng_gen_block_t block;
 
-    if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+    *block_p = (struct tng_gen_block *)malloc(sizeof(struct tng_gen_block));
+    if(!*block_p)
     {
-        tng_block_destroy(&block);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return(TNG_CRITICAL);
     }
 
-    pos = tng_data->last_trajectory_frame_set_output_file_pos;
+    block = *block_p;
 
-    if(tng_data->input_endianness_swap_func_64)
+    block->id = -1;
+    /* Reset the md5_hash */
+    memset(block->md5_hash, '\0', TNG_MD5_HASH_LEN);
+    block->name = 0;
+    block->block_version = TNG_API_VERSION;
+    block->header_contents = 0;
+    block->header_contents_size = 0;
+    block->block_contents = 0;
+    block->block_contents_size = 0;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Clean up a file block container.
+ * @param block_p a pointer to the file block container to destroy.
+ * @details All allocated memory in the data structure is freed, as well as
+ * block_p itself.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_block_destroy(struct tng_gen_block **block_p)
+{
+    tng_gen_block_t block = *block_p;
+
+    if(!*block_p)
     {
-        if(tng_data->input_endianness_swap_func_64(tng_data,
-                                                    &pos)
-            != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                    __FILE__, __LINE__);
-        }
+        return(TNG_SUCCESS);
     }
 
-    if(fwrite(&pos,
-        sizeof(int64_t), 1, tng_data->output_file) != 1)
+/*     fprintf(stderr, "TNG library: Destroying block\n"); */
+    if(block->name)
     {
-        tng_block_destroy(&block);
-        return(TNG_CRITICAL);
+        free(block->name);
+        block->name = 0;
     }
-
-    if(hash_mode == TNG_USE_HASH)
+    if(block->header_contents)
     {
-        tng_md5_hash_update(tng_data, block, 0, contents_start_pos);
+        free(block->header_contents);
+        block->header_contents = 0;
+    }
+    if(block->block_contents)
+    {
+        free(block->block_contents);
+        block->block_contents = 0;
     }
 
-    tng_block_destroy(&block);
-
-    fseeko(tng_data->output_file, output_file_pos, SEEK_SET);
+    free(*block_p);
+    *block_p = 0;
 
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Update the frame set pointers in the current frame set block, already
- * written to disk. It also updates the pointers of the blocks pointing to
- * the current frame set block.
+ * @brief Read the header of a data block, regardless of its type
  * @param tng_data is a trajectory data container.
- * @param hash_mode specifies whether to update the block md5 hash when
- * updating the pointers.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @param block is a general block container.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE(1) if a minor
+ * error has occured (not able to read the header size, thus skipping
+ * the block) or TNG_CRITICAL (2) if a major error has occured.
  */
-static tng_function_status tng_frame_set_pointers_update
-                (const tng_trajectory_t tng_data, const char hash_mode)
+static tng_function_status tng_block_header_read
+                (const tng_trajectory_t tng_data, const tng_gen_block_t block)
 {
-    tng_gen_block_t block;
-    tng_trajectory_frame_set_t frame_set;
-    FILE *temp = tng_data->input_file;
-    uint64_t pos, output_file_pos, contents_start_pos;
+    int64_t header_len, offset;
+    size_t name_len;
+    char *buffer, *name_end, *temp_name;
 
-    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+    TNG_ASSERT(block != 0, "TNG library: Trying to read to uninitialized block (NULL pointer).");
+
+    if(tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
+        return(TNG_CRITICAL);
+    }
+
+    /* First read the header size to be able to read the whole header. */
+    if(tng_fread(tng_data, &block->header_contents_size, sizeof(block->header_contents_size),
+            1, tng_data->input_file) == 0)
+    {
+        fprintf(stderr, "TNG library: Cannot read header size. %s: %d\n",
                __FILE__, __LINE__);
         return(TNG_CRITICAL);
     }
 
-    tng_block_init(&block);
-    output_file_pos = ftello(tng_data->output_file);
+    if(block->header_contents_size == 0)
+    {
+        block->id = -1;
+        return(TNG_FAILURE);
+    }
 
-    tng_data->input_file = tng_data->output_file;
+    tng_statistics_count(tng_data, &tng_data->statistics.n_block_headers_read, 1);
 
-    frame_set = &tng_data->current_trajectory_frame_set;
+    /* If this was the size of the general info block check the endianness */
+    if(ftello(tng_data->input_file) < 9)
+    {
+        /* File is little endian */
+        if ( *((const char*)&block->header_contents_size) != 0x00 &&
+             *((const char*)(&block->header_contents_size) + 7) == 0x00)
+        {
+            /* If the architecture endianness is little endian no byte swap
+             * will be needed. Otherwise use the functions to swap to little
+             * endian */
+            if(tng_data->endianness_32 == TNG_LITTLE_ENDIAN_32)
+            {
+                tng_data->input_endianness_swap_func_32 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_32 =
+                &tng_swap_byte_order_little_endian_32;
+            }
+            if(tng_data->endianness_64 == TNG_LITTLE_ENDIAN_64)
+            {
+                tng_data->input_endianness_swap_func_64 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_64 =
+                &tng_swap_byte_order_little_endian_64;
+            }
+        }
+        /* File is big endian */
+        else
+        {
+            /* If the architecture endianness is big endian no byte swap
+             * will be needed. Otherwise use the functions to swap to big
+             * endian */
+            if(tng_data->endianness_32 == TNG_BIG_ENDIAN_32)
+            {
+                tng_data->input_endianness_swap_func_32 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_32 =
+                &tng_swap_byte_order_big_endian_32;
+            }
+            if(tng_data->endianness_64 == TNG_BIG_ENDIAN_64)
+            {
+                tng_data->input_endianness_swap_func_64 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_64 =
+                &tng_swap_byte_order_big_endian_64;
+            }
+        }
+    }
 
-    pos = tng_data->current_trajectory_frame_set_output_file_pos;
+    if(tng_data->input_endianness_swap_func_64 &&
+       tng_data->input_endianness_swap_func_64(tng_data, (uint64_t *)&block->header_contents_size) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                __FILE__, __LINE__);
+    }
 
-    /* Update next frame set */
-    if(frame_set->next_frame_set_file_pos > 0)
+    /* The header must at least contain the sizes, the ID, the hash, the name
+     * and the version. */
+    header_len = block->header_contents_size - (int64_t)sizeof(block->header_contents_size);
+    if(header_len < (int64_t)(3 * sizeof(int64_t) + TNG_MD5_HASH_LEN + 1))
     {
-        fseeko(tng_data->output_file, frame_set->next_frame_set_file_pos, SEEK_SET);
+        fprintf(stderr, "TNG library: Invalid block header size %" PRId64 ". %s: %d\n",
+                block->header_contents_size, __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
 
-        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n",
+    /* Read the rest of the header at once and decode it from memory. */
+    buffer = (char *)tng_array_grow(tng_data->input_header_buffer,
+                                    &tng_data->input_header_buffer_size,
+                                    header_len, 1);
+    if(!buffer)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
+        return(TNG_CRITICAL);
+    }
+    tng_data->input_header_buffer = buffer;
 
-        contents_start_pos = ftello(tng_data->output_file);
+    if(tng_fread(tng_data, buffer, header_len, 1, tng_data->input_file) == 0)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
 
-        fseeko(tng_data->output_file, block->block_contents_size - (5 *
-               sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+    tng_buffer_numerical_64_get(tng_data, &block->block_contents_size, buffer);
+    tng_buffer_numerical_64_get(tng_data, &block->id, buffer + sizeof(int64_t));
+    memcpy(block->md5_hash, buffer + 2 * sizeof(int64_t), TNG_MD5_HASH_LEN);
+    offset = 2 * sizeof(int64_t) + TNG_MD5_HASH_LEN;
 
-        if(tng_data->input_endianness_swap_func_64)
+    name_end = (char *)memchr(buffer + offset, '\0',
+                              header_len - offset - sizeof(int64_t));
+    if(!name_end)
+    {
+        fprintf(stderr, "TNG library: Block name not terminated. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    name_len = tng_min_size(name_end - (buffer + offset), TNG_MAX_STR_LEN - 1);
+
+    /* Block names are mostly the same for all blocks of a type, so the name
+     * is only copied if it differs from the name of the previous block. */
+    if(!block->name || strncmp(block->name, buffer + offset, name_len) != 0 ||
+       block->name[name_len] != '\0')
+    {
+        if(!block->name || strlen(block->name) < name_len)
         {
-            if(tng_data->input_endianness_swap_func_64(tng_data,
-                                                        &pos)
-                != TNG_SUCCESS)
+            temp_name = (char *)realloc(block->name, name_len + 1);
+            if(!temp_name)
             {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                         __FILE__, __LINE__);
+                free(block->name);
+                block->name = 0;
+                return(TNG_CRITICAL);
             }
+            block->name = temp_name;
         }
+        memcpy(block->name, buffer + offset, name_len);
+        block->name[name_len] = '\0';
+    }
+    offset = name_end - buffer + 1;
 
-        if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
-        {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
+    tng_buffer_numerical_64_get(tng_data, &block->block_version, buffer + offset);
 
-        if(hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->next_frame_set_file_pos,
-                                contents_start_pos);
-        }
-    }
-    /* Update previous frame set */
-    if(frame_set->prev_frame_set_file_pos > 0)
-    {
-        fseeko(tng_data->output_file, frame_set->prev_frame_set_file_pos,
-              SEEK_SET);
+    return(TNG_SUCCESS);
+}
 
-        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n",
-                __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
+/**
+ * @brief Write a whole block, both header and contents, regardless of it type
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ */
+/* Disabled until it is used.*/
+/*
+// static tng_function_status tng_block_verbatim_write(tng_trajectory_t tng_data,
+//                                                     tng_gen_block_t block)
+// {
+//     if(!block->header_contents)
+//     {
+//         fprintf(stderr, "TNG library: No contents to write. %s: %d\n", __FILE__, __LINE__);
+//         return(TNG_FAILURE);
+//     }
+//     if(fwrite(block->header_contents, block->header_contents_size, 1,
+//                 tng_data->output_file) != 1)
+//     {
+//         fprintf(stderr, "TNG library: Could not write all header data. %s: %d\n",
+//                 __FILE__, __LINE__);
+//         return(TNG_CRITICAL);
+//     }
+//
+//     if(!block->block_contents)
+//     {
+//         fprintf(stderr, "TNG library: No block data to write. %s: %d\n",
+//                 __FILE__, __LINE__);
+//         return(TNG_FAILURE);
+//     }
+//     if(fwrite(block->block_contents, block->block_contents_size, 1,
+//                 tng_data->output_file) != 1)
+//     {
+//         fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n",
+//                 __FILE__, __LINE__);
+//         return(TNG_CRITICAL);
+//     }
+//     return(TNG_SUCCESS);
+// }
+*/
 
-        contents_start_pos = ftello(tng_data->output_file);
+/**
+ * @brief Update the md5 hash of a block already written to the file
+ * @param tng_data is a trajectory data container.
+ * @param block is the block, of which to update the md5 hash.
+ * @param header_start_pos is the file position where the block header starts.
+ * @param contents_start_pos is the file position where the block contents
+ * start.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_md5_hash_update(const tng_trajectory_t tng_data,
+                                               const tng_gen_block_t block,
+                                               const int64_t header_start_pos,
+                                               const int64_t contents_start_pos)
+{
+    if(block->block_contents)
+    {
+        free(block->block_contents);
+    }
+
+    block->block_contents = (char *)malloc(block->block_contents_size);
+    if(!block->block_contents)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
 
-        fseeko(tng_data->output_file, block->block_contents_size - (6 *
-               sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+    tng_fseeko(tng_data, tng_data->output_file, contents_start_pos, SEEK_SET);
+    if(tng_fread(tng_data, block->block_contents, block->block_contents_size, 1,
+                tng_data->output_file) == 0)
+    {
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
 
-        if(tng_data->input_endianness_swap_func_64)
+    tng_block_md5_hash_generate(tng_data, block);
+
+    tng_fseeko(tng_data, tng_data->output_file, header_start_pos + 3 * sizeof(int64_t),
+              SEEK_SET);
+    tng_fwrite(tng_data, block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file);
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Calculate the length of a compression algorithms block.
+ * @param tng_data is a trajectory data container.
+ * @param len is pointer to a value to store the length of the block contents.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_compress_algo_block_len_calculate
+                (const tng_trajectory_t tng_data,
+                 int64_t *len)
+{
+    (void)tng_data;
+
+    *len = (1 + 2 * (int64_t)tng_compress_nalgo()) * sizeof(int64_t);
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Write the TNG compression algorithms of positions and velocities
+ * at the current position of the output file. Undetermined algorithms are
+ * written as -1.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_compress_algo_stored_write
+                (const tng_trajectory_t tng_data,
+                 const char hash_mode,
+                 md5_state_t *md5_state)
+{
+    int64_t i, nalgo, temp;
+    int *algo;
+    int j;
+
+    nalgo = tng_compress_nalgo();
+
+    if(tng_file_output_numerical(tng_data, &nalgo, sizeof(nalgo),
+                                 hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    for(j = 0; j < 2; j++)
+    {
+        algo = j == 0 ? tng_data->compress_algo_pos : tng_data->compress_algo_vel;
+        for(i = 0; i < nalgo; i++)
         {
-            if(tng_data->input_endianness_swap_func_64(tng_data,
-                                                        &pos)
-                != TNG_SUCCESS)
+            temp = algo ? algo[i] : -1;
+            if(tng_file_output_numerical(tng_data, &temp, sizeof(temp),
+                                         hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
             {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                        __FILE__, __LINE__);
+                return(TNG_CRITICAL);
             }
         }
+    }
 
-        if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
-        {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
+    return(TNG_SUCCESS);
+}
 
-        if(hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->prev_frame_set_file_pos,
-                                contents_start_pos);
-        }
+/**
+ * @brief Read the TNG compression algorithms of positions and velocities
+ * stored in a compression algorithms block. Algorithms that have not been
+ * determined are left unset.
+ * @param tng_data is a trajectory data container.
+ * @param block is the compression algorithms block.
+ * @param start_pos is the file position where the block contents start.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_compress_algo_stored_read
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 const int64_t start_pos,
+                 const char hash_mode,
+                 md5_state_t *md5_state)
+{
+    int64_t i, nalgo, remaining, temp;
+    int64_t *values;
+    int **algo;
+    int j;
+
+    remaining = start_pos + block->block_contents_size - ftello(tng_data->input_file);
+    if(remaining < (int64_t)sizeof(nalgo))
+    {
+        return(TNG_SUCCESS);
     }
 
-    /* Update the frame set one medium stride step after */
-    if(frame_set->medium_stride_next_frame_set_file_pos > 0)
+    if(tng_file_input_numerical(tng_data, &nalgo, sizeof(nalgo),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
     {
-        fseeko(tng_data->output_file,
-              frame_set->medium_stride_next_frame_set_file_pos,
-              SEEK_SET);
+        return(TNG_CRITICAL);
+    }
+    remaining -= sizeof(nalgo);
 
-        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+    /* Leave data that cannot be interpreted to be skipped by the caller. */
+    if(nalgo != tng_compress_nalgo() ||
+       remaining < 2 * nalgo * (int64_t)sizeof(int64_t))
+    {
+        return(TNG_SUCCESS);
+    }
+
+    values = (int64_t *)malloc(2 * nalgo * sizeof(int64_t));
+    if(!values)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    for(i = 0; i < 2 * nalgo; i++)
+    {
+        if(tng_file_input_numerical(tng_data, &temp, sizeof(temp),
+                                    hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            free(values);
             return(TNG_CRITICAL);
         }
+        values[i] = temp;
+    }
 
-        contents_start_pos = ftello(tng_data->output_file);
-
-        fseeko(tng_data->output_file, block->block_contents_size - (3 *
-               sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+    tng_data->compress_algo_store = TNG_TRUE;
 
-        if(tng_data->input_endianness_swap_func_64)
+    for(j = 0; j < 2; j++)
+    {
+        /* The algorithm has not been determined if the coding is unset. */
+        if(values[j * nalgo] == -1 && values[j * nalgo + 2] == -1)
         {
-            if(tng_data->input_endianness_swap_func_64(tng_data,
-                                                        &pos)
-                != TNG_SUCCESS)
+            continue;
+        }
+        algo = j == 0 ? &tng_data->compress_algo_pos : &tng_data->compress_algo_vel;
+        if(!*algo)
+        {
+            *algo = (int *)malloc(nalgo * sizeof(int));
+            if(!*algo)
             {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                         __FILE__, __LINE__);
+                free(values);
+                return(TNG_CRITICAL);
             }
         }
-
-        if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
-        {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
-
-        if(hash_mode == TNG_USE_HASH)
+        for(i = 0; i < nalgo; i++)
         {
-            tng_md5_hash_update(tng_data, block,
-                                frame_set->medium_stride_next_frame_set_file_pos,
-                                contents_start_pos);
+            (*algo)[i] = (int)values[j * nalgo + i];
         }
     }
-    /* Update the frame set one medium stride step before */
-    if(frame_set->medium_stride_prev_frame_set_file_pos > 0)
+
+    free(values);
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Update the compression algorithms block, already written to disk.
+ * The block is looked for among the non-trajectory blocks of the output file
+ * the first time and is left untouched if it is not found. Its position is
+ * remembered for later updates.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode specifies whether to update the block md5 hash when
+ * updating the algorithms.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the block was
+ * not found or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_compress_algo_block_update
+                (const tng_trajectory_t tng_data, const char hash_mode)
+{
+    tng_gen_block_t block;
+    tng_function_status stat = TNG_FAILURE;
+    FILE *temp = tng_data->input_file;
+    int64_t header_start_pos, contents_start_pos, file_len, len;
+
+    if(tng_data->compress_algo_block_output_file_pos == 0)
     {
-        fseeko(tng_data->output_file,
-               frame_set->medium_stride_prev_frame_set_file_pos,
-               SEEK_SET);
+        return(TNG_FAILURE);
+    }
 
-        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+    tng_data->input_file = tng_data->output_file;
+
+    tng_compress_algo_block_len_calculate(tng_data, &len);
+
+    tng_block_init(&block);
+
+    header_start_pos = tng_data->compress_algo_block_output_file_pos;
+    if(header_start_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file, header_start_pos, SEEK_SET);
+        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS ||
+           block->id != TNG_COMPRESSION_ALGORITHMS)
         {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
-                __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
+            header_start_pos = -1;
         }
+    }
 
-        contents_start_pos = ftello(tng_data->output_file);
+    if(header_start_pos < 0)
+    {
+        tng_data->compress_algo_block_output_file_pos = 0;
 
-        fseeko(tng_data->output_file, block->block_contents_size - (4 *
-               sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_END);
+        file_len = ftello(tng_data->output_file);
+        tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_SET);
 
-        if(tng_data->input_endianness_swap_func_64)
+        header_start_pos = 0;
+        while(header_start_pos < file_len &&
+              tng_block_header_read(tng_data, block) == TNG_SUCCESS &&
+              block->id != -1 &&
+              block->id != TNG_TRAJECTORY_FRAME_SET)
         {
-            if(tng_data->input_endianness_swap_func_64(tng_data,
-                                                        &pos)
-                != TNG_SUCCESS)
+            if(block->id == TNG_COMPRESSION_ALGORITHMS)
             {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                        __FILE__, __LINE__);
+                tng_data->compress_algo_block_output_file_pos = header_start_pos;
+                break;
             }
+            header_start_pos = ftello(tng_data->output_file) + block->block_contents_size;
+            tng_fseeko(tng_data, tng_data->output_file, header_start_pos, SEEK_SET);
         }
+    }
 
-        if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+    /* The block cannot be resized in place. */
+    if(tng_data->compress_algo_block_output_file_pos > 0 &&
+       block->block_contents_size == len)
+    {
+        contents_start_pos = ftello(tng_data->output_file);
+        stat = tng_compress_algo_stored_write(tng_data, TNG_SKIP_HASH, 0);
+        if(stat == TNG_SUCCESS && hash_mode == TNG_USE_HASH)
         {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
+            stat = tng_md5_hash_update(tng_data, block, header_start_pos,
+                                       contents_start_pos);
         }
+    }
 
-        if(hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block,
-                                frame_set->medium_stride_prev_frame_set_file_pos,
-                                contents_start_pos);
+    tng_data->input_file = temp;
+
+    tng_block_destroy(&block);
+
+    return(stat);
+}
+
+/**
+ * @brief Update the frame set pointers in the file header (general info block),
+ * already written to disk
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode specifies whether to update the block md5 hash when
+ * updating the pointers.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_header_pointers_update
+                (const tng_trajectory_t tng_data, const char hash_mode)
+{
+    tng_gen_block_t block;
+    FILE *temp = tng_data->input_file;
+    uint64_t output_file_pos, pos, contents_start_pos;
+
+    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    tng_data->input_file = tng_data->output_file;
+
+    tng_block_init(&block);
+
+    output_file_pos = ftello(tng_data->output_file);
+    tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_SET);
+
+    if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot read general info header. %s: %d\n",
+               __FILE__, __LINE__);
+        tng_data->input_file = temp;
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    contents_start_pos = ftello(tng_data->output_file);
+
+    tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - 5 *
+               sizeof(int64_t), SEEK_CUR);
+
+    tng_data->input_file = temp;
+
+    pos = tng_data->first_trajectory_frame_set_output_file_pos;
+
+    if(tng_data->input_endianness_swap_func_64)
+    {
+        if(tng_data->input_endianness_swap_func_64(tng_data,
+                                                    &pos)
+            != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                    __FILE__, __LINE__);
         }
     }
 
-    /* Update the frame set one long stride step after */
-    if(frame_set->long_stride_next_frame_set_file_pos > 0)
+    if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
     {
-        fseeko(tng_data->output_file,
-               frame_set->long_stride_next_frame_set_file_pos,
-               SEEK_SET);
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    pos = tng_data->last_trajectory_frame_set_output_file_pos;
+
+    if(tng_data->input_endianness_swap_func_64)
+    {
+        if(tng_data->input_endianness_swap_func_64(tng_data,
+                                                    &pos)
+            != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                    __FILE__, __LINE__);
+        }
+    }
+
+    if(tng_fwrite(tng_data, &pos,
+            sizeof(int64_t), 1, tng_data->output_file) != 1)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    if(hash_mode == TNG_USE_HASH)
+    {
+        tng_md5_hash_update(tng_data, block, 0, contents_start_pos);
+    }
+
+    tng_block_destroy(&block);
+
+    /* Update the stored compression algorithms, which may have been
+     * determined since the block was written. */
+    if(tng_data->compress_algo_store &&
+       tng_compress_algo_block_update(tng_data, hash_mode) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    tng_fseeko(tng_data, tng_data->output_file, output_file_pos, SEEK_SET);
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Update the frame set pointers in the current frame set block, already
+ * written to disk. It also updates the pointers of the blocks pointing to
+ * the current frame set block.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode specifies whether to update the block md5 hash when
+ * updating the pointers.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_pointers_update
+                (const tng_trajectory_t tng_data, const char hash_mode)
+{
+    tng_gen_block_t block;
+    tng_trajectory_frame_set_t frame_set;
+    FILE *temp = tng_data->input_file;
+    uint64_t pos, output_file_pos, contents_start_pos;
+
+    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    tng_block_init(&block);
+    output_file_pos = ftello(tng_data->output_file);
+
+    tng_data->input_file = tng_data->output_file;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    pos = tng_data->current_trajectory_frame_set_output_file_pos;
+
+    /* Update next frame set */
+    if(frame_set->next_frame_set_file_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file, frame_set->next_frame_set_file_pos, SEEK_SET);
 
         if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n",
                 __FILE__, __LINE__);
             tng_data->input_file = temp;
             tng_block_destroy(&block);
@@ -1554,8 +2749,8 @@ static tng_function_status tng_frame_set_pointers_update
 
         contents_start_pos = ftello(tng_data->output_file);
 
-        fseeko(tng_data->output_file, block->block_contents_size - (1 *
-               sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (5 *
+                   sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
         if(tng_data->input_endianness_swap_func_64)
         {
@@ -1568,7 +2763,7 @@ static tng_function_status tng_frame_set_pointers_update
             }
         }
 
-        if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
         {
             tng_data->input_file = temp;
             tng_block_destroy(&block);
@@ -1577,21 +2772,19 @@ static tng_function_status tng_frame_set_pointers_update
 
         if(hash_mode == TNG_USE_HASH)
         {
-            tng_md5_hash_update(tng_data, block,
-                                frame_set->long_stride_next_frame_set_file_pos,
+            tng_md5_hash_update(tng_data, block, frame_set->next_frame_set_file_pos,
                                 contents_start_pos);
         }
     }
-    /* Update the frame set one long stride step before */
-    if(frame_set->long_stride_prev_frame_set_file_pos > 0)
+    /* Update previous frame set */
+    if(frame_set->prev_frame_set_file_pos > 0)
     {
-        fseeko(tng_data->output_file,
-               frame_set->long_stride_prev_frame_set_file_pos,
-               SEEK_SET);
+        tng_fseeko(tng_data, tng_data->output_file, frame_set->prev_frame_set_file_pos,
+                  SEEK_SET);
 
         if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n",
                 __FILE__, __LINE__);
             tng_data->input_file = temp;
             tng_block_destroy(&block);
@@ -1600,8 +2793,8 @@ static tng_function_status tng_frame_set_pointers_update
 
         contents_start_pos = ftello(tng_data->output_file);
 
-        fseeko(tng_data->output_file, block->block_contents_size - (2 *
-               sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (6 *
+                   sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
         if(tng_data->input_endianness_swap_func_64)
         {
@@ -1614,7 +2807,7 @@ static tng_function_status tng_frame_set_pointers_update
             }
         }
 
-        if(fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
         {
             tng_data->input_file = temp;
             tng_block_destroy(&block);
@@ -1623,76 +2816,261 @@ static tng_function_status tng_frame_set_pointers_update
 
         if(hash_mode == TNG_USE_HASH)
         {
-            tng_md5_hash_update(tng_data, block,
-                                frame_set->long_stride_prev_frame_set_file_pos,
+            tng_md5_hash_update(tng_data, block, frame_set->prev_frame_set_file_pos,
                                 contents_start_pos);
         }
     }
 
-    fseeko(tng_data->output_file, output_file_pos, SEEK_SET);
-
-    tng_data->input_file = temp;
+    /* Update the frame set one medium stride step after */
+    if(frame_set->medium_stride_next_frame_set_file_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file,
+                  frame_set->medium_stride_next_frame_set_file_pos,
+                  SEEK_SET);
 
-    tng_block_destroy(&block);
+        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+                __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
 
-    return(TNG_SUCCESS);
-}
+        contents_start_pos = ftello(tng_data->output_file);
 
-static tng_function_status tng_reread_frame_set_at_file_pos
-                (const tng_trajectory_t tng_data,
-                 const int64_t pos)
-{
-    tng_gen_block_t block;
-    tng_function_status stat;
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (3 *
+                   sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
-    tng_block_init(&block);
+        if(tng_data->input_endianness_swap_func_64)
+        {
+            if(tng_data->input_endianness_swap_func_64(tng_data,
+                                                        &pos)
+                != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, __LINE__);
+            }
+        }
 
-    fseeko(tng_data->input_file, pos, SEEK_SET);
-    if(pos > 0)
-    {
-        stat = tng_block_header_read(tng_data, block);
-        if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+        if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
         {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", pos,
-                    __FILE__, __LINE__);
+            tng_data->input_file = temp;
             tng_block_destroy(&block);
-            return(TNG_FAILURE);
+            return(TNG_CRITICAL);
         }
 
-        if(tng_block_read_next(tng_data, block,
-                               TNG_SKIP_HASH) != TNG_SUCCESS)
+        if(hash_mode == TNG_USE_HASH)
+        {
+            tng_md5_hash_update(tng_data, block,
+                                frame_set->medium_stride_next_frame_set_file_pos,
+                                contents_start_pos);
+        }
+    }
+    /* Update the frame set one medium stride step before */
+    if(frame_set->medium_stride_prev_frame_set_file_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file,
+                   frame_set->medium_stride_prev_frame_set_file_pos,
+                   SEEK_SET);
+
+        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+                __FILE__, __LINE__);
+            tng_data->input_file = temp;
             tng_block_destroy(&block);
             return(TNG_CRITICAL);
         }
-    }
 
-    tng_block_destroy(&block);
+        contents_start_pos = ftello(tng_data->output_file);
 
-    return(TNG_SUCCESS);
-}
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (4 *
+                   sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
-static tng_function_status tng_file_pos_of_subsequent_trajectory_block_get
-                (const tng_trajectory_t tng_data,
-                 int64_t *pos)
-{
-    int64_t orig_pos, curr_frame_set_pos;
-    tng_gen_block_t block;
-    tng_function_status stat;
-    tng_trajectory_frame_set_t frame_set =
-    &tng_data->current_trajectory_frame_set;
+        if(tng_data->input_endianness_swap_func_64)
+        {
+            if(tng_data->input_endianness_swap_func_64(tng_data,
+                                                        &pos)
+                != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, __LINE__);
+            }
+        }
 
-    orig_pos = ftello(tng_data->input_file);
-    curr_frame_set_pos = tng_data->current_trajectory_frame_set_input_file_pos;
+        if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
 
-    *pos = tng_data->first_trajectory_frame_set_input_file_pos;
+        if(hash_mode == TNG_USE_HASH)
+        {
+            tng_md5_hash_update(tng_data, block,
+                                frame_set->medium_stride_prev_frame_set_file_pos,
+                                contents_start_pos);
+        }
+    }
+
+    /* Update the frame set one long stride step after */
+    if(frame_set->long_stride_next_frame_set_file_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file,
+                   frame_set->long_stride_next_frame_set_file_pos,
+                   SEEK_SET);
+
+        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+                __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+
+        contents_start_pos = ftello(tng_data->output_file);
+
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (1 *
+                   sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+
+        if(tng_data->input_endianness_swap_func_64)
+        {
+            if(tng_data->input_endianness_swap_func_64(tng_data,
+                                                        &pos)
+                != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, __LINE__);
+            }
+        }
+
+        if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+
+        if(hash_mode == TNG_USE_HASH)
+        {
+            tng_md5_hash_update(tng_data, block,
+                                frame_set->long_stride_next_frame_set_file_pos,
+                                contents_start_pos);
+        }
+    }
+    /* Update the frame set one long stride step before */
+    if(frame_set->long_stride_prev_frame_set_file_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file,
+                   frame_set->long_stride_prev_frame_set_file_pos,
+                   SEEK_SET);
+
+        if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+                __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+
+        contents_start_pos = ftello(tng_data->output_file);
+
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (2 *
+                   sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+
+        if(tng_data->input_endianness_swap_func_64)
+        {
+            if(tng_data->input_endianness_swap_func_64(tng_data,
+                                                        &pos)
+                != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                        __FILE__, __LINE__);
+            }
+        }
+
+        if(tng_fwrite(tng_data, &pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+
+        if(hash_mode == TNG_USE_HASH)
+        {
+            tng_md5_hash_update(tng_data, block,
+                                frame_set->long_stride_prev_frame_set_file_pos,
+                                contents_start_pos);
+        }
+    }
+
+    tng_fseeko(tng_data, tng_data->output_file, output_file_pos, SEEK_SET);
+
+    tng_data->input_file = temp;
+
+    tng_block_destroy(&block);
+
+    return(TNG_SUCCESS);
+}
+
+static tng_function_status tng_reread_frame_set_at_file_pos
+                (const tng_trajectory_t tng_data,
+                 const int64_t pos)
+{
+    tng_gen_block_t block;
+    tng_function_status stat;
+
+    tng_block_init(&block);
+
+    tng_fseeko(tng_data, tng_data->input_file, pos, SEEK_SET);
+    if(pos > 0)
+    {
+        stat = tng_block_header_read(tng_data, block);
+        if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", pos,
+                    __FILE__, __LINE__);
+            tng_block_destroy(&block);
+            return(TNG_FAILURE);
+        }
+
+        if(tng_block_read_next(tng_data, block,
+                               TNG_SKIP_HASH) != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+    }
+
+    tng_block_destroy(&block);
+
+    return(TNG_SUCCESS);
+}
+
+static tng_function_status tng_file_pos_of_subsequent_trajectory_block_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *pos)
+{
+    int64_t orig_pos, curr_frame_set_pos;
+    tng_gen_block_t block;
+    tng_function_status stat;
+    tng_trajectory_frame_set_t frame_set =
+    &tng_data->current_trajectory_frame_set;
+
+    orig_pos = ftello(tng_data->input_file);
+    curr_frame_set_pos = tng_data->current_trajectory_frame_set_input_file_pos;
+
+    *pos = tng_data->first_trajectory_frame_set_input_file_pos;
 
     if(*pos <= 0)
     {
         return(TNG_SUCCESS);
     }
 
-    fseeko(tng_data->input_file, *pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, *pos, SEEK_SET);
 
     tng_block_init(&block);
     /* Read block headers first to see that a frame set block is found. */
@@ -1715,7 +3093,7 @@ static tng_function_status tng_file_pos_of_subsequent_trajectory_block_get
     /* Read all frame set blocks (not the blocks between them) */
     while(frame_set->next_frame_set_file_pos > 0)
     {
-        fseeko(tng_data->input_file, frame_set->next_frame_set_file_pos, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, frame_set->next_frame_set_file_pos, SEEK_SET);
         stat = tng_block_header_read(tng_data, block);
         if(stat == TNG_CRITICAL)
         {
@@ -1746,7 +3124,7 @@ static tng_function_status tng_file_pos_of_subsequent_trajectory_block_get
     /* Re-read the frame set that used to be the current one */
     tng_reread_frame_set_at_file_pos(tng_data, curr_frame_set_pos);
 
-    fseeko(tng_data->input_file, orig_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
 
     tng_block_destroy(&block);
 
@@ -1777,7 +3155,7 @@ static tng_function_status tng_frame_set_complete_migrate
         return(TNG_CRITICAL);
     }
 
-    fseeko(tng_data->input_file, block_start_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, block_start_pos, SEEK_SET);
 
     contents = (char *)malloc(block_len);
     if(!contents)
@@ -1786,16 +3164,16 @@ static tng_function_status tng_frame_set_complete_migrate
         return(TNG_CRITICAL);
     }
 
-    if(fread(contents, block_len, 1, tng_data->input_file) == 0)
+    if(tng_fread(tng_data, contents, block_len, 1, tng_data->input_file) == 0)
     {
         fprintf(stderr, "TNG library: Cannot read data from file when migrating data. %s: %d\n",
                __FILE__, __LINE__);
         free(contents);
         return(TNG_CRITICAL);
     }
-    fseeko(tng_data->output_file, new_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->output_file, new_pos, SEEK_SET);
 
-    if(fwrite(contents, block_len, 1, tng_data->output_file) != 1)
+    if(tng_fwrite(tng_data, contents, block_len, 1, tng_data->output_file) != 1)
     {
         fprintf(stderr, "TNG library: Could not write data to file when migrating data. %s: %d\n",
                 __FILE__, __LINE__);
@@ -1829,10 +3207,10 @@ static tng_function_status tng_frame_set_complete_migrate
 
     /* Fill the block with NULL to avoid confusion. */
     memset(contents, '\0', block_len);
-    fseeko(tng_data->output_file, block_start_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->output_file, block_start_pos, SEEK_SET);
 
     /* FIXME: casting block_len to size_t is dangerous */
-    fwrite(contents, 1, block_len, tng_data->output_file);
+    tng_fwrite(tng_data, contents, 1, block_len, tng_data->output_file);
 
     free(contents);
 
@@ -1852,7 +3230,7 @@ static tng_function_status tng_length_of_current_frame_set_contents_get
 
     *len = 0;
 
-    fseeko(tng_data->input_file, curr_frame_set_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, curr_frame_set_pos, SEEK_SET);
 
     tng_block_init(&block);
     /* Read block headers first to see that a frame set block is found. */
@@ -1868,7 +3246,7 @@ static tng_function_status tng_length_of_current_frame_set_contents_get
     /* Read the headers of all blocks in the frame set (not the actual contents of them) */
     while(stat == TNG_SUCCESS)
     {
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
         *len += block->header_contents_size + block->block_contents_size;
         pos += block->header_contents_size + block->block_contents_size;
         if(pos >= tng_data->input_file_len)
@@ -1885,7 +3263,7 @@ static tng_function_status tng_length_of_current_frame_set_contents_get
     /* Re-read the frame set that used to be the current one */
     tng_reread_frame_set_at_file_pos(tng_data, curr_frame_set_pos);
 
-    fseeko(tng_data->input_file, orig_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
 
     tng_block_destroy(&block);
 
@@ -1940,7 +3318,7 @@ static tng_function_status tng_migrate_data_in_file
 
     while(empty_space < offset)
     {
-        fseeko(tng_data->input_file, traj_start_pos, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, traj_start_pos, SEEK_SET);
         stat = tng_block_header_read(tng_data, block);
         if(stat == TNG_CRITICAL)
         {
@@ -1971,7 +3349,7 @@ static tng_function_status tng_migrate_data_in_file
 
         empty_space += frame_set_length;
     }
-    fseeko(tng_data->input_file, orig_file_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, orig_file_pos, SEEK_SET);
     tng_block_destroy(&block);
 
     return(TNG_SUCCESS);
@@ -2063,7 +3441,7 @@ static tng_function_status tng_block_header_write
         return(TNG_CRITICAL);
     }
 
-    if(fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+    if(tng_fwrite(tng_data, block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
     {
         fprintf(stderr, "TNG library: Could not write header data. %s: %d\n", __FILE__, __LINE__);
         return(TNG_CRITICAL);
@@ -2084,6 +3462,109 @@ static tng_function_status tng_block_header_write
     return(TNG_SUCCESS);
 }
 
+/**
+ * @brief Encode the header of a block, regardless of its type, in a buffer.
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container. Its header_contents_size must
+ * already be calculated.
+ * @param dest is the buffer, which must have room for
+ * block->header_contents_size bytes.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_block_header_encode
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 char *dest)
+{
+    size_t name_len;
+
+    dest = tng_buffer_numerical_put(tng_data, dest, &block->header_contents_size,
+                                    sizeof(block->header_contents_size));
+    dest = tng_buffer_numerical_put(tng_data, dest, &block->block_contents_size,
+                                    sizeof(block->block_contents_size));
+    dest = tng_buffer_numerical_put(tng_data, dest, &block->id, sizeof(block->id));
+    memcpy(dest, block->md5_hash, TNG_MD5_HASH_LEN);
+    dest += TNG_MD5_HASH_LEN;
+    name_len = tng_min_size(strlen(block->name) + 1, TNG_MAX_STR_LEN);
+    memcpy(dest, block->name, name_len);
+    dest += name_len;
+    tng_buffer_numerical_put(tng_data, dest, &block->block_version,
+                             sizeof(block->block_version));
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Allocate memory for encoding a block, regardless of its type.
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container. Its name and contents size must
+ * be set. Its header size is calculated.
+ * @param encoded is set to the allocated memory, which has room for both the
+ * block header and the block contents.
+ * @param encoded_len is set to the length of the encoded block.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_block_encoding_init
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 char **encoded,
+                 int64_t *encoded_len)
+{
+    if(tng_block_header_len_calculate(tng_data, block, &block->header_contents_size) !=
+        TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot calculate length of block header. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    *encoded_len = block->header_contents_size + block->block_contents_size;
+    *encoded = (char *)malloc(*encoded_len);
+    if(!*encoded)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Finish encoding a block, regardless of its type, by generating the
+ * md5 hash of its contents and encoding its block header.
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param encoded is the block allocated by tng_block_encoding_init(), with its
+ * contents already encoded after the room for the block header.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_block_encoding_finish
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 const char hash_mode,
+                 char *encoded)
+{
+    md5_state_t md5_state;
+
+    if(hash_mode == TNG_USE_HASH)
+    {
+        md5_init(&md5_state);
+        tng_md5_append(tng_data, &md5_state, (md5_byte_t *)encoded + block->header_contents_size,
+                       block->block_contents_size);
+        md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
+    }
+    else
+    {
+        memset(block->md5_hash, '\0', TNG_MD5_HASH_LEN);
+    }
+
+    return(tng_block_header_encode(tng_data, block, encoded));
+}
+
 static tng_function_status tng_general_info_block_len_calculate
                 (const tng_trajectory_t tng_data,
                  int64_t *len)
@@ -2374,7 +3855,7 @@ static tng_function_status tng_general_info_block_read
     else
     {
         /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
     }
 
     return(TNG_SUCCESS);
@@ -2402,7 +3883,7 @@ static tng_function_status tng_general_info_block_write
         return(TNG_CRITICAL);
     }
 
-    fseeko(tng_data->output_file, 0, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_SET);
 
     tng_block_init(&block);
 
@@ -2552,19 +4033,20 @@ static tng_function_status tng_general_info_block_write
     {
         return(TNG_CRITICAL);
     }
+
     if(hash_mode == TNG_USE_HASH)
     {
         md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
         curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos +
-               3 * sizeof(int64_t), SEEK_SET);
-        if(fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+        tng_fseeko(tng_data, tng_data->output_file, header_file_pos +
+                   3 * sizeof(int64_t), SEEK_SET);
+        if(tng_fwrite(tng_data, block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
         {
             fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__,
                     __LINE__);
             return(TNG_CRITICAL);
         }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->output_file, curr_file_pos, SEEK_SET);
     }
 
     tng_block_destroy(&block);
@@ -2573,46 +4055,196 @@ static tng_function_status tng_general_info_block_write
 }
 
 /**
- * @brief Read the chain data of a molecules block.
+ * @brief Read a compression algorithms block. Populate the TNG compression
+ * algorithms of positions and velocities in tng_data.
  * @param tng_data is a trajectory data container.
- * @param chain is the chain data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
  */
-static tng_function_status tng_chain_data_read(const tng_trajectory_t tng_data,
-                                               const tng_chain_t chain,
-                                               const char hash_mode,
-                                               md5_state_t *md5_state)
+static tng_function_status tng_compress_algo_block_read
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 const char hash_mode)
 {
-    if(tng_file_input_numerical(tng_data, &chain->id,
-                                sizeof(chain->id),
-                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    int64_t start_pos;
+    char hash[TNG_MD5_HASH_LEN];
+    md5_state_t md5_state;
+
+    TNG_ASSERT(block != 0, "TNG library: Trying to read data to an uninitialized block (NULL pointer)");
+
+    if(tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
         return(TNG_CRITICAL);
     }
 
-    tng_freadstr(tng_data, &chain->name, hash_mode, md5_state, __LINE__);
+    start_pos = ftello(tng_data->input_file);
 
-    if(tng_file_input_numerical(tng_data, &chain->n_residues,
-                                sizeof(chain->n_residues),
-                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if(hash_mode == TNG_USE_HASH)
+    {
+        md5_init(&md5_state);
+    }
+
+    if(tng_compress_algo_stored_read(tng_data, block, start_pos,
+                                     hash_mode, &md5_state) == TNG_CRITICAL)
     {
         return(TNG_CRITICAL);
     }
 
-    return(TNG_SUCCESS);
-}
+    if(hash_mode == TNG_USE_HASH)
+    {
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_md5_remaining_append(tng_data, block, start_pos, &md5_state);
 
-/**
- * @brief Write the chain data of a molecules block.
- * @param tng_data is a trajectory data container.
- * @param chain is the chain data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
+        md5_finish(&md5_state, (md5_byte_t *)hash);
+        if(strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
+        {
+            if(strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
+            {
+                fprintf(stderr, "TNG library: Compression algorithms block contents corrupt. "
+                        "Hashes do not match. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
+    }
+    else
+    {
+        /* Seek to the end of the block */
+        tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+    }
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Write a compression algorithms block at the current position of the
+ * output file. It is written after the other non-trajectory blocks, so that
+ * the blocks before it keep their positions.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_compress_algo_block_write
+                (const tng_trajectory_t tng_data,
+                 const char hash_mode)
+{
+    int64_t header_file_pos, curr_file_pos;
+    size_t name_len;
+    tng_gen_block_t block;
+    md5_state_t md5_state;
+
+    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    tng_block_init(&block);
+
+    name_len = strlen("COMPRESSION ALGORITHMS");
+
+    block->name = (char *)malloc(name_len + 1);
+    if(!block->name)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    strcpy(block->name, "COMPRESSION ALGORITHMS");
+    block->id = TNG_COMPRESSION_ALGORITHMS;
+
+    tng_compress_algo_block_len_calculate(tng_data, &block->block_contents_size);
+
+    header_file_pos = ftello(tng_data->output_file);
+
+    if(tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
+               tng_data->output_file_path, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    if(hash_mode == TNG_USE_HASH)
+    {
+        md5_init(&md5_state);
+    }
+
+    if(tng_compress_algo_stored_write(tng_data, hash_mode, &md5_state) == TNG_CRITICAL)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    if(hash_mode == TNG_USE_HASH)
+    {
+        md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
+        curr_file_pos = ftello(tng_data->output_file);
+        tng_fseeko(tng_data, tng_data->output_file, header_file_pos +
+                   3 * sizeof(int64_t), SEEK_SET);
+        if(tng_fwrite(tng_data, block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+        {
+            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__,
+                    __LINE__);
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+        tng_fseeko(tng_data, tng_data->output_file, curr_file_pos, SEEK_SET);
+    }
+
+    tng_block_destroy(&block);
+
+    tng_data->compress_algo_block_output_file_pos = header_file_pos;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Read the chain data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param chain is the chain data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
+ */
+static tng_function_status tng_chain_data_read(const tng_trajectory_t tng_data,
+                                               const tng_chain_t chain,
+                                               const char hash_mode,
+                                               md5_state_t *md5_state)
+{
+    if(tng_file_input_numerical(tng_data, &chain->id,
+                                sizeof(chain->id),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    tng_freadstr_interned(tng_data, &chain->name, hash_mode, md5_state, __LINE__);
+
+    if(tng_file_input_numerical(tng_data, &chain->n_residues,
+                                sizeof(chain->n_residues),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Write the chain data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param chain is the chain data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
  */
 static tng_function_status tng_chain_data_write(const tng_trajectory_t tng_data,
                                                 const tng_chain_t chain,
@@ -2663,7 +4295,7 @@ static tng_function_status tng_residue_data_read(const tng_trajectory_t tng_data
         return(TNG_CRITICAL);
     }
 
-    tng_freadstr(tng_data, &residue->name, hash_mode, md5_state, __LINE__);
+    tng_freadstr_interned(tng_data, &residue->name, hash_mode, md5_state, __LINE__);
 
     if(tng_file_input_numerical(tng_data, &residue->n_atoms,
                                 sizeof(residue->n_atoms),
@@ -2733,9 +4365,9 @@ static tng_function_status tng_atom_data_read(const tng_trajectory_t tng_data,
         return(TNG_CRITICAL);
     }
 
-    tng_freadstr(tng_data, &atom->name, hash_mode, md5_state, __LINE__);
+    tng_freadstr_interned(tng_data, &atom->name, hash_mode, md5_state, __LINE__);
 
-    tng_freadstr(tng_data, &atom->atom_type, hash_mode, md5_state, __LINE__);
+    tng_freadstr_interned(tng_data, &atom->atom_type, hash_mode, md5_state, __LINE__);
 
     return(TNG_SUCCESS);
 }
@@ -2792,36 +4424,14 @@ static tng_function_status tng_molecules_block_len_calculate
     for(i = 0; i < tng_data->n_molecules; i++)
     {
         molecule = &tng_data->molecules[i];
-        if(!molecule->name)
-        {
-            molecule->name = (char *)malloc(1);
-            if(!molecule->name)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                       __FILE__, __LINE__);
-                return(TNG_CRITICAL);
-            }
-            molecule->name[0] = 0;
-        }
-        *len += tng_min_size(strlen(molecule->name) + 1, TNG_MAX_STR_LEN);
+        *len += tng_str_written_len(molecule->name);
 
         chain = molecule->chains;
         for(j = 0; j < molecule->n_chains; j++)
         {
             *len += sizeof(chain->id);
 
-            if(!chain->name)
-            {
-                chain->name = (char *)malloc(1);
-                if(!chain->name)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(TNG_CRITICAL);
-                }
-                chain->name[0] = 0;
-            }
-            *len += tng_min_size(strlen(chain->name) + 1, TNG_MAX_STR_LEN);
+            *len += tng_str_written_len(chain->name);
 
             *len += sizeof(chain->n_residues);
 
@@ -2833,18 +4443,7 @@ static tng_function_status tng_molecules_block_len_calculate
         {
             *len += sizeof(residue->id);
 
-            if(!residue->name)
-            {
-                residue->name = (char *)malloc(1);
-                if(!residue->name)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(TNG_CRITICAL);
-                }
-                residue->name[0] = 0;
-            }
-            *len += tng_min_size(strlen(residue->name) + 1, TNG_MAX_STR_LEN);
+            *len += tng_str_written_len(residue->name);
 
             *len += sizeof(residue->n_atoms);
 
@@ -2855,31 +4454,9 @@ static tng_function_status tng_molecules_block_len_calculate
         for(j = 0; j < molecule->n_atoms; j++)
         {
             *len += sizeof(atom->id);
-            if(!atom->name)
-            {
-                atom->name = (char *)malloc(1);
-                if(!atom->name)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(TNG_CRITICAL);
-                }
-                atom->name[0] = 0;
-            }
-            *len += tng_min_size(strlen(atom->name) + 1, TNG_MAX_STR_LEN);
+            *len += tng_str_written_len(atom->name);
 
-            if(!atom->atom_type)
-            {
-                atom->atom_type = (char *)malloc(1);
-                if(!atom->atom_type)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(TNG_CRITICAL);
-                }
-                atom->atom_type[0] = 0;
-            }
-            *len += tng_min_size(strlen(atom->atom_type) + 1, TNG_MAX_STR_LEN);
+            *len += tng_str_written_len(atom->atom_type);
 
             atom++;
         }
@@ -2907,232 +4484,819 @@ static tng_function_status tng_molecules_block_len_calculate
 }
 
 /**
- * @brief Read a molecules block. Contains chain, residue and atom data
+ * @brief Free the topology index and the connectivity, so that they are
+ * rebuilt the next time they are needed. This must be called whenever the
+ * molecules, the number of atoms, residues or bonds in them or the molecule
+ * counts change.
  * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
- * compared to the md5 hash of the read contents to ensure valid data.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
  */
-static tng_function_status tng_molecules_block_read
-                (const tng_trajectory_t tng_data,
-                 const tng_gen_block_t block,
-                 const char hash_mode)
+static void tng_topology_index_free(const tng_trajectory_t tng_data)
 {
-    int64_t start_pos, i, j, k, l;
-    tng_molecule_t molecule;
-    tng_chain_t chain;
-    tng_residue_t residue;
-    tng_atom_t atom;
-    tng_bond_t bond;
-    char hash[TNG_MD5_HASH_LEN];
-    md5_state_t md5_state;
-
-    if(tng_input_file_init(tng_data) != TNG_SUCCESS)
+    if(tng_data->connectivity_offsets)
     {
-        return(TNG_CRITICAL);
+        free(tng_data->connectivity_offsets);
+        tng_data->connectivity_offsets = 0;
+    }
+    if(tng_data->connectivity_neighbors)
+    {
+        free(tng_data->connectivity_neighbors);
+        tng_data->connectivity_neighbors = 0;
+    }
+    if(tng_data->connectivity_offsets_32)
+    {
+        free(tng_data->connectivity_offsets_32);
+        tng_data->connectivity_offsets_32 = 0;
+    }
+    if(tng_data->connectivity_neighbors_32)
+    {
+        free(tng_data->connectivity_neighbors_32);
+        tng_data->connectivity_neighbors_32 = 0;
+    }
+    if(tng_data->topology_particle_offsets)
+    {
+        free(tng_data->topology_particle_offsets);
+        tng_data->topology_particle_offsets = 0;
     }
+    if(tng_data->topology_residue_offsets)
+    {
+        free(tng_data->topology_residue_offsets);
+        tng_data->topology_residue_offsets = 0;
+    }
+}
 
-    start_pos = ftello(tng_data->input_file);
+/**
+ * @brief Build the topology index, prefix sums of the number of particles and
+ * residues of all molecules of each molecule type, if it is not built already.
+ * @param tng_data is a trajectory data container.
+ * @param molecule_cnt_list will be pointing to the molecule counts used.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if there are no
+ * molecule counts or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_topology_index_get
+                (const tng_trajectory_t tng_data,
+                 int64_t **molecule_cnt_list)
+{
+    int64_t i;
+    tng_molecule_t mol;
 
-    /* FIXME: Does not check if the size of the contents matches the expected
-     * size or if the contents can be read. */
+    *molecule_cnt_list = 0;
+    tng_molecule_cnt_list_get(tng_data, molecule_cnt_list);
 
-    if(tng_data->molecules)
+    if(!*molecule_cnt_list)
     {
-        for(i=0; i<tng_data->n_molecules; i++)
-        {
-            tng_molecule_destroy(tng_data, &tng_data->molecules[i]);
-        }
-        free(tng_data->molecules);
-        tng_data->molecules = 0;
-        tng_data->n_molecules = 0;
+        return(TNG_FAILURE);
     }
 
-    if(hash_mode == TNG_USE_HASH)
+    if(tng_data->topology_particle_offsets)
     {
-        md5_init(&md5_state);
+        return(TNG_SUCCESS);
     }
 
-    if(tng_file_input_numerical(tng_data, &tng_data->n_molecules,
-                                sizeof(tng_data->n_molecules),
-                                hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    tng_data->topology_particle_offsets = (int64_t *)malloc(sizeof(int64_t) *
+                                                           (tng_data->n_molecules + 1));
+    tng_data->topology_residue_offsets = (int64_t *)malloc(sizeof(int64_t) *
+                                                          (tng_data->n_molecules + 1));
+    if(!tng_data->topology_particle_offsets || !tng_data->topology_residue_offsets)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_topology_index_free(tng_data);
         return(TNG_CRITICAL);
     }
 
-    if(tng_data->molecules)
+    tng_data->topology_particle_offsets[0] = 0;
+    tng_data->topology_residue_offsets[0] = 0;
+    for(i = 0; i < tng_data->n_molecules; i++)
     {
-        free(tng_data->molecules);
+        mol = &tng_data->molecules[i];
+        tng_data->topology_particle_offsets[i + 1] = tng_data->topology_particle_offsets[i] +
+                                                     mol->n_atoms * (*molecule_cnt_list)[i];
+        tng_data->topology_residue_offsets[i + 1] = tng_data->topology_residue_offsets[i] +
+                                                    mol->n_residues * (*molecule_cnt_list)[i];
     }
 
-    tng_data->n_particles = 0;
+    return(TNG_SUCCESS);
+}
 
-    tng_data->molecules = (struct tng_molecule *)malloc(tng_data->n_molecules *
-                                                        sizeof(struct tng_molecule));
-    if(!tng_data->molecules)
+/**
+ * @brief Find the molecule type, the molecule instance and the atom of a
+ * particle using the topology index.
+ * @param tng_data is a trajectory data container.
+ * @param nr is the index of the particle.
+ * @param mol_index is set to the index of the molecule type.
+ * @param instance is set to the index of the molecule among the molecules of
+ * that type.
+ * @param atom_index is set to the index of the atom in the molecule.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the particle
+ * cannot be found or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_particle_topology_find
+                (const tng_trajectory_t tng_data,
+                 const int64_t nr,
+                 int64_t *mol_index,
+                 int64_t *instance,
+                 int64_t *atom_index)
+{
+    int64_t low, high, mid, *molecule_cnt_list;
+    int64_t *offsets;
+    tng_function_status stat;
+
+    stat = tng_topology_index_get(tng_data, &molecule_cnt_list);
+    if(stat != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return(TNG_CRITICAL);
+        return(stat);
     }
 
-    if(!tng_data->var_num_atoms_flag)
+    offsets = tng_data->topology_particle_offsets;
+    if(nr < 0 || nr >= offsets[tng_data->n_molecules])
     {
-        if(tng_data->molecule_cnt_list)
+        return(TNG_FAILURE);
+    }
+
+    /* Find the last molecule type starting at or before nr. Molecule types
+     * without particles start at the same particle as the next type. */
+    low = 0;
+    high = tng_data->n_molecules - 1;
+    while(low < high)
+    {
+        mid = low + (high - low + 1) / 2;
+        if(offsets[mid] <= nr)
         {
-            free(tng_data->molecule_cnt_list);
+            low = mid;
         }
-        tng_data->molecule_cnt_list = (int64_t *)malloc(sizeof(int64_t) *
-                                                        tng_data->n_molecules);
-        if(!tng_data->molecule_cnt_list)
+        else
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return(TNG_CRITICAL);
+            high = mid - 1;
         }
     }
 
-    /* Read each molecule from file */
-    for(i=0; i < tng_data->n_molecules; i++)
-    {
-        molecule = &tng_data->molecules[i];
+    *mol_index = low;
+    *instance = (nr - offsets[low]) / tng_data->molecules[low].n_atoms;
+    *atom_index = (nr - offsets[low]) % tng_data->molecules[low].n_atoms;
 
-        molecule->name = 0;
+    return(TNG_SUCCESS);
+}
 
-        if(tng_file_input_numerical(tng_data, &molecule->id,
-                                    sizeof(molecule->id),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+/**
+ * @brief Make sure that the molecular system has a reference count, which
+ * is needed to share it with other trajectories.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_molecular_system_ref_count_init(const tng_trajectory_t tng_data)
+{
+    if(tng_data->molecules_ref_count)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    tng_data->molecules_ref_count = (int64_t *)malloc(sizeof(int64_t));
+    if(!tng_data->molecules_ref_count)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    *tng_data->molecules_ref_count = 1;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Drop a reference to a molecular system. The molecules and their
+ * names are freed if no other trajectory uses them.
+ * @param tng_data is a trajectory data container.
+ * @param molecules is the list of molecules.
+ * @param n_molecules is the number of molecules in the list.
+ * @param name_pool is the string pool containing the names.
+ * @param ref_count is the reference count of the molecules (or NULL if
+ * they have never been shared).
+ */
+static void tng_molecules_unref(const tng_trajectory_t tng_data,
+                                const tng_molecule_t molecules,
+                                const int64_t n_molecules,
+                                struct tng_string_pool *name_pool,
+                                int64_t *ref_count)
+{
+    int64_t i;
+
+    if(ref_count)
+    {
+        if(tng_ref_count_add(ref_count, -1) > 0)
         {
-            return(TNG_CRITICAL);
+            return;
         }
+        free(ref_count);
+    }
 
-/*         fprintf(stderr, "TNG library: Read id: %" PRId64 " offset: %d\n", molecule->id, offset);*/
-        tng_freadstr(tng_data, &molecule->name, hash_mode, &md5_state, __LINE__);
+    if(molecules)
+    {
+        for(i = 0; i < n_molecules; i++)
+        {
+            tng_molecule_destroy(tng_data, &molecules[i]);
+        }
+        free(molecules);
+    }
+    tng_string_pool_free(&name_pool);
+}
 
-        if(tng_file_input_numerical(tng_data, &molecule->quaternary_str,
-                                    sizeof(molecule->quaternary_str),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+/**
+ * @brief Remove the molecular system from a trajectory. The molecules and
+ * their names are freed, unless they are still used by another trajectory.
+ * The molecule count list is not changed.
+ * @param tng_data is a trajectory data container.
+ */
+static void tng_molecular_system_release(const tng_trajectory_t tng_data)
+{
+    tng_topology_index_free(tng_data);
+
+    tng_molecules_unref(tng_data, tng_data->molecules, tng_data->n_molecules,
+                        tng_data->name_pool, tng_data->molecules_ref_count);
+    tng_molecules_unref(tng_data, tng_data->detached_molecules,
+                        tng_data->n_detached_molecules,
+                        tng_data->detached_name_pool,
+                        tng_data->detached_molecules_ref_count);
+
+    tng_data->molecules = 0;
+    tng_data->n_molecules = 0;
+    tng_data->molecules_capacity = 0;
+    tng_data->name_pool = 0;
+    tng_data->molecules_ref_count = 0;
+    tng_data->detached_molecules = 0;
+    tng_data->n_detached_molecules = 0;
+    tng_data->detached_name_pool = 0;
+    tng_data->detached_molecules_ref_count = 0;
+}
+
+/**
+ * @brief Let a trajectory use the molecular system of another trajectory.
+ * The molecules are shared until one of the trajectories modifies them.
+ * The molecule counts are copied.
+ * @param src is the trajectory containing the molecular system.
+ * @param dest is the trajectory that will share the molecular system. Its
+ * current molecular system is released.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_molecular_system_share(const tng_trajectory_t src,
+                                                      const tng_trajectory_t dest)
+{
+    int64_t *new_molecule_cnt_list = 0;
+
+    if(src == dest)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    if(src->molecule_cnt_list && src->n_molecules > 0)
+    {
+        new_molecule_cnt_list = (int64_t *)malloc(sizeof(int64_t) * src->n_molecules);
+        if(!new_molecule_cnt_list)
         {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
             return(TNG_CRITICAL);
         }
+        memcpy(new_molecule_cnt_list, src->molecule_cnt_list,
+               sizeof(int64_t) * src->n_molecules);
+    }
 
-        if(!tng_data->var_num_atoms_flag)
+    tng_molecular_system_release(dest);
+
+    if(dest->molecule_cnt_list)
+    {
+        free(dest->molecule_cnt_list);
+    }
+    dest->molecule_cnt_list = new_molecule_cnt_list;
+
+    if(src->molecules_ref_count)
+    {
+        tng_ref_count_add(src->molecules_ref_count, 1);
+        dest->molecules_ref_count = src->molecules_ref_count;
+        dest->molecules = src->molecules;
+        dest->n_molecules = src->n_molecules;
+        /* The molecule count list only has room for n_molecules. */
+        dest->molecules_capacity = src->n_molecules;
+        dest->name_pool = src->name_pool;
+    }
+    dest->n_particles = src->n_particles;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Make a copy of a molecule with its own chains, residues, atoms and
+ * bonds.
+ * @param src is the molecule to copy.
+ * @param dest is the molecule to copy to. It does not need to be
+ * initialised.
+ * @param pool_p is a pointer to the string pool in which to store the
+ * names of the copy.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured, in which case dest must still be destroyed.
+ */
+static tng_function_status tng_molecule_copy(const tng_molecule_t src,
+                                             const tng_molecule_t dest,
+                                             struct tng_string_pool **pool_p)
+{
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    int64_t i;
+
+    *dest = *src;
+    dest->chains = 0;
+    dest->residues = 0;
+    dest->atoms = 0;
+    dest->bonds = 0;
+    dest->chains_capacity = 0;
+    dest->residues_capacity = 0;
+    dest->atoms_capacity = 0;
+    dest->bonds_capacity = 0;
+
+    if(src->n_chains > 0)
+    {
+        dest->chains = (tng_chain_t)malloc(sizeof(struct tng_chain) * src->n_chains);
+        if(!dest->chains)
         {
-            if(tng_file_input_numerical(tng_data, &tng_data->molecule_cnt_list[i],
-                                        sizeof(int64_t),
-                                        hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-            {
-                return(TNG_CRITICAL);
-            }
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
         }
-
-        if(tng_file_input_numerical(tng_data, &molecule->n_chains,
-                                    sizeof(molecule->n_chains),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        memcpy(dest->chains, src->chains, sizeof(struct tng_chain) * src->n_chains);
+        dest->chains_capacity = src->n_chains;
+    }
+    if(src->n_residues > 0)
+    {
+        dest->residues = (tng_residue_t)malloc(sizeof(struct tng_residue) * src->n_residues);
+        if(!dest->residues)
         {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
             return(TNG_CRITICAL);
         }
-
-        if(tng_file_input_numerical(tng_data, &molecule->n_residues,
-                                    sizeof(molecule->n_residues),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        memcpy(dest->residues, src->residues, sizeof(struct tng_residue) * src->n_residues);
+        dest->residues_capacity = src->n_residues;
+    }
+    if(src->n_atoms > 0)
+    {
+        dest->atoms = (tng_atom_t)malloc(sizeof(struct tng_atom) * src->n_atoms);
+        if(!dest->atoms)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+        memcpy(dest->atoms, src->atoms, sizeof(struct tng_atom) * src->n_atoms);
+        dest->atoms_capacity = src->n_atoms;
+    }
+    if(src->n_bonds > 0)
+    {
+        dest->bonds = (tng_bond_t)malloc(sizeof(struct tng_bond) * src->n_bonds);
+        if(!dest->bonds)
         {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
             return(TNG_CRITICAL);
         }
+        memcpy(dest->bonds, src->bonds, sizeof(struct tng_bond) * src->n_bonds);
+        dest->bonds_capacity = src->n_bonds;
+    }
 
-        if(tng_file_input_numerical(tng_data, &molecule->n_atoms,
-                                    sizeof(molecule->n_atoms),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    /* Point the copies at each other and store the names in the new pool. */
+    if(src->name &&
+       tng_string_pool_intern(pool_p, src->name, &dest->name) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+    for(i = 0; i < dest->n_chains; i++)
+    {
+        chain = &dest->chains[i];
+        chain->molecule = dest;
+        chain->residues = chain->n_residues > 0 ?
+                          dest->residues + (src->chains[i].residues - src->residues) : 0;
+        if(chain->name &&
+           tng_string_pool_intern(pool_p, chain->name, &chain->name) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+    for(i = 0; i < dest->n_residues; i++)
+    {
+        residue = &dest->residues[i];
+        if(residue->chain)
+        {
+            residue->chain = dest->chains + (residue->chain - src->chains);
+        }
+        if(residue->name &&
+           tng_string_pool_intern(pool_p, residue->name, &residue->name) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+    for(i = 0; i < dest->n_atoms; i++)
+    {
+        atom = &dest->atoms[i];
+        if(atom->residue)
+        {
+            atom->residue = dest->residues + (atom->residue - src->residues);
+        }
+        if(atom->name &&
+           tng_string_pool_intern(pool_p, atom->name, &atom->name) != TNG_SUCCESS)
         {
             return(TNG_CRITICAL);
         }
+        if(atom->atom_type &&
+           tng_string_pool_intern(pool_p, atom->atom_type, &atom->atom_type) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
 
-        tng_data->n_particles += molecule->n_atoms *
-                                 tng_data->molecule_cnt_list[i];
+    return(TNG_SUCCESS);
+}
 
-        if(molecule->n_chains > 0)
-        {
-            molecule->chains = (struct tng_chain *)malloc(molecule->n_chains *
-                                                          sizeof(struct tng_chain));
-            if(!molecule->chains)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                        __FILE__, __LINE__);
-                return(TNG_CRITICAL);
-            }
+/**
+ * @brief Change pointers to molecules, chains, residues and atoms in one
+ * list of molecules to point at the same items in another list of molecules,
+ * which is a copy of the first one. Pointers that are not in the first list
+ * are not changed.
+ * @param from is the list of molecules that the pointers might point into.
+ * @param n_molecules is the number of molecules in from (to must contain at
+ * least as many).
+ * @param to is the list of molecules that the pointers should point into.
+ * @param molecule is a pointer to a molecule (or NULL).
+ * @param chain is a pointer to a chain (or NULL).
+ * @param residue is a pointer to a residue (or NULL).
+ * @param atom is a pointer to an atom (or NULL).
+ */
+static void tng_molecule_pointers_translate(const tng_molecule_t from,
+                                            const int64_t n_molecules,
+                                            const tng_molecule_t to,
+                                            tng_molecule_t *molecule,
+                                            tng_chain_t *chain,
+                                            tng_residue_t *residue,
+                                            tng_atom_t *atom)
+{
+    tng_molecule_t src_mol, dest_mol;
+    int64_t i;
 
-            chain = molecule->chains;
+    for(i = 0; i < n_molecules; i++)
+    {
+        src_mol = &from[i];
+        dest_mol = &to[i];
+        if(molecule && *molecule == src_mol)
+        {
+            *molecule = dest_mol;
         }
-        else
+        if(chain && *chain >= src_mol->chains &&
+           *chain < src_mol->chains + src_mol->n_chains)
         {
-            chain = 0;
+            *chain = dest_mol->chains + (*chain - src_mol->chains);
         }
-
-        if(molecule->n_residues > 0)
+        if(residue && *residue >= src_mol->residues &&
+           *residue < src_mol->residues + src_mol->n_residues)
         {
-            molecule->residues = (struct tng_residue *)malloc(molecule->n_residues *
-                                                              sizeof(struct tng_residue));
-            if(!molecule->residues)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                        __FILE__, __LINE__);
-                if(molecule->chains)
-                {
-                    free(molecule->chains);
-                    molecule->chains = 0;
-                }
-                return(TNG_CRITICAL);
-            }
-
-            residue = molecule->residues;
+            *residue = dest_mol->residues + (*residue - src_mol->residues);
         }
-        else
+        if(atom && *atom >= src_mol->atoms &&
+           *atom < src_mol->atoms + src_mol->n_atoms)
         {
-            residue = 0;
+            *atom = dest_mol->atoms + (*atom - src_mol->atoms);
         }
+    }
+}
 
-        molecule->atoms = (struct tng_atom *)malloc(molecule->n_atoms *
-                                                 sizeof(struct tng_atom));
-        if(!molecule->atoms)
+/**
+ * @brief Make sure that the molecular system of a trajectory is not shared
+ * with any other trajectory before modifying it. If it is shared, the
+ * trajectory gets its own copy of it (copy-on-write).
+ * @param tng_data is a trajectory data container.
+ * @param molecule is a pointer to a molecule (or NULL). If it points at a
+ * molecule in the shared molecular system, or in the molecular system used
+ * before the last copy, it is changed to point at the same molecule in the
+ * copy.
+ * @param chain is a pointer to a chain (or NULL), updated like molecule.
+ * @param residue is a pointer to a residue (or NULL), updated like molecule.
+ * @param atom is a pointer to an atom (or NULL), updated like molecule.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_molecular_system_unshare
+                (const tng_trajectory_t tng_data,
+                 tng_molecule_t *molecule,
+                 tng_chain_t *chain,
+                 tng_residue_t *residue,
+                 tng_atom_t *atom)
+{
+    tng_molecule_t new_molecules;
+    struct tng_string_pool *new_pool = 0;
+    int64_t i, j, n_molecules, *new_ref_count;
+    tng_function_status stat = TNG_SUCCESS;
+
+    if(!tng_data->molecules_ref_count ||
+       tng_ref_count_add(tng_data->molecules_ref_count, 0) <= 1)
+    {
+        /* Items retrieved before the last copy are still in the old
+         * molecular system. */
+        if(tng_data->detached_molecules)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            if(molecule->chains)
-            {
-                free(molecule->chains);
-                molecule->chains = 0;
-            }
-            if(molecule->residues)
-            {
-                free(molecule->residues);
-                molecule->residues = 0;
-            }
-            return(TNG_CRITICAL);
+            tng_molecule_pointers_translate(tng_data->detached_molecules,
+                                            tng_data->n_detached_molecules,
+                                            tng_data->molecules,
+                                            molecule, chain, residue, atom);
         }
+        return(TNG_SUCCESS);
+    }
 
-        atom = molecule->atoms;
+    n_molecules = tng_data->n_molecules;
 
-        if(molecule->n_chains > 0)
+    new_ref_count = (int64_t *)malloc(sizeof(int64_t));
+    new_molecules = (tng_molecule_t)malloc(sizeof(struct tng_molecule) *
+                                           tng_max_i64(n_molecules, 1));
+    if(!new_ref_count || !new_molecules)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        if(new_ref_count)
         {
-            /* Read the chains of the molecule */
-            for(j=0; j<molecule->n_chains; j++)
-            {
-                chain->molecule = molecule;
+            free(new_ref_count);
+        }
+        if(new_molecules)
+        {
+            free(new_molecules);
+        }
+        return(TNG_CRITICAL);
+    }
+    *new_ref_count = 1;
 
-                chain->name = 0;
+    for(i = 0; i < n_molecules && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_molecule_copy(&tng_data->molecules[i], &new_molecules[i], &new_pool);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        for(j = 0; j < i; j++)
+        {
+            tng_molecule_destroy(tng_data, &new_molecules[j]);
+        }
+        free(new_molecules);
+        free(new_ref_count);
+        tng_string_pool_free(&new_pool);
+        return(stat);
+    }
 
-                tng_chain_data_read(tng_data, chain, hash_mode, &md5_state);
+    tng_molecule_pointers_translate(tng_data->molecules, n_molecules,
+                                    new_molecules, molecule, chain, residue, atom);
 
-                if(j==0)
-                {
-                    chain->residues = molecule->residues;
-                    residue = chain->residues;
-                }
-                else
-                {
-                    chain->residues = residue;
-                }
+    /* Keep the shared molecular system (instead of the one from before an
+     * earlier copy) so that items retrieved from it can still be found. */
+    tng_molecules_unref(tng_data, tng_data->detached_molecules,
+                        tng_data->n_detached_molecules,
+                        tng_data->detached_name_pool,
+                        tng_data->detached_molecules_ref_count);
+    tng_data->detached_molecules = tng_data->molecules;
+    tng_data->n_detached_molecules = n_molecules;
+    tng_data->detached_name_pool = tng_data->name_pool;
+    tng_data->detached_molecules_ref_count = tng_data->molecules_ref_count;
+
+    tng_data->molecules = new_molecules;
+    tng_data->molecules_capacity = n_molecules;
+    tng_data->name_pool = new_pool;
+    tng_data->molecules_ref_count = new_ref_count;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Read a molecules block. Contains chain, residue and atom data
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_molecules_block_read
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 const char hash_mode)
+{
+    int64_t start_pos, i, j, k, l;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_bond_t bond;
+    char hash[TNG_MD5_HASH_LEN];
+    md5_state_t md5_state;
+
+    if(tng_input_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    start_pos = ftello(tng_data->input_file);
+
+    /* FIXME: Does not check if the size of the contents matches the expected
+     * size or if the contents can be read. */
+
+    tng_molecular_system_release(tng_data);
+
+    if(hash_mode == TNG_USE_HASH)
+    {
+        md5_init(&md5_state);
+    }
+
+    if(tng_file_input_numerical(tng_data, &tng_data->n_molecules,
+                                sizeof(tng_data->n_molecules),
+                                hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(tng_data->molecules)
+    {
+        free(tng_data->molecules);
+    }
+
+    tng_data->n_particles = 0;
+
+    tng_data->molecules = (struct tng_molecule *)malloc(tng_data->n_molecules *
+                                                        sizeof(struct tng_molecule));
+    if(!tng_data->molecules)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    tng_data->molecules_capacity = tng_data->n_molecules;
+
+    if(tng_molecular_system_ref_count_init(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(!tng_data->var_num_atoms_flag)
+    {
+        if(tng_data->molecule_cnt_list)
+        {
+            free(tng_data->molecule_cnt_list);
+        }
+        tng_data->molecule_cnt_list = (int64_t *)malloc(sizeof(int64_t) *
+                                                        tng_data->n_molecules);
+        if(!tng_data->molecule_cnt_list)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+    }
+
+    /* Read each molecule from file */
+    for(i=0; i < tng_data->n_molecules; i++)
+    {
+        molecule = &tng_data->molecules[i];
+
+        tng_molecule_init(tng_data, molecule);
+
+        if(tng_file_input_numerical(tng_data, &molecule->id,
+                                    sizeof(molecule->id),
+                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+
+/*         fprintf(stderr, "TNG library: Read id: %" PRId64 " offset: %d\n", molecule->id, offset);*/
+        tng_freadstr_interned(tng_data, &molecule->name, hash_mode, &md5_state, __LINE__);
+
+        if(tng_file_input_numerical(tng_data, &molecule->quaternary_str,
+                                    sizeof(molecule->quaternary_str),
+                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+
+        if(!tng_data->var_num_atoms_flag)
+        {
+            if(tng_file_input_numerical(tng_data, &tng_data->molecule_cnt_list[i],
+                                        sizeof(int64_t),
+                                        hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+            {
+                return(TNG_CRITICAL);
+            }
+        }
+
+        if(tng_file_input_numerical(tng_data, &molecule->n_chains,
+                                    sizeof(molecule->n_chains),
+                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+
+        if(tng_file_input_numerical(tng_data, &molecule->n_residues,
+                                    sizeof(molecule->n_residues),
+                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+
+        if(tng_file_input_numerical(tng_data, &molecule->n_atoms,
+                                    sizeof(molecule->n_atoms),
+                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+
+        tng_data->n_particles += molecule->n_atoms *
+                                 tng_data->molecule_cnt_list[i];
+
+        if(molecule->n_chains > 0)
+        {
+            molecule->chains = (struct tng_chain *)malloc(molecule->n_chains *
+                                                          sizeof(struct tng_chain));
+            if(!molecule->chains)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                return(TNG_CRITICAL);
+            }
+
+            chain = molecule->chains;
+        }
+        else
+        {
+            chain = 0;
+        }
+
+        if(molecule->n_residues > 0)
+        {
+            molecule->residues = (struct tng_residue *)malloc(molecule->n_residues *
+                                                              sizeof(struct tng_residue));
+            if(!molecule->residues)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                if(molecule->chains)
+                {
+                    free(molecule->chains);
+                    molecule->chains = 0;
+                }
+                return(TNG_CRITICAL);
+            }
+
+            residue = molecule->residues;
+        }
+        else
+        {
+            residue = 0;
+        }
+
+        molecule->atoms = (struct tng_atom *)malloc(molecule->n_atoms *
+                                                 sizeof(struct tng_atom));
+        if(!molecule->atoms)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            if(molecule->chains)
+            {
+                free(molecule->chains);
+                molecule->chains = 0;
+            }
+            if(molecule->residues)
+            {
+                free(molecule->residues);
+                molecule->residues = 0;
+            }
+            return(TNG_CRITICAL);
+        }
+
+        molecule->chains_capacity = molecule->n_chains;
+        molecule->residues_capacity = molecule->n_residues;
+        molecule->atoms_capacity = molecule->n_atoms;
+
+        atom = molecule->atoms;
+
+        if(molecule->n_chains > 0)
+        {
+            /* Read the chains of the molecule */
+            for(j=0; j<molecule->n_chains; j++)
+            {
+                chain->molecule = molecule;
+
+                chain->name = 0;
+
+                tng_chain_data_read(tng_data, chain, hash_mode, &md5_state);
+
+                if(j==0)
+                {
+                    chain->residues = molecule->residues;
+                    residue = chain->residues;
+                }
+                else
+                {
+                    chain->residues = residue;
+                }
 
                 /* Read the residues of the chain */
                 for(k=0; k<chain->n_residues; k++)
@@ -3235,6 +5399,8 @@ static tng_function_status tng_molecules_block_read
                 return(TNG_CRITICAL);
             }
 
+            molecule->bonds_capacity = molecule->n_bonds;
+
             bond = molecule->bonds;
 
             for(j=0; j<molecule->n_bonds; j++)
@@ -3282,7 +5448,7 @@ static tng_function_status tng_molecules_block_read
     else
     {
         /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
     }
 
     return(TNG_SUCCESS);
@@ -3501,15 +5667,15 @@ static tng_function_status tng_molecules_block_write
     {
         md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
         curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos +
-               3 * sizeof(int64_t), SEEK_SET);
-        if(fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+        tng_fseeko(tng_data, tng_data->output_file, header_file_pos +
+                   3 * sizeof(int64_t), SEEK_SET);
+        if(tng_fwrite(tng_data, block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
         {
             fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__,
                     __LINE__);
             return(TNG_CRITICAL);
         }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->output_file, curr_file_pos, SEEK_SET);
     }
 
     tng_block_destroy(&block);
@@ -3566,6 +5732,8 @@ static tng_function_status tng_frame_set_block_read
 
     tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
 
+    tng_statistics_count(tng_data, &tng_data->statistics.n_frame_sets_read, 1);
+
     tng_frame_set_particle_mapping_free(tng_data);
 
     if(hash_mode == TNG_USE_HASH)
@@ -3588,6 +5756,7 @@ static tng_function_status tng_frame_set_block_read
 
     if(tng_data->var_num_atoms_flag)
     {
+        tng_topology_index_free(tng_data);
         prev_n_particles = frame_set->n_particles;
         frame_set->n_particles = 0;
         /* If the list of molecule counts has already been created assume that
@@ -3705,7 +5874,7 @@ static tng_function_status tng_frame_set_block_read
     else
     {
         /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
     }
 
     /* If the output file and the input files are the same the number of
@@ -3721,30 +5890,30 @@ static tng_function_status tng_frame_set_block_read
 }
 
 /**
- * @brief Write tng_data->current_trajectory_frame_set to file
+ * @brief Encode tng_data->current_trajectory_frame_set, i.e. the frame set
+ * block, in memory.
  * @param tng_data is a trajectory data container.
  * @param block is a general block container.
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
  * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param encoded is set to the encoded block, including its block header,
+ * which must be freed by the caller.
+ * @param encoded_len is set to the length of the encoded block.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_frame_set_block_write
+static tng_function_status tng_frame_set_block_encode
                 (const tng_trajectory_t tng_data,
                  const tng_gen_block_t block,
-                 const char hash_mode)
+                 const char hash_mode,
+                 char **encoded,
+                 int64_t *encoded_len)
 {
-    char *temp_name;
-    int64_t i, header_file_pos, curr_file_pos;
+    char *temp_name, *dest, *pos;
+    int64_t i;
     unsigned int name_len;
     tng_trajectory_frame_set_t frame_set =
     &tng_data->current_trajectory_frame_set;
-    md5_state_t md5_state;
-
-    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return(TNG_CRITICAL);
-    }
 
     name_len = (unsigned int)strlen("TRAJECTORY FRAME SET");
 
@@ -3772,128 +5941,149 @@ static tng_function_status tng_frame_set_block_write
         return(TNG_CRITICAL);
     }
 
-    header_file_pos = ftello(tng_data->output_file);
-
-    if(tng_block_header_write(tng_data, block) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-               tng_data->output_file_path, __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-    }
-
-    if(hash_mode == TNG_USE_HASH)
-    {
-        md5_init(&md5_state);
-    }
-    if(tng_file_output_numerical(tng_data, &frame_set->first_frame,
-                                 sizeof(frame_set->first_frame),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
-
-    if(tng_file_output_numerical(tng_data, &frame_set->n_frames,
-                                 sizeof(frame_set->n_frames),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    if(tng_block_encoding_init(tng_data, block, &dest, encoded_len) != TNG_SUCCESS)
     {
         return(TNG_CRITICAL);
     }
 
+    pos = dest + block->header_contents_size;
+    pos = tng_buffer_numerical_put(tng_data, pos, &frame_set->first_frame,
+                                   sizeof(frame_set->first_frame));
+    pos = tng_buffer_numerical_put(tng_data, pos, &frame_set->n_frames,
+                                   sizeof(frame_set->n_frames));
     if(tng_data->var_num_atoms_flag)
     {
         for(i = 0; i < tng_data->n_molecules; i++)
         {
-            if(tng_file_output_numerical(tng_data, &frame_set->molecule_cnt_list[i],
-                                        sizeof(int64_t),
-                                        hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-            {
-                return(TNG_CRITICAL);
-            }
-        }
-    }
+            pos = tng_buffer_numerical_put(tng_data, pos, &frame_set->molecule_cnt_list[i],
+                                           sizeof(int64_t));
+        }
+    }
+    pos = tng_buffer_numerical_put(tng_data, pos, &frame_set->next_frame_set_file_pos,
+                                   sizeof(frame_set->next_frame_set_file_pos));
+    pos = tng_buffer_numerical_put(tng_data, pos, &frame_set->prev_frame_set_file_pos,
+                                   sizeof(frame_set->prev_frame_set_file_pos));
+    pos = tng_buffer_numerical_put(tng_data, pos,
+                                   &frame_set->medium_stride_next_frame_set_file_pos,
+                                   sizeof(frame_set->medium_stride_next_frame_set_file_pos));
+    pos = tng_buffer_numerical_put(tng_data, pos,
+                                   &frame_set->medium_stride_prev_frame_set_file_pos,
+                                   sizeof(frame_set->medium_stride_prev_frame_set_file_pos));
+    pos = tng_buffer_numerical_put(tng_data, pos,
+                                   &frame_set->long_stride_next_frame_set_file_pos,
+                                   sizeof(frame_set->long_stride_next_frame_set_file_pos));
+    pos = tng_buffer_numerical_put(tng_data, pos,
+                                   &frame_set->long_stride_prev_frame_set_file_pos,
+                                   sizeof(frame_set->long_stride_prev_frame_set_file_pos));
+    pos = tng_buffer_numerical_put(tng_data, pos, &frame_set->first_frame_time,
+                                   sizeof(frame_set->first_frame_time));
+    tng_buffer_numerical_put(tng_data, pos, &tng_data->time_per_frame,
+                             sizeof(tng_data->time_per_frame));
+
+    tng_block_encoding_finish(tng_data, block, hash_mode, dest);
+
+    *encoded = dest;
 
-    if(tng_file_output_numerical(tng_data, &frame_set->next_frame_set_file_pos,
-                                 sizeof(frame_set->next_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+    return(TNG_SUCCESS);
+}
 
-    if(tng_file_output_numerical(tng_data, &frame_set->prev_frame_set_file_pos,
-                                 sizeof(frame_set->prev_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+static tng_function_status tng_trajectory_mapping_block_len_calculate
+                (const tng_trajectory_t tng_data,
+                 const int64_t n_particles,
+                 int64_t *len)
+{
+    (void)tng_data;
+    *len = sizeof(int64_t) * (2 + n_particles);
 
-    if(tng_file_output_numerical(tng_data, &frame_set->medium_stride_next_frame_set_file_pos,
-                                 sizeof(frame_set->medium_stride_next_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+    return(TNG_SUCCESS);
+}
 
-    if(tng_file_output_numerical(tng_data, &frame_set->medium_stride_prev_frame_set_file_pos,
-                                 sizeof(frame_set->medium_stride_prev_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+/**
+ * @brief Get a table translating from the particle numbering used in a frame
+ * set to the real particle numbering - used in the molecule description.
+ * The table is built from the mapping blocks the first time it is needed and
+ * kept until the mappings of the frame set change.
+ * @param frame_set is the frame_set containing the mappings to use.
+ * @param n_particles is the number of particles in the frame set.
+ * @param table is set to point to the table, in which table[local] is the
+ * index of the atom in the molecular system. It is set to 0 if the frame set
+ * has no mappings, in which case the numbering is the same.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_particle_mapping_table_get
+                (const tng_trajectory_frame_set_t frame_set,
+                 const int64_t n_particles,
+                 const int64_t **table)
+{
+    int64_t i, j, local, *temp;
+    tng_particle_mapping_t mapping;
 
-    if(tng_file_output_numerical(tng_data, &frame_set->long_stride_next_frame_set_file_pos,
-                                 sizeof(frame_set->long_stride_next_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    if(frame_set->n_mapping_blocks <= 0)
     {
-        return(TNG_CRITICAL);
+        *table = 0;
+        return(TNG_SUCCESS);
     }
 
-    if(tng_file_output_numerical(tng_data, &frame_set->long_stride_prev_frame_set_file_pos,
-                                 sizeof(frame_set->long_stride_prev_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    if(frame_set->mapping_table &&
+       frame_set->mapping_table_n_particles == n_particles)
     {
-        return(TNG_CRITICAL);
+        *table = frame_set->mapping_table;
+        return(TNG_SUCCESS);
     }
 
-    if(tng_file_output_numerical(tng_data, &frame_set->first_frame_time,
-                                 sizeof(frame_set->first_frame_time),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    temp = (int64_t *)realloc(frame_set->mapping_table,
+                              sizeof(int64_t) * tng_max_i64(1, n_particles));
+    if(!temp)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(frame_set->mapping_table);
+        frame_set->mapping_table = 0;
+        frame_set->mapping_table_n_particles = 0;
         return(TNG_CRITICAL);
     }
+    frame_set->mapping_table = temp;
+    frame_set->mapping_table_n_particles = n_particles;
 
-    if(tng_file_output_numerical(tng_data, &tng_data->time_per_frame,
-                                 sizeof(tng_data->time_per_frame),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    /* Particles that are not mapped keep their numbering. */
+    for(i = 0; i < n_particles; i++)
     {
-        return(TNG_CRITICAL);
+        temp[i] = i;
     }
-    if(hash_mode == TNG_USE_HASH)
+    /* If mapping blocks overlap the first one applies, so fill the table
+     * from the last block. */
+    for(i = frame_set->n_mapping_blocks; i--;)
     {
-        md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos +
-               3 * sizeof(int64_t), SEEK_SET);
-        if(fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+        mapping = &frame_set->mappings[i];
+        for(j = 0; j < mapping->n_particles; j++)
         {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__,
-                    __LINE__);
-            return(TNG_CRITICAL);
+            local = mapping->num_first_particle + j;
+            if(local >= 0 && local < n_particles)
+            {
+                temp[local] = mapping->real_particle_numbers[j];
+            }
         }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
     }
 
+    *table = temp;
+
     return(TNG_SUCCESS);
 }
 
-static tng_function_status tng_trajectory_mapping_block_len_calculate
-                (const tng_trajectory_t tng_data,
-                 const int64_t n_particles,
-                 int64_t *len)
+/**
+ * @brief Free the table made by tng_particle_mapping_table_get(), so that it
+ * is rebuilt when the mappings of the frame set have changed.
+ * @param frame_set is the frame_set containing the mappings.
+ */
+static void tng_particle_mapping_table_free(const tng_trajectory_frame_set_t frame_set)
 {
-    (void)tng_data;
-    *len = sizeof(int64_t) * (2 + n_particles);
-
-    return(TNG_SUCCESS);
+    if(frame_set->mapping_table)
+    {
+        free(frame_set->mapping_table);
+        frame_set->mapping_table = 0;
+    }
+    frame_set->mapping_table_n_particles = 0;
 }
 
 /**
@@ -3912,7 +6102,7 @@ static tng_function_status tng_trajectory_mapping_block_read
                  const tng_gen_block_t block,
                  const char hash_mode)
 {
-    int64_t start_pos, i;
+    int64_t start_pos;
     tng_trajectory_frame_set_t frame_set =
     &tng_data->current_trajectory_frame_set;
     tng_particle_mapping_t mapping, mappings;
@@ -3929,6 +6119,8 @@ static tng_function_status tng_trajectory_mapping_block_read
     /* FIXME: Does not check if the size of the contents matches the expected
      * size or if the contents can be read. */
 
+    tng_particle_mapping_table_free(frame_set);
+
     frame_set->n_mapping_blocks++;
     mappings = (tng_particle_mapping_t)realloc(frame_set->mappings,
                                                sizeof(struct tng_particle_mapping) *
@@ -3973,33 +6165,23 @@ static tng_function_status tng_trajectory_mapping_block_read
         return(TNG_CRITICAL);
     }
 
-    /* If the byte order needs to be swapped the data must be read one value at
-     * a time and swapped */
-    if(tng_data->input_endianness_swap_func_64)
+    /* The data is read all at once and the byte order swapped afterwards. */
+    if(tng_fread(tng_data, mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t),
+                1, tng_data->input_file) == 0)
     {
-        for(i = 0; i < mapping->n_particles; i++)
-        {
-            if(tng_file_input_numerical(tng_data, &mapping->real_particle_numbers[i],
-                                        sizeof(int64_t),
-                                        hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-            {
-                return(TNG_CRITICAL);
-            }
-        }
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
     }
-    /* Otherwise the data can be read all at once */
-    else
+    if(hash_mode == TNG_USE_HASH)
     {
-        if(fread(mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t),
-                1, tng_data->input_file) == 0)
-        {
-            fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
-        if(hash_mode == TNG_USE_HASH)
-        {
-            md5_append(&md5_state, (md5_byte_t *)mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t));
-        }
+        tng_md5_append(tng_data, &md5_state, (md5_byte_t *)mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t));
+    }
+    if(tng_swap_byte_order_array_64(tng_data, tng_data->input_endianness_swap_func_64,
+                                    mapping->real_particle_numbers, mapping->n_particles)
+       != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                __FILE__, __LINE__);
     }
 
     if(hash_mode == TNG_USE_HASH)
@@ -4021,33 +6203,36 @@ static tng_function_status tng_trajectory_mapping_block_read
     else
     {
         /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
     }
 
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Write the atom mappings of the current trajectory frame set
+ * @brief Encode the atom mappings of the current trajectory frame set in
+ * memory.
  * @param tng_data is a trajectory data container.
  * @param block is a general block container.
- * @param mapping_block_nr is the index of the mapping block to write.
+ * @param mapping_block_nr is the index of the mapping block to encode.
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
  * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param encoded is set to the encoded block, including its block header,
+ * which must be freed by the caller.
+ * @param encoded_len is set to the length of the encoded block.
  * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
  * has occurred or TNG_CRITICAL (2) if a major error has occured.
  */
-static tng_function_status tng_trajectory_mapping_block_write
+static tng_function_status tng_trajectory_mapping_block_encode
                 (const tng_trajectory_t tng_data,
                  const tng_gen_block_t block,
                  const int mapping_block_nr,
-                 const char hash_mode)
+                 const char hash_mode,
+                 char **encoded,
+                 int64_t *encoded_len)
 {
-    int64_t header_file_pos, curr_file_pos;
-    char *temp_name;
-    int i;
+    char *temp_name, *dest, *pos;
     unsigned int name_len;
-    md5_state_t md5_state;
     tng_particle_mapping_t mapping =
     &tng_data->current_trajectory_frame_set.mappings[mapping_block_nr];
 
@@ -4059,11 +6244,6 @@ static tng_function_status tng_trajectory_mapping_block_write
         return(TNG_FAILURE);
     }
 
-    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return(TNG_CRITICAL);
-    }
-
     name_len = (unsigned int)strlen("PARTICLE MAPPING");
 
     if(!block->name || strlen(block->name) < name_len)
@@ -4092,75 +6272,29 @@ static tng_function_status tng_trajectory_mapping_block_write
         return(TNG_CRITICAL);
     }
 
-    header_file_pos = ftello(tng_data->output_file);
-
-    if(tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+    if(tng_block_encoding_init(tng_data, block, &dest, encoded_len) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-               tng_data->output_file_path, __FILE__, __LINE__);
         return(TNG_CRITICAL);
     }
 
-    if(hash_mode == TNG_USE_HASH)
-    {
-        md5_init(&md5_state);
-    }
-    if(tng_file_output_numerical(tng_data, &mapping->num_first_particle,
-                                 sizeof(mapping->num_first_particle),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+    pos = dest + block->header_contents_size;
+    pos = tng_buffer_numerical_put(tng_data, pos, &mapping->num_first_particle,
+                                   sizeof(mapping->num_first_particle));
+    pos = tng_buffer_numerical_put(tng_data, pos, &mapping->n_particles,
+                                   sizeof(mapping->n_particles));
 
-    if(tng_file_output_numerical(tng_data, &mapping->n_particles,
-                                 sizeof(mapping->n_particles),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    /* The whole list is copied and its byte order swapped at once. */
+    memcpy(pos, mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t));
+    if(tng_swap_byte_order_array_64(tng_data, tng_data->output_endianness_swap_func_64,
+                                    pos, mapping->n_particles) != TNG_SUCCESS)
     {
-        return(TNG_CRITICAL);
+        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                __FILE__, __LINE__);
     }
 
-    if(tng_data->output_endianness_swap_func_64)
-    {
-        for(i = 0; i < mapping->n_particles; i++)
-        {
-            if(tng_file_output_numerical(tng_data, &mapping->real_particle_numbers[i],
-                                        sizeof(int64_t),
-                                        hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-            {
-                return(TNG_CRITICAL);
-            }
-        }
-    }
-    else
-    {
-        if(fwrite(mapping->real_particle_numbers,
-                  mapping->n_particles * sizeof(int64_t),
-                  1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
-        if(hash_mode == TNG_USE_HASH)
-        {
-            md5_append(&md5_state, (md5_byte_t *)mapping->real_particle_numbers,
-                       mapping->n_particles * sizeof(int64_t));
-        }
-    }
+    tng_block_encoding_finish(tng_data, block, hash_mode, dest);
 
-    if(hash_mode == TNG_USE_HASH)
-    {
-        md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos +
-               3 * sizeof(int64_t), SEEK_SET);
-        if(fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__,
-                    __LINE__);
-            return(TNG_CRITICAL);
-        }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
-    }
+    *encoded = dest;
 
     return(TNG_SUCCESS);
 }
@@ -4218,12 +6352,82 @@ static tng_function_status tng_particle_data_block_create
     return(TNG_SUCCESS);
 }
 
+/* Determine the compression algorithm from only the first particles of the
+ * frames. The compression itself is discarded, but the algorithm parameters
+ * that were -1 in algo are set. */
+static void tng_compress_algo_sample_find(const tng_trajectory_t tng_data,
+                                          const tng_gen_block_t block,
+                                          const int64_t n_frames,
+                                          const int64_t n_particles,
+                                          const char type,
+                                          const char *data,
+                                          int *algo)
+{
+    int64_t i, n_sample = tng_data->compression_algo_sample_n_particles;
+    int size, compressed_len;
+    char *sample, *dest;
+
+    if(n_sample <= 0 || n_sample >= n_particles)
+    {
+        return;
+    }
+
+    size = (type == TNG_FLOAT_DATA) ? sizeof(float) : sizeof(double);
+
+    sample = (char *)malloc(n_frames * n_sample * 3 * size);
+    if(!sample)
+    {
+        return;
+    }
+    for(i = 0; i < n_frames; i++)
+    {
+        memcpy(sample + i * n_sample * 3 * size,
+               data + i * n_particles * 3 * size,
+               n_sample * 3 * size);
+    }
+
+    if(type == TNG_FLOAT_DATA)
+    {
+        if(block->id == TNG_TRAJ_POSITIONS)
+        {
+            dest = tng_compress_pos_float((float *)sample, (int)n_sample, (int)n_frames,
+                                          1/(float)tng_data->compression_precision,
+                                          0, algo, &compressed_len);
+        }
+        else
+        {
+            dest = tng_compress_vel_float((float *)sample, (int)n_sample, (int)n_frames,
+                                          1/(float)tng_data->compression_precision,
+                                          0, algo, &compressed_len);
+        }
+    }
+    else
+    {
+        if(block->id == TNG_TRAJ_POSITIONS)
+        {
+            dest = tng_compress_pos((double *)sample, (int)n_sample, (int)n_frames,
+                                    1/tng_data->compression_precision,
+                                    0, algo, &compressed_len);
+        }
+        else
+        {
+            dest = tng_compress_vel((double *)sample, (int)n_sample, (int)n_frames,
+                                    1/tng_data->compression_precision,
+                                    0, algo, &compressed_len);
+        }
+    }
+
+    free(dest);
+    free(sample);
+}
+
 static tng_function_status tng_compress(const tng_trajectory_t tng_data,
                                         const tng_gen_block_t block,
                                         const int64_t n_frames,
                                         const int64_t n_particles,
                                         const char type,
-                                        char **data,
+                                        const char *data,
+                                        char **compressed,
                                         int64_t *new_len)
 {
     int nalgo;
@@ -4231,6 +6435,9 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
     int *alt_algo = 0;
     char *dest;
     int64_t algo_find_n_frames = -1;
+    int64_t n_block_frames, n_blocks, i;
+    int *algo, *block_lengths;
+    char **blocks;
     float f_precision;
     double d_precision;
 
@@ -4257,12 +6464,25 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
     f_precision = 1/(float)tng_data->compression_precision;
     d_precision = 1/tng_data->compression_precision;
 
+    /* With a keyframe interval the frames are compressed in separate blocks,
+     * each starting with a keyframe. The algorithm is determined from
+     * the first block. */
+    if(tng_data->compression_keyframe_interval > 0 &&
+       n_frames > tng_data->compression_keyframe_interval)
+    {
+        n_block_frames = tng_data->compression_keyframe_interval;
+    }
+    else
+    {
+        n_block_frames = n_frames;
+    }
+
     if(block->id == TNG_TRAJ_POSITIONS)
     {
         /* If there is only one frame in this frame set and there might be more
          * do not store the algorithm as the compression algorithm, but find
          * the best one without storing it */
-        if(n_frames == 1 && tng_data->frame_set_n_frames > 1)
+        if(n_block_frames == 1 && tng_data->frame_set_n_frames > 1)
         {
             nalgo = tng_compress_nalgo();
             alt_algo = (int *)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
@@ -4284,12 +6504,15 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
                 alt_algo[3] = -1;
             }
 
+            tng_compress_algo_sample_find(tng_data, block, n_block_frames,
+                                          n_particles, type, data, alt_algo);
+
             /* If the initial coding and initial coding parameter are -1
              * they will be determined in tng_compress_pos/_float/. */
             if(type == TNG_FLOAT_DATA)
             {
-                dest = tng_compress_pos_float((float *)*data, (int)n_particles,
-                                              (int)n_frames,
+                dest = tng_compress_pos_float((float *)data, (int)n_particles,
+                                              (int)n_block_frames,
                                               f_precision,
                                               0, alt_algo,
                                               &compressed_len);
@@ -4297,8 +6520,8 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
             }
             else
             {
-                dest = tng_compress_pos((double *)*data, (int)n_particles,
-                                        (int)n_frames,
+                dest = tng_compress_pos((double *)data, (int)n_particles,
+                                        (int)n_block_frames,
                                         d_precision,
                                         0, alt_algo,
                                         &compressed_len);
@@ -4319,13 +6542,13 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
         else if(!tng_data->compress_algo_pos || tng_data->compress_algo_pos[2] == -1 ||
                 tng_data->compress_algo_pos[2] == -1)
         {
-            if(n_frames > 6)
+            if(n_block_frames > 6)
             {
                 algo_find_n_frames = 5;
             }
             else
             {
-                algo_find_n_frames = n_frames;
+                algo_find_n_frames = n_block_frames;
             }
 
             /* If the algorithm parameters are -1 they will be determined during the
@@ -4340,20 +6563,23 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
                 tng_data->compress_algo_pos[2] = -1;
                 tng_data->compress_algo_pos[3] = -1;
             }
+            tng_compress_algo_sample_find(tng_data, block, algo_find_n_frames,
+                                          n_particles, type, data,
+                                          tng_data->compress_algo_pos);
             if(type == TNG_FLOAT_DATA)
             {
-                dest = tng_compress_pos_float((float *)*data, (int)n_particles,
+                dest = tng_compress_pos_float((float *)data, (int)n_particles,
                                               (int)algo_find_n_frames,
                                               f_precision,
                                               0, tng_data->
                                               compress_algo_pos,
                                               &compressed_len);
 
-                if(algo_find_n_frames < n_frames)
+                if(algo_find_n_frames < n_block_frames)
                 {
                     free(dest);
-                    dest = tng_compress_pos_float((float *)*data, (int)n_particles,
-                                                  (int)n_frames,
+                    dest = tng_compress_pos_float((float *)data, (int)n_particles,
+                                                  (int)n_block_frames,
                                                   f_precision,
                                                   0, tng_data->compress_algo_pos,
                                                   &compressed_len);
@@ -4361,18 +6587,18 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
             }
             else
             {
-                dest = tng_compress_pos((double *)*data, (int)n_particles,
+                dest = tng_compress_pos((double *)data, (int)n_particles,
                                         (int)algo_find_n_frames,
                                         d_precision,
                                         0, tng_data->
                                         compress_algo_pos,
                                         &compressed_len);
 
-                if(algo_find_n_frames < n_frames)
+                if(algo_find_n_frames < n_block_frames)
                 {
                     free(dest);
-                    dest = tng_compress_pos((double *)*data, (int)n_particles,
-                                            (int)n_frames,
+                    dest = tng_compress_pos((double *)data, (int)n_particles,
+                                            (int)n_block_frames,
                                             d_precision, 0,
                                             tng_data->compress_algo_pos,
                                             &compressed_len);
@@ -4383,15 +6609,15 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
         {
             if(type == TNG_FLOAT_DATA)
             {
-                dest = tng_compress_pos_float((float *)*data, (int)n_particles,
-                                              (int)n_frames,
+                dest = tng_compress_pos_float((float *)data, (int)n_particles,
+                                              (int)n_block_frames,
                                               f_precision, 0,
                                               tng_data->compress_algo_pos, &compressed_len);
             }
             else
             {
-                dest = tng_compress_pos((double *)*data, (int)n_particles,
-                                        (int)n_frames,
+                dest = tng_compress_pos((double *)data, (int)n_particles,
+                                        (int)n_block_frames,
                                         d_precision, 0,
                                         tng_data->compress_algo_pos,
                                         &compressed_len);
@@ -4403,7 +6629,7 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
         /* If there is only one frame in this frame set and there might be more
          * do not store the algorithm as the compression algorithm, but find
          * the best one without storing it */
-        if(n_frames == 1 && tng_data->frame_set_n_frames > 1)
+        if(n_block_frames == 1 && tng_data->frame_set_n_frames > 1)
         {
             nalgo = tng_compress_nalgo();
             alt_algo = (int *)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
@@ -4425,12 +6651,15 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
                 alt_algo[3] = -1;
             }
 
+            tng_compress_algo_sample_find(tng_data, block, n_block_frames,
+                                          n_particles, type, data, alt_algo);
+
             /* If the initial coding and initial coding parameter are -1
              * they will be determined in tng_compress_pos/_float/. */
             if(type == TNG_FLOAT_DATA)
             {
-                dest = tng_compress_vel_float((float *)*data, (int)n_particles,
-                                              (int)n_frames,
+                dest = tng_compress_vel_float((float *)data, (int)n_particles,
+                                              (int)n_block_frames,
                                               f_precision,
                                               0, alt_algo,
                                               &compressed_len);
@@ -4438,8 +6667,8 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
             }
             else
             {
-                dest = tng_compress_vel((double *)*data, (int)n_particles,
-                                        (int)n_frames,
+                dest = tng_compress_vel((double *)data, (int)n_particles,
+                                        (int)n_block_frames,
                                         d_precision,
                                         0, alt_algo,
                                         &compressed_len);
@@ -4460,13 +6689,13 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
         else if(!tng_data->compress_algo_vel || tng_data->compress_algo_vel[2] == -1 ||
                 tng_data->compress_algo_vel[2] == -1)
         {
-            if(n_frames > 6)
+            if(n_block_frames > 6)
             {
                 algo_find_n_frames = 5;
             }
             else
             {
-                algo_find_n_frames = n_frames;
+                algo_find_n_frames = n_block_frames;
             }
 
             /* If the algorithm parameters are -1 they will be determined during the
@@ -4481,19 +6710,22 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
                 tng_data->compress_algo_vel[2] = -1;
                 tng_data->compress_algo_vel[3] = -1;
             }
+            tng_compress_algo_sample_find(tng_data, block, algo_find_n_frames,
+                                          n_particles, type, data,
+                                          tng_data->compress_algo_vel);
             if(type == TNG_FLOAT_DATA)
             {
-                dest = tng_compress_vel_float((float *)*data, (int)n_particles,
+                dest = tng_compress_vel_float((float *)data, (int)n_particles,
                                               (int)algo_find_n_frames,
                                               f_precision,
                                               0, tng_data->
                                               compress_algo_vel,
                                               &compressed_len);
-                if(algo_find_n_frames < n_frames)
+                if(algo_find_n_frames < n_block_frames)
                 {
                     free(dest);
-                    dest = tng_compress_vel_float((float *)*data, (int)n_particles,
-                                                  (int)n_frames,
+                    dest = tng_compress_vel_float((float *)data, (int)n_particles,
+                                                  (int)n_block_frames,
                                                   f_precision,
                                                   0, tng_data->compress_algo_vel,
                                                   &compressed_len);
@@ -4501,17 +6733,17 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
             }
             else
             {
-                dest = tng_compress_vel((double *)*data, (int)n_particles,
+                dest = tng_compress_vel((double *)data, (int)n_particles,
                                         (int)algo_find_n_frames,
                                         d_precision,
                                         0, tng_data->
                                         compress_algo_vel,
                                         &compressed_len);
-                if(algo_find_n_frames < n_frames)
+                if(algo_find_n_frames < n_block_frames)
                 {
                     free(dest);
-                    dest = tng_compress_vel((double *)*data, (int)n_particles,
-                                            (int)n_frames,
+                    dest = tng_compress_vel((double *)data, (int)n_particles,
+                                            (int)n_block_frames,
                                             d_precision,
                                             0, tng_data->compress_algo_vel,
                                             &compressed_len);
@@ -4522,8 +6754,8 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
         {
             if(type == TNG_FLOAT_DATA)
             {
-                dest = tng_compress_vel_float((float *)*data, (int)n_particles,
-                                              (int)n_frames,
+                dest = tng_compress_vel_float((float *)data, (int)n_particles,
+                                              (int)n_block_frames,
                                               f_precision,
                                               0, tng_data->
                                               compress_algo_vel,
@@ -4531,8 +6763,8 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
             }
             else
             {
-                dest = tng_compress_vel((double *)*data, (int)n_particles,
-                                        (int)n_frames,
+                dest = tng_compress_vel((double *)data, (int)n_particles,
+                                        (int)n_block_frames,
                                         d_precision,
                                         0, tng_data->
                                         compress_algo_vel,
@@ -4546,75 +6778,209 @@ static tng_function_status tng_compress(const tng_trajectory_t tng_data,
         return(TNG_FAILURE);
     }
 
-    if(alt_algo)
-    {
-        free(alt_algo);
-    }
-
-    free(*data);
-
-    *data = (char *)dest;
-
-    *new_len = compressed_len;
-
-    return(TNG_SUCCESS);
-}
-
-static tng_function_status tng_uncompress(const tng_trajectory_t tng_data,
-                                          const tng_gen_block_t block,
-                                          const char type,
-                                          char **data,
-                                          const int64_t uncompressed_len)
-{
-    double *d_dest = 0;
-    float *f_dest = 0;
-    int result;
-    (void)tng_data;
-
-    TNG_ASSERT(uncompressed_len, "TNG library: The full length of the uncompressed data must be > 0.");
-
-    if(block->id != TNG_TRAJ_POSITIONS &&
-       block->id != TNG_TRAJ_VELOCITIES)
-    {
-        fprintf(stderr, "TNG library: Can only uncompress positions and velocities with the"
-               "TNG method.\n");
-        return(TNG_FAILURE);
-    }
-    if(type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    if(!dest)
     {
-        fprintf(stderr, "TNG library: Data type not supported.\n");
+        fprintf(stderr, "TNG library: Cannot TNG compress data. %s: %d\n",
+                __FILE__, __LINE__);
+        if(alt_algo)
+        {
+            free(alt_algo);
+        }
         return(TNG_FAILURE);
     }
 
-    if(type == TNG_FLOAT_DATA)
+    if(n_block_frames < n_frames)
     {
-        f_dest = (float *)malloc(uncompressed_len);
-        if(!f_dest)
+        if(alt_algo)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
+            algo = alt_algo;
+        }
+        else if(block->id == TNG_TRAJ_POSITIONS)
+        {
+            algo = tng_data->compress_algo_pos;
+        }
+        else
+        {
+            algo = tng_data->compress_algo_vel;
         }
-        result = tng_compress_uncompress_float(*data, f_dest);
-
-        free(*data);
 
-        *data = (char *)f_dest;
-    }
-    else
-    {
-        d_dest = (double *)malloc(uncompressed_len);
-        if(!d_dest)
+        n_blocks = (n_frames + n_block_frames - 1) / n_block_frames;
+        blocks = (char **)calloc(n_blocks, sizeof(char *));
+        block_lengths = (int *)malloc(n_blocks * sizeof(int));
+        if(!blocks || !block_lengths)
         {
             fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                     __FILE__, __LINE__);
+            free(blocks);
+            free(block_lengths);
+            free(dest);
+            if(alt_algo)
+            {
+                free(alt_algo);
+            }
             return(TNG_CRITICAL);
         }
-        result = tng_compress_uncompress(*data, d_dest);
-
-        free(*data);
+        blocks[0] = dest;
+        block_lengths[0] = compressed_len;
 
-        *data = (char *)d_dest;
+        for(i = 1; i < n_blocks; i++)
+        {
+            int n = (int)tng_min_i64(n_block_frames, n_frames - i * n_block_frames);
+            if(type == TNG_FLOAT_DATA)
+            {
+                float *block_data = (float *)data + i * n_block_frames * n_particles * 3;
+                if(block->id == TNG_TRAJ_POSITIONS)
+                {
+                    blocks[i] = tng_compress_pos_float(block_data, (int)n_particles, n,
+                                                       f_precision, 0, algo,
+                                                       &block_lengths[i]);
+                }
+                else
+                {
+                    blocks[i] = tng_compress_vel_float(block_data, (int)n_particles, n,
+                                                       f_precision, 0, algo,
+                                                       &block_lengths[i]);
+                }
+            }
+            else
+            {
+                double *block_data = (double *)data + i * n_block_frames * n_particles * 3;
+                if(block->id == TNG_TRAJ_POSITIONS)
+                {
+                    blocks[i] = tng_compress_pos(block_data, (int)n_particles, n,
+                                                 d_precision, 0, algo,
+                                                 &block_lengths[i]);
+                }
+                else
+                {
+                    blocks[i] = tng_compress_vel(block_data, (int)n_particles, n,
+                                                 d_precision, 0, algo,
+                                                 &block_lengths[i]);
+                }
+            }
+            if(!blocks[i])
+            {
+                break;
+            }
+        }
+
+        if(i == n_blocks)
+        {
+            dest = tng_compress_keyframes_pack(blocks, block_lengths, (int)n_blocks,
+                                               (int)n_frames, (int)n_block_frames,
+                                               &compressed_len);
+        }
+        else
+        {
+            dest = 0;
+        }
+
+        for(i = 0; i < n_blocks; i++)
+        {
+            free(blocks[i]);
+        }
+        free(blocks);
+        free(block_lengths);
+
+        if(!dest)
+        {
+            fprintf(stderr, "TNG library: Cannot TNG compress data. %s: %d\n",
+                    __FILE__, __LINE__);
+            if(alt_algo)
+            {
+                free(alt_algo);
+            }
+            return(TNG_FAILURE);
+        }
+    }
+
+    if(alt_algo)
+    {
+        free(alt_algo);
+    }
+
+    *compressed = (char *)dest;
+
+    *new_len = compressed_len;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Get the scratch memory for uncompressing TNG and XTC compressed
+ * blocks, which is kept in the trajectory to be reused between blocks.
+ * @param tng_data is a trajectory data container.
+ * @return The scratch memory, or NULL if it cannot be allocated, in which
+ * case memory is allocated for each block instead.
+ */
+static struct tng_compress_scratch *tng_compress_scratch_get(const tng_trajectory_t tng_data)
+{
+    if(!tng_data->compress_scratch)
+    {
+        tng_data->compress_scratch = tng_compress_scratch_init();
+    }
+    return(tng_data->compress_scratch);
+}
+
+/**
+ * @brief Uncompress a TNG compressed block directly into a destination
+ * array.
+ * @param tng_data is a trajectory data container.
+ * @param block is the block of the data.
+ * @param type is the data type of the destination, TNG_FLOAT_DATA or
+ * TNG_DOUBLE_DATA.
+ * @param data is the compressed data.
+ * @param dest is the destination, which must have room for
+ * uncompressed_len bytes.
+ * @param uncompressed_len is the expected length of the uncompressed data.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the data
+ * cannot be uncompressed or does not have the expected length.
+ */
+static tng_function_status tng_uncompress(const tng_trajectory_t tng_data,
+                                          const tng_gen_block_t block,
+                                          const char type,
+                                          char *data,
+                                          char *dest,
+                                          const int64_t uncompressed_len)
+{
+    int vel, natoms, nframes, algo[4];
+    int result, size;
+    double precision;
+
+    TNG_ASSERT(uncompressed_len, "TNG library: The full length of the uncompressed data must be > 0.");
+
+    if(block->id != TNG_TRAJ_POSITIONS &&
+       block->id != TNG_TRAJ_VELOCITIES)
+    {
+        fprintf(stderr, "TNG library: Can only uncompress positions and velocities with the"
+               "TNG method.\n");
+        return(TNG_FAILURE);
+    }
+    if(type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    {
+        fprintf(stderr, "TNG library: Data type not supported.\n");
+        return(TNG_FAILURE);
+    }
+    size = type == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double);
+
+    /* The data is uncompressed directly into dest, so it must not contain
+     * more values than expected. */
+    if(tng_compress_inquire(data, &vel, &natoms, &nframes, &precision, algo) ||
+       (int64_t)natoms * nframes * 3 * size != uncompressed_len)
+    {
+        fprintf(stderr, "TNG library: Unexpected length of TNG compressed block.\n");
+        return(TNG_FAILURE);
+    }
+
+    if(type == TNG_FLOAT_DATA)
+    {
+        result = tng_compress_uncompress_float_scratch(data, (float *)dest,
+                                                       tng_compress_scratch_get(tng_data));
+    }
+    else
+    {
+        result = tng_compress_uncompress_scratch(data, (double *)dest,
+                                                 tng_compress_scratch_get(tng_data));
     }
 
     if(result == 1)
@@ -4626,9 +6992,205 @@ static tng_function_status tng_uncompress(const tng_trajectory_t tng_data,
     return(TNG_SUCCESS);
 }
 
+/* Each frame of an XTC compressed block is stored as a separate
+ * tng_compress stream using the XTC2 coding. The stream header is 9 four
+ * byte fields followed by the four byte length of the packed data. */
+#define TNG_XTC_FRAME_HEADER_LEN 40
+
+static tng_function_status tng_xtc_compress(const tng_trajectory_t tng_data,
+                                            const tng_gen_block_t block,
+                                            const int64_t n_frames,
+                                            const int64_t n_particles,
+                                            const char type,
+                                            const char *data,
+                                            char **compressed,
+                                            int64_t *new_len)
+{
+    int64_t i, frame_len, offset = 0;
+    int compressed_len;
+    int algo[4];
+    char *dest, *frame_dest, *temp;
+    float f_precision;
+    double d_precision;
+
+    if(block->id != TNG_TRAJ_POSITIONS)
+    {
+        fprintf(stderr, "TNG library: Can only compress positions with the "
+               "XTC method. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    if(type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    {
+        fprintf(stderr, "TNG library: Data type not supported. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    if(n_frames <= 0 || n_particles <= 0)
+    {
+        fprintf(stderr, "TNG library: Missing frames or particles. Cannot compress data "
+               "with the XTC method. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    f_precision = 1/(float)tng_data->compression_precision;
+    d_precision = 1/tng_data->compression_precision;
+
+    frame_len = n_particles * 3 * (type == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double));
+    dest = 0;
+
+    for(i = 0; i < n_frames; i++)
+    {
+        /* Only one frame per stream so the inter frame coding is never used. */
+        algo[0] = TNG_COMPRESS_ALGO_POS_XTC2;
+        algo[1] = 0;
+        algo[2] = TNG_COMPRESS_ALGO_POS_XTC2;
+        algo[3] = 0;
+
+        if(type == TNG_FLOAT_DATA)
+        {
+            frame_dest = tng_compress_pos_float((float *)(data + i * frame_len),
+                                                (int)n_particles, 1, f_precision,
+                                                0, algo, &compressed_len);
+        }
+        else
+        {
+            frame_dest = tng_compress_pos((double *)(data + i * frame_len),
+                                          (int)n_particles, 1, d_precision,
+                                          0, algo, &compressed_len);
+        }
+        if(!frame_dest)
+        {
+            fprintf(stderr, "TNG library: Cannot XTC compress frame. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(dest);
+            return(TNG_FAILURE);
+        }
+        temp = (char *)realloc(dest, offset + compressed_len);
+        if(!temp)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(frame_dest);
+            free(dest);
+            return(TNG_CRITICAL);
+        }
+        dest = temp;
+        memcpy(dest + offset, frame_dest, compressed_len);
+        offset += compressed_len;
+        free(frame_dest);
+    }
+
+    *compressed = dest;
+
+    *new_len = offset;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Uncompress frames of an XTC compressed block directly into a
+ * destination array.
+ * @param tng_data is a trajectory data container.
+ * @param block is the block of the data.
+ * @param type is the data type of the destination, TNG_FLOAT_DATA or
+ * TNG_DOUBLE_DATA.
+ * @param data is the compressed data.
+ * @param compressed_len is the length of the compressed data.
+ * @param first_frame is the first frame of the block to uncompress. The
+ * frames before it are skipped without uncompressing them.
+ * @param dest is the destination, which must have room for
+ * uncompressed_len bytes.
+ * @param uncompressed_len is the expected length of the uncompressed data.
+ * The frames from first_frame are uncompressed until it is reached.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the data
+ * cannot be uncompressed or does not have the expected length.
+ */
+static tng_function_status tng_xtc_uncompress(const tng_trajectory_t tng_data,
+                                              const tng_gen_block_t block,
+                                              const char type,
+                                              char *data,
+                                              const int64_t compressed_len,
+                                              const int64_t first_frame,
+                                              char *dest,
+                                              const int64_t uncompressed_len)
+{
+    int64_t offset = 0, dest_offset = 0, frame_len, frame = 0;
+    int vel, natoms, nframes, algo[4];
+    int result = 0;
+    double precision;
+    unsigned char *p;
+    int size;
+    struct tng_compress_scratch *scratch;
+
+    TNG_ASSERT(uncompressed_len, "TNG library: The full length of the uncompressed data must be > 0.");
+
+    if(block->id != TNG_TRAJ_POSITIONS)
+    {
+        fprintf(stderr, "TNG library: Can only uncompress positions with the "
+               "XTC method. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    if(type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    {
+        fprintf(stderr, "TNG library: Data type not supported. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    size = type == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double);
+    scratch = tng_compress_scratch_get(tng_data);
+
+    /* The frames are independent, so each one can be located by only reading
+     * the stream header of the preceding frames. */
+    while(offset + TNG_XTC_FRAME_HEADER_LEN <= compressed_len && dest_offset < uncompressed_len)
+    {
+        p = (unsigned char *)data + offset;
+        frame_len = TNG_XTC_FRAME_HEADER_LEN + ((int64_t)p[36] | ((int64_t)p[37] << 8) |
+                    ((int64_t)p[38] << 16) | ((int64_t)p[39] << 24));
+        if(frame < first_frame && offset + frame_len <= compressed_len)
+        {
+            offset += frame_len;
+            frame++;
+            continue;
+        }
+        if(offset + frame_len > compressed_len ||
+           tng_compress_inquire((char *)p, &vel, &natoms, &nframes,
+                                &precision, algo) ||
+           vel || nframes != 1 ||
+           dest_offset + (int64_t)natoms * 3 * size > uncompressed_len)
+        {
+            result = 1;
+            break;
+        }
+        if(type == TNG_FLOAT_DATA)
+        {
+            result = tng_compress_uncompress_float_scratch((char *)p, (float *)(dest + dest_offset),
+                                                           scratch);
+        }
+        else
+        {
+            result = tng_compress_uncompress_scratch((char *)p, (double *)(dest + dest_offset),
+                                                     scratch);
+        }
+        if(result)
+        {
+            break;
+        }
+        offset += frame_len;
+        dest_offset += (int64_t)natoms * 3 * size;
+    }
+
+    if(result == 1 || dest_offset != uncompressed_len)
+    {
+        fprintf(stderr, "TNG library: Cannot uncompress XTC compressed block. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    return(TNG_SUCCESS);
+}
+
 static tng_function_status tng_gzip_compress(const tng_trajectory_t tng_data,
-                                             char **data, const int64_t len,
-                                             int64_t *new_len)
+                                             const char *data, const int64_t len,
+                                             char **compressed, int64_t *new_len)
 {
     Bytef *dest;
     uLongf stat, max_len;
@@ -4643,7 +7205,7 @@ static tng_function_status tng_gzip_compress(const tng_trajectory_t tng_data,
         return(TNG_CRITICAL);
     }
 
-    stat = compress(dest, &max_len, (Bytef *)*data, len);
+    stat = compress(dest, &max_len, (const Bytef *)data, len);
     if(stat != (unsigned long)Z_OK)
     {
         free(dest);
@@ -4661,9 +7223,7 @@ static tng_function_status tng_gzip_compress(const tng_trajectory_t tng_data,
 
     *new_len = max_len;
 
-    free(*data);
-
-    *data = (char *)dest;
+    *compressed = (char *)dest;
 
     return(TNG_SUCCESS);
 }
@@ -4739,7 +7299,8 @@ static tng_function_status tng_allocate_particle_data_mem
 {
     void ***values;
     int64_t i, j, k, size, frame_alloc;
-    (void)tng_data;
+
+    tng_statistics_count(tng_data, &tng_data->statistics.n_allocations, 1);
 
     if(n_particles == 0 || n_values_per_frame == 0)
     {
@@ -5122,7 +7683,8 @@ static tng_function_status tng_allocate_data_mem
 {
     void **values;
     int64_t i, j, size, frame_alloc;
-    (void)tng_data;
+
+    tng_statistics_count(tng_data, &tng_data->statistics.n_allocations, 1);
 
     if(n_values_per_frame == 0)
     {
@@ -5250,13 +7812,13 @@ static tng_function_status tng_data_read(const tng_trajectory_t tng_data,
                                          md5_state_t *md5_state)
 {
     int64_t i, j, k, tot_n_particles, n_frames_div, offset;
-    int64_t full_data_len;
+    int64_t full_data_len, start_ticks;
     int size, len;
     char ***first_dim_values, **second_dim_values;
     tng_data_t data;
     tng_trajectory_frame_set_t frame_set =
     &tng_data->current_trajectory_frame_set;
-    char block_type_flag, *contents;
+    char block_type_flag, *contents, *uncompressed = 0;
     tng_bool is_particle_data;
     tng_function_status stat;
 
@@ -5418,7 +7980,7 @@ static tng_function_status tng_data_read(const tng_trajectory_t tng_data,
         return(TNG_CRITICAL);
     }
 
-    if(fread(contents, block_data_len, 1, tng_data->input_file) == 0)
+    if(tng_fread(tng_data, contents, block_data_len, 1, tng_data->input_file) == 0)
     {
         fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
         return(TNG_CRITICAL);
@@ -5426,7 +7988,31 @@ static tng_function_status tng_data_read(const tng_trajectory_t tng_data,
 
     if(hash_mode == TNG_USE_HASH)
     {
-        md5_append(md5_state, (md5_byte_t *)contents, block_data_len);
+        tng_md5_append(tng_data, md5_state, (md5_byte_t *)contents, block_data_len);
+    }
+
+    /* Allocate memory */
+    if(!data->values || data->n_frames != n_frames ||
+       data->n_values_per_frame != n_values)
+    {
+        if(is_particle_data == TNG_TRUE)
+        {
+            stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
+                                                  stride_length,
+                                                  tot_n_particles, n_values);
+        }
+        else
+        {
+            stat = tng_allocate_data_mem(tng_data, data, n_frames, stride_length,
+                                         n_values);
+        }
+        if(stat != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory for data. %s: %d\n",
+                   __FILE__, __LINE__);
+            free(contents);
+            return(TNG_CRITICAL);
+        }
     }
 
     if(codec_id != TNG_UNCOMPRESSED)
@@ -5436,15 +8022,49 @@ static tng_function_status tng_data_read(const tng_trajectory_t tng_data,
         {
             full_data_len *= n_particles;
         }
+        /* TNG and XTC compressed blocks are uncompressed directly into the
+         * data values, unless the values of the block are interleaved with
+         * the values of other particle mapping blocks. Then a buffer kept in
+         * the trajectory is used. */
+        if(codec_id == TNG_XTC_COMPRESSION || codec_id == TNG_TNG_COMPRESSION)
+        {
+            if(is_particle_data && n_particles != tot_n_particles)
+            {
+                uncompressed = (char *)tng_array_grow(tng_data->uncompress_buffer,
+                                                      &tng_data->uncompress_buffer_size,
+                                                      full_data_len, 1);
+                if(!uncompressed)
+                {
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                            __FILE__, __LINE__);
+                    free(contents);
+                    return(TNG_CRITICAL);
+                }
+                tng_data->uncompress_buffer = uncompressed;
+            }
+            else
+            {
+                uncompressed = (char *)data->values;
+            }
+        }
+        start_ticks = tng_statistics_timer_start(tng_data);
         switch(codec_id)
         {
         case TNG_XTC_COMPRESSION:
-            fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
+            if(tng_xtc_uncompress(tng_data, block, datatype, contents,
+                                  block_data_len, 0, uncompressed,
+                                  full_data_len) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Could not read XTC compressed block data. %s: %d\n",
+                       __FILE__, __LINE__);
+                free(contents);
+                return(TNG_CRITICAL);
+            }
             break;
         case TNG_TNG_COMPRESSION:
 /*            fprintf(stderr, "TNG library: Before TNG uncompression: %" PRId64 "\n", block->block_contents_size);*/
-            if(tng_uncompress(tng_data, block, datatype,
-                              &contents, full_data_len) != TNG_SUCCESS)
+            if(tng_uncompress(tng_data, block, datatype, contents,
+                              uncompressed, full_data_len) != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Could not read tng compressed block data. %s: %d\n",
                        __FILE__, __LINE__);
@@ -5466,36 +8086,15 @@ static tng_function_status tng_data_read(const tng_trajectory_t tng_data,
     /*         fprintf(stderr, "TNG library: After compression: %" PRId64 "\n", block->block_contents_size); */
             break;
         }
+        tng_statistics_timer_stop(tng_data, codec_id == TNG_GZIP_COMPRESSION ?
+                                  &tng_data->statistics.gzip_uncompress_ticks :
+                                  &tng_data->statistics.uncompress_ticks, start_ticks);
     }
     else
     {
         full_data_len = block_data_len;
     }
 
-    /* Allocate memory */
-    if(!data->values || data->n_frames != n_frames ||
-       data->n_values_per_frame != n_values)
-    {
-        if(is_particle_data == TNG_TRUE)
-        {
-            stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
-                                                  stride_length,
-                                                  tot_n_particles, n_values);
-        }
-        else
-        {
-            stat = tng_allocate_data_mem(tng_data, data, n_frames, stride_length,
-                                         n_values);
-        }
-        if(stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory for data. %s: %d\n",
-                   __FILE__, __LINE__);
-            free(contents);
-            return(TNG_CRITICAL);
-        }
-    }
-
     data->first_frame_with_data = first_frame_with_data;
 
     if(datatype == TNG_CHAR_DATA)
@@ -5562,157 +8161,264 @@ static tng_function_status tng_data_read(const tng_trajectory_t tng_data,
     }
     else
     {
-        if(is_particle_data)
-        {
-            memcpy((char *)data->values + n_frames_div * size * n_values *
-                   num_first_particle, contents, full_data_len);
-        }
-        else
-        {
-            memcpy(data->values, contents, full_data_len);
-        }
-        /* Endianness is handled by the TNG compression library. TNG compressed blocks are always written
-         * as little endian by the compression library. */
-        if(codec_id != TNG_TNG_COMPRESSION)
+        /* Endianness is handled by the TNG compression library. TNG and XTC compressed blocks are always
+         * written as little endian by the compression library. */
+        if(codec_id != TNG_TNG_COMPRESSION && codec_id != TNG_XTC_COMPRESSION)
         {
             switch(datatype)
             {
             case TNG_FLOAT_DATA:
-                if(tng_data->input_endianness_swap_func_32)
+                if(tng_swap_byte_order_array_32(tng_data,
+                                                tng_data->input_endianness_swap_func_32,
+                                                contents, full_data_len / size)
+                   != TNG_SUCCESS)
                 {
-                    for(i = 0; i < full_data_len; i+=size)
-                    {
-                        if(tng_data->input_endianness_swap_func_32(tng_data,
-                            (uint32_t *)((char *)data->values + i))
-                            != TNG_SUCCESS)
-                        {
-                            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                    __FILE__, __LINE__);
-                        }
-                    }
+                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                            __FILE__, __LINE__);
                 }
                 break;
             case TNG_INT_DATA:
             case TNG_DOUBLE_DATA:
-                if(tng_data->input_endianness_swap_func_64)
+                if(tng_swap_byte_order_array_64(tng_data,
+                                                tng_data->input_endianness_swap_func_64,
+                                                contents, full_data_len / size)
+                   != TNG_SUCCESS)
                 {
-                    for(i = 0; i < full_data_len; i+=size)
-                    {
-                        if(tng_data->input_endianness_swap_func_64(tng_data,
-                            (uint64_t *)((char *)data->values + i))
-                            != TNG_SUCCESS)
-                        {
-                            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                    __FILE__, __LINE__);
-                        }
-                    }
+                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                            __FILE__, __LINE__);
                 }
                 break;
             case TNG_CHAR_DATA:
                 break;
             }
         }
+
+        if(uncompressed)
+        {
+            free(contents);
+            contents = uncompressed;
+        }
+
+        /* The values of the particles of one mapping block are stored frame
+         * by frame among the values of all particles. */
+        if(is_particle_data && n_particles != tot_n_particles)
+        {
+            for(i = 0; i < n_frames_div; i++)
+            {
+                memcpy((char *)data->values + (i * tot_n_particles + num_first_particle) *
+                       n_values * size,
+                       contents + i * n_particles * n_values * size,
+                       n_particles * n_values * size);
+            }
+        }
+        else if(contents != data->values)
+        {
+            memcpy(data->values, contents, full_data_len);
+        }
     }
 
-    free(contents);
+    /* The uncompressed data is not owned by this function. */
+    if(!uncompressed)
+    {
+        free(contents);
+    }
 
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Write a data block (particle or non-particle data)
+ * @brief Find a data block to write and prepare the settings that are
+ * stored with its data.
  * @param tng_data is a trajectory data container.
- * @param block is the block to store the data (should already contain
- * the block headers and the block contents).
  * @param block_index is the index number of the data block in the frame set.
  * @param is_particle_data is a flag to specify if the data to write is
  * particle dependent or not.
- * @param mapping is the particle mapping that is relevant for the data block.
- * Only relevant if writing particle dependent data.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @param data_p is set to point to the data block.
+ * @param block_type_flag is set to TNG_TRAJECTORY_BLOCK if the data block
+ * belongs to the current frame set, otherwise to TNG_NON_TRAJECTORY_BLOCK.
+ * @details This must be done once for each data block before encoding it,
+ * also when the data block is encoded once for each particle mapping.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the data
+ * block has not had any data added in this frame set and should not be
+ * written.
  */
-static tng_function_status tng_data_block_write(const tng_trajectory_t tng_data,
-                                                const tng_gen_block_t block,
-                                                const int64_t block_index,
-                                                const tng_bool is_particle_data,
-                                                const tng_particle_mapping_t mapping,
-                                                const char hash_mode)
+static tng_function_status tng_data_block_write_prepare
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_index,
+                 const tng_bool is_particle_data,
+                 tng_data_t *data_p,
+                 char *block_type_flag)
 {
-    int64_t n_particles, num_first_particle, n_frames, stride_length;
-    int64_t full_data_len, block_data_len, frame_step, data_start_pos;
-    int64_t i, j, k, curr_file_pos, header_file_pos;
-    int size;
-    size_t len;
-    tng_function_status stat;
-    char temp, *temp_name, ***first_dim_values, **second_dim_values, *contents;
-    double multiplier;
     tng_trajectory_frame_set_t frame_set =
     &tng_data->current_trajectory_frame_set;
     tng_data_t data;
-    char block_type_flag;
-    md5_state_t md5_state;
 
     /* If we have already started writing frame sets it is too late to write
      * non-trajectory data blocks */
     if(tng_data->current_trajectory_frame_set_output_file_pos > 0)
     {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
+        *block_type_flag = TNG_TRAJECTORY_BLOCK;
     }
     else
     {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
-    }
-
-    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return(TNG_CRITICAL);
+        *block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
     }
 
     if(is_particle_data == TNG_TRUE)
     {
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK)
+        if(*block_type_flag == TNG_TRAJECTORY_BLOCK)
         {
             data = &frame_set->tr_particle_data[block_index];
-
-            /* If this data block has not had any data added in this frame set
-             * do not write it. */
-            if(data->first_frame_with_data < frame_set->first_frame)
-            {
-                return(TNG_SUCCESS);
-            }
-
-            stride_length = tng_max_i64(1, data->stride_length);
         }
         else
         {
             data = &tng_data->non_tr_particle_data[block_index];
-            stride_length = 1;
         }
     }
     else
     {
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK)
+        if(*block_type_flag == TNG_TRAJECTORY_BLOCK)
         {
             data = &frame_set->tr_data[block_index];
-
-            /* If this data block has not had any data added in this frame set
-             * do not write it. */
-            if(data->first_frame_with_data < frame_set->first_frame)
-            {
-                return(TNG_SUCCESS);
-            }
-
-            stride_length = tng_max_i64(1, data->stride_length);
         }
         else
         {
             data = &tng_data->non_tr_data[block_index];
-            stride_length = 1;
         }
     }
+    *data_p = data;
+
+    if(*block_type_flag == TNG_TRAJECTORY_BLOCK)
+    {
+        /* If this data block has not had any data added in this frame set
+         * do not write it. */
+        if(data->first_frame_with_data < frame_set->first_frame)
+        {
+            return(TNG_FAILURE);
+        }
+
+        if(data->n_frames > 0 && data->stride_length > 1 &&
+           data->first_frame_with_data == 0)
+        {
+            /* FIXME: first_frame_with_data is not reliably set */
+            data->first_frame_with_data = frame_set->first_frame;
+        }
+    }
+
+    /* TNG and XTC compression will use compression precision to get integers
+     * from floating point data. The compression multiplier stores that
+     * information to be able to return the precision of the compressed data. */
+    if(data->codec_id == TNG_TNG_COMPRESSION || data->codec_id == TNG_XTC_COMPRESSION)
+    {
+        data->compression_multiplier = tng_data->compression_precision;
+    }
+    /* Uncompressed data blocks do not use compression multipliers at all.
+     * GZip compression does not need it either. */
+    else if(data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
+    {
+        data->compression_multiplier = 1.0;
+    }
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Encode the strings of a data block of type TNG_CHAR_DATA.
+ * @param data is the data block.
+ * @param n_frames is the number of frames to encode.
+ * @param num_first_particle is the number of the first particle to encode,
+ * or -1 if the data is not particle dependent.
+ * @param n_particles is the number of particles to encode.
+ * @param dest is the buffer to encode the strings in. If NULL only the length
+ * of the encoded strings is calculated.
+ * @return The length of the encoded strings.
+ */
+static int64_t tng_data_strings_encode
+                (const tng_data_t data,
+                 const int64_t n_frames,
+                 const int64_t num_first_particle,
+                 const int64_t n_particles,
+                 char *dest)
+{
+    int64_t i, j, k, len = 0;
+    size_t str_len;
+    char **second_dim_values;
+
+    for(i = 0; i < n_frames; i++)
+    {
+        for(j = 0; j < (num_first_particle >= 0 ? n_particles : 1); j++)
+        {
+            if(num_first_particle >= 0)
+            {
+                second_dim_values = data->strings[i][num_first_particle + j];
+            }
+            else
+            {
+                second_dim_values = data->strings[0][i];
+            }
+            for(k = 0; k < data->n_values_per_frame; k++)
+            {
+                str_len = tng_min_size(strlen(second_dim_values[k]) + 1, TNG_MAX_STR_LEN);
+                if(dest)
+                {
+                    memcpy(dest + len, second_dim_values[k], str_len);
+                }
+                len += str_len;
+            }
+        }
+    }
+
+    return(len);
+}
+
+/**
+ * @brief Encode a data block (particle or non-particle data), including its
+ * block header, in memory.
+ * @param tng_data is a trajectory data container.
+ * @param block is the block to encode. Its name, ID, contents size and md5
+ * hash are set.
+ * @param data is the data block, see tng_data_block_write_prepare().
+ * @param block_type_flag specifies if this is a trajectory block or a
+ * non-trajectory block. (TNG_TRAJECTORY_BLOCK or TNG_NON_TRAJECTORY_BLOCK)
+ * @param mapping is the particle mapping that is relevant for the data block.
+ * Only relevant if writing particle dependent data.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param codec_id is the ID of the codec to use. If the data cannot be
+ * compressed it is set to TNG_UNCOMPRESSED and the data is encoded without
+ * compression.
+ * @param encoded is set to the encoded block, which must be freed by the
+ * caller.
+ * @param encoded_len is set to the length of the encoded block, i.e. the
+ * sum of its header and contents sizes.
+ * @details Apart from the compression algorithm, which is stored in tng_data
+ * the first time data is TNG compressed, no shared data is modified, so
+ * different data blocks can be encoded concurrently.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_encode
+                (const tng_trajectory_t tng_data,
+                 const tng_gen_block_t block,
+                 const tng_data_t data,
+                 const char block_type_flag,
+                 const tng_particle_mapping_t mapping,
+                 const char hash_mode,
+                 int64_t *codec_id,
+                 char **encoded,
+                 int64_t *encoded_len)
+{
+    int64_t n_particles, num_first_particle, n_frames, stride_length;
+    int64_t full_data_len, block_data_len, frame_step, i, start_ticks;
+    int size;
+    size_t len;
+    tng_function_status stat;
+    tng_bool swap_needed;
+    char temp, *temp_name, *contents, *compressed, *dest, *pos;
+    const char *block_data;
+    double multiplier;
+    tng_trajectory_frame_set_t frame_set =
+    &tng_data->current_trajectory_frame_set;
 
     switch(data->datatype)
     {
@@ -5755,30 +8461,22 @@ static tng_function_status tng_data_block_write(const tng_trajectory_t tng_data,
 
     if(block_type_flag == TNG_TRAJECTORY_BLOCK)
     {
+        stride_length = tng_max_i64(1, data->stride_length);
+
         /* If the frame set is finished before writing the full number of frames
            make sure the data block is not longer than the frame set. */
         n_frames = tng_min_i64(n_frames, frame_set->n_frames);
 
         n_frames -= (data->first_frame_with_data - frame_set->first_frame);
     }
+    else
+    {
+        stride_length = 1;
+    }
 
     frame_step = (n_frames % stride_length) ? n_frames / stride_length + 1:
                  n_frames / stride_length;
 
-    /* TNG compression will use compression precision to get integers from
-     * floating point data. The compression multiplier stores that information
-     * to be able to return the precision of the compressed data. */
-    if(data->codec_id == TNG_TNG_COMPRESSION)
-    {
-        data->compression_multiplier = tng_data->compression_precision;
-    }
-    /* Uncompressed data blocks do not use compression multipliers at all.
-     * GZip compression does not need it either. */
-    else if(data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
-    {
-        data->compression_multiplier = 1.0;
-    }
-
     if(data->dependency & TNG_PARTICLE_DEPENDENT)
     {
         if(mapping && mapping->n_particles != 0)
@@ -5801,502 +8499,690 @@ static tng_function_status tng_data_block_write(const tng_trajectory_t tng_data,
     }
     else
     {
-        /* This just appeases gcc-7 -Wmaybe-uninitialized.
-         * FIXME: It would be better to refactor so that
-         * TNG_PARTICLE_DEPENDENT triggers two distinct code paths.
-         */
         num_first_particle = -1;
-        n_particles = -1;
+        n_particles = 1;
     }
 
-    if(data->dependency & TNG_PARTICLE_DEPENDENT)
+    /* First get the data values to store, compressed if required. */
+    contents = 0;
+    block_data = 0;
+    block_data_len = 0;
+    if(data->datatype == TNG_CHAR_DATA)
     {
-        if(tng_data_block_len_calculate(tng_data, data, TNG_TRUE, n_frames,
-                                        frame_step, stride_length, num_first_particle,
-                                        n_particles, &data_start_pos,
-                                        &block->block_contents_size) != TNG_SUCCESS)
+        if(data->strings)
         {
-            fprintf(stderr, "TNG library: Cannot calculate length of particle data block. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
+            block_data_len = tng_data_strings_encode(data, frame_step,
+                                                     num_first_particle,
+                                                     n_particles, 0);
+            contents = (char *)malloc(tng_max_i64(block_data_len, 1));
+            if(!contents)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                return(TNG_CRITICAL);
+            }
+            tng_data_strings_encode(data, frame_step, num_first_particle,
+                                    n_particles, contents);
+            block_data = contents;
         }
     }
     else
     {
-        if(tng_data_block_len_calculate(tng_data, data, TNG_FALSE, n_frames,
-                                        frame_step, stride_length, 0,
-                                        1, &data_start_pos,
-                                        &block->block_contents_size) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot calculate length of non-particle data block. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
-    }
-
-    header_file_pos = ftello(tng_data->output_file);
-
-    if(tng_block_header_write(tng_data, block) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-               tng_data->output_file_path, __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-    }
-
-    if(hash_mode == TNG_USE_HASH)
-    {
-        md5_init(&md5_state);
-    }
-
-    if(tng_file_output_numerical(tng_data, &data->datatype,
-                                 sizeof(data->datatype),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
-
-    if(tng_file_output_numerical(tng_data, &data->dependency,
-                                 sizeof(data->dependency),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
+        full_data_len = size * frame_step * n_particles * data->n_values_per_frame;
 
-    if(data->dependency & TNG_FRAME_DEPENDENT)
-    {
-        if(stride_length > 1)
+        if(data->datatype == TNG_FLOAT_DATA)
         {
-            temp = 1;
+            swap_needed = tng_data->output_endianness_swap_func_32 != 0;
         }
         else
         {
-            temp = 0;
-        }
-        if(tng_file_output_numerical(tng_data, &temp,
-                                    sizeof(temp),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
-        }
-    }
-
-    if(tng_file_output_numerical(tng_data, &data->n_values_per_frame,
-                                 sizeof(data->n_values_per_frame),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
-
-    if(tng_file_output_numerical(tng_data, &data->codec_id,
-                                 sizeof(data->codec_id),
-                                 hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return(TNG_CRITICAL);
-    }
-
-    if(data->codec_id != TNG_UNCOMPRESSED)
-    {
-        if(tng_file_output_numerical(tng_data, &data->compression_multiplier,
-                                    sizeof(data->compression_multiplier),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
+            swap_needed = tng_data->output_endianness_swap_func_64 != 0;
         }
-    }
 
-    if(data->n_frames > 0 && stride_length > 1)
-    {
-        /* FIXME: first_frame_with_data is not reliably set */
-        if(data->first_frame_with_data == 0)
+        /* TNG and XTC compression only read the values, and take care of the
+         * byte order themselves. Uncompressed and gzipped values are not
+         * multiplied, so unless their byte order must be swapped the values
+         * are also used where they are stored instead of being copied. */
+        if(data->values &&
+           (*codec_id == TNG_TNG_COMPRESSION || *codec_id == TNG_XTC_COMPRESSION ||
+            ((*codec_id == TNG_UNCOMPRESSED || *codec_id == TNG_GZIP_COMPRESSION) &&
+             !swap_needed)))
         {
-            data->first_frame_with_data = frame_set->first_frame;
+            block_data = (const char *)data->values;
         }
-        if(tng_file_output_numerical(tng_data, &data->first_frame_with_data,
-                                    sizeof(data->first_frame_with_data),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+        else
         {
-            return(TNG_CRITICAL);
+            contents = (char *)malloc(tng_max_i64(full_data_len, 1));
+            if(!contents)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                return(TNG_CRITICAL);
+            }
+            block_data = contents;
         }
 
-        if(tng_file_output_numerical(tng_data, &stride_length,
-                                    sizeof(stride_length),
-                                    hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
-        }
-    }
-
-    if(data->dependency & TNG_PARTICLE_DEPENDENT)
-    {
-        if(tng_file_output_numerical(tng_data, &num_first_particle,
-                                     sizeof(num_first_particle),
-                                     hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
-        }
-
-        if(tng_file_output_numerical(tng_data, &n_particles,
-                                     sizeof(n_particles),
-                                     hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
-        }
-    }
-
-    if(data->datatype == TNG_CHAR_DATA)
-    {
-        if(data->strings)
-        {
-            if(data->dependency & TNG_PARTICLE_DEPENDENT)
-            {
-                for(i = 0; i < frame_step; i++)
-                {
-                    first_dim_values = data->strings[i];
-                    for(j = num_first_particle; j < num_first_particle + n_particles;
-                        j++)
-                    {
-                        second_dim_values = first_dim_values[j];
-                        for(k = 0; k < data->n_values_per_frame; k++)
-                        {
-                            if(tng_fwritestr(tng_data, second_dim_values[k],
-                                            hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-                            {
-                                return(TNG_CRITICAL);
-                            }
-                        }
-                    }
-                }
-            }
-            else
-            {
-                for(i = 0; i < frame_step; i++)
-                {
-                    for(j = 0; j < data->n_values_per_frame; j++)
-                    {
-                        if(tng_fwritestr(tng_data, data->strings[0][i][j],
-                                         hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-                        {
-                            return(TNG_CRITICAL);
-                        }
-                    }
-                }
-            }
-        }
-    }
-    else
-    {
-        if(data->dependency & TNG_PARTICLE_DEPENDENT)
-        {
-            full_data_len = size * frame_step * n_particles * data->n_values_per_frame;
-        }
-        else
-        {
-            full_data_len = size * frame_step * data->n_values_per_frame;
-        }
-        contents = (char *)malloc(full_data_len);
-        if(!contents)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
-
-        if(data->values)
+        if(contents && data->values)
         {
             memcpy(contents, data->values, full_data_len);
-            /* If writing TNG compressed data the endianness is taken into account by the compression
-             * routines. TNG compressed data is always written as little endian. */
-            if(data->codec_id != TNG_TNG_COMPRESSION)
+            /* If writing TNG or XTC compressed data the endianness is taken into account by the
+             * compression routines. Such data is always written as little endian. */
+            if(*codec_id != TNG_TNG_COMPRESSION && *codec_id != TNG_XTC_COMPRESSION)
             {
                 switch(data->datatype)
                 {
                 case TNG_FLOAT_DATA:
-                    if(data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
-                    {
-                        if(tng_data->output_endianness_swap_func_32)
-                        {
-                            for(i = 0; i < full_data_len; i+=size)
-                            {
-                                if(tng_data->output_endianness_swap_func_32(tng_data,
-                                (uint32_t *)(contents + i))
-                                != TNG_SUCCESS)
-                                {
-                                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                            __FILE__, __LINE__);
-                                }
-                            }
-                        }
-                    }
-                    else
+                    if(*codec_id != TNG_UNCOMPRESSED && *codec_id != TNG_GZIP_COMPRESSION)
                     {
                         multiplier = data->compression_multiplier;
-                        if(fabs(multiplier - 1.0) > 0.00001 ||
-                        tng_data->output_endianness_swap_func_32)
+                        if(fabs(multiplier - 1.0) > 0.00001)
                         {
                             for(i = 0; i < full_data_len; i+=size)
                             {
                                 *(float *)(contents + i) *= (float)multiplier;
-                                if(tng_data->output_endianness_swap_func_32 &&
-                                tng_data->output_endianness_swap_func_32(tng_data,
-                                (uint32_t *)(contents + i))
-                                != TNG_SUCCESS)
-                                {
-                                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                            __FILE__, __LINE__);
-                                }
                             }
                         }
                     }
+                    if(tng_swap_byte_order_array_32(tng_data,
+                                                    tng_data->output_endianness_swap_func_32,
+                                                    contents, full_data_len / size)
+                       != TNG_SUCCESS)
+                    {
+                        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                                __FILE__, __LINE__);
+                    }
                     break;
                 case TNG_INT_DATA:
-                    if(tng_data->output_endianness_swap_func_64)
+                    if(tng_swap_byte_order_array_64(tng_data,
+                                                    tng_data->output_endianness_swap_func_64,
+                                                    contents, full_data_len / size)
+                       != TNG_SUCCESS)
                     {
-                        for(i = 0; i < full_data_len; i+=size)
-                        {
-                            if(tng_data->output_endianness_swap_func_64(tng_data,
-                            (uint64_t *)(contents + i))
-                            != TNG_SUCCESS)
-                            {
-                                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                        __FILE__, __LINE__);
-                            }
-                        }
+                        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                                __FILE__, __LINE__);
                     }
                     break;
                 case TNG_DOUBLE_DATA:
-                    if(data->codec_id == TNG_UNCOMPRESSED || data-> codec_id == TNG_GZIP_COMPRESSION)
-                    {
-                        if(tng_data->output_endianness_swap_func_64)
-                        {
-                            for(i = 0; i < full_data_len; i+=size)
-                            {
-                                if(tng_data->output_endianness_swap_func_64(tng_data,
-                                (uint64_t *)(contents + i))
-                                != TNG_SUCCESS)
-                                {
-                                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                            __FILE__, __LINE__);
-                                }
-                            }
-                        }
-                    }
-                    else
+                    if(*codec_id != TNG_UNCOMPRESSED && *codec_id != TNG_GZIP_COMPRESSION)
                     {
                         multiplier = data->compression_multiplier;
-                        if(fabs(multiplier - 1.0) > 0.00001 ||
-                        tng_data->output_endianness_swap_func_64)
+                        if(fabs(multiplier - 1.0) > 0.00001)
                         {
                             for(i = 0; i < full_data_len; i+=size)
                             {
                                 *(double *)(contents + i) *= multiplier;
-                                if(tng_data->output_endianness_swap_func_64 &&
-                                tng_data->output_endianness_swap_func_64(tng_data,
-                                (uint64_t *)(contents + i))
-                                != TNG_SUCCESS)
-                                {
-                                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                            __FILE__, __LINE__);
-                                }
                             }
                         }
                     }
+                    if(tng_swap_byte_order_array_64(tng_data,
+                                                    tng_data->output_endianness_swap_func_64,
+                                                    contents, full_data_len / size)
+                       != TNG_SUCCESS)
+                    {
+                        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                                __FILE__, __LINE__);
+                    }
                     break;
                 case TNG_CHAR_DATA:
                     break;
                 }
             }
         }
-        else
+        else if(contents)
         {
             memset(contents, 0, full_data_len);
         }
 
         block_data_len = full_data_len;
 
-        switch(data->codec_id)
+        compressed = 0;
+        start_ticks = tng_statistics_timer_start(tng_data);
+        switch(*codec_id)
         {
         case TNG_XTC_COMPRESSION:
-            fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
-            data->codec_id = TNG_UNCOMPRESSED;
+            stat = tng_xtc_compress(tng_data, block, frame_step,
+                                    n_particles, data->datatype,
+                                    block_data, &compressed, &block_data_len);
+            if(stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Could not write XTC compressed block data. %s: %d\n",
+                    __FILE__, __LINE__);
+            }
             break;
         case TNG_TNG_COMPRESSION:
             stat = tng_compress(tng_data, block, frame_step,
                                 n_particles, data->datatype,
-                                &contents, &block_data_len);
+                                block_data, &compressed, &block_data_len);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Could not write TNG compressed block data. %s: %d\n",
                     __FILE__, __LINE__);
-                if(stat == TNG_CRITICAL)
-                {
-                    return(TNG_CRITICAL);
-                }
-                /* Set the data again, but with no compression (to write only
-                 * the relevant data) */
-                data->codec_id = TNG_UNCOMPRESSED;
-                stat = tng_data_block_write(tng_data, block,
-                                            block_index, is_particle_data, mapping,
-                                            hash_mode);
-                free(contents);
-                return(stat);
             }
             break;
         case TNG_GZIP_COMPRESSION:
-    /*         fprintf(stderr, "TNG library: Before compression: %" PRId64 "\n", block->block_contents_size); */
             stat = tng_gzip_compress(tng_data,
-                                     &contents,
+                                     block_data,
                                      full_data_len,
+                                     &compressed,
                                      &block_data_len);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Could not write gzipped block data. %s: %d\n", __FILE__,
                     __LINE__);
-                if(stat == TNG_CRITICAL)
-                {
-                    return(TNG_CRITICAL);
-                }
-                data->codec_id = TNG_UNCOMPRESSED;
             }
-    /*         fprintf(stderr, "TNG library: After compression: %" PRId64 "\n", block->block_contents_size); */
             break;
+        default:
+            stat = TNG_SUCCESS;
         }
-        if(block_data_len != full_data_len)
+        tng_statistics_timer_stop(tng_data, *codec_id == TNG_GZIP_COMPRESSION ?
+                                  &tng_data->statistics.gzip_compress_ticks :
+                                  &tng_data->statistics.compress_ticks, start_ticks);
+        if(stat != TNG_SUCCESS)
         {
-            block->block_contents_size -= full_data_len - block_data_len;
-
-            curr_file_pos = ftello(tng_data->output_file);
-            fseeko(tng_data->output_file, header_file_pos + sizeof(block->header_contents_size), SEEK_SET);
-
-            if(tng_file_output_numerical(tng_data, &block->block_contents_size,
-                                         sizeof(block->block_contents_size),
-                                         TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+            free(contents);
+            if(stat == TNG_CRITICAL)
             {
                 return(TNG_CRITICAL);
             }
-            fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
-        }
-        if(fwrite(contents, block_data_len, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n", __FILE__,
-                    __LINE__);
-            return(TNG_CRITICAL);
+            /* Encode the data again, but with no compression (to write only
+             * the relevant data) */
+            *codec_id = TNG_UNCOMPRESSED;
+            return(tng_data_block_encode(tng_data, block, data, block_type_flag,
+                                         mapping, hash_mode, codec_id,
+                                         encoded, encoded_len));
         }
-        if(hash_mode == TNG_USE_HASH)
+        if(compressed)
         {
-            md5_append(&md5_state, (md5_byte_t *)contents, block_data_len);
+            free(contents);
+            contents = compressed;
+            block_data = contents;
         }
+    }
+
+    /* Then calculate the final sizes to be able to encode the whole block. */
+    block->block_contents_size = sizeof(data->datatype) + sizeof(data->dependency) +
+                                 sizeof(data->n_values_per_frame) + sizeof(*codec_id) +
+                                 block_data_len;
+    if(data->dependency & TNG_FRAME_DEPENDENT)
+    {
+        block->block_contents_size += sizeof(temp);
+    }
+    if(*codec_id != TNG_UNCOMPRESSED)
+    {
+        block->block_contents_size += sizeof(data->compression_multiplier);
+    }
+    if(data->n_frames > 0 && stride_length > 1)
+    {
+        block->block_contents_size += sizeof(data->first_frame_with_data) +
+                                      sizeof(stride_length);
+    }
+    if(data->dependency & TNG_PARTICLE_DEPENDENT)
+    {
+        block->block_contents_size += sizeof(num_first_particle) + sizeof(n_particles);
+    }
 
+    if(tng_block_encoding_init(tng_data, block, &dest, encoded_len) != TNG_SUCCESS)
+    {
         free(contents);
+        return(TNG_CRITICAL);
     }
 
-    if(hash_mode == TNG_USE_HASH)
+    pos = dest + block->header_contents_size;
+    pos = tng_buffer_numerical_put(tng_data, pos, &data->datatype,
+                                   sizeof(data->datatype));
+    pos = tng_buffer_numerical_put(tng_data, pos, &data->dependency,
+                                   sizeof(data->dependency));
+    if(data->dependency & TNG_FRAME_DEPENDENT)
     {
-        md5_finish(&md5_state, (md5_byte_t *)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos +
-                3 * sizeof(int64_t), SEEK_SET);
-        if(fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__,
-                    __LINE__);
-            return(TNG_CRITICAL);
-        }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+        temp = stride_length > 1 ? 1 : 0;
+        pos = tng_buffer_numerical_put(tng_data, pos, &temp, sizeof(temp));
+    }
+    pos = tng_buffer_numerical_put(tng_data, pos, &data->n_values_per_frame,
+                                   sizeof(data->n_values_per_frame));
+    pos = tng_buffer_numerical_put(tng_data, pos, codec_id, sizeof(*codec_id));
+    if(*codec_id != TNG_UNCOMPRESSED)
+    {
+        pos = tng_buffer_numerical_put(tng_data, pos, &data->compression_multiplier,
+                                       sizeof(data->compression_multiplier));
+    }
+    if(data->n_frames > 0 && stride_length > 1)
+    {
+        pos = tng_buffer_numerical_put(tng_data, pos, &data->first_frame_with_data,
+                                       sizeof(data->first_frame_with_data));
+        pos = tng_buffer_numerical_put(tng_data, pos, &stride_length,
+                                       sizeof(stride_length));
+    }
+    if(data->dependency & TNG_PARTICLE_DEPENDENT)
+    {
+        pos = tng_buffer_numerical_put(tng_data, pos, &num_first_particle,
+                                       sizeof(num_first_particle));
+        pos = tng_buffer_numerical_put(tng_data, pos, &n_particles,
+                                       sizeof(n_particles));
+    }
+    if(block_data_len > 0)
+    {
+        memcpy(pos, block_data, block_data_len);
     }
+    free(contents);
 
-    frame_set->n_written_frames += frame_set->n_unwritten_frames;
-    frame_set->n_unwritten_frames = 0;
+    tng_block_encoding_finish(tng_data, block, hash_mode, dest);
+
+    *encoded = dest;
 
     return(TNG_SUCCESS);
 }
 
 /**
- * @brief Read the meta information of a data block (particle or non-particle data).
+ * @brief Write a data block (particle or non-particle data)
  * @param tng_data is a trajectory data container.
- * @param datatype is set to the datatype of the data block.
- * @param dependency is set to the dependency (particle and/or frame dependent)
- * @param sparse_data is set to TRUE if data is not written every frame.
- * @param n_values is set to the number of values per frame of the data.
- * @param codec_id is set to the ID of the codec used to compress the data.
- * @param first_frame_with_data is set to the first frame with data (only relevant if
- * sparse_data == TRUE).
- * @param stride_length is set to the writing interval of the data (1 if sparse_data
- * == FALSE).
- * @param num_first_particle is set to the number of the first particle with data written
- * in this block.
- * @param block_n_particles is set to the number of particles in this data block.
- * @param multiplier is set to the compression multiplier.
- * @param hash_mode specifies whether to check if the hash matches the contents or not.
- * @param md5_state is the md5 hash of the block (only used if hash_mode == TNG_USE_HASH).
+ * @param block is the block to store the data (should already contain
+ * the block headers and the block contents).
+ * @param block_index is the index number of the data block in the frame set.
+ * @param is_particle_data is a flag to specify if the data to write is
+ * particle dependent or not.
+ * @param mapping is the particle mapping that is relevant for the data block.
+ * Only relevant if writing particle dependent data.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_data_block_meta_information_read
-                (const tng_trajectory_t tng_data,
-                 char *datatype,
-                 char *dependency,
-                 char *sparse_data,
-                 int64_t *n_values,
-                 int64_t *codec_id,
-                 int64_t *first_frame_with_data,
-                 int64_t *stride_length,
-                 int64_t *n_frames,
-                 int64_t *num_first_particle,
-                 int64_t *block_n_particles,
-                 double *multiplier,
-                 const char hash_mode,
-                 md5_state_t *md5_state)
+static tng_function_status tng_data_block_write(const tng_trajectory_t tng_data,
+                                                const tng_gen_block_t block,
+                                                const int64_t block_index,
+                                                const tng_bool is_particle_data,
+                                                const tng_particle_mapping_t mapping,
+                                                const char hash_mode)
 {
-    if(tng_file_input_numerical(tng_data, datatype,
-                                sizeof(*datatype),
-                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    int64_t codec_id, encoded_len;
+    char block_type_flag, *encoded;
+    tng_trajectory_frame_set_t frame_set =
+    &tng_data->current_trajectory_frame_set;
+    tng_data_t data;
+    tng_function_status stat;
+
+    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
         return(TNG_CRITICAL);
     }
 
-    if(tng_file_input_numerical(tng_data, dependency,
-                                sizeof(*dependency),
-                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if(tng_data_block_write_prepare(tng_data, block_index, is_particle_data,
+                                    &data, &block_type_flag) != TNG_SUCCESS)
     {
-        return(TNG_CRITICAL);
+        return(TNG_SUCCESS);
     }
 
-    if(*dependency & TNG_FRAME_DEPENDENT)
+    codec_id = data->codec_id;
+    stat = tng_data_block_encode(tng_data, block, data, block_type_flag, mapping,
+                                 hash_mode, &codec_id, &encoded, &encoded_len);
+    if(codec_id != data->codec_id)
     {
-        if(tng_file_input_numerical(tng_data, sparse_data,
-                                    sizeof(*sparse_data),
-                                    hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
-        }
+        data->codec_id = codec_id;
+        data->compression_multiplier = 1.0;
     }
-
-    if(tng_file_input_numerical(tng_data, n_values,
-                                sizeof(*n_values),
-                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if(stat != TNG_SUCCESS)
     {
-        return(TNG_CRITICAL);
+        return(stat);
     }
 
-    if(tng_file_input_numerical(tng_data, codec_id,
-                                sizeof(*codec_id),
-                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if(tng_fwrite(tng_data, encoded, encoded_len, 1, tng_data->output_file) != 1)
     {
+        fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n", __FILE__,
+                __LINE__);
+        free(encoded);
         return(TNG_CRITICAL);
     }
+    free(encoded);
 
-    if(*codec_id != TNG_UNCOMPRESSED)
-    {
-        if(tng_file_input_numerical(tng_data, multiplier,
-                                    sizeof(*multiplier),
-                                    hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return(TNG_CRITICAL);
-        }
-    }
-    else
-    {
-        *multiplier = 1;
+    frame_set->n_written_frames += frame_set->n_unwritten_frames;
+    frame_set->n_unwritten_frames = 0;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Check if encoding a data block can store a TNG compression
+ * algorithm in the trajectory, i.e. if the data block is TNG compressed and
+ * the compression algorithm has not been fully determined yet.
+ * @param tng_data is a trajectory data container.
+ * @param data is the data block.
+ * @return TNG_TRUE if the compression algorithm can be stored, otherwise
+ * TNG_FALSE.
+ */
+static tng_bool tng_data_block_compress_algo_pending
+                (const tng_trajectory_t tng_data,
+                 const tng_data_t data)
+{
+    int *algo;
+
+    if(data->codec_id != TNG_TNG_COMPRESSION)
+    {
+        return(TNG_FALSE);
+    }
+    if(data->block_id == TNG_TRAJ_POSITIONS)
+    {
+        algo = tng_data->compress_algo_pos;
+    }
+    else if(data->block_id == TNG_TRAJ_VELOCITIES)
+    {
+        algo = tng_data->compress_algo_vel;
+    }
+    else
+    {
+        return(TNG_FALSE);
+    }
+
+    if(!algo || algo[2] == -1 || algo[3] == -1)
+    {
+        return(TNG_TRUE);
+    }
+    return(TNG_FALSE);
+}
+
+/**
+ * @brief Encode a data block or a particle mapping block of the current frame
+ * set, see tng_data_block_encode() and tng_trajectory_mapping_block_encode().
+ * @param tng_data is a trajectory data container.
+ * @param encoding is the block to encode. Its status is set to the result.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ */
+static void tng_block_encoding_run
+                (const tng_trajectory_t tng_data,
+                 struct tng_block_encoding *encoding,
+                 const char hash_mode)
+{
+    if(encoding->data)
+    {
+        encoding->stat = tng_data_block_encode(tng_data, encoding->block, encoding->data,
+                                               TNG_TRAJECTORY_BLOCK, encoding->mapping,
+                                               hash_mode, &encoding->codec_id,
+                                               &encoding->encoded, &encoding->encoded_len);
+    }
+    else
+    {
+        encoding->stat = tng_trajectory_mapping_block_encode
+                         (tng_data, encoding->block,
+                          (int)(encoding->mapping -
+                                tng_data->current_trajectory_frame_set.mappings),
+                          hash_mode, &encoding->encoded, &encoding->encoded_len);
+    }
+    encoding->is_encoded = TNG_TRUE;
+}
+
+/**
+ * @brief Encode all data blocks and particle mapping blocks of the current
+ * frame set in memory.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param encodings_p is set to the list of encoded blocks, in the order
+ * they are written to the file after the frame set block. Particle data
+ * blocks are listed once for each particle mapping, after its mapping block.
+ * The list must be freed using tng_block_encodings_free().
+ * @param n_encodings is set to the number of encoded blocks.
+ * @details The blocks are encoded concurrently if OpenMP is enabled.
+ * Particle mapping blocks, which are small, and data blocks that can store a
+ * TNG compression algorithm in the trajectory are encoded one at a time
+ * before the others, so that the algorithm is only determined once.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_blocks_encode
+                (const tng_trajectory_t tng_data,
+                 const char hash_mode,
+                 struct tng_block_encoding **encodings_p,
+                 int64_t *n_encodings)
+{
+    int64_t i, j, n_particle_mappings;
+    char block_type_flag;
+    tng_trajectory_frame_set_t frame_set =
+    &tng_data->current_trajectory_frame_set;
+    struct tng_block_encoding *encodings, *encoding;
+    tng_data_t data, *particle_data;
+    tng_function_status stat = TNG_SUCCESS;
+
+    *encodings_p = 0;
+    *n_encodings = 0;
+
+    n_particle_mappings = tng_max_i64(1, frame_set->n_mapping_blocks);
+
+    encodings = (struct tng_block_encoding *)
+                calloc(tng_max_i64(1, frame_set->n_data_blocks +
+                                      frame_set->n_mapping_blocks +
+                                      frame_set->n_particle_data_blocks *
+                                      n_particle_mappings),
+                       sizeof(struct tng_block_encoding));
+    particle_data = (tng_data_t *)malloc(sizeof(tng_data_t) *
+                                         tng_max_i64(1, frame_set->n_particle_data_blocks));
+    if(!encodings || !particle_data)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(encodings);
+        free(particle_data);
+        return(TNG_CRITICAL);
+    }
+    *encodings_p = encodings;
+
+    /* Preparing the data blocks modifies them, so that is done once for
+     * each data block before encoding. */
+    for(i = 0; i < frame_set->n_data_blocks; i++)
+    {
+        if(tng_data_block_write_prepare(tng_data, i, TNG_FALSE, &data,
+                                        &block_type_flag) == TNG_SUCCESS)
+        {
+            encodings[*n_encodings].data = data;
+            (*n_encodings)++;
+        }
+    }
+    for(i = 0; i < frame_set->n_particle_data_blocks; i++)
+    {
+        if(tng_data_block_write_prepare(tng_data, i, TNG_TRUE, &data,
+                                        &block_type_flag) != TNG_SUCCESS)
+        {
+            data = 0;
+        }
+        particle_data[i] = data;
+    }
+    for(i = 0; i < n_particle_mappings; i++)
+    {
+        if(frame_set->n_mapping_blocks > 0)
+        {
+            if(frame_set->mappings[i].n_particles <= 0)
+            {
+                continue;
+            }
+            encodings[*n_encodings].mapping = &frame_set->mappings[i];
+            (*n_encodings)++;
+        }
+        for(j = 0; j < frame_set->n_particle_data_blocks; j++)
+        {
+            if(particle_data[j])
+            {
+                encodings[*n_encodings].data = particle_data[j];
+                encodings[*n_encodings].is_particle_data = TNG_TRUE;
+                if(frame_set->n_mapping_blocks > 0)
+                {
+                    encodings[*n_encodings].mapping = &frame_set->mappings[i];
+                }
+                (*n_encodings)++;
+            }
+        }
+    }
+    free(particle_data);
+
+    for(i = 0; i < *n_encodings; i++)
+    {
+        encoding = &encodings[i];
+        if(encoding->data)
+        {
+            encoding->codec_id = encoding->data->codec_id;
+        }
+        if(tng_block_init(&encoding->block) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+
+    for(i = 0; i < *n_encodings; i++)
+    {
+        encoding = &encodings[i];
+        if(!encoding->data ||
+           tng_data_block_compress_algo_pending(tng_data, encoding->data))
+        {
+            tng_block_encoding_run(tng_data, encoding, hash_mode);
+        }
+    }
+
+    if(tng_statistics_threads_begin(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(i = 0; i < *n_encodings; i++)
+    {
+        if(!encodings[i].is_encoded)
+        {
+            tng_block_encoding_run(tng_data, &encodings[i], hash_mode);
+        }
+    }
+    tng_statistics_threads_end(tng_data);
+
+    for(i = 0; i < *n_encodings; i++)
+    {
+        encoding = &encodings[i];
+        /* Data that could not be compressed is not compressed in the
+         * following frame sets either. */
+        if(encoding->data && encoding->codec_id != encoding->data->codec_id)
+        {
+            encoding->data->codec_id = encoding->codec_id;
+            encoding->data->compression_multiplier = 1.0;
+        }
+        if(encoding->stat > stat)
+        {
+            stat = encoding->stat;
+        }
+    }
+
+    return(stat);
+}
+
+/**
+ * @brief Free a list of data blocks encoded by
+ * tng_frame_set_blocks_encode().
+ * @param encodings is the list of encoded data blocks.
+ * @param n_encodings is the number of encoded data blocks.
+ */
+static void tng_block_encodings_free
+                (struct tng_block_encoding *encodings,
+                 const int64_t n_encodings)
+{
+    int64_t i;
+
+    if(!encodings)
+    {
+        return;
+    }
+    for(i = 0; i < n_encodings; i++)
+    {
+        free(encodings[i].encoded);
+        if(encodings[i].block)
+        {
+            tng_block_destroy(&encodings[i].block);
+        }
+    }
+    free(encodings);
+}
+
+/**
+ * @brief Read the meta information of a data block (particle or non-particle data).
+ * @param tng_data is a trajectory data container.
+ * @param datatype is set to the datatype of the data block.
+ * @param dependency is set to the dependency (particle and/or frame dependent)
+ * @param sparse_data is set to TRUE if data is not written every frame.
+ * @param n_values is set to the number of values per frame of the data.
+ * @param codec_id is set to the ID of the codec used to compress the data.
+ * @param first_frame_with_data is set to the first frame with data (only relevant if
+ * sparse_data == TRUE).
+ * @param stride_length is set to the writing interval of the data (1 if sparse_data
+ * == FALSE).
+ * @param num_first_particle is set to the number of the first particle with data written
+ * in this block.
+ * @param block_n_particles is set to the number of particles in this data block.
+ * @param multiplier is set to the compression multiplier.
+ * @param hash_mode specifies whether to check if the hash matches the contents or not.
+ * @param md5_state is the md5 hash of the block (only used if hash_mode == TNG_USE_HASH).
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_meta_information_read
+                (const tng_trajectory_t tng_data,
+                 char *datatype,
+                 char *dependency,
+                 char *sparse_data,
+                 int64_t *n_values,
+                 int64_t *codec_id,
+                 int64_t *first_frame_with_data,
+                 int64_t *stride_length,
+                 int64_t *n_frames,
+                 int64_t *num_first_particle,
+                 int64_t *block_n_particles,
+                 double *multiplier,
+                 const char hash_mode,
+                 md5_state_t *md5_state)
+{
+    if(tng_file_input_numerical(tng_data, datatype,
+                                sizeof(*datatype),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(tng_file_input_numerical(tng_data, dependency,
+                                sizeof(*dependency),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(*dependency & TNG_FRAME_DEPENDENT)
+    {
+        if(tng_file_input_numerical(tng_data, sparse_data,
+                                    sizeof(*sparse_data),
+                                    hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+
+    if(tng_file_input_numerical(tng_data, n_values,
+                                sizeof(*n_values),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(tng_file_input_numerical(tng_data, codec_id,
+                                sizeof(*codec_id),
+                                hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(*codec_id != TNG_UNCOMPRESSED)
+    {
+        if(tng_file_input_numerical(tng_data, multiplier,
+                                    sizeof(*multiplier),
+                                    hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+    else
+    {
+        *multiplier = 1;
     }
 
     if(*dependency & TNG_FRAME_DEPENDENT)
@@ -6449,7 +9335,7 @@ static tng_function_status tng_data_block_contents_read
     else
     {
         /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
     }
 
     return(stat);
@@ -6578,7 +9464,7 @@ static tng_function_status tng_frame_set_finalize
 
     pos = tng_data->current_trajectory_frame_set_output_file_pos;
 
-    fseeko(tng_data->output_file, pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->output_file, pos, SEEK_SET);
 
     if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
     {
@@ -6591,9 +9477,9 @@ static tng_function_status tng_frame_set_finalize
 
 //     contents_start_pos = ftello(tng_data->output_file);
 
-    fseeko(tng_data->output_file, sizeof(frame_set->first_frame), SEEK_CUR);
-    if(fwrite(&frame_set->n_frames, sizeof(frame_set->n_frames),
-              1, tng_data->output_file) != 1)
+    tng_fseeko(tng_data, tng_data->output_file, sizeof(frame_set->first_frame), SEEK_CUR);
+    if(tng_fwrite(tng_data, &frame_set->n_frames, sizeof(frame_set->n_frames),
+                  1, tng_data->output_file) != 1)
     {
         tng_data->input_file = temp;
         tng_block_destroy(&block);
@@ -6606,7 +9492,7 @@ static tng_function_status tng_frame_set_finalize
                             pos + block->header_contents_size);
     }
 
-    fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->output_file, curr_file_pos, SEEK_SET);
 
     tng_data->input_file = temp;
     tng_block_destroy(&block);
@@ -6692,35 +9578,22 @@ tng_function_status DECLSPECDLLEXPORT tng_atom_name_set
                  const tng_atom_t atom,
                  const char *new_name)
 {
-    unsigned int len;
-    (void)tng_data;
+    tng_atom_t own_atom = atom;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
-
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if(atom->name && strlen(atom->name) < len)
+    if(tng_molecular_system_unshare(tng_data, 0, 0, 0, &own_atom) != TNG_SUCCESS)
     {
-        free(atom->name);
-        atom->name = 0;
+        return(TNG_CRITICAL);
     }
-    if(!atom->name)
+    if(own_atom != atom)
     {
-        atom->name = (char *)malloc(len);
-        if(!atom->name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
+        /* The atom was in a shared molecular system, continue with the copy. */
+        return(tng_atom_name_set(tng_data, own_atom, new_name));
     }
 
-    strncpy(atom->name, new_name, len);
-
-    return(TNG_SUCCESS);
+    return(tng_string_pool_intern(&tng_data->name_pool, new_name, &atom->name));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_atom_type_get
@@ -6748,35 +9621,22 @@ tng_function_status DECLSPECDLLEXPORT tng_atom_type_set
                  const tng_atom_t atom,
                  const char *new_type)
 {
-    unsigned int len;
-    (void)tng_data;
+    tng_atom_t own_atom = atom;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(new_type, "TNG library: new_type must not be a NULL pointer.");
 
-    len = tng_min_size(strlen(new_type) + 1, TNG_MAX_STR_LEN);
-
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if(atom->atom_type && strlen(atom->atom_type) < len)
+    if(tng_molecular_system_unshare(tng_data, 0, 0, 0, &own_atom) != TNG_SUCCESS)
     {
-        free(atom->atom_type);
-        atom->atom_type = 0;
+        return(TNG_CRITICAL);
     }
-    if(!atom->atom_type)
+    if(own_atom != atom)
     {
-        atom->atom_type = (char *)malloc(len);
-        if(!atom->atom_type)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
+        /* The atom was in a shared molecular system, continue with the copy. */
+        return(tng_atom_type_set(tng_data, own_atom, new_type));
     }
 
-    strncpy(atom->atom_type, new_type, len);
-
-    return(TNG_SUCCESS);
+    return(tng_string_pool_intern(&tng_data->name_pool, new_type, &atom->atom_type));
 }
 
 /**
@@ -6793,33 +9653,12 @@ static tng_function_status tng_atom_init(const tng_atom_t atom)
 }
 
 /**
- * @brief Free the memory in an atom struct
- * @param atom is the atom to destroy.
- * @return TNG_SUCCESS (0) if successful.
- */
-static tng_function_status tng_atom_destroy(const tng_atom_t atom)
-{
-    if(atom->name)
-    {
-        free(atom->name);
-        atom->name = 0;
-    }
-    if(atom->atom_type)
-    {
-        free(atom->atom_type);
-        atom->atom_type = 0;
-    }
-
-    return(TNG_SUCCESS);
-}
-
-/**
- * @brief Update chain->residue pointers (after new memory for
- * molecule->residues has been allocated).
- * @param tng_data The trajectory container containing the molecule.
- * @param mol The molecule that contains the chains that need to be
- * updated.
- * @returns TNG_SUCCESS (0) if successful.
+ * @brief Update chain->residue pointers (after new memory for
+ * molecule->residues has been allocated).
+ * @param tng_data The trajectory container containing the molecule.
+ * @param mol The molecule that contains the chains that need to be
+ * updated.
+ * @returns TNG_SUCCESS (0) if successful.
  */
 static tng_function_status tng_molecule_chains_residue_pointers_update
                 (const tng_trajectory_t tng_data,
@@ -6868,6 +9707,113 @@ static tng_function_status tng_molecule_atoms_residue_pointers_update
     return(TNG_SUCCESS);
 }
 
+/**
+ * @brief Update residue->chain pointers (after new memory for
+ * molecule->chains has been allocated).
+ * @param tng_data The trajectory container containing the molecule.
+ * @param mol The molecule that contains the residues that need to be
+ * updated.
+ * @returns TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_molecule_residues_chain_pointers_update
+                (const tng_trajectory_t tng_data,
+                 const tng_molecule_t mol)
+{
+    tng_chain_t chain;
+    int64_t i, j;
+    (void)tng_data;
+
+    for(i = 0; i < mol->n_chains; i++)
+    {
+        chain = &mol->chains[i];
+        for(j = 0; j < chain->n_residues; j++)
+        {
+            chain->residues[j].chain = chain;
+        }
+    }
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Update chain->molecule pointers (after the molecule has been
+ * moved in memory).
+ * @param tng_data The trajectory container containing the molecule.
+ * @param mol The molecule that contains the chains that need to be
+ * updated.
+ * @returns TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_molecule_chains_molecule_pointers_update
+                (const tng_trajectory_t tng_data,
+                 const tng_molecule_t mol)
+{
+    int64_t i;
+    (void)tng_data;
+
+    for(i = 0; i < mol->n_chains; i++)
+    {
+        mol->chains[i].molecule = mol;
+    }
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Make room for one more molecule in the molecule list and the
+ * molecule count list of a trajectory.
+ * @param tng_data The trajectory container.
+ * @returns TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_molecules_grow(const tng_trajectory_t tng_data)
+{
+    tng_molecule_t new_molecules;
+    int64_t *new_molecule_cnt_list, capacity, i;
+
+    if(tng_molecular_system_unshare(tng_data, 0, 0, 0, 0) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    capacity = tng_data->molecules_capacity;
+    new_molecules = (tng_molecule_t)tng_array_grow(tng_data->molecules, &capacity,
+                                                   tng_data->n_molecules + 1,
+                                                   sizeof(struct tng_molecule));
+    if(!new_molecules)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    tng_data->molecules = new_molecules;
+
+    if(tng_molecular_system_ref_count_init(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(capacity != tng_data->molecules_capacity)
+    {
+        /* The molecules may have moved. */
+        for(i = 0; i < tng_data->n_molecules; i++)
+        {
+            tng_molecule_chains_molecule_pointers_update(tng_data, &new_molecules[i]);
+        }
+    }
+
+    new_molecule_cnt_list = (int64_t *)tng_array_grow(tng_data->molecule_cnt_list,
+                                                      &tng_data->molecules_capacity,
+                                                      tng_data->n_molecules + 1,
+                                                      sizeof(int64_t));
+    if(!new_molecule_cnt_list)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    tng_data->molecule_cnt_list = new_molecule_cnt_list;
+
+    return(TNG_SUCCESS);
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_version_major
                 (const tng_trajectory_t tng_data,
                  int *version)
@@ -6943,47 +9889,22 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_w_id_add
                  const int64_t id,
                  tng_molecule_t *molecule)
 {
-    tng_molecule_t new_molecules;
-    int64_t *new_molecule_cnt_list;
     tng_function_status stat = TNG_SUCCESS;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    new_molecules = (tng_molecule_t)realloc(tng_data->molecules,
-                                            sizeof(struct tng_molecule) *
-                                            (tng_data->n_molecules + 1));
-
-    if(!new_molecules)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(tng_data->molecules);
-        tng_data->molecules = 0;
-        return(TNG_CRITICAL);
-    }
-
-    new_molecule_cnt_list = (int64_t *)realloc(tng_data->molecule_cnt_list,
-                                               sizeof(int64_t) *
-                                               (tng_data->n_molecules + 1));
+    tng_topology_index_free(tng_data);
 
-    if(!new_molecule_cnt_list)
+    if(tng_molecules_grow(tng_data) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(tng_data->molecule_cnt_list);
-        tng_data->molecule_cnt_list = 0;
-        free(new_molecules);
         return(TNG_CRITICAL);
     }
 
-    tng_data->molecules = new_molecules;
-    tng_data->molecule_cnt_list = new_molecule_cnt_list;
-
-    *molecule = &new_molecules[tng_data->n_molecules];
+    *molecule = &tng_data->molecules[tng_data->n_molecules];
 
     tng_molecule_init(tng_data, *molecule);
-    tng_molecule_name_set(tng_data, *molecule, name);
+    stat = tng_molecule_name_set(tng_data, *molecule, name);
 
     /* FIXME: Should this be a function argument instead? */
     tng_data->molecule_cnt_list[tng_data->n_molecules] = 0;
@@ -6999,11 +9920,13 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_existing_add
                 (const tng_trajectory_t tng_data,
                  tng_molecule_t *molecule_p)
 {
-    int64_t *new_molecule_cnt_list, id;
-    tng_molecule_t new_molecules, molecule;
+    int64_t id;
+    tng_molecule_t molecule;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
+    tng_topology_index_free(tng_data);
+
     /* Set ID to the ID of the last molecule + 1 */
     if(tng_data->n_molecules)
     {
@@ -7014,45 +9937,29 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_existing_add
         id = 1;
     }
 
-    new_molecules = (tng_molecule_t)realloc(tng_data->molecules,
-                                            sizeof(struct tng_molecule) *
-                                            (tng_data->n_molecules + 1));
-
-    if(!new_molecules)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(tng_data->molecules);
-        tng_data->molecules = 0;
-        return(TNG_CRITICAL);
-    }
-
-    new_molecule_cnt_list = (int64_t *)realloc(tng_data->molecule_cnt_list,
-                                               sizeof(int64_t) *
-                                               (tng_data->n_molecules + 1));
-
-    if(!new_molecule_cnt_list)
+    if(tng_molecules_grow(tng_data) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(tng_data->molecule_cnt_list);
-        tng_data->molecule_cnt_list = 0;
-        free(new_molecules);
         return(TNG_CRITICAL);
     }
 
     molecule = *molecule_p;
 
-    tng_data->molecules = new_molecules;
-    tng_data->molecule_cnt_list = new_molecule_cnt_list;
-
-    new_molecules[tng_data->n_molecules] = *molecule;
+    tng_data->molecules[tng_data->n_molecules] = *molecule;
 
     tng_data->molecule_cnt_list[tng_data->n_molecules] = 0;
 
     free(*molecule_p);
 
-    molecule = &new_molecules[tng_data->n_molecules];
+    molecule = &tng_data->molecules[tng_data->n_molecules];
+
+    tng_molecule_chains_molecule_pointers_update(tng_data, molecule);
+
+    /* Molecules in the molecular system always have a name. */
+    if(!molecule->name &&
+       tng_string_pool_intern(&tng_data->name_pool, "", &molecule->name) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
 
     *molecule_p = molecule;
 
@@ -7087,35 +9994,22 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_name_set
                  const tng_molecule_t molecule,
                  const char *new_name)
 {
-    unsigned int len;
-    (void)tng_data;
+    tng_molecule_t own_molecule = molecule;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
-
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if(molecule->name && strlen(molecule->name) < len)
+    if(tng_molecular_system_unshare(tng_data, &own_molecule, 0, 0, 0) != TNG_SUCCESS)
     {
-        free(molecule->name);
-        molecule->name = 0;
+        return(TNG_CRITICAL);
     }
-    if(!molecule->name)
+    if(own_molecule != molecule)
     {
-        molecule->name = (char *)malloc(len);
-        if(!molecule->name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
+        /* The molecule was in a shared molecular system, continue with the copy. */
+        return(tng_molecule_name_set(tng_data, own_molecule, new_name));
     }
 
-    strncpy(molecule->name, new_name, len);
-
-    return(TNG_SUCCESS);
+    return(tng_string_pool_intern(&tng_data->name_pool, new_name, &molecule->name));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_get
@@ -7130,7 +10024,9 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_get
 
     for(i = 0; i < tng_data->n_molecules; i++)
     {
-        if(&tng_data->molecules[i] == molecule)
+        if(&tng_data->molecules[i] == molecule ||
+           (i < tng_data->n_detached_molecules &&
+            &tng_data->detached_molecules[i] == molecule))
         {
             index = i;
             break;
@@ -7156,7 +10052,9 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_set
 
     for(i = 0; i < tng_data->n_molecules; i++)
     {
-        if(&tng_data->molecules[i] == molecule)
+        if(&tng_data->molecules[i] == molecule ||
+           (i < tng_data->n_detached_molecules &&
+            &tng_data->detached_molecules[i] == molecule))
         {
             index = i;
             break;
@@ -7168,6 +10066,8 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_set
                __FILE__, __LINE__);
         return(TNG_FAILURE);
     }
+    tng_topology_index_free(tng_data);
+
     if(tng_data->var_num_atoms_flag == TNG_CONSTANT_N_ATOMS)
     {
         old_cnt = tng_data->molecule_cnt_list[index];
@@ -7239,131 +10139,12 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_of_index_get
 tng_function_status DECLSPECDLLEXPORT tng_molecule_system_copy(const tng_trajectory_t tng_data_src,
                                                                const tng_trajectory_t tng_data_dest)
 {
-    tng_molecule_t molecule, molecule_temp;
-    tng_chain_t chain, chain_temp;
-    tng_residue_t residue, residue_temp;
-    tng_atom_t atom, atom_temp;
-    tng_bond_t bond_temp;
-    tng_function_status stat;
-    int64_t i, j, k, l, *list_temp;
-
     TNG_ASSERT(tng_data_src, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(tng_data_dest, "TNG library: Trajectory container not properly setup.");
 
-    for(i = 0; i < tng_data_dest->n_molecules; i++)
-    {
-        molecule = &tng_data_dest->molecules[i];
-        tng_molecule_destroy(tng_data_dest, molecule);
-    }
-
-    tng_data_dest->n_molecules = 0;
-    tng_data_dest->n_particles = 0;
-
-    molecule_temp = (tng_molecule_t)realloc(tng_data_dest->molecules,
-                                            sizeof(struct tng_molecule) * tng_data_src->n_molecules);
-    if(!molecule_temp)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(tng_data_dest->molecules);
-        tng_data_dest->molecules = 0;
-        return(TNG_CRITICAL);
-    }
-    list_temp = (int64_t *)realloc(tng_data_dest->molecule_cnt_list,
-                                   sizeof(int64_t) * tng_data_src->n_molecules);
-    if(!list_temp)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(tng_data_dest->molecule_cnt_list);
-        tng_data_dest->molecule_cnt_list = 0;
-        free(molecule_temp);
-        return(TNG_CRITICAL);
-    }
-
-    tng_data_dest->molecules = molecule_temp;
-    tng_data_dest->molecule_cnt_list = list_temp;
-
-    for(i = 0; i < tng_data_src->n_molecules; i++)
-    {
-        molecule = &tng_data_src->molecules[i];
-        stat = tng_molecule_w_id_add(tng_data_dest, molecule->name, molecule->id,
-                                     &molecule_temp);
-        if(stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot create new molecule to make a copy. %s: %d\n",
-                   __FILE__, __LINE__);
-            return(stat);
-        }
-        molecule_temp->quaternary_str = molecule->quaternary_str;
-        for(j = 0; j < molecule->n_chains; j++)
-        {
-            chain = &molecule->chains[j];
-            stat = tng_molecule_chain_w_id_add(tng_data_dest, molecule_temp,
-                                               chain->name, chain->id,
-                                               &chain_temp);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot create new chain to make a copy. %s: %d\n",
-                       __FILE__, __LINE__);
-                return(stat);
-            }
-            for(k = 0; k < chain->n_residues; k++)
-            {
-                residue = &chain->residues[k];
-                stat = tng_chain_residue_w_id_add(tng_data_dest, chain_temp,
-                                                  residue->name, residue->id,
-                                                  &residue_temp);
-                if(stat != TNG_SUCCESS)
-                {
-                    fprintf(stderr, "TNG library: Cannot create new residue to make a copy. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(stat);
-                }
-                for(l = 0; l < residue->n_atoms; l++)
-                {
-                    atom = &molecule->atoms[residue->atoms_offset + l];
-                    stat = tng_residue_atom_w_id_add(tng_data_dest, residue_temp,
-                                                     atom->name, atom->atom_type,
-                                                     atom->id, &atom_temp);
-                    if(stat != TNG_SUCCESS)
-                    {
-                    fprintf(stderr, "TNG library: Cannot create new atom to make a copy. %s: %d\n",
-                           __FILE__, __LINE__);
-                        return(stat);
-                    }
-                }
-            }
-        }
-        molecule_temp->n_bonds = molecule->n_bonds;
-        if(molecule->n_bonds > 0)
-        {
-            bond_temp = (tng_bond_t)realloc(molecule_temp->bonds, sizeof(struct tng_bond) *
-                                            molecule->n_bonds);
-            if(!bond_temp)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                        __FILE__, __LINE__);
-                free(molecule_temp->bonds);
-                molecule_temp->n_bonds = 0;
-                return(TNG_CRITICAL);
-            }
-            molecule_temp->bonds = bond_temp;
-            for(j = 0; j < molecule->n_bonds; j++)
-            {
-                molecule_temp->bonds[j] = molecule->bonds[j];
-            }
-        }
-        stat = tng_molecule_cnt_set(tng_data_dest, molecule_temp,
-                                    tng_data_src->molecule_cnt_list[i]);
-        if(stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot set molecule count. %s: %d.\n",
-                   __FILE__, __LINE__);
-            return(stat);
-        }
-    }
-    return(TNG_SUCCESS);
+    /* The molecules are not actually copied until one of the trajectories
+     * modifies them. */
+    return(tng_molecular_system_share(tng_data_src, tng_data_dest));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_molecule_num_chains_get
@@ -7529,31 +10310,49 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_w_id_add
                  const int64_t id,
                  tng_chain_t *chain)
 {
+    tng_molecule_t own_molecule = molecule;
     tng_chain_t new_chains;
+    int64_t old_capacity;
     tng_function_status stat = TNG_SUCCESS;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    new_chains = (tng_chain_t)realloc(molecule->chains,
-                                      sizeof(struct tng_chain) *
-                                      (molecule->n_chains + 1));
+    if(tng_molecular_system_unshare(tng_data, &own_molecule, 0, 0, 0) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+    if(own_molecule != molecule)
+    {
+        /* The molecule was in a shared molecular system, continue with the copy. */
+        return(tng_molecule_chain_w_id_add(tng_data, own_molecule, name, id, chain));
+    }
+
+    old_capacity = molecule->chains_capacity;
+    new_chains = (tng_chain_t)tng_array_grow(molecule->chains,
+                                             &molecule->chains_capacity,
+                                             molecule->n_chains + 1,
+                                             sizeof(struct tng_chain));
 
     if(!new_chains)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
-        free(molecule->chains);
-        molecule->chains = 0;
         return(TNG_CRITICAL);
     }
 
     molecule->chains = new_chains;
 
+    if(molecule->chains_capacity != old_capacity)
+    {
+        tng_molecule_residues_chain_pointers_update(tng_data, molecule);
+    }
+
     *chain = &new_chains[molecule->n_chains];
     (*chain)->name = 0;
+    (*chain)->residues = 0;
 
-    tng_chain_name_set(tng_data, *chain, name);
+    stat = tng_chain_name_set(tng_data, *chain, name);
 
     (*chain)->molecule = molecule;
     (*chain)->n_residues = 0;
@@ -7572,20 +10371,29 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_bond_add
                  const int64_t to_atom_id,
                  tng_bond_t *bond)
 {
+    tng_molecule_t own_molecule = molecule;
     tng_bond_t new_bonds;
-    (void)tng_data;
 
-    new_bonds = (tng_bond_t)realloc(molecule->bonds,
-                                    sizeof(struct tng_bond) *
-                                    (molecule->n_bonds + 1));
+    if(tng_molecular_system_unshare(tng_data, &own_molecule, 0, 0, 0) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+    if(own_molecule != molecule)
+    {
+        /* The molecule was in a shared molecular system, continue with the copy. */
+        return(tng_molecule_bond_add(tng_data, own_molecule, from_atom_id, to_atom_id, bond));
+    }
+
+    new_bonds = (tng_bond_t)tng_array_grow(molecule->bonds,
+                                           &molecule->bonds_capacity,
+                                           molecule->n_bonds + 1,
+                                           sizeof(struct tng_bond));
 
     if(!new_bonds)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
         *bond = 0;
-        free(molecule->bonds);
-        molecule->bonds = 0;
         return(TNG_CRITICAL);
     }
 
@@ -7598,6 +10406,8 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_bond_add
 
     molecule->n_bonds++;
 
+    tng_topology_index_free(tng_data);
+
     return(TNG_SUCCESS);
 }
 
@@ -7656,34 +10466,22 @@ tng_function_status DECLSPECDLLEXPORT tng_chain_name_set
                  const tng_chain_t chain,
                  const char *new_name)
 {
-    unsigned int len;
-    (void)tng_data;
+    tng_chain_t own_chain = chain;
 
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
-
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if(chain->name && strlen(chain->name) < len)
+    if(tng_molecular_system_unshare(tng_data, 0, &own_chain, 0, 0) != TNG_SUCCESS)
     {
-        free(chain->name);
-        chain->name = 0;
+        return(TNG_CRITICAL);
     }
-    if(!chain->name)
+    if(own_chain != chain)
     {
-        chain->name = (char *)malloc(len);
-        if(!chain->name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
+        /* The chain was in a shared molecular system, continue with the copy. */
+        return(tng_chain_name_set(tng_data, own_chain, new_name));
     }
 
-    strncpy(chain->name, new_name, len);
-
-    return(TNG_SUCCESS);
+    return(tng_string_pool_intern(&tng_data->name_pool, new_name, &chain->name));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_chain_num_residues_get
@@ -7782,38 +10580,57 @@ tng_function_status DECLSPECDLLEXPORT tng_chain_residue_w_id_add
                  const int64_t id,
                  tng_residue_t *residue)
 {
-    int64_t curr_index;
+    tng_chain_t own_chain = chain;
+    int64_t curr_index, old_capacity;
     tng_residue_t new_residues, temp_residue, last_residue;
     tng_molecule_t molecule = chain->molecule;
     tng_function_status stat = TNG_SUCCESS;
+    char moved;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    if(chain->n_residues)
+    if(tng_molecular_system_unshare(tng_data, 0, &own_chain, 0, 0) != TNG_SUCCESS)
     {
-        curr_index = chain->residues - molecule->residues;
+        return(TNG_CRITICAL);
     }
-    else
+    if(own_chain != chain)
     {
-        curr_index = -1;
+        /* The chain was in a shared molecular system, continue with the copy. */
+        return(tng_chain_residue_w_id_add(tng_data, own_chain, name, id, residue));
     }
 
-    new_residues = (tng_residue_t)realloc(molecule->residues,
-                                          sizeof(struct tng_residue) *
-                                          (molecule->n_residues + 1));
+    tng_topology_index_free(tng_data);
+
+    if(chain->n_residues)
+    {
+        curr_index = chain->residues - molecule->residues;
+    }
+    else
+    {
+        curr_index = -1;
+    }
+
+    old_capacity = molecule->residues_capacity;
+    new_residues = (tng_residue_t)tng_array_grow(molecule->residues,
+                                                 &molecule->residues_capacity,
+                                                 molecule->n_residues + 1,
+                                                 sizeof(struct tng_residue));
 
     if(!new_residues)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
-        free(molecule->residues);
-        molecule->residues = 0;
         return(TNG_CRITICAL);
     }
 
     molecule->residues = new_residues;
 
+    /* The pointers to the residues only need updating if the residues have
+     * been moved, which does not happen for most residues when adding them
+     * one at a time. */
+    moved = molecule->residues_capacity != old_capacity;
+
     if(curr_index != -1)
     {
         chain->residues = new_residues + curr_index;
@@ -7828,22 +10645,28 @@ tng_function_status DECLSPECDLLEXPORT tng_chain_residue_w_id_add
             {
                 ++temp_residue;
                 memmove(temp_residue + 1, temp_residue,
-                        last_residue - temp_residue);
+                        (last_residue - temp_residue + 1) * sizeof(struct tng_residue));
+                moved = TNG_TRUE;
             }
         }
     }
     else
     {
         curr_index = molecule->n_residues;
+        if(chain != &molecule->chains[molecule->n_chains - 1])
+        {
+            moved = TNG_TRUE;
+        }
+        else
+        {
+            chain->residues = new_residues + curr_index;
+        }
     }
 
     *residue = &molecule->residues[curr_index + chain->n_residues];
 
-    tng_molecule_chains_residue_pointers_update(tng_data, molecule);
-    tng_molecule_atoms_residue_pointers_update(tng_data, molecule);
-
     (*residue)->name = 0;
-    tng_residue_name_set(tng_data, *residue, name);
+    stat = tng_residue_name_set(tng_data, *residue, name);
 
     (*residue)->chain = chain;
     (*residue)->n_atoms = 0;
@@ -7854,6 +10677,12 @@ tng_function_status DECLSPECDLLEXPORT tng_chain_residue_w_id_add
 
     (*residue)->id = id;
 
+    if(moved)
+    {
+        tng_molecule_chains_residue_pointers_update(tng_data, molecule);
+        tng_molecule_atoms_residue_pointers_update(tng_data, molecule);
+    }
+
     return(stat);
 }
 
@@ -7880,35 +10709,22 @@ tng_function_status DECLSPECDLLEXPORT tng_residue_name_set(const tng_trajectory_
                                                            const tng_residue_t residue,
                                                            const char *new_name)
 {
-    unsigned int len;
-    (void)tng_data;
+    tng_residue_t own_residue = residue;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer");
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
-
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if(residue->name && strlen(residue->name) < len)
+    if(tng_molecular_system_unshare(tng_data, 0, 0, &own_residue, 0) != TNG_SUCCESS)
     {
-        free(residue->name);
-        residue->name = 0;
+        return(TNG_CRITICAL);
     }
-    if(!residue->name)
+    if(own_residue != residue)
     {
-        residue->name = (char *)malloc(len);
-        if(!residue->name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            return(TNG_CRITICAL);
-        }
+        /* The residue was in a shared molecular system, continue with the copy. */
+        return(tng_residue_name_set(tng_data, own_residue, new_name));
     }
 
-    strncpy(residue->name, new_name, len);
-
-    return(TNG_SUCCESS);
+    return(tng_string_pool_intern(&tng_data->name_pool, new_name, &residue->name));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_residue_num_atoms_get
@@ -7991,6 +10807,7 @@ tng_function_status DECLSPECDLLEXPORT tng_residue_atom_w_id_add
                  const int64_t id,
                  tng_atom_t *atom)
 {
+    tng_residue_t own_residue = residue;
     tng_atom_t new_atoms;
     tng_molecule_t molecule = residue->chain->molecule;
     tng_function_status stat = TNG_SUCCESS;
@@ -7999,21 +10816,32 @@ tng_function_status DECLSPECDLLEXPORT tng_residue_atom_w_id_add
     TNG_ASSERT(atom_name, "TNG library: atom_name must not be a NULL pointer.");
     TNG_ASSERT(atom_type, "TNG library: atom_type must not be a NULL pointer.");
 
+    if(tng_molecular_system_unshare(tng_data, 0, 0, &own_residue, 0) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+    if(own_residue != residue)
+    {
+        /* The residue was in a shared molecular system, continue with the copy. */
+        return(tng_residue_atom_w_id_add(tng_data, own_residue, atom_name, atom_type, id, atom));
+    }
+
+    tng_topology_index_free(tng_data);
+
     if(!residue->n_atoms)
     {
         residue->atoms_offset = molecule->n_atoms;
     }
 
-    new_atoms = (tng_atom_t)realloc(molecule->atoms,
-                                    sizeof(struct tng_atom) *
-                                    (molecule->n_atoms + 1));
+    new_atoms = (tng_atom_t)tng_array_grow(molecule->atoms,
+                                           &molecule->atoms_capacity,
+                                           molecule->n_atoms + 1,
+                                           sizeof(struct tng_atom));
 
     if(!new_atoms)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
-        free(molecule->atoms);
-        molecule->atoms = 0;
         return(TNG_CRITICAL);
     }
 
@@ -8022,8 +10850,11 @@ tng_function_status DECLSPECDLLEXPORT tng_residue_atom_w_id_add
     *atom = &new_atoms[molecule->n_atoms];
 
     tng_atom_init(*atom);
-    tng_atom_name_set(tng_data, *atom, atom_name);
-    tng_atom_type_set(tng_data, *atom, atom_type);
+    if(tng_atom_name_set(tng_data, *atom, atom_name) != TNG_SUCCESS ||
+       tng_atom_type_set(tng_data, *atom, atom_type) != TNG_SUCCESS)
+    {
+        stat = TNG_CRITICAL;
+    }
 
     (*atom)->residue = residue;
 
@@ -8081,6 +10912,10 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_init(const tng_trajectory_t t
     molecule->atoms = 0;
     molecule->n_bonds = 0;
     molecule->bonds = 0;
+    molecule->chains_capacity = 0;
+    molecule->residues_capacity = 0;
+    molecule->atoms_capacity = 0;
+    molecule->bonds_capacity = 0;
 
     return(TNG_SUCCESS);
 }
@@ -8088,55 +10923,35 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_init(const tng_trajectory_t t
 tng_function_status DECLSPECDLLEXPORT tng_molecule_destroy(const tng_trajectory_t tng_data,
                                                            const tng_molecule_t molecule)
 {
-    int64_t i;
     (void)tng_data;
 
-    if(molecule->name)
-    {
-        free(molecule->name);
-        molecule->name = 0;
-    }
+    /* The names are stored in the string pool of the trajectory and are
+     * freed with it. */
+    molecule->name = 0;
 
     if(molecule->chains)
     {
-        for(i = 0; i < molecule->n_chains; i++)
-        {
-            if(molecule->chains[i].name)
-            {
-                free(molecule->chains[i].name);
-                molecule->chains[i].name = 0;
-            }
-        }
         free(molecule->chains);
         molecule->chains = 0;
     }
     molecule->n_chains = 0;
+    molecule->chains_capacity = 0;
 
     if(molecule->residues)
     {
-        for(i = 0; i < molecule->n_residues; i++)
-        {
-            if(molecule->residues[i].name)
-            {
-                free(molecule->residues[i].name);
-                molecule->residues[i].name = 0;
-            }
-        }
         free(molecule->residues);
         molecule->residues = 0;
     }
     molecule->n_residues = 0;
+    molecule->residues_capacity = 0;
 
     if(molecule->atoms)
     {
-        for(i = 0; i < molecule->n_atoms; i++)
-        {
-            tng_atom_destroy(&molecule->atoms[i]);
-        }
         free(molecule->atoms);
         molecule->atoms = 0;
     }
     molecule->n_atoms = 0;
+    molecule->atoms_capacity = 0;
 
     if(molecule->bonds)
     {
@@ -8144,6 +10959,7 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_destroy(const tng_trajectory_
         molecule->bonds = 0;
     }
     molecule->n_bonds = 0;
+    molecule->bonds_capacity = 0;
 
     return(TNG_SUCCESS);
 }
@@ -8154,35 +10970,21 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_name_of_particle_nr_get
                  char *name,
                  const int max_len)
 {
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
+    int64_t mol_index, instance, atom_index;
     tng_molecule_t mol;
-    tng_bool found = TNG_FALSE;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
-
-    if(!molecule_cnt_list)
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
     {
-        return(TNG_FAILURE);
+        return(stat);
     }
 
-    for(i = 0; i < tng_data->n_molecules; i++)
-    {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        found = TNG_TRUE;
-        break;
-    }
-    if(!found)
-    {
-        return(TNG_FAILURE);
-    }
+    mol = &tng_data->molecules[mol_index];
 
     strncpy(name, mol->name, max_len - 1);
     name[max_len - 1] = 0;
@@ -8199,37 +11001,20 @@ tng_function_status DECLSPECDLLEXPORT tng_molecule_id_of_particle_nr_get
                  const int64_t nr,
                  int64_t *id)
 {
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_bool found = TNG_FALSE;
+    int64_t mol_index, instance, atom_index;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
-
-    if(!molecule_cnt_list)
-    {
-        return(TNG_FAILURE);
-    }
-
-    for(i = 0; i < tng_data->n_molecules; i++)
-    {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        found = TNG_TRUE;
-        break;
-    }
-    if(!found)
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
     {
-        return(TNG_FAILURE);
+        return(stat);
     }
 
-    *id = mol->id;
+    *id = tng_data->molecules[mol_index].id;
 
     return(TNG_SUCCESS);
 }
@@ -8309,243 +11094,438 @@ tng_function_status DECLSPECDLLEXPORT tng_molsystem_bonds_get
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_name_of_particle_nr_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t nr,
-                 char *name,
-                 const int max_len)
-{
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t atom;
-    tng_bool found = TNG_FALSE;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+/**
+ * @brief Build the connectivity of all molecules of one molecule type by
+ * repeating the bonds of one molecule.
+ * @param mol is the molecule type.
+ * @param mol_cnt is the number of molecules of this type.
+ * @param first_particle is the number of the first particle of the first
+ * molecule of this type.
+ * @param first_neighbor is the position in neighbors of the first
+ * neighbour of the first particle.
+ * @param offsets is the list of offsets of all particles.
+ * @param neighbors is the list of neighbours of all particles.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a bond refers to
+ * an atom that is not in the molecule or TNG_CRITICAL (2) if a major error
+ * has occured.
+ */
+static tng_function_status tng_molecule_connectivity_build
+                (const tng_molecule_t mol,
+                 const int64_t mol_cnt,
+                 const int64_t first_particle,
+                 const int64_t first_neighbor,
+                 int64_t *offsets,
+                 int64_t *neighbors)
+{
+    int64_t i, j, k, n_neighbors, particle, neighbor, temp;
+    int64_t *mol_offsets, *mol_neighbors, *fill;
+    tng_bond_t bond;
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    n_neighbors = 2 * mol->n_bonds;
 
-    if(!molecule_cnt_list)
+    mol_offsets = (int64_t *)malloc(sizeof(int64_t) * (mol->n_atoms + 1));
+    mol_neighbors = (int64_t *)malloc(sizeof(int64_t) * tng_max_i64(n_neighbors, 1));
+    fill = (int64_t *)calloc(tng_max_i64(mol->n_atoms, 1), sizeof(int64_t));
+    if(!mol_offsets || !mol_neighbors || !fill)
     {
-        return(TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(mol_offsets);
+        free(mol_neighbors);
+        free(fill);
+        return(TNG_CRITICAL);
     }
 
-    for(i = 0; i < tng_data->n_molecules; i++)
+    /* Count the neighbours of each atom in one molecule. */
+    for(i = 0; i < mol->n_bonds; i++)
     {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        bond = &mol->bonds[i];
+        if(bond->from_atom_id < 0 || bond->from_atom_id >= mol->n_atoms ||
+           bond->to_atom_id < 0 || bond->to_atom_id >= mol->n_atoms)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            fprintf(stderr, "TNG library: Bond between atoms %" PRId64 " and %" PRId64
+                    " is outside molecule %s. %s: %d\n", bond->from_atom_id,
+                    bond->to_atom_id, mol->name ? mol->name : "", __FILE__, __LINE__);
+            free(mol_offsets);
+            free(mol_neighbors);
+            free(fill);
+            return(TNG_FAILURE);
         }
-        atom = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        fill[bond->from_atom_id]++;
+        fill[bond->to_atom_id]++;
     }
-    if(!found)
+    mol_offsets[0] = 0;
+    for(i = 0; i < mol->n_atoms; i++)
     {
-        return(TNG_FAILURE);
+        mol_offsets[i + 1] = mol_offsets[i] + fill[i];
+        fill[i] = mol_offsets[i];
     }
-    if(!atom->residue || !atom->residue->chain)
+    for(i = 0; i < mol->n_bonds; i++)
     {
-        return(TNG_FAILURE);
+        bond = &mol->bonds[i];
+        mol_neighbors[fill[bond->from_atom_id]++] = bond->to_atom_id;
+        mol_neighbors[fill[bond->to_atom_id]++] = bond->from_atom_id;
+    }
+    /* Sort the neighbours of each atom. Atoms only have a few bonds. */
+    for(i = 0; i < mol->n_atoms; i++)
+    {
+        for(j = mol_offsets[i] + 1; j < mol_offsets[i + 1]; j++)
+        {
+            temp = mol_neighbors[j];
+            for(k = j; k > mol_offsets[i] && mol_neighbors[k - 1] > temp; k--)
+            {
+                mol_neighbors[k] = mol_neighbors[k - 1];
+            }
+            mol_neighbors[k] = temp;
+        }
     }
 
-    strncpy(name, atom->residue->chain->name, max_len - 1);
-    name[max_len - 1] = 0;
-
-    if(strlen(atom->residue->chain->name) > (unsigned int)max_len - 1)
+    /* All molecules of the type have the same bonds. */
+    particle = first_particle;
+    neighbor = first_neighbor;
+    for(i = 0; i < mol_cnt; i++)
     {
-        return(TNG_FAILURE);
+        for(j = 0; j < mol->n_atoms; j++)
+        {
+            offsets[particle + j] = neighbor + mol_offsets[j];
+        }
+        for(j = 0; j < n_neighbors; j++)
+        {
+            neighbors[neighbor + j] = particle + mol_neighbors[j];
+        }
+        particle += mol->n_atoms;
+        neighbor += n_neighbors;
     }
+
+    free(mol_offsets);
+    free(mol_neighbors);
+    free(fill);
+
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_name_of_particle_nr_get
+tng_function_status DECLSPECDLLEXPORT tng_molsystem_connectivity_get
                 (const tng_trajectory_t tng_data,
-                 const int64_t nr,
-                 char *name,
-                 const int max_len)
+                 int64_t *n_particles,
+                 const int64_t **offsets,
+                 const int64_t **neighbors)
 {
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t atom;
-    tng_bool found = TNG_FALSE;
+    int64_t i, n_neighbors, *molecule_cnt_list, *neighbor_offsets;
+    int64_t *new_offsets, *new_neighbors;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
-
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(offsets, "TNG library: offsets must not be a NULL pointer.");
+    TNG_ASSERT(neighbors, "TNG library: neighbors must not be a NULL pointer.");
 
-    if(!molecule_cnt_list)
+    stat = tng_topology_index_get(tng_data, &molecule_cnt_list);
+    if(stat != TNG_SUCCESS)
     {
-        return(TNG_FAILURE);
+        return(stat);
     }
 
-    for(i = 0; i < tng_data->n_molecules; i++)
+    *n_particles = tng_data->topology_particle_offsets[tng_data->n_molecules];
+
+    if(!tng_data->connectivity_offsets)
     {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        /* The position of the first neighbour of each molecule type. */
+        neighbor_offsets = (int64_t *)malloc(sizeof(int64_t) * (tng_data->n_molecules + 1));
+        if(!neighbor_offsets)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
         }
-        atom = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
-    }
-    if(!found)
-    {
-        return(TNG_FAILURE);
-    }
-    if(!atom->residue)
-    {
-        return(TNG_FAILURE);
-    }
+        neighbor_offsets[0] = 0;
+        for(i = 0; i < tng_data->n_molecules; i++)
+        {
+            neighbor_offsets[i + 1] = neighbor_offsets[i] + 2 *
+                                      tng_data->molecules[i].n_bonds *
+                                      molecule_cnt_list[i];
+        }
+        n_neighbors = neighbor_offsets[tng_data->n_molecules];
 
-    strncpy(name, atom->residue->name, max_len - 1);
-    name[max_len - 1] = 0;
+        new_offsets = (int64_t *)malloc(sizeof(int64_t) * (*n_particles + 1));
+        new_neighbors = (int64_t *)malloc(sizeof(int64_t) * tng_max_i64(n_neighbors, 1));
+        if(!new_offsets || !new_neighbors)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(neighbor_offsets);
+            free(new_offsets);
+            free(new_neighbors);
+            return(TNG_CRITICAL);
+        }
 
-    if(strlen(atom->residue->name) > (unsigned int)max_len - 1)
-    {
-        return(TNG_FAILURE);
+        /* The molecule types fill separate parts of the lists, so they can
+         * be processed concurrently. */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(i = 0; i < tng_data->n_molecules; i++)
+        {
+            tng_function_status mol_stat;
+
+            mol_stat = tng_molecule_connectivity_build(&tng_data->molecules[i],
+                                                       molecule_cnt_list[i],
+                                                       tng_data->topology_particle_offsets[i],
+                                                       neighbor_offsets[i],
+                                                       new_offsets, new_neighbors);
+            if(mol_stat != TNG_SUCCESS)
+            {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+                {
+                    if(mol_stat > stat)
+                    {
+                        stat = mol_stat;
+                    }
+                }
+            }
+        }
+        new_offsets[*n_particles] = n_neighbors;
+        free(neighbor_offsets);
+
+        if(stat != TNG_SUCCESS)
+        {
+            free(new_offsets);
+            free(new_neighbors);
+            return(stat);
+        }
+
+        tng_data->connectivity_offsets = new_offsets;
+        tng_data->connectivity_neighbors = new_neighbors;
     }
+
+    *offsets = tng_data->connectivity_offsets;
+    *neighbors = tng_data->connectivity_neighbors;
+
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_id_of_particle_nr_get
+tng_function_status DECLSPECDLLEXPORT tng_molsystem_connectivity_int32_get
                 (const tng_trajectory_t tng_data,
-                 const int64_t nr,
-                 int64_t *id)
+                 int64_t *n_particles,
+                 const int32_t **offsets,
+                 const int32_t **neighbors)
 {
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t atom;
-    tng_bool found = TNG_FALSE;
+    const int64_t *offsets_64, *neighbors_64;
+    int64_t i, n_neighbors;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
-
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(offsets, "TNG library: offsets must not be a NULL pointer.");
+    TNG_ASSERT(neighbors, "TNG library: neighbors must not be a NULL pointer.");
 
-    if(!molecule_cnt_list)
+    stat = tng_molsystem_connectivity_get(tng_data, n_particles, &offsets_64,
+                                          &neighbors_64);
+    if(stat != TNG_SUCCESS)
     {
-        return(TNG_FAILURE);
+        return(stat);
     }
 
-    for(i = 0; i < tng_data->n_molecules; i++)
+    if(!tng_data->connectivity_offsets_32)
     {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        n_neighbors = offsets_64[*n_particles];
+        if(*n_particles > INT32_MAX || n_neighbors > INT32_MAX)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            fprintf(stderr, "TNG library: The connectivity is too large for 32 bit integers. "
+                    "%s: %d\n", __FILE__, __LINE__);
+            return(TNG_FAILURE);
+        }
+
+        tng_data->connectivity_offsets_32 = (int32_t *)malloc(sizeof(int32_t) *
+                                                              (*n_particles + 1));
+        tng_data->connectivity_neighbors_32 = (int32_t *)malloc(sizeof(int32_t) *
+                                                                tng_max_i64(n_neighbors, 1));
+        if(!tng_data->connectivity_offsets_32 || !tng_data->connectivity_neighbors_32)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(tng_data->connectivity_offsets_32);
+            free(tng_data->connectivity_neighbors_32);
+            tng_data->connectivity_offsets_32 = 0;
+            tng_data->connectivity_neighbors_32 = 0;
+            return(TNG_CRITICAL);
+        }
+        for(i = 0; i <= *n_particles; i++)
+        {
+            tng_data->connectivity_offsets_32[i] = (int32_t)offsets_64[i];
+        }
+        for(i = 0; i < n_neighbors; i++)
+        {
+            tng_data->connectivity_neighbors_32[i] = (int32_t)neighbors_64[i];
         }
-        atom = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
-    }
-    if(!found)
-    {
-        return(TNG_FAILURE);
-    }
-    if(!atom->residue)
-    {
-        return(TNG_FAILURE);
     }
 
-    *id = atom->residue->id;
+    *offsets = tng_data->connectivity_offsets_32;
+    *neighbors = tng_data->connectivity_neighbors_32;
 
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_global_residue_id_of_particle_nr_get
+tng_function_status DECLSPECDLLEXPORT tng_chain_name_of_particle_nr_get
                 (const tng_trajectory_t tng_data,
                  const int64_t nr,
-                 int64_t *id)
+                 char *name,
+                 const int max_len)
 {
-    int64_t cnt = 0, i, offset = 0, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
+    int64_t mol_index, instance, atom_index;
     tng_atom_t atom;
-    tng_bool found = TNG_FALSE;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
 
-    if(!molecule_cnt_list)
+    atom = &tng_data->molecules[mol_index].atoms[atom_index];
+
+    if(!atom->residue || !atom->residue->chain)
     {
         return(TNG_FAILURE);
     }
 
-    for(i = 0; i < tng_data->n_molecules; i++)
+    strncpy(name, atom->residue->chain->name, max_len - 1);
+    name[max_len - 1] = 0;
+
+    if(strlen(atom->residue->chain->name) > (unsigned int)max_len - 1)
     {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            offset += mol->n_residues * molecule_cnt_list[i];
-            continue;
-        }
-        atom = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        return(TNG_FAILURE);
     }
-    if(!found)
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_residue_name_of_particle_nr_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t nr,
+                 char *name,
+                 const int max_len)
+{
+    int64_t mol_index, instance, atom_index;
+    tng_atom_t atom;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
     {
-        return(TNG_FAILURE);
+        return(stat);
     }
+
+    atom = &tng_data->molecules[mol_index].atoms[atom_index];
+
     if(!atom->residue)
     {
         return(TNG_FAILURE);
     }
 
-    offset += mol->n_residues * ((nr - cnt) / mol->n_atoms);
-
-    *id = atom->residue->id + offset;
+    strncpy(name, atom->residue->name, max_len - 1);
+    name[max_len - 1] = 0;
 
+    if(strlen(atom->residue->name) > (unsigned int)max_len - 1)
+    {
+        return(TNG_FAILURE);
+    }
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_name_of_particle_nr_get
+tng_function_status DECLSPECDLLEXPORT tng_residue_id_of_particle_nr_get
                 (const tng_trajectory_t tng_data,
                  const int64_t nr,
-                 char *name,
-                 const int max_len)
+                 int64_t *id)
 {
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
+    int64_t mol_index, instance, atom_index;
     tng_atom_t atom;
-    tng_bool found = TNG_FALSE;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
 
-    if(!molecule_cnt_list)
+    atom = &tng_data->molecules[mol_index].atoms[atom_index];
+    if(!atom->residue)
     {
         return(TNG_FAILURE);
     }
 
-    for(i = 0; i < tng_data->n_molecules; i++)
+    *id = atom->residue->id;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_global_residue_id_of_particle_nr_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t nr,
+                 int64_t *id)
+{
+    int64_t mol_index, instance, atom_index;
+    tng_molecule_t mol;
+    tng_atom_t atom;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
+
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
     {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        atom = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        return(stat);
     }
-    if(!found)
+
+    mol = &tng_data->molecules[mol_index];
+    atom = &mol->atoms[atom_index];
+    if(!atom->residue)
     {
         return(TNG_FAILURE);
     }
 
+    *id = atom->residue->id + tng_data->topology_residue_offsets[mol_index] +
+          mol->n_residues * instance;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_atom_name_of_particle_nr_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t nr,
+                 char *name,
+                 const int max_len)
+{
+    int64_t mol_index, instance, atom_index;
+    tng_atom_t atom;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    atom = &tng_data->molecules[mol_index].atoms[atom_index];
+
     strncpy(name, atom->name, max_len - 1);
     name[max_len - 1] = 0;
 
@@ -8562,48 +11542,235 @@ tng_function_status tng_atom_type_of_particle_nr_get
                  char *type,
                  const int max_len)
 {
-    int64_t cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
+    int64_t mol_index, instance, atom_index;
     tng_atom_t atom;
-    tng_bool found = TNG_FALSE;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    stat = tng_particle_topology_find(tng_data, nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
 
-    if(!molecule_cnt_list)
+    atom = &tng_data->molecules[mol_index].atoms[atom_index];
+
+    strncpy(type, atom->atom_type, max_len - 1);
+    type[max_len - 1] = 0;
+
+    if(strlen(atom->atom_type) > (unsigned int)max_len - 1)
     {
         return(TNG_FAILURE);
     }
+    return(TNG_SUCCESS);
+}
 
-    for(i = 0; i < tng_data->n_molecules; i++)
+/** The kinds of topology information that can be retrieved for a range of
+ *  particles by tng_particle_range_topology_get(). */
+enum tng_topology_query {TNG_QUERY_MOLECULE_ID,
+                         TNG_QUERY_GLOBAL_RESIDUE_ID,
+                         TNG_QUERY_MOLECULE_NAME,
+                         TNG_QUERY_CHAIN_NAME,
+                         TNG_QUERY_RESIDUE_NAME,
+                         TNG_QUERY_ATOM_NAME,
+                         TNG_QUERY_ATOM_TYPE};
+
+/**
+ * @brief Get topology information of a range of particles. The particles are
+ * traversed in order, so the molecule of each particle does not have to be
+ * looked up separately.
+ * @param tng_data is a trajectory data container.
+ * @param first_nr is the index of the first particle.
+ * @param n_particles is the number of particles.
+ * @param query specifies what information to retrieve.
+ * @param ids is filled with the retrieved ids, if query is an id query.
+ * @param names is filled with pointers to the retrieved names, if query is a
+ * name query.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the particles
+ * cannot be found or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_particle_range_topology_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const enum tng_topology_query query,
+                 int64_t *ids,
+                 const char **names)
+{
+    int64_t i, mol_index, instance, atom_index, residue_offset;
+    int64_t *molecule_cnt_list, *offsets;
+    tng_molecule_t mol;
+    tng_atom_t atom;
+    tng_function_status stat;
+
+    if(n_particles <= 0)
     {
-        mol = &tng_data->molecules[i];
-        if(cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        atom = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        return(TNG_SUCCESS);
     }
-    if(!found)
+
+    stat = tng_particle_topology_find(tng_data, first_nr, &mol_index, &instance,
+                                      &atom_index);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_topology_index_get(tng_data, &molecule_cnt_list);
+    offsets = tng_data->topology_particle_offsets;
+
+    if(first_nr + n_particles > offsets[tng_data->n_molecules])
     {
         return(TNG_FAILURE);
     }
 
-    strncpy(type, atom->atom_type, max_len - 1);
-    type[max_len - 1] = 0;
+    mol = &tng_data->molecules[mol_index];
+    residue_offset = tng_data->topology_residue_offsets[mol_index] +
+                     mol->n_residues * instance;
 
-    if(strlen(atom->atom_type) > (unsigned int)max_len - 1)
+    for(i = 0; i < n_particles; i++)
     {
-        return(TNG_FAILURE);
+        atom = &mol->atoms[atom_index];
+        switch(query)
+        {
+        case TNG_QUERY_MOLECULE_ID:
+            ids[i] = mol->id;
+            break;
+        case TNG_QUERY_GLOBAL_RESIDUE_ID:
+            ids[i] = atom->residue ? atom->residue->id + residue_offset : -1;
+            break;
+        case TNG_QUERY_MOLECULE_NAME:
+            names[i] = mol->name;
+            break;
+        case TNG_QUERY_CHAIN_NAME:
+            names[i] = atom->residue && atom->residue->chain ?
+                       atom->residue->chain->name : 0;
+            break;
+        case TNG_QUERY_RESIDUE_NAME:
+            names[i] = atom->residue ? atom->residue->name : 0;
+            break;
+        case TNG_QUERY_ATOM_NAME:
+            names[i] = atom->name;
+            break;
+        case TNG_QUERY_ATOM_TYPE:
+        default:
+            names[i] = atom->atom_type;
+        }
+
+        /* Move on to the next molecule, and to the next molecule type
+         * with particles when all molecules of this type are done. */
+        if(++atom_index == mol->n_atoms)
+        {
+            atom_index = 0;
+            residue_offset += mol->n_residues;
+            if(++instance == molecule_cnt_list[mol_index] && i + 1 < n_particles)
+            {
+                instance = 0;
+                do
+                {
+                    mol_index++;
+                } while(offsets[mol_index + 1] == offsets[mol_index]);
+                mol = &tng_data->molecules[mol_index];
+                residue_offset = tng_data->topology_residue_offsets[mol_index];
+            }
+        }
     }
+
     return(TNG_SUCCESS);
 }
 
+tng_function_status DECLSPECDLLEXPORT tng_molecule_ids_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 int64_t *ids)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(ids, "TNG library: ids must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_MOLECULE_ID, ids, 0));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_global_residue_ids_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 int64_t *ids)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(ids, "TNG library: ids must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_GLOBAL_RESIDUE_ID, ids, 0));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_molecule_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(names, "TNG library: names must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_MOLECULE_NAME, 0, names));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_chain_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(names, "TNG library: names must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_CHAIN_NAME, 0, names));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_residue_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(names, "TNG library: names must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_RESIDUE_NAME, 0, names));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_atom_names_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **names)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(names, "TNG library: names must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_ATOM_NAME, 0, names));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_atom_types_of_particles_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_nr,
+                 const int64_t n_particles,
+                 const char **types)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(types, "TNG library: types must not be a NULL pointer.");
+
+    return(tng_particle_range_topology_get(tng_data, first_nr, n_particles,
+                                           TNG_QUERY_ATOM_TYPE, 0, types));
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_add
                 (const tng_trajectory_t tng_data,
                  const int64_t num_first_particle,
@@ -8655,6 +11822,8 @@ tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_add
         }
     }
 
+    tng_particle_mapping_table_free(frame_set);
+
     frame_set->n_mapping_blocks++;
 
     mapping = (tng_particle_mapping_t)realloc(frame_set->mappings, sizeof(struct tng_particle_mapping) *
@@ -8699,6 +11868,8 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_particle_mapping_free(const
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
+    tng_particle_mapping_table_free(frame_set);
+
     if(frame_set->n_mapping_blocks && frame_set->mappings)
     {
         for(i = 0; i < frame_set->n_mapping_blocks; i++)
@@ -8718,35 +11889,421 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_particle_mapping_free(const
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_trajectory_init(tng_trajectory_t *tng_data_p)
+/**
+ * @brief Read the first frame and the number of frames of a frame set in
+ * the input file.
+ * @param tng_data is a trajectory data container.
+ * @param file_pos is the position of the frame set in the input file.
+ * @param first_frame is set to the first frame of the frame set.
+ * @param n_frames is set to the number of frames in the frame set.
+ * @details The position of the input file is not changed.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if there is no
+ * frame set at file_pos or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_frame_range_read
+                (const tng_trajectory_t tng_data,
+                 const int64_t file_pos,
+                 int64_t *first_frame,
+                 int64_t *n_frames)
 {
-    time_t seconds;
-    tng_trajectory_frame_set_t frame_set;
-    tng_trajectory_t tng_data;
+    tng_gen_block_t block;
+    tng_function_status stat;
+    int64_t orig_file_pos;
 
-    *tng_data_p = (tng_trajectory_t)malloc(sizeof(struct tng_trajectory));
-    if(!*tng_data_p)
+    if(file_pos <= 0)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        return(TNG_CRITICAL);
+        return(TNG_FAILURE);
     }
 
-    tng_data = *tng_data_p;
-
-    frame_set = &tng_data->current_trajectory_frame_set;
-
-    tng_data->input_file_path = 0;
-    tng_data->input_file = 0;
-    tng_data->input_file_len = 0;
-    tng_data->output_file_path = 0;
-    tng_data->output_file = 0;
+    orig_file_pos = ftello(tng_data->input_file);
 
-    tng_data->first_program_name = 0;
-    tng_data->first_user_name = 0;
-    tng_data->first_computer_name = 0;
-    tng_data->first_pgp_signature = 0;
-    tng_data->last_program_name = 0;
+    tng_block_init(&block);
+    tng_fseeko(tng_data, tng_data->input_file,
+               file_pos,
+               SEEK_SET);
+    /* Read block headers first to see that a frame set block is found. */
+    stat = tng_block_header_read(tng_data, block);
+    if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", file_pos,
+                __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return(TNG_FAILURE);
+    }
+    tng_block_destroy(&block);
+
+    if(tng_file_input_numerical(tng_data, first_frame,
+                                sizeof(*first_frame),
+                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    if(tng_file_input_numerical(tng_data, n_frames,
+                                sizeof(*n_frames),
+                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    tng_fseeko(tng_data, tng_data->input_file, orig_file_pos, SEEK_SET);
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Close the files of a trajectory split into several input files
+ * and free the memory of their list.
+ * @param tng_data is a trajectory data container.
+ * @details If the input file of the trajectory is one of them it is closed
+ * as well.
+ */
+static void tng_input_segments_free(const tng_trajectory_t tng_data)
+{
+    int64_t i;
+    struct tng_input_segment *segment;
+
+    for(i = 0; i < tng_data->n_input_segments; i++)
+    {
+        segment = &tng_data->input_segments[i];
+        if(segment->file)
+        {
+            if(segment->file == tng_data->input_file)
+            {
+                tng_data->input_file = 0;
+            }
+            fclose(segment->file);
+        }
+        free(segment->path);
+    }
+    free(tng_data->input_segments);
+    tng_data->input_segments = 0;
+    tng_data->n_input_segments = 0;
+    tng_data->n_open_input_segments = 0;
+    tng_data->current_input_segment = -1;
+}
+
+/**
+ * @brief Copy the list of files of a trajectory split into several input
+ * files, without opening them.
+ * @param src is the trajectory with the list of files.
+ * @param dest is the trajectory to copy the list to. It must not have a list
+ * of files already.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_input_segments_copy(const tng_trajectory_t src,
+                                                   const tng_trajectory_t dest)
+{
+    struct tng_input_segment *segments;
+    int64_t i;
+
+    segments = (struct tng_input_segment *)calloc(src->n_input_segments,
+                                                  sizeof(struct tng_input_segment));
+    if(!segments)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    for(i = 0; i < src->n_input_segments; i++)
+    {
+        segments[i] = src->input_segments[i];
+        segments[i].file = 0;
+        segments[i].last_used = 0;
+        segments[i].path = (char *)malloc(strlen(src->input_segments[i].path) + 1);
+        if(!segments[i].path)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            while(i-- > 0)
+            {
+                free(segments[i].path);
+            }
+            free(segments);
+            return(TNG_CRITICAL);
+        }
+        strcpy(segments[i].path, src->input_segments[i].path);
+    }
+
+    dest->input_segments = segments;
+    dest->n_input_segments = src->n_input_segments;
+    dest->max_open_input_segments = src->max_open_input_segments;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Read what is needed for finding the frames of one of the files of a
+ * trajectory split into several input files.
+ * @param file_name is the name of the file.
+ * @param segment is the entry of the file in the list of files. Its file is
+ * not kept open.
+ * @details Only the general info block and the first and last frame set
+ * blocks are read, not the molecular system.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the file
+ * contains no frame sets or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_input_segment_index_read
+                (const char *file_name,
+                 struct tng_input_segment *segment)
+{
+    tng_trajectory_t tng_data;
+    tng_gen_block_t block;
+    int64_t first_frame, n_frames;
+    tng_function_status stat;
+
+    if(tng_trajectory_init(&tng_data) != TNG_SUCCESS)
+    {
+        tng_trajectory_destroy(&tng_data);
+        return(TNG_CRITICAL);
+    }
+
+    stat = tng_input_file_set(tng_data, file_name);
+    if(stat != TNG_SUCCESS)
+    {
+        tng_trajectory_destroy(&tng_data);
+        return(stat);
+    }
+
+    tng_block_init(&block);
+    tng_fseeko(tng_data, tng_data->input_file, 0, SEEK_SET);
+    stat = tng_block_header_read(tng_data, block);
+    if(stat != TNG_SUCCESS || block->id != TNG_GENERAL_INFO)
+    {
+        fprintf(stderr, "TNG library: Cannot read general info block of %s. %s: %d\n",
+                file_name, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        tng_trajectory_destroy(&tng_data);
+        return(TNG_CRITICAL);
+    }
+    stat = tng_general_info_block_read(tng_data, block, TNG_SKIP_HASH);
+    tng_block_destroy(&block);
+    if(stat != TNG_SUCCESS)
+    {
+        tng_trajectory_destroy(&tng_data);
+        return(stat);
+    }
+
+    stat = tng_frame_set_frame_range_read(tng_data,
+                                          tng_data->first_trajectory_frame_set_input_file_pos,
+                                          &segment->first_frame, &n_frames);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_frame_range_read(tng_data,
+                                              tng_data->last_trajectory_frame_set_input_file_pos,
+                                              &first_frame, &n_frames);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        segment->n_frames = first_frame + n_frames - segment->first_frame;
+        stat = tng_num_frame_sets_get(tng_data, &segment->n_frame_sets);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot find the frames of %s. %s: %d\n",
+                file_name, __FILE__, __LINE__);
+        tng_trajectory_destroy(&tng_data);
+        return(stat);
+    }
+
+    segment->path = (char *)malloc(strlen(file_name) + 1);
+    if(!segment->path)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_trajectory_destroy(&tng_data);
+        return(TNG_CRITICAL);
+    }
+    strcpy(segment->path, file_name);
+    segment->file = 0;
+    segment->file_len = tng_data->input_file_len;
+    segment->first_frame_set_pos = tng_data->first_trajectory_frame_set_input_file_pos;
+    segment->last_frame_set_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+    segment->frame_set_n_frames = tng_data->frame_set_n_frames;
+    segment->medium_stride_length = tng_data->medium_stride_length;
+    segment->long_stride_length = tng_data->long_stride_length;
+    segment->endianness_swap_func_32 = tng_data->input_endianness_swap_func_32;
+    segment->endianness_swap_func_64 = tng_data->input_endianness_swap_func_64;
+    segment->last_used = 0;
+
+    tng_trajectory_destroy(&tng_data);
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Make one of the files of a trajectory split into several input
+ * files the input file of the trajectory.
+ * @param tng_data is a trajectory data container.
+ * @param segment_nr is the index of the file in the list of files.
+ * @details The file is opened if it is not open already. If as many files as
+ * allowed are open the least recently used one is closed first. Unless the
+ * file already is the input file no frame set is read from it afterwards.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if the file
+ * cannot be opened.
+ */
+static tng_function_status tng_input_segment_activate
+                (const tng_trajectory_t tng_data,
+                 const int64_t segment_nr)
+{
+    struct tng_input_segment *segment = &tng_data->input_segments[segment_nr];
+    int64_t i, lru = -1;
+    char *temp;
+
+    segment->last_used = ++tng_data->input_segment_use_count;
+
+    if(segment_nr == tng_data->current_input_segment && segment->file)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    if(!segment->file)
+    {
+        if(tng_data->n_open_input_segments >= tng_data->max_open_input_segments)
+        {
+            for(i = 0; i < tng_data->n_input_segments; i++)
+            {
+                if(i != segment_nr && tng_data->input_segments[i].file &&
+                   (lru < 0 ||
+                    tng_data->input_segments[i].last_used < tng_data->input_segments[lru].last_used))
+                {
+                    lru = i;
+                }
+            }
+            if(lru >= 0)
+            {
+                if(tng_data->input_segments[lru].file == tng_data->input_file)
+                {
+                    tng_data->input_file = 0;
+                }
+                fclose(tng_data->input_segments[lru].file);
+                tng_data->input_segments[lru].file = 0;
+                tng_data->n_open_input_segments--;
+            }
+        }
+        segment->file = fopen(segment->path, "rb");
+        if(!segment->file)
+        {
+            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
+                    segment->path, __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+        tng_data->n_open_input_segments++;
+    }
+
+    temp = (char *)realloc(tng_data->input_file_path, strlen(segment->path) + 1);
+    if(!temp)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    tng_data->input_file_path = temp;
+    strcpy(tng_data->input_file_path, segment->path);
+
+    tng_data->input_file = segment->file;
+    tng_data->input_file_len = segment->file_len;
+    tng_data->first_trajectory_frame_set_input_file_pos = segment->first_frame_set_pos;
+    tng_data->last_trajectory_frame_set_input_file_pos = segment->last_frame_set_pos;
+    tng_data->frame_set_n_frames = segment->frame_set_n_frames;
+    tng_data->medium_stride_length = segment->medium_stride_length;
+    tng_data->long_stride_length = segment->long_stride_length;
+    tng_data->input_endianness_swap_func_32 = segment->endianness_swap_func_32;
+    tng_data->input_endianness_swap_func_64 = segment->endianness_swap_func_64;
+
+    if(segment_nr != tng_data->current_input_segment)
+    {
+        /* The frame set positions of the previous file are not valid in
+         * this file. */
+        tng_data->current_trajectory_frame_set_input_file_pos = -1;
+        tng_data->current_trajectory_frame_set.next_frame_set_file_pos = -1;
+        tng_data->current_input_segment = segment_nr;
+    }
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Make the file containing a frame the input file of a trajectory
+ * split into several input files.
+ * @param tng_data is a trajectory data container.
+ * @param frame is the frame number.
+ * @details If the frame is between the frames of two files the later file
+ * is used.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if the file
+ * cannot be opened.
+ */
+static tng_function_status tng_input_segment_of_frame_activate
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame)
+{
+    struct tng_input_segment *segments = tng_data->input_segments;
+    int64_t low = 0, high = tng_data->n_input_segments - 1, mid;
+
+    /* Find the last file starting at or before the frame. */
+    while(low < high)
+    {
+        mid = (low + high + 1) / 2;
+        if(segments[mid].first_frame <= frame)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    if(frame >= segments[low].first_frame + segments[low].n_frames &&
+       low + 1 < tng_data->n_input_segments)
+    {
+        low++;
+    }
+
+    return(tng_input_segment_activate(tng_data, low));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_trajectory_init(tng_trajectory_t *tng_data_p)
+{
+    time_t seconds;
+    tng_trajectory_frame_set_t frame_set;
+    tng_trajectory_t tng_data;
+
+    *tng_data_p = (tng_trajectory_t)malloc(sizeof(struct tng_trajectory));
+    if(!*tng_data_p)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    tng_data = *tng_data_p;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    tng_data->input_file_path = 0;
+    tng_data->input_file = 0;
+    tng_data->input_file_len = 0;
+    tng_data->input_header_buffer = 0;
+    tng_data->input_header_buffer_size = 0;
+    tng_data->compress_scratch = 0;
+    tng_data->uncompress_buffer = 0;
+    tng_data->uncompress_buffer_size = 0;
+    tng_data->input_segments = 0;
+    tng_data->n_input_segments = 0;
+    tng_data->current_input_segment = -1;
+    tng_data->n_open_input_segments = 0;
+    tng_data->max_open_input_segments = 0;
+    tng_data->input_segment_use_count = 0;
+    tng_data->output_file_path = 0;
+    tng_data->output_file = 0;
+
+    tng_data->first_program_name = 0;
+    tng_data->first_user_name = 0;
+    tng_data->first_computer_name = 0;
+    tng_data->first_pgp_signature = 0;
+    tng_data->last_program_name = 0;
     tng_data->last_user_name = 0;
     tng_data->last_computer_name = 0;
     tng_data->last_pgp_signature = 0;
@@ -8785,11 +12342,25 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init(tng_trajectory_t *tng_
     tng_data->compress_algo_pos = 0;
     tng_data->compress_algo_vel = 0;
     tng_data->compression_precision = 1000;
+    tng_data->compression_keyframe_interval = 0;
+    tng_data->compression_algo_sample_n_particles = 0;
+    tng_data->compress_algo_store = TNG_FALSE;
+    tng_data->compress_algo_block_output_file_pos = -1;
+
+    tng_data->statistics_enabled = TNG_FALSE;
+    memset(&tng_data->statistics, 0, sizeof(tng_data->statistics));
+    tng_data->thread_statistics = 0;
+    tng_data->n_thread_statistics = 0;
+    tng_data->thread_statistics_active = TNG_FALSE;
+    tng_data->statistics_start_ticks = 0;
+    tng_data->statistics_start_time = 0;
     tng_data->distance_unit_exponential = -9;
 
     frame_set->first_frame = -1;
     frame_set->n_mapping_blocks = 0;
     frame_set->mappings = 0;
+    frame_set->mapping_table = 0;
+    frame_set->mapping_table_n_particles = 0;
     frame_set->molecule_cnt_list = 0;
 
     frame_set->n_particle_data_blocks = 0;
@@ -8813,6 +12384,19 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init(tng_trajectory_t *tng_
     tng_data->n_molecules = 0;
     tng_data->molecules = 0;
     tng_data->molecule_cnt_list = 0;
+    tng_data->molecules_capacity = 0;
+    tng_data->name_pool = 0;
+    tng_data->molecules_ref_count = 0;
+    tng_data->detached_molecules = 0;
+    tng_data->n_detached_molecules = 0;
+    tng_data->detached_name_pool = 0;
+    tng_data->detached_molecules_ref_count = 0;
+    tng_data->topology_particle_offsets = 0;
+    tng_data->topology_residue_offsets = 0;
+    tng_data->connectivity_offsets = 0;
+    tng_data->connectivity_neighbors = 0;
+    tng_data->connectivity_offsets_32 = 0;
+    tng_data->connectivity_neighbors_32 = 0;
     tng_data->n_particles = 0;
 
     {
@@ -8900,6 +12484,14 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t *t
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
+    tng_input_segments_free(tng_data);
+
+    if(tng_data->thread_statistics)
+    {
+        free(tng_data->thread_statistics);
+        tng_data->thread_statistics = 0;
+    }
+
     if(tng_data->input_file)
     {
         if(tng_data->output_file == tng_data->input_file)
@@ -8925,6 +12517,21 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t *t
         tng_data->output_file = 0;
     }
 
+    if(tng_data->input_header_buffer)
+    {
+        free(tng_data->input_header_buffer);
+        tng_data->input_header_buffer = 0;
+    }
+
+    tng_compress_scratch_deinit(tng_data->compress_scratch);
+    tng_data->compress_scratch = 0;
+
+    if(tng_data->uncompress_buffer)
+    {
+        free(tng_data->uncompress_buffer);
+        tng_data->uncompress_buffer = 0;
+    }
+
     if(tng_data->output_file_path)
     {
         free(tng_data->output_file_path);
@@ -9217,16 +12824,7 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t *t
     frame_set->n_particle_data_blocks = 0;
     frame_set->n_data_blocks = 0;
 
-    if(tng_data->molecules)
-    {
-        for(i = 0; i < tng_data->n_molecules; i++)
-        {
-            tng_molecule_destroy(tng_data, &tng_data->molecules[i]);
-        }
-        free(tng_data->molecules);
-        tng_data->molecules = 0;
-        tng_data->n_molecules = 0;
-    }
+    tng_molecular_system_release(tng_data);
     if(tng_data->molecule_cnt_list)
     {
         free(tng_data->molecule_cnt_list);
@@ -9277,6 +12875,22 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src
         dest->input_file_path = 0;
     }
     dest->input_file = 0;
+    dest->input_header_buffer = 0;
+    dest->input_header_buffer_size = 0;
+    dest->compress_scratch = 0;
+    dest->uncompress_buffer = 0;
+    dest->uncompress_buffer_size = 0;
+    dest->input_segments = 0;
+    dest->n_input_segments = 0;
+    dest->current_input_segment = -1;
+    dest->n_open_input_segments = 0;
+    dest->max_open_input_segments = 0;
+    dest->input_segment_use_count = 0;
+    if(src->n_input_segments > 0 &&
+       tng_input_segments_copy(src, dest) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
     if(src->output_file_path)
     {
         dest->output_file_path = (char *)malloc(strlen(src->output_file_path) + 1);
@@ -9335,9 +12949,39 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src
     dest->compress_algo_vel = 0;
     dest->distance_unit_exponential = -9;
     dest->compression_precision = 1000;
+    dest->compression_keyframe_interval = src->compression_keyframe_interval;
+    dest->compression_algo_sample_n_particles = src->compression_algo_sample_n_particles;
+    dest->compress_algo_store = src->compress_algo_store;
+    dest->compress_algo_block_output_file_pos = -1;
+
+    dest->thread_statistics = 0;
+    dest->n_thread_statistics = 0;
+    dest->thread_statistics_active = TNG_FALSE;
+    if(src->statistics_enabled)
+    {
+        tng_statistics_enabled_set(dest, TNG_TRUE);
+    }
+    else
+    {
+        dest->statistics_enabled = TNG_FALSE;
+        memset(&dest->statistics, 0, sizeof(dest->statistics));
+        dest->statistics_start_ticks = 0;
+        dest->statistics_start_time = 0;
+    }
+
+    /* Reuse the compression algorithms already determined for the source. */
+    if(tng_compression_algorithm_set(dest, TNG_TRAJ_POSITIONS,
+                                     src->compress_algo_pos) != TNG_SUCCESS ||
+       tng_compression_algorithm_set(dest, TNG_TRAJ_VELOCITIES,
+                                     src->compress_algo_vel) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
 
     frame_set->n_mapping_blocks = 0;
     frame_set->mappings = 0;
+    frame_set->mapping_table = 0;
+    frame_set->mapping_table_n_particles = 0;
     frame_set->molecule_cnt_list = 0;
 
     frame_set->n_particle_data_blocks = 0;
@@ -9360,6 +13004,19 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src
     dest->n_molecules = 0;
     dest->molecules = 0;
     dest->molecule_cnt_list = 0;
+    dest->molecules_capacity = 0;
+    dest->name_pool = 0;
+    dest->molecules_ref_count = 0;
+    dest->detached_molecules = 0;
+    dest->n_detached_molecules = 0;
+    dest->detached_name_pool = 0;
+    dest->detached_molecules_ref_count = 0;
+    dest->topology_particle_offsets = 0;
+    dest->topology_residue_offsets = 0;
+    dest->connectivity_offsets = 0;
+    dest->connectivity_neighbors = 0;
+    dest->connectivity_offsets_32 = 0;
+    dest->connectivity_neighbors_32 = 0;
     dest->n_particles = src->n_particles;
 
     dest->endianness_32 = src->endianness_32;
@@ -9373,7 +13030,9 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src
     dest->current_trajectory_frame_set.prev_frame_set_file_pos = -1;
     dest->current_trajectory_frame_set.n_frames = 0;
 
-    return(TNG_SUCCESS);
+    /* The molecular system is shared with src until either of them
+     * modifies it. */
+    return(tng_molecular_system_share(src, dest));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_input_file_get
@@ -9404,6 +13063,8 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_set
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(file_name, "TNG library: file_name must not be a NULL pointer");
 
+    /* The trajectory is no longer read from several files. */
+    tng_input_segments_free(tng_data);
 
     if(tng_data->input_file_path && strcmp(tng_data->input_file_path,
                                            file_name) == 0)
@@ -9433,25 +13094,93 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_set
     return(tng_input_file_init(tng_data));
 }
 
-tng_function_status tng_output_file_get
+tng_function_status DECLSPECDLLEXPORT tng_input_file_segments_set
                 (const tng_trajectory_t tng_data,
-                 char *file_name,
-                 const int max_len)
+                 const char **file_names,
+                 const int64_t n_files,
+                 const int64_t max_open_files)
 {
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(file_name, "TNG library: file_name must not be a NULL pointer");
+    struct tng_input_segment *segments;
+    int64_t i;
+    tng_function_status stat = TNG_SUCCESS;
 
-    strncpy(file_name, tng_data->output_file_path, max_len - 1);
-    file_name[max_len - 1] = 0;
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(file_names, "TNG library: file_names must not be a NULL pointer");
+    TNG_ASSERT(n_files > 0, "TNG library: n_files must be > 0.");
 
-    if(strlen(tng_data->output_file_path) > (unsigned int)max_len - 1)
+    if(n_files <= 0)
     {
         return(TNG_FAILURE);
     }
-    return(TNG_SUCCESS);
-}
 
-tng_function_status DECLSPECDLLEXPORT tng_output_file_set
+    segments = (struct tng_input_segment *)calloc(n_files, sizeof(struct tng_input_segment));
+    if(!segments)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    for(i = 0; i < n_files && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_input_segment_index_read(file_names[i], &segments[i]);
+        if(stat == TNG_SUCCESS && i > 0 &&
+           segments[i].first_frame < segments[i - 1].first_frame + segments[i - 1].n_frames)
+        {
+            fprintf(stderr, "TNG library: The frames of %s do not follow the frames of %s. %s: %d\n",
+                    file_names[i], file_names[i - 1], __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_input_file_set(tng_data, file_names[0]);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_input_file_init(tng_data);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        for(i = 0; i < n_files; i++)
+        {
+            free(segments[i].path);
+        }
+        free(segments);
+        return(stat);
+    }
+
+    tng_data->input_segments = segments;
+    tng_data->n_input_segments = n_files;
+    tng_data->max_open_input_segments = tng_max_i64(1, max_open_files);
+    tng_data->current_input_segment = 0;
+    tng_data->n_open_input_segments = 1;
+    segments[0].file = tng_data->input_file;
+    segments[0].last_used = ++tng_data->input_segment_use_count;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status tng_output_file_get
+                (const tng_trajectory_t tng_data,
+                 char *file_name,
+                 const int max_len)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(file_name, "TNG library: file_name must not be a NULL pointer");
+
+    strncpy(file_name, tng_data->output_file_path, max_len - 1);
+    file_name[max_len - 1] = 0;
+
+    if(strlen(tng_data->output_file_path) > (unsigned int)max_len - 1)
+    {
+        return(TNG_FAILURE);
+    }
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_output_file_set
                 (const tng_trajectory_t tng_data,
                  const char *file_name)
 {
@@ -9485,6 +13214,7 @@ tng_function_status DECLSPECDLLEXPORT tng_output_file_set
     tng_data->output_file_path = temp;
 
     strncpy(tng_data->output_file_path, file_name, len);
+    tng_data->compress_algo_block_output_file_pos = -1;
 
     return(tng_output_file_init(tng_data));
 }
@@ -9523,6 +13253,7 @@ tng_function_status DECLSPECDLLEXPORT tng_output_append_file_set
     tng_data->output_file_path = temp;
 
     strncpy(tng_data->output_file_path, file_name, len);
+    tng_data->compress_algo_block_output_file_pos = -1;
 
     tng_data->output_file = fopen(tng_data->output_file_path, "rb+");
     if(!tng_data->output_file)
@@ -10245,76 +13976,278 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frames_get
                     (const tng_trajectory_t tng_data,
                      int64_t *n)
 {
-    tng_gen_block_t block;
+    struct tng_input_segment *segment;
     tng_function_status stat;
-    int64_t file_pos, last_file_pos, first_frame, n_frames;
+    int64_t first_frame, n_frames;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(tng_data->input_file, "TNG library: An input file must be open to find the next frame set");
     TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    file_pos = ftello(tng_data->input_file);
-    last_file_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+    if(tng_data->n_input_segments > 0)
+    {
+        segment = &tng_data->input_segments[tng_data->n_input_segments - 1];
+        *n = segment->first_frame + segment->n_frames;
+        return(TNG_SUCCESS);
+    }
+
+    stat = tng_frame_set_frame_range_read(tng_data,
+                                          tng_data->last_trajectory_frame_set_input_file_pos,
+                                          &first_frame, &n_frames);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    *n = first_frame + n_frames;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_precision_get
+                (const tng_trajectory_t tng_data,
+                 double *precision)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    *precision = tng_data->compression_precision;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_precision_set
+                (const tng_trajectory_t tng_data,
+                 const double precision)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    tng_data->compression_precision = precision;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_keyframe_interval_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *interval)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(interval, "TNG library: interval must not be a NULL pointer.");
+
+    *interval = tng_data->compression_keyframe_interval;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_keyframe_interval_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t interval)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(interval >= 0, "TNG library: The keyframe interval must be >= 0.");
+
+    tng_data->compression_keyframe_interval = interval;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_algo_sample_get
+                (const tng_trajectory_t tng_data,
+                 int64_t *n_particles)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+
+    *n_particles = tng_data->compression_algo_sample_n_particles;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_algo_sample_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t n_particles)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_particles >= 0, "TNG library: The number of particles must be >= 0.");
+
+    tng_data->compression_algo_sample_n_particles = n_particles;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 int *algo)
+{
+    int *src;
+    int i, nalgo;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(algo, "TNG library: algo must not be a NULL pointer.");
+
+    if(block_id == TNG_TRAJ_POSITIONS)
+    {
+        src = tng_data->compress_algo_pos;
+    }
+    else if(block_id == TNG_TRAJ_VELOCITIES)
+    {
+        src = tng_data->compress_algo_vel;
+    }
+    else
+    {
+        return(TNG_FAILURE);
+    }
 
-    if(last_file_pos <= 0)
+    if(!src)
     {
         return(TNG_FAILURE);
     }
 
-    tng_block_init(&block);
-    fseeko(tng_data->input_file,
-           last_file_pos,
-           SEEK_SET);
-    /* Read block headers first to see that a frame set block is found. */
-    stat = tng_block_header_read(tng_data, block);
-    if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+    nalgo = tng_compress_nalgo();
+    for(i = 0; i < nalgo; i++)
+    {
+        algo[i] = src[i];
+    }
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const int *algo)
+{
+    int **dest;
+    int i, nalgo;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if(block_id == TNG_TRAJ_POSITIONS)
+    {
+        dest = &tng_data->compress_algo_pos;
+    }
+    else if(block_id == TNG_TRAJ_VELOCITIES)
+    {
+        dest = &tng_data->compress_algo_vel;
+    }
+    else
     {
-        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", last_file_pos,
-                __FILE__, __LINE__);
-        tng_block_destroy(&block);
         return(TNG_FAILURE);
     }
-    tng_block_destroy(&block);
 
-    if(tng_file_input_numerical(tng_data, &first_frame,
-                                sizeof(first_frame),
-                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    if(!algo)
     {
-        return(TNG_CRITICAL);
+        if(*dest)
+        {
+            free(*dest);
+            *dest = 0;
+        }
+        return(TNG_SUCCESS);
     }
 
-    if(tng_file_input_numerical(tng_data, &n_frames,
-                                sizeof(n_frames),
-                                TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    nalgo = tng_compress_nalgo();
+    if(!*dest)
     {
-        return(TNG_CRITICAL);
+        *dest = (int *)malloc(nalgo * sizeof **dest);
+        if(!*dest)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+    }
+    for(i = 0; i < nalgo; i++)
+    {
+        (*dest)[i] = algo[i];
     }
 
-    fseeko(tng_data->input_file, file_pos, SEEK_SET);
+    return(TNG_SUCCESS);
+}
 
-    *n = first_frame + n_frames;
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_store_get
+                (const tng_trajectory_t tng_data,
+                 char *store)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(store, "TNG library: store must not be a NULL pointer.");
+
+    *store = tng_data->compress_algo_store;
 
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_compression_precision_get
+tng_function_status DECLSPECDLLEXPORT tng_compression_algorithm_store_set
                 (const tng_trajectory_t tng_data,
-                 double *precision)
+                 const char store)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
-    *precision = tng_data->compression_precision;
+    tng_data->compress_algo_store = store ? TNG_TRUE : TNG_FALSE;
 
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_compression_precision_set
+tng_function_status DECLSPECDLLEXPORT tng_statistics_enabled_set
                 (const tng_trajectory_t tng_data,
-                 const double precision)
+                 const tng_bool enabled)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
-    tng_data->compression_precision = precision;
+    tng_data->statistics_enabled = enabled ? TNG_TRUE : TNG_FALSE;
+
+    return(tng_statistics_reset(tng_data));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_statistics_get
+                (const tng_trajectory_t tng_data,
+                 struct tng_statistics *statistics)
+{
+    double elapsed;
+    int i;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(statistics, "TNG library: statistics must not be a NULL pointer.");
+
+    *statistics = tng_data->statistics;
+    for(i = 0; i < tng_data->n_thread_statistics; i++)
+    {
+        tng_statistics_add(statistics, &tng_data->thread_statistics[i]);
+    }
+
+#ifdef TNG_HAVE_TSC
+    elapsed = tng_statistics_time_get() - tng_data->statistics_start_time;
+    if(tng_data->statistics_enabled && tng_data->statistics_start_time > 0 &&
+       elapsed > 0)
+    {
+        statistics->ticks_per_second = (int64_t)((tng_ticks_get() -
+                                                  tng_data->statistics_start_ticks) /
+                                                 elapsed);
+    }
+    else
+    {
+        statistics->ticks_per_second = 0;
+    }
+#else
+    (void)elapsed;
+    statistics->ticks_per_second = CLOCKS_PER_SEC;
+#endif
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_statistics_reset
+                (const tng_trajectory_t tng_data)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    memset(&tng_data->statistics, 0, sizeof(tng_data->statistics));
+    if(tng_data->thread_statistics)
+    {
+        memset(tng_data->thread_statistics, 0,
+               sizeof(struct tng_statistics) * tng_data->n_thread_statistics);
+    }
+    tng_data->statistics_start_ticks = tng_ticks_get();
+    tng_data->statistics_start_time = tng_statistics_time_get();
 
     return(TNG_SUCCESS);
 }
@@ -10564,11 +14497,21 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get
     struct tng_trajectory_frame_set orig_frame_set;
     tng_gen_block_t block;
     tng_function_status stat;
-    int64_t cnt = 0;
+    int64_t i, cnt = 0;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
+    if(tng_data->n_input_segments > 0)
+    {
+        for(i = 0; i < tng_data->n_input_segments; i++)
+        {
+            cnt += tng_data->input_segments[i].n_frame_sets;
+        }
+        *n = tng_data->n_trajectory_frame_sets = cnt;
+        return(TNG_SUCCESS);
+    }
+
     orig_frame_set = tng_data->current_trajectory_frame_set;
 
     frame_set = &tng_data->current_trajectory_frame_set;
@@ -10583,9 +14526,9 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get
     }
 
     tng_block_init(&block);
-    fseeko(tng_data->input_file,
-           file_pos,
-           SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file,
+               file_pos,
+               SEEK_SET);
     tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
     /* Read block headers first to see what block is found. */
     stat = tng_block_header_read(tng_data, block);
@@ -10617,7 +14560,7 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get
         if(file_pos > 0)
         {
             cnt += long_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10646,9 +14589,9 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get
         if(file_pos > 0)
         {
             cnt += medium_stride_length;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10676,9 +14619,9 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get
         if(file_pos > 0)
         {
             ++cnt;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10708,10 +14651,12 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get
      * other frame sets. */
     frame_set->mappings = 0;
     frame_set->n_mapping_blocks = 0;
+    frame_set->mapping_table = 0;
+    frame_set->mapping_table_n_particles = 0;
 
-    fseeko(tng_data->input_file,
-           tng_data->first_trajectory_frame_set_input_file_pos,
-           SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file,
+               tng_data->first_trajectory_frame_set_input_file_pos,
+               SEEK_SET);
 
     tng_data->current_trajectory_frame_set_input_file_pos = orig_frame_set_file_pos;
 
@@ -10742,6 +14687,8 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(nr >= 0, "The frame set number (nr) must be >= 0");
 
+    tng_statistics_count(tng_data, &tng_data->statistics.n_frame_set_searches, 1);
+
     frame_set = &tng_data->current_trajectory_frame_set;
 
     stat = tng_num_frame_sets_get(tng_data, &n_frame_sets);
@@ -10778,9 +14725,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
     }
 
     tng_block_init(&block);
-    fseeko(tng_data->input_file,
-           file_pos,
-           SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file,
+               file_pos,
+               SEEK_SET);
     tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
     /* Read block headers first to see what block is found. */
     stat = tng_block_header_read(tng_data, block);
@@ -10815,7 +14762,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             curr_nr += long_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10848,9 +14795,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             curr_nr += medium_stride_length;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10883,9 +14830,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             ++curr_nr;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10918,9 +14865,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             curr_nr -= long_stride_length;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10953,9 +14900,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             curr_nr -= medium_stride_length;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10987,9 +14934,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             --curr_nr;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11022,9 +14969,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find
         if(file_pos > 0)
         {
             ++curr_nr;
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11067,16 +15014,29 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(frame >= 0, "TNG library: frame must be >= 0.");
 
+    tng_statistics_count(tng_data, &tng_data->statistics.n_frame_set_searches, 1);
+
     frame_set = &tng_data->current_trajectory_frame_set;
 
+    /* If the trajectory is split into several files only the file
+     * containing the frame is searched. */
+    if(tng_data->n_input_segments > 1)
+    {
+        stat = tng_input_segment_of_frame_activate(tng_data, frame);
+        if(stat != TNG_SUCCESS)
+        {
+            return(stat);
+        }
+    }
+
     tng_block_init(&block);
 
     if(tng_data->current_trajectory_frame_set_input_file_pos < 0)
     {
         file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
-        fseeko(tng_data->input_file,
-               file_pos,
-               SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file,
+                   file_pos,
+                   SEEK_SET);
         tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
         /* Read block headers first to see what block is found. */
         stat = tng_block_header_read(tng_data, block);
@@ -11157,9 +15117,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
 
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
@@ -11199,7 +15159,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->long_stride_next_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11234,9 +15194,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->medium_stride_next_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11269,9 +15229,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->next_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11306,9 +15266,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->long_stride_prev_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11343,9 +15303,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->medium_stride_prev_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11378,9 +15338,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->prev_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11414,9 +15374,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find
         file_pos = frame_set->next_frame_set_file_pos;
         if(file_pos > 0)
         {
-            fseeko(tng_data->input_file,
-                   file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file,
+                       file_pos,
+                       SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -11495,43 +15455,6 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_frame_range_get
     return(TNG_SUCCESS);
 }
 
-/**
- * @brief Translate from the particle numbering used in a frame set to the real
- *  particle numbering - used in the molecule description.
- * @param frame_set is the frame_set containing the mappings to use.
- * @param local is the index number of the atom in this frame set
- * @param real is set to the index of the atom in the molecular system.
- * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the mapping
- * cannot be found.
- */
-static TNG_INLINE tng_function_status tng_particle_mapping_get_real_particle
-                (const tng_trajectory_frame_set_t frame_set,
-                 const int64_t local,
-                 int64_t *real)
-{
-    int64_t i, n_blocks = frame_set->n_mapping_blocks, first;
-    tng_particle_mapping_t mapping;
-    if(n_blocks <= 0)
-    {
-        *real = local;
-        return(TNG_SUCCESS);
-    }
-    for(i = 0; i < n_blocks; i++)
-    {
-        mapping = &frame_set->mappings[i];
-        first = mapping->num_first_particle;
-        if(local < first ||
-           local >= first + mapping->n_particles)
-        {
-            continue;
-        }
-        *real = mapping->real_particle_numbers[local-first];
-        return(TNG_SUCCESS);
-    }
-    *real = local;
-    return(TNG_FAILURE);
-}
-
 /**
  * @brief Translate from the real particle numbering to the particle numbering
  *  used in a frame set.
@@ -11587,7 +15510,7 @@ static tng_function_status tng_file_headers_len_get
 
     orig_pos = ftello(tng_data->input_file);
 
-    fseeko(tng_data->input_file, 0, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, 0, SEEK_SET);
 
     tng_block_init(&block);
     /* Read through the headers of non-trajectory blocks (they come before the
@@ -11598,10 +15521,10 @@ static tng_function_status tng_file_headers_len_get
            block->id != TNG_TRAJECTORY_FRAME_SET)
     {
         *len += block->header_contents_size + block->block_contents_size;
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
     }
 
-    fseeko(tng_data->input_file, orig_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
 
     tng_block_destroy(&block);
 
@@ -11624,7 +15547,7 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_read
         return(TNG_CRITICAL);
     }
 
-    fseeko(tng_data->input_file, 0, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, 0, SEEK_SET);
 
     tng_block_init(&block);
     /* Non trajectory blocks (they come before the trajectory
@@ -11641,7 +15564,7 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_read
     /* Go back if a trajectory block was encountered */
     if(block->id == TNG_TRAJECTORY_FRAME_SET)
     {
-        fseeko(tng_data->input_file, prev_pos, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, prev_pos, SEEK_SET);
     }
 
     tng_block_destroy(&block);
@@ -11718,6 +15641,14 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_write
                                          &len);
             tot_len += len;
         }
+        if(tng_data->compress_algo_store)
+        {
+            strcpy(block->name, "COMPRESSION ALGORITHMS");
+            tng_block_header_len_calculate(tng_data, block, &len);
+            tot_len += len;
+            tng_compress_algo_block_len_calculate(tng_data, &len);
+            tot_len += len;
+        }
         tng_block_destroy(&block);
 
         if(tot_len > orig_len)
@@ -11775,8 +15706,16 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_write
 
     tng_block_destroy(&block);
 
+    if(tng_data->compress_algo_store &&
+       tng_compress_algo_block_write(tng_data, hash_mode) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Error writing compression algorithms block of file %s. %s: %d\n",
+                tng_data->output_file_path, __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
     /* Continue writing at the end of the file. */
-    fseeko(tng_data->output_file, 0, SEEK_END);
+    tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_END);
     if(temp_pos > 0)
     {
         tng_data->current_trajectory_frame_set_output_file_pos = temp_pos;
@@ -11803,6 +15742,8 @@ tng_function_status DECLSPECDLLEXPORT tng_block_read_next
         return(tng_general_info_block_read(tng_data, block, hash_mode));
     case TNG_MOLECULES:
         return(tng_molecules_block_read(tng_data, block, hash_mode));
+    case TNG_COMPRESSION_ALGORITHMS:
+        return(tng_compress_algo_block_read(tng_data, block, hash_mode));
     default:
         if(block->id >= TNG_TRAJ_BOX_SHAPE)
         {
@@ -11811,7 +15752,7 @@ tng_function_status DECLSPECDLLEXPORT tng_block_read_next
         else
         {
             /* Skip to the next block */
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+            tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
             return(TNG_FAILURE);
         }
     }
@@ -11882,7 +15823,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read
 
         if(block->id == TNG_TRAJECTORY_FRAME_SET)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
         }
     }
 
@@ -11901,6 +15842,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
     tng_gen_block_t block;
     tng_function_status stat;
     int found_flag = 1;
+    tng_bool read_mappings;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
@@ -11921,9 +15863,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
 
     if(file_pos > 0)
     {
-        fseeko(tng_data->input_file,
-              file_pos,
-              SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file,
+                  file_pos,
+                  SEEK_SET);
     }
     else
     {
@@ -11944,7 +15886,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
     /* If the current frame set had already been read skip its block contents */
     if(found_flag)
     {
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
     }
     /* Otherwise read the frame set block */
     else
@@ -11961,8 +15903,10 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
     file_pos = ftello(tng_data->input_file);
 
     found_flag = 0;
+    /* The particle mappings are kept if they have already been read. */
+    read_mappings = tng_data->current_trajectory_frame_set.n_mapping_blocks <= 0;
 
-    /* Read only blocks of the requested ID
+    /* Read only particle mapping blocks and blocks of the requested ID
         * until next frame set block */
     stat = tng_block_header_read(tng_data, block);
     while(file_pos < tng_data->input_file_len &&
@@ -11970,14 +15914,18 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
           block->id != TNG_TRAJECTORY_FRAME_SET &&
           block->id != -1)
     {
-        if(block->id == block_id)
+        if(block->id == block_id ||
+           (read_mappings && block->id == TNG_PARTICLE_MAPPING))
         {
+            if(block->id == block_id)
+            {
+                found_flag = 1;
+            }
             stat = tng_block_read_next(tng_data, block,
                                        hash_mode);
             if(stat != TNG_CRITICAL)
             {
                 file_pos = ftello(tng_data->input_file);
-                found_flag = 1;
                 if(file_pos < tng_data->input_file_len)
                 {
                     stat = tng_block_header_read(tng_data, block);
@@ -11987,7 +15935,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
         else
         {
             file_pos += block->block_contents_size + block->header_contents_size;
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+            tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
             if(file_pos < tng_data->input_file_len)
             {
                 stat = tng_block_header_read(tng_data, block);
@@ -12004,7 +15952,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_current_only_data_from_
 
     if(block->id == TNG_TRAJECTORY_FRAME_SET)
     {
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
     }
 
     tng_block_destroy(&block);
@@ -12034,6 +15982,17 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next
 
     file_pos = tng_data->current_trajectory_frame_set.next_frame_set_file_pos;
 
+    /* After the last frame set of a file continue with the next file, if the
+     * trajectory is split into several files. */
+    if(file_pos < 0 && tng_data->current_trajectory_frame_set_input_file_pos > 0 &&
+       tng_data->current_input_segment + 1 < tng_data->n_input_segments)
+    {
+        if(tng_input_segment_activate(tng_data, tng_data->current_input_segment + 1) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+
     if(file_pos < 0 && tng_data->current_trajectory_frame_set_input_file_pos <= 0)
     {
         file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
@@ -12041,9 +16000,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next
 
     if(file_pos > 0)
     {
-        fseeko(tng_data->input_file,
-               file_pos,
-               SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file,
+                   file_pos,
+                   SEEK_SET);
     }
     else
     {
@@ -12071,6 +16030,17 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next_only_data_from_blo
 
     file_pos = tng_data->current_trajectory_frame_set.next_frame_set_file_pos;
 
+    /* After the last frame set of a file continue with the next file, if the
+     * trajectory is split into several files. */
+    if(file_pos < 0 && tng_data->current_trajectory_frame_set_input_file_pos > 0 &&
+       tng_data->current_input_segment + 1 < tng_data->n_input_segments)
+    {
+        if(tng_input_segment_activate(tng_data, tng_data->current_input_segment + 1) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+    }
+
     if(file_pos < 0 && tng_data->current_trajectory_frame_set_input_file_pos <= 0)
     {
         file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
@@ -12078,9 +16048,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next_only_data_from_blo
 
     if(file_pos > 0)
     {
-        fseeko(tng_data->input_file,
-               file_pos,
-               SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file,
+                   file_pos,
+                   SEEK_SET);
     }
     else
     {
@@ -12112,22 +16082,22 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next_only_data_from_blo
     return(stat);
 }
 
-tng_function_status tng_frame_set_write
-                (const tng_trajectory_t tng_data,
-                 const char hash_mode)
+/**
+ * @brief Set the output file position of the current frame set to the
+ * current position of the output file, where it is to be written.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if there is no
+ * output file or if the position is not valid (e.g. if the file headers have
+ * not been written).
+ */
+static tng_function_status tng_frame_set_output_file_pos_set
+                (const tng_trajectory_t tng_data)
 {
-    int i, j;
-    tng_gen_block_t block;
-    tng_trajectory_frame_set_t frame_set;
-    tng_function_status stat;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-
-    frame_set = &tng_data->current_trajectory_frame_set;
-
-    if(frame_set->n_written_frames == frame_set->n_frames)
+    if(!tng_data->output_file)
     {
-        return(TNG_SUCCESS);
+        fprintf(stderr, "TNG library: No file specified for writing. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_FAILURE);
     }
 
     tng_data->current_trajectory_frame_set_output_file_pos =
@@ -12146,49 +16116,120 @@ tng_function_status tng_frame_set_write
         tng_data->current_trajectory_frame_set_output_file_pos;
     }
 
-    tng_block_init(&block);
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Encode the current frame set in memory, as it is written to the
+ * output file.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param with_frame_set_block specifies if the frame set block itself is
+ * encoded before the particle mapping and data blocks.
+ * @param contents is set to the encoded blocks, which must be freed by the
+ * caller.
+ * @param len is set to the length of contents.
+ * @details The frames of the frame set are counted as written if it
+ * contains any data blocks.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_encode
+                (const tng_trajectory_t tng_data,
+                 const char hash_mode,
+                 const tng_bool with_frame_set_block,
+                 char **contents,
+                 int64_t *len)
+{
+    int64_t i, n_encodings, frame_set_len = 0;
+    tng_gen_block_t block;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_block_encoding *encodings;
+    char *frame_set_encoded = 0, *pos;
+    tng_bool has_data = TNG_FALSE;
+    tng_function_status stat;
+
+    *contents = 0;
+    *len = 0;
+
+    stat = tng_frame_set_blocks_encode(tng_data, hash_mode, &encodings, &n_encodings);
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot encode frame set blocks. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_block_encodings_free(encodings, n_encodings);
+        return(stat);
+    }
 
-    if(tng_frame_set_block_write(tng_data, block, hash_mode) != TNG_SUCCESS)
+    if(with_frame_set_block)
     {
+        tng_block_init(&block);
+        stat = tng_frame_set_block_encode(tng_data, block, hash_mode, &frame_set_encoded,
+                                          &frame_set_len);
         tng_block_destroy(&block);
-        return(TNG_FAILURE);
+        if(stat != TNG_SUCCESS)
+        {
+            tng_block_encodings_free(encodings, n_encodings);
+            return(TNG_FAILURE);
+        }
     }
 
-    /* Write non-particle data blocks */
-    for(i = 0; i<frame_set->n_data_blocks; i++)
+    *len = frame_set_len;
+    for(i = 0; i < n_encodings; i++)
     {
-        block->id = frame_set->tr_data[i].block_id;
-        tng_data_block_write(tng_data, block, i, TNG_FALSE, 0, hash_mode);
+        *len += encodings[i].encoded_len;
     }
-    /* Write the mapping blocks and particle data blocks*/
-    if(frame_set->n_mapping_blocks)
+    *contents = (char *)malloc(tng_max_i64(*len, 1));
+    if(!*contents)
     {
-        for(i = 0; i < frame_set->n_mapping_blocks; i++)
-        {
-            block->id = TNG_PARTICLE_MAPPING;
-            if(frame_set->mappings[i].n_particles > 0)
-            {
-                tng_trajectory_mapping_block_write(tng_data, block, i, hash_mode);
-                for(j = 0; j<frame_set->n_particle_data_blocks; j++)
-                {
-                    block->id = frame_set->tr_particle_data[j].block_id;
-                    tng_data_block_write(tng_data, block,
-                                         j, TNG_TRUE, &frame_set->mappings[i],
-                                         hash_mode);
-                }
-            }
-        }
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(frame_set_encoded);
+        tng_block_encodings_free(encodings, n_encodings);
+        return(TNG_CRITICAL);
     }
-    else
+    if(frame_set_encoded)
+    {
+        memcpy(*contents, frame_set_encoded, frame_set_len);
+        free(frame_set_encoded);
+    }
+    pos = *contents + frame_set_len;
+    for(i = 0; i < n_encodings; i++)
     {
-        for(i = 0; i<frame_set->n_particle_data_blocks; i++)
+        memcpy(pos, encodings[i].encoded, encodings[i].encoded_len);
+        pos += encodings[i].encoded_len;
+        if(encodings[i].data)
         {
-            block->id = frame_set->tr_particle_data[i].block_id;
-            tng_data_block_write(tng_data, block,
-                                 i, TNG_TRUE, 0, hash_mode);
+            has_data = TNG_TRUE;
         }
     }
+    tng_block_encodings_free(encodings, n_encodings);
+
+    if(has_data)
+    {
+        frame_set->n_written_frames += frame_set->n_unwritten_frames;
+        frame_set->n_unwritten_frames = 0;
+    }
+
+    return(TNG_SUCCESS);
+}
 
+/**
+ * @brief Update the pointers to the current frame set, which has just been
+ * written, in the general info block and in the previous frame sets.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the md5 hashes of the updated blocks are
+ * updated.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_write_finish
+                (const tng_trajectory_t tng_data,
+                 const char hash_mode)
+{
+    tng_function_status stat;
 
     /* Update pointers in the general info block */
     stat = tng_header_pointers_update(tng_data, hash_mode);
@@ -12198,15 +16239,56 @@ tng_function_status tng_frame_set_write
         stat = tng_frame_set_pointers_update(tng_data, hash_mode);
     }
 
-    tng_block_destroy(&block);
-
-    frame_set->n_unwritten_frames = 0;
+    tng_data->current_trajectory_frame_set.n_unwritten_frames = 0;
 
     fflush(tng_data->output_file);
 
     return(stat);
 }
 
+tng_function_status tng_frame_set_write
+                (const tng_trajectory_t tng_data,
+                 const char hash_mode)
+{
+    int64_t len;
+    tng_trajectory_frame_set_t frame_set;
+    char *contents;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    if(frame_set->n_written_frames == frame_set->n_frames)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    if(tng_frame_set_output_file_pos_set(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_FAILURE);
+    }
+
+    /* The whole frame set is encoded in memory and written at once. */
+    stat = tng_frame_set_encode(tng_data, hash_mode, TNG_TRUE, &contents, &len);
+    if(stat != TNG_SUCCESS)
+    {
+        free(contents);
+        return(stat);
+    }
+
+    if(tng_fwrite(tng_data, contents, len, 1, tng_data->output_file) != 1)
+    {
+        fprintf(stderr, "TNG library: Could not write frame set. %s: %d\n", __FILE__,
+                __LINE__);
+        free(contents);
+        return(TNG_CRITICAL);
+    }
+    free(contents);
+
+    return(tng_frame_set_write_finish(tng_data, hash_mode));
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_frame_set_premature_write
                 (const tng_trajectory_t tng_data,
                  const char hash_mode)
@@ -12226,66 +16308,507 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_premature_write
     return(tng_frame_set_write(tng_data, hash_mode));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_frame_set_new
+#ifdef TNG_HAVE_MPI
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_mpi_write
                 (const tng_trajectory_t tng_data,
-                 const int64_t first_frame,
-                 const int64_t n_frames)
+                 const MPI_Comm comm,
+                 const char hash_mode)
 {
-    tng_gen_block_t block;
+    int rank, local_stat, stat;
+    int64_t len, offset = 0;
+    MPI_Offset frame_set_pos = 0;
+    MPI_File file;
     tng_trajectory_frame_set_t frame_set;
-    FILE *temp = tng_data->input_file;
-    int64_t curr_file_pos;
+    char *contents = 0, path[TNG_MAX_STR_LEN];
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(first_frame >= 0, "TNG library: first_frame must be >= 0.");
-    TNG_ASSERT(n_frames >= 0, "TNG library: n_frames must be >= 0.");
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
-    curr_file_pos = ftello(tng_data->output_file);
-
-    if(curr_file_pos <= 10)
+    if(frame_set->n_written_frames == frame_set->n_frames)
     {
-        tng_file_headers_write(tng_data, TNG_USE_HASH);
+        return(TNG_SUCCESS);
     }
 
-    /* Set pointer to previous frame set to the one that was loaded
-     * before.
-     * FIXME: This is a bit risky. If they are not added in order
-     * it will be wrong. */
-    if(tng_data->n_trajectory_frame_sets)
+    /* As with tng_frame_set_premature_write() only the frames stored so far
+     * are written if the frame set is not finished. */
+    if(frame_set->n_unwritten_frames > 0)
     {
-        frame_set->prev_frame_set_file_pos =
-        tng_data->last_trajectory_frame_set_output_file_pos;
+        frame_set->n_frames = frame_set->n_unwritten_frames;
     }
 
-    frame_set->next_frame_set_file_pos = -1;
+    MPI_Comm_rank(comm, &rank);
 
-    tng_data->current_trajectory_frame_set_output_file_pos =
-    ftello(tng_data->output_file);
+    /* The first process writes the frame set block and owns the output file,
+     * where the frame set is appended. */
+    local_stat = TNG_SUCCESS;
+    if(rank == 0)
+    {
+        local_stat = tng_frame_set_output_file_pos_set(tng_data);
+        if(local_stat == TNG_SUCCESS)
+        {
+            fflush(tng_data->output_file);
+            frame_set_pos = tng_data->current_trajectory_frame_set_output_file_pos;
+            strncpy(path, tng_data->output_file_path, TNG_MAX_STR_LEN - 1);
+            path[TNG_MAX_STR_LEN - 1] = '\0';
+        }
+    }
+    MPI_Bcast(&local_stat, 1, MPI_INT, 0, comm);
+    if(local_stat != TNG_SUCCESS)
+    {
+        return((tng_function_status)local_stat);
+    }
+    MPI_Bcast(&frame_set_pos, 1, MPI_OFFSET, 0, comm);
+    MPI_Bcast(path, TNG_MAX_STR_LEN, MPI_CHAR, 0, comm);
+    /* The data blocks of all processes belong to the frame set. */
+    tng_data->current_trajectory_frame_set_output_file_pos = frame_set_pos;
 
-    tng_data->n_trajectory_frame_sets++;
+    /* Each process encodes its own particle mapping and data blocks. */
+    local_stat = tng_frame_set_encode(tng_data, hash_mode, rank == 0, &contents, &len);
+    if(local_stat == TNG_SUCCESS && len > INT_MAX)
+    {
+        fprintf(stderr, "TNG library: Frame set too large to write. %s: %d\n",
+                __FILE__, __LINE__);
+        local_stat = TNG_FAILURE;
+    }
+    MPI_Allreduce(&local_stat, &stat, 1, MPI_INT, MPI_MAX, comm);
+    if(stat != TNG_SUCCESS)
+    {
+        free(contents);
+        return((tng_function_status)stat);
+    }
 
-    /* Set the medium range pointers */
-    if(tng_data->n_trajectory_frame_sets == tng_data->medium_stride_length + 1)
+    /* The blocks of the processes are written in order after each other. */
+    MPI_Exscan(&len, &offset, 1, MPI_INT64_T, MPI_SUM, comm);
+    if(rank == 0)
     {
-        frame_set->medium_stride_prev_frame_set_file_pos =
-        tng_data->first_trajectory_frame_set_output_file_pos;
+        offset = 0;
     }
-    else if(tng_data->n_trajectory_frame_sets > tng_data->medium_stride_length + 1)
+
+    local_stat = TNG_SUCCESS;
+    if(MPI_File_open(comm, path, MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
     {
-        /* FIXME: Currently only working if the previous frame set has its
-         * medium stride pointer already set. This might need some fixing. */
-        if(frame_set->medium_stride_prev_frame_set_file_pos != -1 &&
-           frame_set->medium_stride_prev_frame_set_file_pos != 0)
+        fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n", path,
+                __FILE__, __LINE__);
+        free(contents);
+        return(TNG_CRITICAL);
+    }
+    if(MPI_File_write_at_all(file, frame_set_pos + offset, contents, (int)len,
+                             MPI_BYTE, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Could not write frame set. %s: %d\n", __FILE__,
+                __LINE__);
+        local_stat = TNG_CRITICAL;
+    }
+    MPI_File_close(&file);
+    free(contents);
+
+    if(rank == 0)
+    {
+        tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_END);
+        if(local_stat == TNG_SUCCESS)
         {
-            tng_block_init(&block);
-            tng_data->input_file = tng_data->output_file;
+            local_stat = tng_frame_set_write_finish(tng_data, hash_mode);
+        }
+    }
+    else
+    {
+        frame_set->n_unwritten_frames = 0;
+    }
+    MPI_Allreduce(&local_stat, &stat, 1, MPI_INT, MPI_MAX, comm);
+
+    return((tng_function_status)stat);
+}
+#endif
+
+/**
+ * @brief Create a new frame set, a copy of another frame set, and write its
+ * frame set block to the end of the output file. Its particle mapping and
+ * data blocks must be written directly after it.
+ * @param tng_data_out is the trajectory data container to write to.
+ * @param frame_set_src is the frame set to copy, which may belong to another
+ * trajectory with the same molecular system.
+ * @param first_frame is the first frame of the new frame set.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @details Finish writing the frame set with tng_frame_set_write_finish().
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_block_append
+                (const tng_trajectory_t tng_data_out,
+                 const tng_trajectory_frame_set_t frame_set_src,
+                 const int64_t first_frame,
+                 const char hash_mode)
+{
+    int64_t len;
+    tng_trajectory_frame_set_t frame_set_out;
+    tng_gen_block_t block;
+    char *contents;
+    tng_function_status stat;
+
+    frame_set_out = &tng_data_out->current_trajectory_frame_set;
+
+    if(tng_output_file_init(tng_data_out) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    stat = tng_frame_set_new(tng_data_out, first_frame, frame_set_src->n_frames);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    frame_set_out->first_frame_time = frame_set_src->first_frame_time;
+    if(tng_data_out->var_num_atoms_flag)
+    {
+        if(!frame_set_out->molecule_cnt_list)
+        {
+            frame_set_out->molecule_cnt_list =
+            (int64_t *)malloc(sizeof(int64_t) * tng_data_out->n_molecules);
+            if(!frame_set_out->molecule_cnt_list)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                return(TNG_CRITICAL);
+            }
+        }
+        memcpy(frame_set_out->molecule_cnt_list, frame_set_src->molecule_cnt_list,
+               sizeof(int64_t) * tng_data_out->n_molecules);
+        frame_set_out->n_particles = frame_set_src->n_particles;
+    }
+
+    if(tng_frame_set_output_file_pos_set(tng_data_out) != TNG_SUCCESS)
+    {
+        return(TNG_FAILURE);
+    }
+
+    tng_block_init(&block);
+    stat = tng_frame_set_block_encode(tng_data_out, block, hash_mode, &contents, &len);
+    tng_block_destroy(&block);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    if(tng_fwrite(tng_data_out, contents, len, 1, tng_data_out->output_file) != 1)
+    {
+        fprintf(stderr, "TNG library: Could not write frame set. %s: %d\n", __FILE__,
+                __LINE__);
+        free(contents);
+        return(TNG_CRITICAL);
+    }
+    free(contents);
+
+    frame_set_out->n_written_frames = frame_set_out->n_frames;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Shift the frame number of the first frame with data of a data block,
+ * which has been read into memory as it is stored in the file.
+ * @param tng_data_in is the trajectory from which the block was read.
+ * @param tng_data_out is the trajectory to which the block is written.
+ * @param contents is the contents of the block, after the block header.
+ * @param contents_len is the length of contents.
+ * @param frame_offset is the number to add to the frame number.
+ * @param shifted is set to TNG_TRUE if the block contains a frame number,
+ * which has been shifted.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if the block
+ * contents are not valid.
+ */
+static tng_function_status tng_data_block_first_frame_shift
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 char *contents,
+                 const int64_t contents_len,
+                 const int64_t frame_offset,
+                 tng_bool *shifted)
+{
+    int64_t offset, codec_id, first_frame_with_data;
+    char dependency;
+
+    *shifted = TNG_FALSE;
+
+    /* Only the data blocks of frame dependent data, which is not stored in
+     * every frame, contain the first frame with data. */
+    if(contents_len < 2)
+    {
+        return(TNG_CRITICAL);
+    }
+    dependency = contents[1];
+    if(!(dependency & TNG_FRAME_DEPENDENT) || contents_len < 3 || !contents[2])
+    {
+        return(TNG_SUCCESS);
+    }
+
+    offset = 3 + sizeof(int64_t);
+    if(contents_len < offset + (int64_t)sizeof(int64_t))
+    {
+        return(TNG_CRITICAL);
+    }
+    tng_buffer_numerical_64_get(tng_data_in, &codec_id, contents + offset);
+    offset += sizeof(int64_t);
+    if(codec_id != TNG_UNCOMPRESSED)
+    {
+        offset += sizeof(double);
+    }
+    if(contents_len < offset + (int64_t)sizeof(int64_t))
+    {
+        return(TNG_CRITICAL);
+    }
+
+    tng_buffer_numerical_64_get(tng_data_in, &first_frame_with_data, contents + offset);
+    first_frame_with_data += frame_offset;
+    tng_buffer_numerical_put(tng_data_out, contents + offset, &first_frame_with_data,
+                             sizeof(first_frame_with_data));
+    *shifted = TNG_TRUE;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_raw_copy
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 const int64_t first_frame,
+                 const char hash_mode)
+{
+    int64_t file_pos, frame_offset, len, buffer_size = 0;
+    tng_trajectory_frame_set_t frame_set_in;
+    tng_gen_block_t block;
+    char *contents, *buffer = 0, *temp, *hash;
+    char empty_hash[TNG_MD5_HASH_LEN];
+    tng_bool shifted;
+    md5_state_t md5_state;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data_in, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(tng_data_out, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(first_frame >= 0, "TNG library: first_frame must be >= 0.");
+
+    frame_set_in = &tng_data_in->current_trajectory_frame_set;
+
+    if(tng_data_in->current_trajectory_frame_set_input_file_pos <= 0 ||
+       tng_input_file_init(tng_data_in) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: No frame set has been read from the input file. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    /* The contents of the blocks are copied as they are, so the values must
+     * be stored in the same byte order. */
+    if(tng_data_in->input_endianness_swap_func_32 != tng_data_out->output_endianness_swap_func_32 ||
+       tng_data_in->input_endianness_swap_func_64 != tng_data_out->output_endianness_swap_func_64)
+    {
+        fprintf(stderr, "TNG library: Cannot copy blocks between files of different byte order. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    if(tng_data_in->var_num_atoms_flag != tng_data_out->var_num_atoms_flag ||
+       (tng_data_in->var_num_atoms_flag &&
+        tng_data_in->n_molecules != tng_data_out->n_molecules))
+    {
+        fprintf(stderr, "TNG library: The molecular systems of the trajectories do not match. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_frame_set_block_append(tng_data_out, frame_set_in, first_frame, hash_mode);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    tng_block_init(&block);
+
+    /* Skip the frame set block of the input file. */
+    tng_fseeko(tng_data_in, tng_data_in->input_file, tng_data_in->current_trajectory_frame_set_input_file_pos,
+               SEEK_SET);
+    if(tng_block_header_read(tng_data_in, block) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+    file_pos = tng_data_in->current_trajectory_frame_set_input_file_pos +
+               block->header_contents_size + block->block_contents_size;
+
+    frame_offset = first_frame - frame_set_in->first_frame;
+    memset(empty_hash, '\0', TNG_MD5_HASH_LEN);
+
+    /* Copy the particle mapping and data blocks of the frame set, i.e. all
+     * blocks until the next frame set. Only the frame numbers and the md5
+     * hashes of the blocks are changed. */
+    while(file_pos < tng_data_in->input_file_len)
+    {
+        tng_fseeko(tng_data_in, tng_data_in->input_file, file_pos, SEEK_SET);
+        if(tng_block_header_read(tng_data_in, block) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+            break;
+        }
+        if(block->id == TNG_TRAJECTORY_FRAME_SET)
+        {
+            break;
+        }
+
+        len = block->header_contents_size + block->block_contents_size;
+        temp = (char *)tng_array_grow(buffer, &buffer_size, len, 1);
+        if(!temp)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+            break;
+        }
+        buffer = temp;
+
+        tng_fseeko(tng_data_in, tng_data_in->input_file, file_pos, SEEK_SET);
+        if(tng_fread(tng_data_in, buffer, len, 1, tng_data_in->input_file) == 0)
+        {
+            fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+            break;
+        }
+        contents = buffer + block->header_contents_size;
+
+        shifted = TNG_FALSE;
+        if(block->id != TNG_PARTICLE_MAPPING && frame_offset != 0)
+        {
+            stat = tng_data_block_first_frame_shift(tng_data_in, tng_data_out, contents,
+                                                    block->block_contents_size,
+                                                    frame_offset, &shifted);
+            if(stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Invalid data block contents. %s: %d\n",
+                        __FILE__, __LINE__);
+                break;
+            }
+        }
+
+        /* The md5 hash follows the sizes and the ID in the block header. The
+         * existing hash is kept if the contents have not changed. */
+        hash = buffer + 3 * sizeof(int64_t);
+        if(hash_mode == TNG_USE_HASH)
+        {
+            if(shifted || memcmp(hash, empty_hash, TNG_MD5_HASH_LEN) == 0)
+            {
+                md5_init(&md5_state);
+                tng_md5_append(tng_data_out, &md5_state, (md5_byte_t *)contents,
+                               (int)block->block_contents_size);
+                md5_finish(&md5_state, (md5_byte_t *)hash);
+            }
+        }
+        else
+        {
+            memset(hash, '\0', TNG_MD5_HASH_LEN);
+        }
+
+        if(tng_fwrite(tng_data_out, buffer, len, 1, tng_data_out->output_file) != 1)
+        {
+            fprintf(stderr, "TNG library: Could not write block. %s: %d\n", __FILE__,
+                    __LINE__);
+            stat = TNG_CRITICAL;
+            break;
+        }
+
+        file_pos += len;
+    }
+    free(buffer);
+    tng_block_destroy(&block);
+
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    return(tng_frame_set_write_finish(tng_data_out, hash_mode));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_new
+                (const tng_trajectory_t tng_data,
+                 const int64_t first_frame,
+                 const int64_t n_frames)
+{
+    tng_gen_block_t block;
+    tng_trajectory_frame_set_t frame_set;
+    FILE *temp = tng_data->input_file;
+    int64_t curr_file_pos;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(first_frame >= 0, "TNG library: first_frame must be >= 0.");
+    TNG_ASSERT(n_frames >= 0, "TNG library: n_frames must be >= 0.");
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    /* A trajectory without an output file, e.g. one holding the particles of
+     * one process for tng_frame_set_mpi_write(), keeps its frame sets in
+     * memory only. */
+    if(!tng_data->output_file)
+    {
+        /* The frame set has no position in a file of its own, but its data
+         * blocks must be trajectory blocks. The position of the frame set
+         * in the output file is set when it is written. */
+        if(tng_data->current_trajectory_frame_set_output_file_pos <= 0)
+        {
+            tng_data->current_trajectory_frame_set_output_file_pos = 1;
+        }
+        tng_data->n_trajectory_frame_sets++;
+        frame_set->first_frame = first_frame;
+        frame_set->n_frames = n_frames;
+        frame_set->n_written_frames = 0;
+        frame_set->n_unwritten_frames = 0;
+        frame_set->first_frame_time = -1;
+        return(TNG_SUCCESS);
+    }
+
+    curr_file_pos = ftello(tng_data->output_file);
+
+    if(curr_file_pos <= 10)
+    {
+        tng_file_headers_write(tng_data, TNG_USE_HASH);
+    }
+
+    /* Set pointer to previous frame set to the one that was loaded
+     * before.
+     * FIXME: This is a bit risky. If they are not added in order
+     * it will be wrong. */
+    if(tng_data->n_trajectory_frame_sets)
+    {
+        frame_set->prev_frame_set_file_pos =
+        tng_data->last_trajectory_frame_set_output_file_pos;
+    }
+
+    frame_set->next_frame_set_file_pos = -1;
+
+    tng_data->current_trajectory_frame_set_output_file_pos =
+    ftello(tng_data->output_file);
+
+    tng_data->n_trajectory_frame_sets++;
+
+    /* Set the medium range pointers */
+    if(tng_data->n_trajectory_frame_sets == tng_data->medium_stride_length + 1)
+    {
+        frame_set->medium_stride_prev_frame_set_file_pos =
+        tng_data->first_trajectory_frame_set_output_file_pos;
+    }
+    else if(tng_data->n_trajectory_frame_sets > tng_data->medium_stride_length + 1)
+    {
+        /* FIXME: Currently only working if the previous frame set has its
+         * medium stride pointer already set. This might need some fixing. */
+        if(frame_set->medium_stride_prev_frame_set_file_pos != -1 &&
+           frame_set->medium_stride_prev_frame_set_file_pos != 0)
+        {
+            tng_block_init(&block);
+            tng_data->input_file = tng_data->output_file;
 
             curr_file_pos = ftello(tng_data->output_file);
-            fseeko(tng_data->output_file,
-                   frame_set->medium_stride_prev_frame_set_file_pos,
-                   SEEK_SET);
+            tng_fseeko(tng_data, tng_data->output_file,
+                       frame_set->medium_stride_prev_frame_set_file_pos,
+                       SEEK_SET);
 
             if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
             {
@@ -12298,9 +16821,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_new
 
             /* Read the next frame set from the previous frame set and one
              * medium stride step back */
-            fseeko(tng_data->output_file, block->block_contents_size - (6 *
+            tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (6 *
             sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
-            if(fread(&frame_set->medium_stride_prev_frame_set_file_pos,
+            if(tng_fread(tng_data, &frame_set->medium_stride_prev_frame_set_file_pos,
                sizeof(frame_set->medium_stride_prev_frame_set_file_pos),
                1, tng_data->output_file) == 0)
             {
@@ -12339,9 +16862,9 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_new
                     tng_block_init(&block);
                     tng_data->input_file = tng_data->output_file;
 
-                    fseeko(tng_data->output_file,
-                           frame_set->long_stride_prev_frame_set_file_pos,
-                           SEEK_SET);
+                    tng_fseeko(tng_data, tng_data->output_file,
+                               frame_set->long_stride_prev_frame_set_file_pos,
+                               SEEK_SET);
 
                     if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
                     {
@@ -12354,12 +16877,12 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_new
 
                     /* Read the next frame set from the previous frame set and one
                     * long stride step back */
-                    fseeko(tng_data->output_file, block->block_contents_size - (6 *
-                          sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+                    tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size - (6 *
+                              sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
                     tng_block_destroy(&block);
 
-                    if(fread(&frame_set->long_stride_prev_frame_set_file_pos,
+                    if(tng_fread(tng_data, &frame_set->long_stride_prev_frame_set_file_pos,
                     sizeof(frame_set->long_stride_prev_frame_set_file_pos),
                     1, tng_data->output_file) == 0)
                     {
@@ -12383,7 +16906,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_new
             }
 
             tng_data->input_file = temp;
-            fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+            tng_fseeko(tng_data, tng_data->output_file, curr_file_pos, SEEK_SET);
         }
     }
 
@@ -12480,7 +17003,7 @@ tng_function_status DECLSPECDLLEXPORT tng_first_frame_nr_of_next_frame_set_get
         return(TNG_FAILURE);
     }
 
-    fseeko(tng_data->input_file, next_frame_set_file_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, next_frame_set_file_pos, SEEK_SET);
     /* Read block headers first to see that a frame set block is found. */
     tng_block_init(&block);
     stat = tng_block_header_read(tng_data, block);
@@ -12488,6 +17011,7 @@ tng_function_status DECLSPECDLLEXPORT tng_first_frame_nr_of_next_frame_set_get
     {
         fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
                file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
         return(TNG_CRITICAL);
     }
 /*    if(tng_data->current_trajectory_frame_set_input_file_pos <= 0)
@@ -12496,13 +17020,19 @@ tng_function_status DECLSPECDLLEXPORT tng_first_frame_nr_of_next_frame_set_get
     }*/
     tng_block_destroy(&block);
 
-    if(fread(frame, sizeof(int64_t), 1, tng_data->input_file) == 0)
+    if(tng_fread(tng_data, frame, sizeof(int64_t), 1, tng_data->input_file) == 0)
     {
         fprintf(stderr, "TNG library: Cannot read first frame of next frame set. %s: %d\n",
                __FILE__, __LINE__);
         return(TNG_CRITICAL);
     }
-    fseeko(tng_data->input_file, file_pos, SEEK_SET);
+    if(tng_data->input_endianness_swap_func_64 &&
+       tng_data->input_endianness_swap_func_64(tng_data, (uint64_t *)frame) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                __FILE__, __LINE__);
+    }
+    tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
 
     return(TNG_SUCCESS);
 }
@@ -12854,2455 +17384,4391 @@ tng_function_status DECLSPECDLLEXPORT tng_data_block_name_get
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
-    stat = tng_particle_data_find(tng_data, block_id, &data);
-    if(stat == TNG_SUCCESS)
+    stat = tng_particle_data_find(tng_data, block_id, &data);
+    if(stat == TNG_SUCCESS)
+    {
+        block_type = TNG_PARTICLE_BLOCK_DATA;
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, block_id, &data);
+        if(stat == TNG_SUCCESS)
+        {
+            block_type = TNG_NON_PARTICLE_BLOCK_DATA;
+        }
+        else
+        {
+            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+            if(stat != TNG_SUCCESS)
+            {
+                return(stat);
+            }
+            stat = tng_particle_data_find(tng_data, block_id, &data);
+            if(stat == TNG_SUCCESS)
+            {
+                block_type = TNG_PARTICLE_BLOCK_DATA;
+            }
+            else
+            {
+                stat = tng_data_find(tng_data, block_id, &data);
+                if(stat == TNG_SUCCESS)
+                {
+                    block_type = TNG_NON_PARTICLE_BLOCK_DATA;
+                }
+            }
+        }
+    }
+    if(block_type == TNG_PARTICLE_BLOCK_DATA)
+    {
+        for(i = 0; i < frame_set->n_particle_data_blocks; i++)
+        {
+            data = &frame_set->tr_particle_data[i];
+            if(data->block_id == block_id)
+            {
+                strncpy(name, data->block_name, max_len);
+                name[max_len - 1] = '\0';
+                return(TNG_SUCCESS);
+            }
+        }
+    }
+    else if(block_type == TNG_NON_PARTICLE_BLOCK_DATA)
+    {
+        for(i = 0; i < frame_set->n_data_blocks; i++)
+        {
+            data = &frame_set->tr_data[i];
+            if(data->block_id == block_id)
+            {
+                strncpy(name, data->block_name, max_len);
+                name[max_len - 1] = '\0';
+                return(TNG_SUCCESS);
+            }
+        }
+    }
+
+    return(TNG_FAILURE);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_block_dependency_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 int *block_dependency)
+{
+    int64_t i;
+    tng_function_status stat;
+    tng_data_t data;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(block_dependency, "TNG library: block_dependency must not be a NULL pointer.");
+
+    for(i = 0; i < tng_data->n_particle_data_blocks; i++)
+    {
+        data = &tng_data->non_tr_particle_data[i];
+        if(data->block_id == block_id)
+        {
+            *block_dependency = TNG_PARTICLE_DEPENDENT;
+            return(TNG_SUCCESS);
+        }
+    }
+    for(i = 0; i < tng_data->n_data_blocks; i++)
+    {
+        data = &tng_data->non_tr_data[i];
+        if(data->block_id == block_id)
+        {
+            *block_dependency = 0;
+            return(TNG_SUCCESS);
+        }
+    }
+
+    stat = tng_particle_data_find(tng_data, block_id, &data);
+    if(stat == TNG_SUCCESS)
+    {
+        *block_dependency = TNG_PARTICLE_DEPENDENT + TNG_FRAME_DEPENDENT;
+        return(TNG_SUCCESS);
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, block_id, &data);
+        if(stat == TNG_SUCCESS)
+        {
+            *block_dependency = TNG_FRAME_DEPENDENT;
+            return(TNG_SUCCESS);
+        }
+        else
+        {
+            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+            if(stat != TNG_SUCCESS)
+            {
+                return(stat);
+            }
+            stat = tng_particle_data_find(tng_data, block_id, &data);
+            if(stat == TNG_SUCCESS)
+            {
+                *block_dependency = TNG_PARTICLE_DEPENDENT + TNG_FRAME_DEPENDENT;
+                return(TNG_SUCCESS);
+            }
+            else
+            {
+                stat = tng_data_find(tng_data, block_id, &data);
+                if(stat == TNG_SUCCESS)
+                {
+                    *block_dependency = TNG_FRAME_DEPENDENT;
+                    return(TNG_SUCCESS);
+                }
+            }
+        }
+    }
+
+    return(TNG_FAILURE);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_block_num_values_per_frame_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 int64_t *n_values_per_frame)
+{
+    int64_t i;
+    tng_function_status stat;
+    tng_data_t data;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+
+    for(i = 0; i < tng_data->n_particle_data_blocks; i++)
+    {
+        data = &tng_data->non_tr_particle_data[i];
+        if(data->block_id == block_id)
+        {
+            *n_values_per_frame = data->n_values_per_frame;
+            return(TNG_SUCCESS);
+        }
+    }
+    for(i = 0; i < tng_data->n_data_blocks; i++)
+    {
+        data = &tng_data->non_tr_data[i];
+        if(data->block_id == block_id)
+        {
+            *n_values_per_frame = data->n_values_per_frame;
+            return(TNG_SUCCESS);
+        }
+    }
+
+    stat = tng_particle_data_find(tng_data, block_id, &data);
+    if(stat == TNG_SUCCESS)
+    {
+        *n_values_per_frame = data->n_values_per_frame;
+        return(TNG_SUCCESS);
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, block_id, &data);
+        if(stat == TNG_SUCCESS)
+        {
+            *n_values_per_frame = data->n_values_per_frame;
+            return(TNG_SUCCESS);
+        }
+        else
+        {
+            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+            if(stat != TNG_SUCCESS)
+            {
+                return(stat);
+            }
+            stat = tng_particle_data_find(tng_data, block_id, &data);
+            if(stat == TNG_SUCCESS)
+            {
+                *n_values_per_frame = data->n_values_per_frame;
+                return(TNG_SUCCESS);
+            }
+            else
+            {
+                stat = tng_data_find(tng_data, block_id, &data);
+                if(stat == TNG_SUCCESS)
+                {
+                    *n_values_per_frame = data->n_values_per_frame;
+                    return(TNG_SUCCESS);
+                }
+            }
+        }
+    }
+
+    return(TNG_FAILURE);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_n_frames_of_data_block_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 int64_t *n_frames)
+{
+    tng_gen_block_t block;
+    tng_function_status stat;
+    char datatype, dependency, sparse_data;
+    int64_t n_values, codec_id, first_frame_with_data, stride_length, curr_n_frames;
+    int64_t num_first_particle, block_n_particles;
+    double multiplier;
+    md5_state_t md5_state;
+    int found = TNG_FALSE;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    tng_block_init(&block);
+
+    stat = tng_block_header_read(tng_data, block);
+    /* If the block header could not be read the reading position might not have been
+     * at the start of a block. Try again from the file position of the current frame
+     * set. */
+    if(stat != TNG_SUCCESS)
+    {
+        tng_fseeko(tng_data, tng_data->input_file, tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
+        stat = tng_block_header_read(tng_data, block);
+        if(stat != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return(stat);
+        }
+    }
+    if(block->id == TNG_TRAJECTORY_FRAME_SET)
+    {
+        stat = tng_block_read_next(tng_data, block, TNG_SKIP_HASH);
+        if(stat != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return(stat);
+        }
+        stat = tng_block_header_read(tng_data, block);
+    }
+    while(stat == TNG_SUCCESS && block->id != TNG_TRAJECTORY_FRAME_SET && found == TNG_FALSE)
+    {
+        if(block->id == block_id)
+        {
+            stat = tng_data_block_meta_information_read(tng_data, &datatype,
+                                                        &dependency, &sparse_data,
+                                                        &n_values, &codec_id,
+                                                        &first_frame_with_data,
+                                                        &stride_length, &curr_n_frames,
+                                                        &num_first_particle,
+                                                        &block_n_particles,
+                                                        &multiplier, TNG_SKIP_HASH,
+                                                        &md5_state);
+            if(stat == TNG_SUCCESS)
+            {
+                found = TNG_TRUE;
+            }
+        }
+        else
+        {
+            tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
+            stat = tng_block_header_read(tng_data, block);
+        }
+    }
+    if(found == TNG_TRUE)
+    {
+        *n_frames = (tng_data->current_trajectory_frame_set.n_frames -
+                     (tng_data->current_trajectory_frame_set.first_frame - first_frame_with_data)) / stride_length;
+    }
+    else if(stat == TNG_SUCCESS)
+    {
+        *n_frames = 0;
+    }
+
+    tng_block_destroy(&block);
+
+    return(stat);
+}
+
+static tng_function_status tng_frame_gen_data_write
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t block_id,
+                 const tng_bool is_particle_data,
+                 const int64_t val_first_particle,
+                 const int64_t val_n_particles,
+                 const void *values,
+                 const char hash_mode)
+{
+    int64_t header_pos, file_pos, tot_n_particles;
+    int64_t output_file_len, n_values_per_frame, size, contents_size;
+    int64_t header_size, temp_first, temp_last;
+    int64_t mapping_block_end_pos, num_first_particle, block_n_particles;
+    int64_t last_frame, temp_current, write_n_particles;
+    tng_gen_block_t block;
+    tng_trajectory_frame_set_t frame_set;
+    FILE *temp = tng_data->input_file;
+    struct tng_data data;
+    tng_function_status stat;
+    tng_particle_mapping_t mapping;
+    char dependency, sparse_data, datatype;
+    void *copy;
+
+    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    temp_first = tng_data->first_trajectory_frame_set_input_file_pos;
+    temp_last = tng_data->last_trajectory_frame_set_input_file_pos;
+    temp_current = tng_data->current_trajectory_frame_set_input_file_pos;
+    tng_data->first_trajectory_frame_set_input_file_pos =
+    tng_data->first_trajectory_frame_set_output_file_pos;
+    tng_data->last_trajectory_frame_set_input_file_pos =
+    tng_data->last_trajectory_frame_set_output_file_pos;
+    tng_data->current_trajectory_frame_set_input_file_pos =
+    tng_data->current_trajectory_frame_set_output_file_pos;
+
+    tng_data->input_file = tng_data->output_file;
+
+    stat = tng_frame_set_of_frame_find(tng_data, frame_nr);
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    if(stat != TNG_SUCCESS)
+    {
+        last_frame = frame_set->first_frame +
+                     frame_set->n_frames - 1;
+        /* If the wanted frame would be in the frame set after the last
+            * frame set create a new frame set. */
+        if(stat == TNG_FAILURE &&
+            last_frame < frame_nr)
+/*           (last_frame < frame_nr &&
+            tng_data->current_trajectory_frame_set.first_frame +
+            tng_data->frame_set_n_frames >= frame_nr))*/
+        {
+            if(last_frame + tng_data->frame_set_n_frames < frame_nr)
+            {
+                last_frame = frame_nr - 1;
+            }
+            tng_frame_set_new(tng_data,
+                              last_frame+1,
+                              tng_data->frame_set_n_frames);
+            file_pos = ftello(tng_data->output_file);
+            tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_END);
+            output_file_len = ftello(tng_data->output_file);
+            tng_fseeko(tng_data, tng_data->output_file, file_pos, SEEK_SET);
+
+            /* Read mapping blocks from the last frame set */
+            tng_block_init(&block);
+
+            stat = tng_block_header_read(tng_data, block);
+            while(file_pos < output_file_len &&
+                  stat != TNG_CRITICAL &&
+                  block->id != TNG_TRAJECTORY_FRAME_SET &&
+                  block->id != -1)
+            {
+                if(block->id == TNG_PARTICLE_MAPPING)
+                {
+                    tng_trajectory_mapping_block_read(tng_data, block,
+                                                      hash_mode);
+                }
+                else
+                {
+                    tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size,
+                            SEEK_CUR);
+                }
+                file_pos = ftello(tng_data->output_file);
+                if(file_pos < output_file_len)
+                {
+                    stat = tng_block_header_read(tng_data, block);
+                }
+            }
+
+            tng_block_destroy(&block);
+            /* Write the frame set to disk */
+            if(tng_frame_set_write(tng_data, hash_mode) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Error writing frame set. %s: %d\n", __FILE__, __LINE__);
+                return(TNG_CRITICAL);
+            }
+        }
+        else
+        {
+            tng_data->input_file = temp;
+            tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+            tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+            tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+            return(stat);
+        }
+    }
+
+    tng_block_init(&block);
+
+    file_pos = tng_data->current_trajectory_frame_set_output_file_pos;
+
+    tng_fseeko(tng_data, tng_data->output_file, 0, SEEK_END);
+    output_file_len = ftello(tng_data->output_file);
+    tng_fseeko(tng_data, tng_data->output_file, file_pos, SEEK_SET);
+
+    /* Read past the frame set block first */
+    stat = tng_block_header_read(tng_data, block);
+    if(stat == TNG_CRITICAL)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+               file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        tng_data->input_file = temp;
+
+        tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+        tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+        tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+        return(stat);
+    }
+    tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size,
+                SEEK_CUR);
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        if(tng_data->var_num_atoms_flag)
+        {
+            tot_n_particles = frame_set->n_particles;
+        }
+        else
+        {
+            tot_n_particles = tng_data->n_particles;
+        }
+
+        if(val_n_particles < tot_n_particles)
+        {
+            mapping_block_end_pos = -1;
+            /* Read all mapping blocks to find the right place to put the data */
+            stat = tng_block_header_read(tng_data, block);
+            while(file_pos < output_file_len &&
+                    stat != TNG_CRITICAL &&
+                    block->id != TNG_TRAJECTORY_FRAME_SET &&
+                    block->id != -1)
+            {
+                if(block->id == TNG_PARTICLE_MAPPING)
+                {
+                    tng_trajectory_mapping_block_read(tng_data, block, hash_mode);
+                }
+                else
+                {
+                    tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size,
+                               SEEK_CUR);
+                }
+                file_pos = ftello(tng_data->output_file);
+                if(block->id == TNG_PARTICLE_MAPPING)
+                {
+                    mapping = &frame_set->mappings[frame_set->n_mapping_blocks - 1];
+                    if(val_first_particle >= mapping->num_first_particle &&
+                       val_first_particle < mapping->num_first_particle +
+                       mapping->n_particles &&
+                       val_first_particle + val_n_particles <=
+                       mapping->num_first_particle + mapping->n_particles)
+                    {
+                        mapping_block_end_pos = file_pos;
+                    }
+                }
+                if(file_pos < output_file_len)
+                {
+                    stat = tng_block_header_read(tng_data, block);
+                }
+            }
+            if(stat == TNG_CRITICAL)
+            {
+                fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                       file_pos, __FILE__, __LINE__);
+                tng_block_destroy(&block);
+                tng_data->input_file = temp;
+
+                tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+                tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+                tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+                return(stat);
+            }
+            if(mapping_block_end_pos < 0)
+            {
+                tng_block_destroy(&block);
+                tng_data->input_file = temp;
+
+                tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+                tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+                tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+                return(TNG_FAILURE);
+            }
+            tng_fseeko(tng_data, tng_data->output_file, mapping_block_end_pos, SEEK_SET);
+        }
+    }
+
+    /* Read all block headers until next frame set block or
+     * until the wanted block id is found */
+    stat = tng_block_header_read(tng_data, block);
+    while(file_pos < output_file_len &&
+            stat != TNG_CRITICAL &&
+            block->id != block_id &&
+            (is_particle_data != TNG_TRUE || block->id != TNG_PARTICLE_MAPPING) &&
+            block->id != TNG_TRAJECTORY_FRAME_SET &&
+            block->id != -1)
+    {
+        tng_fseeko(tng_data, tng_data->output_file, block->block_contents_size, SEEK_CUR);
+        file_pos = ftello(tng_data->output_file);
+        if(file_pos < output_file_len)
+        {
+            stat = tng_block_header_read(tng_data, block);
+        }
+    }
+    if(stat == TNG_CRITICAL)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+               file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        tng_data->input_file = temp;
+        tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+        tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+        tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+        return(stat);
+    }
+
+    contents_size = block->block_contents_size;
+    header_size = block->header_contents_size;
+
+    header_pos = ftello(tng_data->output_file) - header_size;
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    if(tng_file_input_numerical(tng_data, &datatype,
+                                 sizeof(datatype),
+                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+    if(tng_file_input_numerical(tng_data, &dependency,
+                                 sizeof(dependency),
+                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+    data.datatype = datatype;
+
+    if(!(dependency & TNG_FRAME_DEPENDENT) ||
+       (is_particle_data == TNG_FALSE && dependency & TNG_PARTICLE_DEPENDENT) ||
+       (is_particle_data == TNG_TRUE && !(dependency & TNG_PARTICLE_DEPENDENT)))
+    {
+        tng_block_destroy(&block);
+        tng_data->input_file = temp;
+
+        tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+        tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+        tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+        return(TNG_FAILURE);
+    }
+
+    if(tng_file_input_numerical(tng_data, &sparse_data,
+                                 sizeof(sparse_data),
+                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    if(tng_file_input_numerical(tng_data, &data.n_values_per_frame,
+                                 sizeof(data.n_values_per_frame),
+                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    if(tng_file_input_numerical(tng_data, &data.codec_id,
+                                 sizeof(data.codec_id),
+                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    {
+        tng_block_destroy(&block);
+        return(TNG_CRITICAL);
+    }
+
+    if(data.codec_id != TNG_UNCOMPRESSED)
+    {
+        if(tng_file_input_numerical(tng_data, &data.compression_multiplier,
+                                     sizeof(data.compression_multiplier),
+                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+    }
+    else
+    {
+        data.compression_multiplier = 1;
+    }
+
+    if(sparse_data)
+    {
+        if(tng_file_input_numerical(tng_data, &data.first_frame_with_data,
+                                     sizeof(data.first_frame_with_data),
+                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+
+        if(tng_file_input_numerical(tng_data, &data.stride_length,
+                                     sizeof(data.stride_length),
+                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+    }
+    else
+    {
+        data.first_frame_with_data = 0;
+        data.stride_length = 1;
+    }
+    data.n_frames = tng_data->current_trajectory_frame_set.n_frames;
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        if(tng_file_input_numerical(tng_data, &num_first_particle,
+                                     sizeof(num_first_particle),
+                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+
+        if(tng_file_input_numerical(tng_data, &block_n_particles,
+                                     sizeof(block_n_particles),
+                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+    }
+
+    tng_data->input_file = temp;
+
+    tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
+    tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
+    tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+
+    switch(data.datatype)
+    {
+        case(TNG_INT_DATA):
+            size = sizeof(int64_t);
+            break;
+        case(TNG_FLOAT_DATA):
+            size = sizeof(float);
+            break;
+        case(TNG_DOUBLE_DATA):
+            size = sizeof(double);
+            break;
+        default:
+            fprintf(stderr, "TNG library: Cannot calculate writing locations. %s: %d.\n", __FILE__,
+                   __LINE__);
+            tng_block_destroy(&block);
+            return(TNG_FAILURE);
+    }
+
+    n_values_per_frame = data.n_values_per_frame;
+
+    file_pos = (frame_nr - tng_max_i64(frame_set->first_frame,
+                               data.first_frame_with_data)) /
+                data.stride_length;
+    if(is_particle_data == TNG_TRUE)
+    {
+        file_pos *= block_n_particles * size * n_values_per_frame;
+    }
+    else
+    {
+        file_pos *= size * n_values_per_frame;
+    }
+
+    if(file_pos > contents_size)
+    {
+        fprintf(stderr, "TNG library: Attempting to write outside the block. %s: %d\n", __FILE__,
+               __LINE__);
+        tng_block_destroy(&block);
+        return(TNG_FAILURE);
+    }
+
+    tng_fseeko(tng_data, tng_data->output_file, file_pos, SEEK_CUR);
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        write_n_particles = val_n_particles;
+    }
+    else
+    {
+        write_n_particles = 1;
+    }
+
+    /* If the endianness is not big endian the data needs to be swapped */
+    if((data.datatype == TNG_INT_DATA ||
+        data.datatype == TNG_DOUBLE_DATA) &&
+       tng_data->output_endianness_swap_func_64)
+    {
+        copy = (char *)malloc(write_n_particles * n_values_per_frame * size);
+        memcpy(copy, values, write_n_particles * n_values_per_frame * size);
+        if(tng_swap_byte_order_array_64(tng_data, tng_data->output_endianness_swap_func_64,
+                                        copy, write_n_particles * n_values_per_frame)
+           != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                    __FILE__, __LINE__);
+        }
+        tng_fwrite(tng_data, copy, write_n_particles * n_values_per_frame, size,
+                   tng_data->output_file);
+        free(copy);
+    }
+    else if(data.datatype == TNG_FLOAT_DATA &&
+            tng_data->output_endianness_swap_func_32)
+    {
+        copy = (char *)malloc(write_n_particles * n_values_per_frame * size);
+        memcpy(copy, values, write_n_particles * n_values_per_frame * size);
+        if(tng_swap_byte_order_array_32(tng_data, tng_data->output_endianness_swap_func_32,
+                                        copy, write_n_particles * n_values_per_frame)
+           != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                    __FILE__, __LINE__);
+        }
+        tng_fwrite(tng_data, copy, write_n_particles * n_values_per_frame, size,
+                   tng_data->output_file);
+        free(copy);
+    }
+
+    else
+    {
+        tng_fwrite(tng_data, values, write_n_particles * n_values_per_frame, size, tng_data->output_file);
+    }
+
+    fflush(tng_data->output_file);
+
+    /* Update the number of written frames in the frame set. */
+    if(frame_nr - frame_set->first_frame + 1 > frame_set->n_written_frames)
+    {
+        frame_set->n_written_frames = frame_nr - frame_set->first_frame + 1;
+    }
+
+    /* If the last frame has been written update the hash */
+    if(hash_mode == TNG_USE_HASH && (frame_nr + data.stride_length -
+       data.first_frame_with_data) >=
+       frame_set->n_frames)
+    {
+        tng_md5_hash_update(tng_data, block, header_pos, header_pos +
+                            header_size);
+    }
+
+    tng_block_destroy(&block);
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_data_write
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t block_id,
+                 const void *values,
+                 const char hash_mode)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(frame_nr >= 0, "TNG library: frame_nr must be >= 0.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
+
+    /* This is now just calling the generic data writing function. This
+     * function must keep its signature to let the API be backwards
+     * compatible. */
+    return(tng_frame_gen_data_write(tng_data, frame_nr, block_id,
+                                    TNG_FALSE, 0, 0, values, hash_mode));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_particle_data_write
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t block_id,
+                 const int64_t val_first_particle,
+                 const int64_t val_n_particles,
+                 const void *values,
+                 const char hash_mode)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(frame_nr >= 0, "TNG library: frame_nr must be >= 0.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
+    TNG_ASSERT(val_first_particle >= 0, "TNG library: val_first_particle must be >= 0.");
+    TNG_ASSERT(val_n_particles >= 0, "TNG library: val_n_particles must be >= 0.");
+
+    /* This is now just calling the generic data writing function. This
+     * function must keep its signature to let the API be backwards
+     * compatible. */
+    return(tng_frame_gen_data_write(tng_data, frame_nr, block_id,
+                                    TNG_TRUE, val_first_particle, val_n_particles,
+                                    values, hash_mode));
+}
+
+static tng_function_status tng_data_values_alloc
+                (const tng_trajectory_t tng_data,
+                 union data_values ***values,
+                 const int64_t n_frames,
+                 const int64_t n_values_per_frame,
+                 const char type)
+{
+    int64_t i;
+    tng_function_status stat;
+
+    if(n_frames <= 0 || n_values_per_frame <= 0)
+    {
+        return(TNG_FAILURE);
+    }
+
+    if(*values)
+    {
+        stat = tng_data_values_free(tng_data, *values, n_frames,
+                                    n_values_per_frame,
+                                    type);
+        if(stat != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot free particle data values. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(stat);
+        }
+    }
+    *values = (union data_values **)malloc(sizeof(union data_values *) * n_frames);
+    if(!*values)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+
+    }
+
+    for(i = 0; i < n_frames; i++)
+    {
+        (*values)[i] = (union data_values *)malloc(sizeof(union data_values) *
+                           n_values_per_frame);
+        if(!(*values)[i])
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(values);
+            values = 0;
+            return(TNG_CRITICAL);
+        }
+    }
+    return(TNG_SUCCESS);
+}
+
+/* FIXME: This needs ***values */
+tng_function_status DECLSPECDLLEXPORT tng_data_values_free
+                (const tng_trajectory_t tng_data,
+                 union data_values **values,
+                 const int64_t n_frames,
+                 const int64_t n_values_per_frame,
+                 const char type)
+{
+    int64_t i, j;
+    (void)tng_data;
+
+    if(values)
+    {
+        for(i = 0; i < n_frames; i++)
+        {
+            if(values[i])
+            {
+                if(type == TNG_CHAR_DATA)
+                {
+                    for(j = 0; j < n_values_per_frame; j++)
+                    {
+                        if(values[i][j].c)
+                        {
+                            free(values[i][j].c);
+                            values[i][j].c = 0;
+                        }
+                    }
+                }
+                free(values[i]);
+                values[i] = 0;
+            }
+        }
+        free(values);
+        values = 0;
+    }
+
+    return(TNG_SUCCESS);
+}
+
+static tng_function_status tng_particle_data_values_alloc
+                (const tng_trajectory_t tng_data,
+                 union data_values ****values,
+                 const int64_t n_frames,
+                 const int64_t n_particles,
+                 const int64_t n_values_per_frame,
+                 const char type)
+{
+    int64_t i, j;
+    tng_function_status stat;
+
+    if(n_particles == 0 || n_values_per_frame == 0)
+    {
+        return(TNG_FAILURE);
+    }
+
+    if(*values)
+    {
+        stat = tng_particle_data_values_free(tng_data, *values, n_frames,
+                                             n_particles, n_values_per_frame,
+                                             type);
+        if(stat != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot free particle data values. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(stat);
+        }
+    }
+    *values = (union data_values ***)malloc(sizeof(union data_values **) * n_frames);
+    if(!*values)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+
+    }
+
+    for(i = 0; i < n_frames; i++)
+    {
+        (*values)[i] = (union data_values **)malloc(sizeof(union data_values *) *
+                           n_particles);
+        if(!(*values)[i])
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(*values);
+            *values = 0;
+            return(TNG_CRITICAL);
+        }
+        for(j = 0; j < n_particles; j++)
+        {
+            (*values)[i][j] = (union data_values *)malloc(sizeof(union data_values) *
+                                  n_values_per_frame);
+            if(!(*values)[i][j])
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                tng_particle_data_values_free(tng_data, *values, n_frames,
+                                              n_particles, n_values_per_frame,
+                                              type);
+                *values = 0;
+                return(TNG_CRITICAL);
+            }
+        }
+    }
+    return(TNG_SUCCESS);
+}
+
+/* FIXME: This needs ****values */
+tng_function_status DECLSPECDLLEXPORT tng_particle_data_values_free
+                (const tng_trajectory_t tng_data,
+                 union data_values ***values,
+                 const int64_t n_frames,
+                 const int64_t n_particles,
+                 const int64_t n_values_per_frame,
+                 const char type)
+{
+    int64_t i, j, k;
+    (void)tng_data;
+
+    if(values)
+    {
+        for(i = 0; i < n_frames; i++)
+        {
+            if(values[i])
+            {
+                for(j = 0; j < n_particles; j++)
+                {
+                    if(type == TNG_CHAR_DATA)
+                    {
+                        for(k = 0; k < n_values_per_frame; k++)
+                        {
+                            if(values[i][j][k].c)
+                            {
+                                free(values[i][j][k].c);
+                                values[i][j][k].c = 0;
+                            }
+                        }
+                    }
+                    free(values[i][j]);
+                    values[i][j] = 0;
+                }
+                free(values[i]);
+                values[i] = 0;
+            }
+        }
+        free(values);
+        values = 0;
+    }
+
+    return(TNG_SUCCESS);
+}
+
+static tng_function_status tng_gen_data_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const tng_bool is_particle_data,
+                 union data_values ****values,
+                 int64_t *n_frames,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type)
+{
+    int64_t i, j, k, mapping, file_pos, i_step, block_index;
+    const int64_t *mapping_table;
+    int size;
+    size_t len;
+    tng_data_t data;
+    tng_trajectory_frame_set_t frame_set;
+    tng_gen_block_t block;
+    char block_type_flag;
+    tng_function_status stat;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    block_index = -1;
+    data = 0;
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, block_id, &data);
+    }
+
+    if(tng_data->current_trajectory_frame_set_input_file_pos > 0)
+    {
+        block_type_flag = TNG_TRAJECTORY_BLOCK;
+    }
+    else
+    {
+        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+    }
+
+    if(stat != TNG_SUCCESS)
+    {
+        tng_block_init(&block);
+        file_pos = ftello(tng_data->input_file);
+        /* Read all blocks until next frame set block */
+        stat = tng_block_header_read(tng_data, block);
+        while(file_pos < tng_data->input_file_len &&
+                stat != TNG_CRITICAL &&
+                block->id != TNG_TRAJECTORY_FRAME_SET &&
+                block->id != -1)
+        {
+            /* Use hash by default */
+            stat = tng_block_read_next(tng_data, block,
+                                    TNG_USE_HASH);
+            if(stat != TNG_CRITICAL)
+            {
+                file_pos = ftello(tng_data->input_file);
+                if(file_pos < tng_data->input_file_len)
+                {
+                    stat = tng_block_header_read(tng_data, block);
+                }
+            }
+        }
+        tng_block_destroy(&block);
+        if(stat == TNG_CRITICAL)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    file_pos, __FILE__, __LINE__);
+            return(stat);
+        }
+
+        if(is_particle_data == TNG_TRUE)
+        {
+            for(i = 0; i < frame_set->n_particle_data_blocks; i++)
+            {
+                data = &frame_set->tr_particle_data[i];
+                if(data->block_id == block_id)
+                {
+                    block_index = i;
+                    block_type_flag = TNG_TRAJECTORY_BLOCK;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            for(i = 0; i < frame_set->n_data_blocks; i++)
+            {
+                data = &frame_set->tr_data[i];
+                if(data->block_id == block_id)
+                {
+                    block_index = i;
+                    break;
+                }
+            }
+        }
+        if(block_index < 0)
+        {
+            return(TNG_FAILURE);
+        }
+    }
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        if(block_type_flag == TNG_TRAJECTORY_BLOCK &&
+           tng_data->var_num_atoms_flag)
+        {
+            *n_particles = frame_set->n_particles;
+        }
+        else
+        {
+            *n_particles = tng_data->n_particles;
+        }
+    }
+
+    *n_frames = tng_max_i64(1, data->n_frames);
+    *n_values_per_frame = data->n_values_per_frame;
+    *type = data->datatype;
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        if(*values == 0)
+        {
+            if(tng_particle_data_values_alloc(tng_data, values, *n_frames,
+                                             *n_particles, *n_values_per_frame,
+                                             *type) != TNG_SUCCESS)
+            {
+                return(TNG_CRITICAL);
+            }
+        }
+
+        if(tng_particle_mapping_table_get(frame_set, *n_particles,
+                                          &mapping_table) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+
+        i_step = (*n_particles) * (*n_values_per_frame);
+
+        /* It's not very elegant to reuse so much of the code in the different case
+         * statements, but it's unnecessarily slow to have the switch-case block
+         * inside the for loops. */
+        switch(*type)
+        {
+        case TNG_CHAR_DATA:
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k = 0; k < *n_values_per_frame; k++)
+                    {
+                        len = strlen(data->strings[i][j][k]) + 1;
+                        (*values)[i][mapping][k].c = (char *)malloc(len);
+                        strncpy((*values)[i][mapping][k].c,
+                                data->strings[i][j][k], len);
+                    }
+                }
+            }
+            break;
+        case TNG_INT_DATA:
+            size = sizeof(int);
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k = 0; k < *n_values_per_frame; k++)
+                    {
+                        (*values)[i][mapping][k].i = *(int *)
+                                                     ((char *)data->values + size *
+                                                     (i * i_step + j *
+                                                      (*n_values_per_frame) + k));
+                    }
+                }
+            }
+            break;
+        case TNG_FLOAT_DATA:
+            size = sizeof(float);
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k = 0; k < *n_values_per_frame; k++)
+                    {
+                        (*values)[i][mapping][k].f = *(float *)
+                                                     ((char *)data->values + size *
+                                                     (i * i_step + j *
+                                                      (*n_values_per_frame) + k));
+                    }
+                }
+            }
+            break;
+        case TNG_DOUBLE_DATA:
+        default:
+            size = sizeof(double);
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k = 0; k < *n_values_per_frame; k++)
+                    {
+                        (*values)[i][mapping][k].d = *(double *)
+                                                     ((char *)data->values + size *
+                                                     (i * i_step + j *
+                                                      (*n_values_per_frame) + k));
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        if(*(values[0]) == 0)
+        {
+            if(tng_data_values_alloc(tng_data, values[0], *n_frames,
+                                     *n_values_per_frame,
+                                     *type) != TNG_SUCCESS)
+            {
+                return(TNG_CRITICAL);
+            }
+        }
+        switch(*type)
+        {
+        case TNG_CHAR_DATA:
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    len = strlen(data->strings[0][i][j]) + 1;
+                    (*values)[0][i][j].c = (char *)malloc(len);
+                    strncpy((*values)[0][i][j].c, data->strings[0][i][j], len);
+                }
+            }
+            break;
+        case TNG_INT_DATA:
+            size = sizeof(int);
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    (*values)[0][i][j].i = *(int *)((char *)data->values + size *
+                                                    (i*(*n_values_per_frame) + j));
+                }
+            }
+            break;
+        case TNG_FLOAT_DATA:
+            size = sizeof(float);
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    (*values)[0][i][j].f = *(float *)((char *)data->values + size *
+                                                   (i*(*n_values_per_frame) + j));
+                }
+            }
+            break;
+        case TNG_DOUBLE_DATA:
+        default:
+            size = sizeof(double);
+            for(i = 0; i < *n_frames; i++)
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    (*values)[0][i][j].d = *(double *)((char *)data->values + size *
+                                                       (i*(*n_values_per_frame) + j));
+                }
+            }
+        }
+    }
+
+    data->last_retrieved_frame = frame_set->first_frame + data->n_frames - 1;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 union data_values ***values,
+                 int64_t *n_frames,
+                 int64_t *n_values_per_frame,
+                 char *type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+
+    return(tng_gen_data_get(tng_data, block_id, TNG_FALSE, &values, n_frames, 0,
+                            n_values_per_frame, type));
+}
+
+static tng_function_status tng_gen_data_vector_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const tng_bool is_particle_data,
+                 void **values,
+                 int64_t *n_frames,
+                 int64_t *stride_length,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type)
+{
+    int64_t i, j, mapping, file_pos, i_step, full_data_len, n_frames_div;
+    int64_t block_index;
+    const int64_t *mapping_table;
+    int size;
+    tng_data_t data;
+    tng_trajectory_frame_set_t frame_set;
+    tng_gen_block_t block;
+    void *temp;
+    char block_type_flag;
+    tng_function_status stat;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    block_index = -1;
+    data = 0;
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, block_id, &data);
+    }
+
+    if(stat != TNG_SUCCESS)
+    {
+        tng_block_init(&block);
+        file_pos = ftello(tng_data->input_file);
+        /* Read all blocks until next frame set block */
+        stat = tng_block_header_read(tng_data, block);
+        while(file_pos < tng_data->input_file_len &&
+                stat != TNG_CRITICAL &&
+                block->id != TNG_TRAJECTORY_FRAME_SET &&
+                block->id != -1)
+        {
+            /* Use hash by default */
+            stat = tng_block_read_next(tng_data, block,
+                                    TNG_USE_HASH);
+            if(stat != TNG_CRITICAL)
+            {
+                file_pos = ftello(tng_data->input_file);
+                if(file_pos < tng_data->input_file_len)
+                {
+                    stat = tng_block_header_read(tng_data, block);
+                }
+            }
+        }
+        tng_block_destroy(&block);
+        if(stat == TNG_CRITICAL)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    file_pos, __FILE__, __LINE__);
+            return(stat);
+        }
+
+        for(i = 0; i < frame_set->n_particle_data_blocks; i++)
+        {
+            data = &frame_set->tr_particle_data[i];
+            if(data->block_id == block_id)
+            {
+                block_index = i;
+                break;
+            }
+        }
+        if(block_index < 0)
+        {
+            return(TNG_FAILURE);
+        }
+    }
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        if(tng_data->current_trajectory_frame_set_input_file_pos > 0)
+        {
+            block_type_flag = TNG_TRAJECTORY_BLOCK;
+        }
+        else
+        {
+            block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+        }
+
+       if(block_type_flag == TNG_TRAJECTORY_BLOCK &&
+          tng_data->var_num_atoms_flag)
+        {
+            *n_particles = frame_set->n_particles;
+        }
+        else
+        {
+            *n_particles = tng_data->n_particles;
+        }
+    }
+
+    *type = data->datatype;
+
+    switch(*type)
+    {
+    case TNG_CHAR_DATA:
+        return(TNG_FAILURE);
+    case TNG_INT_DATA:
+        size = sizeof(int64_t);
+        break;
+    case TNG_FLOAT_DATA:
+        size = sizeof(float);
+        break;
+    case TNG_DOUBLE_DATA:
+    default:
+        size = sizeof(double);
+    }
+
+    *n_frames = tng_max_i64(1, data->n_frames);
+    *n_values_per_frame = data->n_values_per_frame;
+    *stride_length = data->stride_length;
+
+    n_frames_div = (*n_frames % *stride_length) ?
+                   *n_frames / *stride_length + 1:
+                   *n_frames / *stride_length;
+
+    full_data_len = n_frames_div * size *
+                (*n_values_per_frame);
+    if(is_particle_data == TNG_TRUE)
+    {
+        full_data_len *= (*n_particles);
+    }
+
+    temp = (char *)realloc(*values, full_data_len);
+    if(!temp)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(*values);
+        *values = 0;
+        return(TNG_CRITICAL);
+    }
+
+    *values = temp;
+
+    if(is_particle_data != TNG_TRUE || frame_set->n_mapping_blocks <= 0)
+    {
+        memcpy(*values, data->values, full_data_len);
+    }
+    else
+    {
+        if(tng_particle_mapping_table_get(frame_set, *n_particles,
+                                          &mapping_table) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+
+        i_step = (*n_particles) * (*n_values_per_frame);
+        for(i = 0; i < *n_frames; i++)
+        {
+            for(j = 0; j < *n_particles; j++)
+            {
+                mapping = mapping_table ? mapping_table[j] : j;
+                memcpy(((char *)*values) + size * (i * i_step + mapping *
+                       (*n_values_per_frame)),
+                       (char *)data->values + size *
+                       (i * i_step + j * (*n_values_per_frame)),
+                       size * (*n_values_per_frame));
+            }
+        }
+    }
+
+    data->last_retrieved_frame = frame_set->first_frame + data->n_frames - 1;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_vector_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 void **values,
+                 int64_t *n_frames,
+                 int64_t *stride_length,
+                 int64_t *n_values_per_frame,
+                 char *type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+
+    return(tng_gen_data_vector_get(tng_data, block_id, TNG_FALSE, values,
+                                   n_frames, stride_length, 0, n_values_per_frame,
+                                   type));
+}
+
+static tng_function_status tng_gen_data_interval_get
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const tng_bool is_particle_data,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 union data_values ****values,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type)
+{
+    int64_t i, j, k, mapping, n_frames, file_pos, current_frame_pos, i_step;
+    int64_t first_frame, block_index;
+    const int64_t *mapping_table = 0;
+    int size;
+    size_t len;
+    tng_data_t data;
+    tng_trajectory_frame_set_t frame_set;
+    tng_gen_block_t block;
+    char block_type_flag;
+    tng_function_status stat;
+
+    block_index = -1;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+    first_frame = frame_set->first_frame;
+
+    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
+    if(stat != TNG_SUCCESS)
     {
-        block_type = TNG_PARTICLE_BLOCK_DATA;
+        return(stat);
     }
-    else
+
+    /* Do not re-read the frame set. */
+    if((is_particle_data == TNG_TRUE &&
+       (first_frame != frame_set->first_frame ||
+        frame_set->n_particle_data_blocks <= 0)) ||
+       (is_particle_data == TNG_FALSE &&
+       (first_frame != frame_set->first_frame ||
+        frame_set->n_data_blocks <= 0)))
     {
-        stat = tng_data_find(tng_data, block_id, &data);
-        if(stat == TNG_SUCCESS)
-        {
-            block_type = TNG_NON_PARTICLE_BLOCK_DATA;
-        }
-        else
+        tng_block_init(&block);
+        file_pos = ftello(tng_data->input_file);
+        /* Read all blocks until next frame set block */
+        stat = tng_block_header_read(tng_data, block);
+        while(file_pos < tng_data->input_file_len &&
+                stat != TNG_CRITICAL &&
+                block->id != TNG_TRAJECTORY_FRAME_SET &&
+                block->id != -1)
         {
-            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            if(stat != TNG_SUCCESS)
-            {
-                return(stat);
-            }
-            stat = tng_particle_data_find(tng_data, block_id, &data);
-            if(stat == TNG_SUCCESS)
-            {
-                block_type = TNG_PARTICLE_BLOCK_DATA;
-            }
-            else
+            stat = tng_block_read_next(tng_data, block,
+                                    hash_mode);
+            if(stat != TNG_CRITICAL)
             {
-                stat = tng_data_find(tng_data, block_id, &data);
-                if(stat == TNG_SUCCESS)
+                file_pos = ftello(tng_data->input_file);
+                if(file_pos < tng_data->input_file_len)
                 {
-                    block_type = TNG_NON_PARTICLE_BLOCK_DATA;
+                    stat = tng_block_header_read(tng_data, block);
                 }
             }
         }
+        tng_block_destroy(&block);
+        if(stat == TNG_CRITICAL)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    file_pos, __FILE__, __LINE__);
+            return(stat);
+        }
     }
-    if(block_type == TNG_PARTICLE_BLOCK_DATA)
+
+    /* See if there is already a data block of this ID.
+     * Start checking the last read frame set */
+    if(is_particle_data == TNG_TRUE)
     {
-        for(i = 0; i < frame_set->n_particle_data_blocks; i++)
+        for(i = frame_set->n_particle_data_blocks; i-- ;)
         {
             data = &frame_set->tr_particle_data[i];
             if(data->block_id == block_id)
             {
-                strncpy(name, data->block_name, max_len);
-                name[max_len - 1] = '\0';
-                return(TNG_SUCCESS);
+                block_index = i;
+                block_type_flag = TNG_TRAJECTORY_BLOCK;
+                break;
             }
         }
     }
-    else if(block_type == TNG_NON_PARTICLE_BLOCK_DATA)
+    else
     {
         for(i = 0; i < frame_set->n_data_blocks; i++)
         {
             data = &frame_set->tr_data[i];
             if(data->block_id == block_id)
             {
-                strncpy(name, data->block_name, max_len);
-                name[max_len - 1] = '\0';
-                return(TNG_SUCCESS);
+                block_index = i;
+                break;
             }
         }
     }
 
-    return(TNG_FAILURE);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_data_block_dependency_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 int *block_dependency)
-{
-    int64_t i;
-    tng_function_status stat;
-    tng_data_t data;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(block_dependency, "TNG library: block_dependency must not be a NULL pointer.");
+    if(block_index < 0)
+    {
+        fprintf(stderr, "TNG library: Could not find particle data block with id %" PRId64 ". %s: %d\n",
+                block_id, __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
 
-    for(i = 0; i < tng_data->n_particle_data_blocks; i++)
+    if(is_particle_data ==  TNG_TRUE)
     {
-        data = &tng_data->non_tr_particle_data[i];
-        if(data->block_id == block_id)
+        if(block_type_flag == TNG_TRAJECTORY_BLOCK &&
+           tng_data->var_num_atoms_flag)
         {
-            *block_dependency = TNG_PARTICLE_DEPENDENT;
-            return(TNG_SUCCESS);
+            *n_particles = frame_set->n_particles;
+        }
+        else
+        {
+            *n_particles = tng_data->n_particles;
         }
     }
-    for(i = 0; i < tng_data->n_data_blocks; i++)
+
+    n_frames = end_frame_nr - start_frame_nr + 1;
+    *n_values_per_frame = data->n_values_per_frame;
+    *type = data->datatype;
+
+    if(*values == 0)
     {
-        data = &tng_data->non_tr_data[i];
-        if(data->block_id == block_id)
+        if(is_particle_data == TNG_TRUE)
         {
-            *block_dependency = 0;
-            return(TNG_SUCCESS);
+            if(tng_particle_data_values_alloc(tng_data, values, n_frames,
+                                             *n_particles, *n_values_per_frame,
+                                             *type) != TNG_SUCCESS)
+            {
+                return(TNG_CRITICAL);
+            }
+        }
+        else
+        {
+            if(tng_data_values_alloc(tng_data, *values, n_frames,
+                                     *n_values_per_frame,
+                                     *type) != TNG_SUCCESS)
+            {
+                return(TNG_CRITICAL);
+            }
         }
     }
 
-    stat = tng_particle_data_find(tng_data, block_id, &data);
-    if(stat == TNG_SUCCESS)
+    current_frame_pos = start_frame_nr - frame_set->first_frame;
+
+    if(is_particle_data == TNG_TRUE)
     {
-        *block_dependency = TNG_PARTICLE_DEPENDENT + TNG_FRAME_DEPENDENT;
-        return(TNG_SUCCESS);
+        if(tng_particle_mapping_table_get(frame_set, *n_particles,
+                                          &mapping_table) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+        i_step = (*n_particles) * (*n_values_per_frame);
     }
     else
     {
-        stat = tng_data_find(tng_data, block_id, &data);
-        if(stat == TNG_SUCCESS)
+        i_step = (*n_values_per_frame);
+    }
+    /* It's not very elegant to reuse so much of the code in the different case
+     * statements, but it's unnecessarily slow to have the switch-case block
+     * inside the for loops. */
+    switch(*type)
+    {
+    case TNG_CHAR_DATA:
+        for(i=0; i<n_frames; i++)
         {
-            *block_dependency = TNG_FRAME_DEPENDENT;
-            return(TNG_SUCCESS);
+            if(current_frame_pos == frame_set->n_frames)
+            {
+                stat = tng_frame_set_read_next(tng_data, hash_mode);
+                if(stat != TNG_SUCCESS)
+                {
+                    return(stat);
+                }
+                current_frame_pos = 0;
+                if(is_particle_data == TNG_TRUE &&
+                   tng_particle_mapping_table_get(frame_set, *n_particles,
+                                                  &mapping_table) != TNG_SUCCESS)
+                {
+                    return(TNG_CRITICAL);
+                }
+            }
+            if(is_particle_data == TNG_TRUE)
+            {
+                for(j = 0; j < *n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k = 0; k < *n_values_per_frame; k++)
+                    {
+                        len = strlen(data->strings[current_frame_pos][j][k]) + 1;
+                        (*values)[i][mapping][k].c = (char *)malloc(len);
+                        strncpy((*values)[i][mapping][k].c, data->strings[current_frame_pos][j][k], len);
+                    }
+                }
+            }
+            else
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    len = strlen(data->strings[0][current_frame_pos][j]) + 1;
+                    (*values)[0][i][j].c = (char *)malloc(len);
+                    strncpy((*values)[0][i][j].c, data->strings[0][current_frame_pos][j], len);
+                }
+            }
+            current_frame_pos++;
+        }
+        break;
+    case TNG_INT_DATA:
+        size = sizeof(int);
+        for(i=0; i<n_frames; i++)
+        {
+            if(current_frame_pos == frame_set->n_frames)
+            {
+                stat = tng_frame_set_read_next(tng_data, hash_mode);
+                if(stat != TNG_SUCCESS)
+                {
+                    return(stat);
+                }
+                current_frame_pos = 0;
+                if(is_particle_data == TNG_TRUE &&
+                   tng_particle_mapping_table_get(frame_set, *n_particles,
+                                                  &mapping_table) != TNG_SUCCESS)
+                {
+                    return(TNG_CRITICAL);
+                }
+            }
+            if(is_particle_data == TNG_TRUE)
+            {
+                for(j = 0; j < *n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k = 0; k < *n_values_per_frame; k++)
+                    {
+                        (*values)[i][mapping][k].i = *(int *)
+                                                     ((char *)data->values + size *
+                                                      (current_frame_pos *
+                                                       i_step + j *
+                                                       (*n_values_per_frame) + k));
+                    }
+                }
+                current_frame_pos++;
+            }
+            else
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    (*values)[0][i][j].i = *(int *)((char *)data->values + size *
+                                                (current_frame_pos *
+                                                 i_step + j));
+                }
+            }
+        }
+        break;
+    case TNG_FLOAT_DATA:
+        size = sizeof(float);
+        for(i=0; i<n_frames; i++)
+        {
+            if(current_frame_pos == frame_set->n_frames)
+            {
+                stat = tng_frame_set_read_next(tng_data, hash_mode);
+                if(stat != TNG_SUCCESS)
+                {
+                    return(stat);
+                }
+                current_frame_pos = 0;
+                if(is_particle_data == TNG_TRUE &&
+                   tng_particle_mapping_table_get(frame_set, *n_particles,
+                                                  &mapping_table) != TNG_SUCCESS)
+                {
+                    return(TNG_CRITICAL);
+                }
+            }
+            if(is_particle_data == TNG_TRUE)
+            {
+                for(j=0; j<*n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k=0; k<*n_values_per_frame; k++)
+                    {
+                        (*values)[i][mapping][k].f = *(float *)
+                                                     ((char *)data->values + size *
+                                                      (current_frame_pos *
+                                                       i_step + j *
+                                                       (*n_values_per_frame) + k));
+                    }
+                }
+            }
+            else
+            {
+                for(j = 0; j < *n_values_per_frame; j++)
+                {
+                    (*values)[0][i][j].f = *(float *)((char *)data->values + size *
+                                                   (current_frame_pos *
+                                                    i_step + j));
+                }
+            }
+            current_frame_pos++;
         }
-        else
+        break;
+    case TNG_DOUBLE_DATA:
+    default:
+        size = sizeof(double);
+        for(i=0; i<n_frames; i++)
         {
-            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            if(stat != TNG_SUCCESS)
+            if(current_frame_pos == frame_set->n_frames)
             {
-                return(stat);
+                stat = tng_frame_set_read_next(tng_data, hash_mode);
+                if(stat != TNG_SUCCESS)
+                {
+                    return(stat);
+                }
+                current_frame_pos = 0;
+                if(is_particle_data == TNG_TRUE &&
+                   tng_particle_mapping_table_get(frame_set, *n_particles,
+                                                  &mapping_table) != TNG_SUCCESS)
+                {
+                    return(TNG_CRITICAL);
+                }
             }
-            stat = tng_particle_data_find(tng_data, block_id, &data);
-            if(stat == TNG_SUCCESS)
+            if(is_particle_data == TNG_TRUE)
             {
-                *block_dependency = TNG_PARTICLE_DEPENDENT + TNG_FRAME_DEPENDENT;
-                return(TNG_SUCCESS);
+                for(j=0; j<*n_particles; j++)
+                {
+                    mapping = mapping_table ? mapping_table[j] : j;
+                    for(k=0; k<*n_values_per_frame; k++)
+                    {
+                        (*values)[i][mapping][k].d = *(double *)
+                                                     ((char *)data->values + size *
+                                                      (current_frame_pos *
+                                                       i_step + j *
+                                                       (*n_values_per_frame) + k));
+                    }
+                }
             }
             else
             {
-                stat = tng_data_find(tng_data, block_id, &data);
-                if(stat == TNG_SUCCESS)
+                for(j = 0; j < *n_values_per_frame; j++)
                 {
-                    *block_dependency = TNG_FRAME_DEPENDENT;
-                    return(TNG_SUCCESS);
+                    (*values)[0][i][j].d = *(double *)((char *)data->values + size *
+                                                    (current_frame_pos *
+                                                     i_step + j));
                 }
             }
+            current_frame_pos++;
         }
     }
 
-    return(TNG_FAILURE);
+    data->last_retrieved_frame = end_frame_nr;
+
+    return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_data_block_num_values_per_frame_get
+tng_function_status DECLSPECDLLEXPORT tng_data_interval_get
                 (const tng_trajectory_t tng_data,
                  const int64_t block_id,
-                 int64_t *n_values_per_frame)
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 union data_values ***values,
+                 int64_t *n_values_per_frame,
+                 char *type)
 {
-    int64_t i;
-    tng_function_status stat;
-    tng_data_t data;
-
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
     TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    for(i = 0; i < tng_data->n_particle_data_blocks; i++)
-    {
-        data = &tng_data->non_tr_particle_data[i];
-        if(data->block_id == block_id)
-        {
-            *n_values_per_frame = data->n_values_per_frame;
-            return(TNG_SUCCESS);
-        }
-    }
-    for(i = 0; i < tng_data->n_data_blocks; i++)
+    return(tng_gen_data_interval_get(tng_data, block_id, TNG_FALSE, start_frame_nr,
+                                     end_frame_nr, hash_mode, &values, 0,
+                                     n_values_per_frame, type));
+}
+
+/**
+ * @brief Read a range of frames of TNG compressed positions or velocities,
+ * or XTC compressed positions, in the current frame set, uncompressing only
+ * the requested frames. For TNG compressed data this only decodes the
+ * keyframe blocks (see tng_compression_keyframe_interval_set()) covering
+ * the frames instead of the whole frame set. XTC compressed frames are
+ * decoded one by one.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID of the data block, TNG_TRAJ_POSITIONS or
+ * TNG_TRAJ_VELOCITIES.
+ * @param start_frame_nr is the index number of the first frame to read.
+ * @param end_frame_nr is the index number of the last frame to read.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @param values is set to point to the frames that were read. The memory
+ * must be freed when it is not needed any more.
+ * @param n_particles is set to the number of particles in the returned data.
+ * @param stride_length is set to the stride length of the returned data.
+ * @param n_values_per_frame is set to the number of values per frame and
+ * particle.
+ * @param type is set to the data type of the data in the array.
+ * @details The data is not stored in the frame set, so this is only useful
+ * if the block has not been read. The file position is restored before
+ * returning.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the data is not
+ * a TNG or XTC compressed block of all particles with stride length 1 in the
+ * current frame set, so the whole block must be read instead, or
+ * TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_particle_data_frames_partial_read
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 void **values,
+                 int64_t *n_particles,
+                 int64_t *stride_length,
+                 int64_t *n_values_per_frame,
+                 char *type)
+{
+    int64_t orig_pos, file_pos, start_pos, block_data_len, n_values, codec_id;
+    int64_t n_frames, first_frame_with_data, block_stride_length, num_first_particle;
+    int64_t block_n_particles, tot_n_particles, first_frame, n_read_frames;
+    int64_t values_len, start_ticks;
+    int vel, natoms, block_n_frames, algo[4], size, result;
+    double multiplier, precision;
+    char datatype, dependency, sparse_data = 0;
+    char *contents, *temp;
+    char hash[TNG_MD5_HASH_LEN];
+    md5_state_t md5_state;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_gen_block_t block;
+    tng_function_status stat;
+
+    if((block_id != TNG_TRAJ_POSITIONS && block_id != TNG_TRAJ_VELOCITIES) ||
+       start_frame_nr < frame_set->first_frame ||
+       end_frame_nr >= frame_set->first_frame + frame_set->n_frames)
     {
-        data = &tng_data->non_tr_data[i];
-        if(data->block_id == block_id)
-        {
-            *n_values_per_frame = data->n_values_per_frame;
-            return(TNG_SUCCESS);
-        }
+        return(TNG_FAILURE);
     }
 
-    stat = tng_particle_data_find(tng_data, block_id, &data);
-    if(stat == TNG_SUCCESS)
+    if(tng_data->var_num_atoms_flag)
     {
-        *n_values_per_frame = data->n_values_per_frame;
-        return(TNG_SUCCESS);
+        tot_n_particles = frame_set->n_particles;
     }
     else
     {
-        stat = tng_data_find(tng_data, block_id, &data);
-        if(stat == TNG_SUCCESS)
-        {
-            *n_values_per_frame = data->n_values_per_frame;
-            return(TNG_SUCCESS);
-        }
-        else
+        tot_n_particles = tng_data->n_particles;
+    }
+
+    orig_pos = ftello(tng_data->input_file);
+
+    tng_block_init(&block);
+
+    /* Find the data block. Particle mapping blocks mean that the block does
+     * not contain all particles in order. */
+    tng_fseeko(tng_data, tng_data->input_file,
+               tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
+    stat = tng_block_header_read(tng_data, block);
+    if(stat == TNG_SUCCESS)
+    {
+        file_pos = ftello(tng_data->input_file) + block->block_contents_size;
+        tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
+        stat = TNG_FAILURE;
+        while(file_pos < tng_data->input_file_len &&
+              tng_block_header_read(tng_data, block) == TNG_SUCCESS &&
+              block->id != TNG_TRAJECTORY_FRAME_SET &&
+              block->id != TNG_PARTICLE_MAPPING &&
+              block->id != -1)
         {
-            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            if(stat != TNG_SUCCESS)
-            {
-                return(stat);
-            }
-            stat = tng_particle_data_find(tng_data, block_id, &data);
-            if(stat == TNG_SUCCESS)
-            {
-                *n_values_per_frame = data->n_values_per_frame;
-                return(TNG_SUCCESS);
-            }
-            else
+            if(block->id == block_id)
             {
-                stat = tng_data_find(tng_data, block_id, &data);
-                if(stat == TNG_SUCCESS)
-                {
-                    *n_values_per_frame = data->n_values_per_frame;
-                    return(TNG_SUCCESS);
-                }
+                stat = TNG_SUCCESS;
+                break;
             }
+            file_pos = ftello(tng_data->input_file) + block->block_contents_size;
+            tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
         }
     }
+    if(stat != TNG_SUCCESS)
+    {
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        tng_block_destroy(&block);
+        return(TNG_FAILURE);
+    }
 
-    return(TNG_FAILURE);
-}
+    start_pos = ftello(tng_data->input_file);
 
-tng_function_status DECLSPECDLLEXPORT tng_frame_set_n_frames_of_data_block_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 int64_t *n_frames)
-{
-    tng_gen_block_t block;
-    tng_function_status stat;
-    char datatype, dependency, sparse_data;
-    int64_t n_values, codec_id, first_frame_with_data, stride_length, curr_n_frames;
-    int64_t num_first_particle, block_n_particles;
-    double multiplier;
-    md5_state_t md5_state;
-    int found = TNG_FALSE;
+    if(hash_mode == TNG_USE_HASH)
+    {
+        md5_init(&md5_state);
+    }
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    if(tng_data_block_meta_information_read(tng_data, &datatype, &dependency,
+                                            &sparse_data, &n_values, &codec_id,
+                                            &first_frame_with_data,
+                                            &block_stride_length, &n_frames,
+                                            &num_first_particle,
+                                            &block_n_particles, &multiplier,
+                                            hash_mode, &md5_state) == TNG_CRITICAL)
+    {
+        fprintf(stderr, "TNG library: Cannot read data block (%s) meta information. %s: %d\n",
+            block->name, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        return(TNG_CRITICAL);
+    }
 
-    tng_block_init(&block);
+    if((codec_id != TNG_TNG_COMPRESSION && codec_id != TNG_XTC_COMPRESSION) ||
+       (datatype != TNG_FLOAT_DATA && datatype != TNG_DOUBLE_DATA) ||
+       !(dependency & TNG_PARTICLE_DEPENDENT) || n_values != 3 ||
+       block_stride_length != 1 || first_frame_with_data != frame_set->first_frame ||
+       num_first_particle != 0 || block_n_particles != tot_n_particles)
+    {
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        tng_block_destroy(&block);
+        return(TNG_FAILURE);
+    }
 
-    stat = tng_block_header_read(tng_data, block);
-    /* If the block header could not be read the reading position might not have been
-     * at the start of a block. Try again from the file position of the current frame
-     * set. */
-    if(stat != TNG_SUCCESS)
+    block_data_len = block->block_contents_size - (ftello(tng_data->input_file) - start_pos);
+
+    contents = (char *)malloc(block_data_len);
+    if(!contents)
     {
-        fseeko(tng_data->input_file, tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
-        stat = tng_block_header_read(tng_data, block);
-        if(stat != TNG_SUCCESS)
-        {
-            tng_block_destroy(&block);
-            return(stat);
-        }
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        return(TNG_CRITICAL);
     }
-    if(block->id == TNG_TRAJECTORY_FRAME_SET)
+
+    if(tng_fread(tng_data, contents, block_data_len, 1, tng_data->input_file) == 0)
     {
-        stat = tng_block_read_next(tng_data, block, TNG_SKIP_HASH);
-        if(stat != TNG_SUCCESS)
-        {
-            tng_block_destroy(&block);
-            return(stat);
-        }
-        stat = tng_block_header_read(tng_data, block);
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+        free(contents);
+        tng_block_destroy(&block);
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        return(TNG_CRITICAL);
     }
-    while(stat == TNG_SUCCESS && block->id != TNG_TRAJECTORY_FRAME_SET && found == TNG_FALSE)
+
+    if(hash_mode == TNG_USE_HASH)
     {
-        if(block->id == block_id)
+        tng_md5_append(tng_data, &md5_state, (md5_byte_t *)contents, block_data_len);
+        md5_finish(&md5_state, (md5_byte_t *)hash);
+        if(strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
         {
-            stat = tng_data_block_meta_information_read(tng_data, &datatype,
-                                                        &dependency, &sparse_data,
-                                                        &n_values, &codec_id,
-                                                        &first_frame_with_data,
-                                                        &stride_length, &curr_n_frames,
-                                                        &num_first_particle,
-                                                        &block_n_particles,
-                                                        &multiplier, TNG_SKIP_HASH,
-                                                        &md5_state);
-            if(stat == TNG_SUCCESS)
+            if(strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
             {
-                found = TNG_TRUE;
+                fprintf(stderr, "TNG library: Data block contents corrupt (%s). Hashes do not match. "
+                        "%s: %d\n", block->name, __FILE__, __LINE__);
             }
         }
-        else
-        {
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
-            stat = tng_block_header_read(tng_data, block);
-        }
     }
-    if(found == TNG_TRUE)
+
+    first_frame = start_frame_nr - frame_set->first_frame;
+    n_read_frames = end_frame_nr - start_frame_nr + 1;
+    size = datatype == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double);
+    values_len = n_read_frames * tot_n_particles * 3 * size;
+
+    /* The frames are uncompressed directly into values, so the block must
+     * not contain more particles than expected. XTC compressed frames are
+     * checked when they are uncompressed. */
+    if(codec_id == TNG_TNG_COMPRESSION &&
+       (tng_compress_inquire(contents, &vel, &natoms, &block_n_frames, &precision, algo) ||
+        natoms != tot_n_particles || block_n_frames != n_frames))
     {
-        *n_frames = (tng_data->current_trajectory_frame_set.n_frames -
-                     (tng_data->current_trajectory_frame_set.first_frame - first_frame_with_data)) / stride_length;
+        fprintf(stderr, "TNG library: Unexpected length of TNG compressed block. %s: %d\n",
+                __FILE__, __LINE__);
+        free(contents);
+        tng_block_destroy(&block);
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        return(TNG_CRITICAL);
     }
-    else if(stat == TNG_SUCCESS)
+
+    temp = (char *)realloc(*values, values_len);
+    if(!temp)
     {
-        *n_frames = 0;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(contents);
+        free(*values);
+        *values = 0;
+        tng_block_destroy(&block);
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        return(TNG_CRITICAL);
+    }
+    *values = temp;
+
+    start_ticks = tng_statistics_timer_start(tng_data);
+    if(codec_id == TNG_XTC_COMPRESSION)
+    {
+        result = tng_xtc_uncompress(tng_data, block, datatype, contents, block_data_len,
+                                    first_frame, (char *)*values, values_len) != TNG_SUCCESS;
+    }
+    else if(datatype == TNG_FLOAT_DATA)
+    {
+        result = tng_compress_uncompress_frames_float(contents, (int)first_frame,
+                                                      (int)n_read_frames, (float *)*values);
+    }
+    else
+    {
+        result = tng_compress_uncompress_frames(contents, (int)first_frame,
+                                                (int)n_read_frames, (double *)*values);
     }
+    tng_statistics_timer_stop(tng_data, &tng_data->statistics.uncompress_ticks, start_ticks);
 
+    free(contents);
     tng_block_destroy(&block);
 
-    return(stat);
+    if(result)
+    {
+        fprintf(stderr, "TNG library: Cannot uncompress compressed block. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+        return(TNG_CRITICAL);
+    }
+
+    *n_particles = tot_n_particles;
+    *stride_length = 1;
+    *n_values_per_frame = n_values;
+    *type = datatype;
+
+    tng_fseeko(tng_data, tng_data->input_file, orig_pos, SEEK_SET);
+
+    return(TNG_SUCCESS);
 }
 
-static tng_function_status tng_frame_gen_data_write
+static tng_function_status tng_gen_data_vector_interval_get
                 (const tng_trajectory_t tng_data,
-                 const int64_t frame_nr,
                  const int64_t block_id,
                  const tng_bool is_particle_data,
-                 const int64_t val_first_particle,
-                 const int64_t val_n_particles,
-                 const void *values,
-                 const char hash_mode)
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 void **values,
+                 int64_t *n_particles,
+                 int64_t *stride_length,
+                 int64_t *n_values_per_frame,
+                 char *type)
 {
-    int64_t header_pos, file_pos, tot_n_particles;
-    int64_t output_file_len, n_values_per_frame, size, contents_size;
-    int64_t header_size, temp_first, temp_last;
-    int64_t mapping_block_end_pos, num_first_particle, block_n_particles;
-    int64_t i, last_frame, temp_current, write_n_particles;
-    tng_gen_block_t block;
+    int64_t n_frames, tot_n_frames, n_frames_div, n_frames_div_2, first_frame;
+    int64_t file_pos, current_frame_pos, last_frame_pos, full_data_len, frame_size;
+    int size;
     tng_trajectory_frame_set_t frame_set;
-    FILE *temp = tng_data->input_file;
-    struct tng_data data;
+    tng_data_t data;
+    tng_gen_block_t block;
+    void *current_values = 0, *temp;
     tng_function_status stat;
-    tng_particle_mapping_t mapping;
-    char dependency, sparse_data, datatype;
-    void *copy;
-
-    if(tng_output_file_init(tng_data) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
-               __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-    }
-
-    temp_first = tng_data->first_trajectory_frame_set_input_file_pos;
-    temp_last = tng_data->last_trajectory_frame_set_input_file_pos;
-    temp_current = tng_data->current_trajectory_frame_set_input_file_pos;
-    tng_data->first_trajectory_frame_set_input_file_pos =
-    tng_data->first_trajectory_frame_set_output_file_pos;
-    tng_data->last_trajectory_frame_set_input_file_pos =
-    tng_data->last_trajectory_frame_set_output_file_pos;
-    tng_data->current_trajectory_frame_set_input_file_pos =
-    tng_data->current_trajectory_frame_set_output_file_pos;
-
-    tng_data->input_file = tng_data->output_file;
-
-    stat = tng_frame_set_of_frame_find(tng_data, frame_nr);
 
     frame_set = &tng_data->current_trajectory_frame_set;
+    first_frame = frame_set->first_frame;
 
+    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
     if(stat != TNG_SUCCESS)
     {
-        last_frame = frame_set->first_frame +
-                     frame_set->n_frames - 1;
-        /* If the wanted frame would be in the frame set after the last
-            * frame set create a new frame set. */
-        if(stat == TNG_FAILURE &&
-            last_frame < frame_nr)
-/*           (last_frame < frame_nr &&
-            tng_data->current_trajectory_frame_set.first_frame +
-            tng_data->frame_set_n_frames >= frame_nr))*/
-        {
-            if(last_frame + tng_data->frame_set_n_frames < frame_nr)
-            {
-                last_frame = frame_nr - 1;
-            }
-            tng_frame_set_new(tng_data,
-                              last_frame+1,
-                              tng_data->frame_set_n_frames);
-            file_pos = ftello(tng_data->output_file);
-            fseeko(tng_data->output_file, 0, SEEK_END);
-            output_file_len = ftello(tng_data->output_file);
-            fseeko(tng_data->output_file, file_pos, SEEK_SET);
-
-            /* Read mapping blocks from the last frame set */
-            tng_block_init(&block);
-
-            stat = tng_block_header_read(tng_data, block);
-            while(file_pos < output_file_len &&
-                  stat != TNG_CRITICAL &&
-                  block->id != TNG_TRAJECTORY_FRAME_SET &&
-                  block->id != -1)
-            {
-                if(block->id == TNG_PARTICLE_MAPPING)
-                {
-                    tng_trajectory_mapping_block_read(tng_data, block,
-                                                      hash_mode);
-                }
-                else
-                {
-                    fseeko(tng_data->output_file, block->block_contents_size,
-                        SEEK_CUR);
-                }
-                file_pos = ftello(tng_data->output_file);
-                if(file_pos < output_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
-            }
+        return(stat);
+    }
 
-            tng_block_destroy(&block);
-            /* Write the frame set to disk */
-            if(tng_frame_set_write(tng_data, hash_mode) != TNG_SUCCESS)
+    /* Do not re-read the frame set and only need the requested block + particle mapping blocks. */
+    /* TODO: Test that blocks are read correctly now that now all of them are read at the same time. */
+    if(is_particle_data == TNG_TRUE)
+    {
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+        /* If the block has not been read, only the requested frames of
+         * it may need to be uncompressed. */
+        if(stat != TNG_SUCCESS)
+        {
+            stat = tng_particle_data_frames_partial_read(tng_data, block_id,
+                                                         start_frame_nr, end_frame_nr,
+                                                         hash_mode, values, n_particles,
+                                                         stride_length, n_values_per_frame,
+                                                         type);
+            if(stat != TNG_FAILURE)
             {
-                fprintf(stderr, "TNG library: Error writing frame set. %s: %d\n", __FILE__, __LINE__);
-                return(TNG_CRITICAL);
+                return(stat);
             }
         }
-        else
-        {
-            tng_data->input_file = temp;
-            tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-            tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-            tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
-            return(stat);
-        }
     }
-
-    tng_block_init(&block);
-
-    file_pos = tng_data->current_trajectory_frame_set_output_file_pos;
-
-    fseeko(tng_data->output_file, 0, SEEK_END);
-    output_file_len = ftello(tng_data->output_file);
-    fseeko(tng_data->output_file, file_pos, SEEK_SET);
-
-    /* Read past the frame set block first */
-    stat = tng_block_header_read(tng_data, block);
-    if(stat == TNG_CRITICAL)
+    else
     {
-        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-               file_pos, __FILE__, __LINE__);
-        tng_block_destroy(&block);
-        tng_data->input_file = temp;
-
-        tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-        tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-        tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
-        return(stat);
+        stat = tng_data_find(tng_data, block_id, &data);
     }
-    fseeko(tng_data->output_file, block->block_contents_size,
-            SEEK_CUR);
 
-    if(is_particle_data == TNG_TRUE)
+    if(first_frame != frame_set->first_frame ||
+       stat != TNG_SUCCESS)
     {
-        if(tng_data->var_num_atoms_flag)
-        {
-            tot_n_particles = frame_set->n_particles;
-        }
-        else
+        tng_block_init(&block);
+        if(stat != TNG_SUCCESS)
         {
-            tot_n_particles = tng_data->n_particles;
-        }
+            tng_fseeko(tng_data, tng_data->input_file,
+                      tng_data->current_trajectory_frame_set_input_file_pos,
+                      SEEK_SET);
+            stat = tng_block_header_read(tng_data, block);
+            if(stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n",
+                        __FILE__, __LINE__);
+                return(stat);
+            }
 
-        if(val_n_particles < tot_n_particles)
+            tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        }
+        file_pos = ftello(tng_data->input_file);
+        /* Read until next frame set block */
+        stat = tng_block_header_read(tng_data, block);
+        while(file_pos < tng_data->input_file_len &&
+            stat != TNG_CRITICAL &&
+            block->id != TNG_TRAJECTORY_FRAME_SET &&
+            block->id != -1)
         {
-            mapping_block_end_pos = -1;
-            /* Read all mapping blocks to find the right place to put the data */
-            stat = tng_block_header_read(tng_data, block);
-            while(file_pos < output_file_len &&
-                    stat != TNG_CRITICAL &&
-                    block->id != TNG_TRAJECTORY_FRAME_SET &&
-                    block->id != -1)
+            if(block->id == block_id || block->id == TNG_PARTICLE_MAPPING)
             {
-                if(block->id == TNG_PARTICLE_MAPPING)
-                {
-                    tng_trajectory_mapping_block_read(tng_data, block, hash_mode);
-                }
-                else
-                {
-                    fseeko(tng_data->output_file, block->block_contents_size,
-                           SEEK_CUR);
-                }
-                file_pos = ftello(tng_data->output_file);
-                if(block->id == TNG_PARTICLE_MAPPING)
-                {
-                    mapping = &frame_set->mappings[frame_set->n_mapping_blocks - 1];
-                    if(val_first_particle >= mapping->num_first_particle &&
-                       val_first_particle < mapping->num_first_particle +
-                       mapping->n_particles &&
-                       val_first_particle + val_n_particles <=
-                       mapping->num_first_particle + mapping->n_particles)
+                stat = tng_block_read_next(tng_data, block,
+                                        hash_mode);
+                if(stat != TNG_CRITICAL)
+                {
+                    file_pos = ftello(tng_data->input_file);
+                    if(file_pos < tng_data->input_file_len)
                     {
-                        mapping_block_end_pos = file_pos;
+                        stat = tng_block_header_read(tng_data, block);
                     }
                 }
-                if(file_pos < output_file_len)
+            }
+            else
+            {
+                file_pos += block->block_contents_size + block->header_contents_size;
+                tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
+                if(file_pos < tng_data->input_file_len)
                 {
                     stat = tng_block_header_read(tng_data, block);
                 }
             }
-            if(stat == TNG_CRITICAL)
-            {
-                fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                       file_pos, __FILE__, __LINE__);
-                tng_block_destroy(&block);
-                tng_data->input_file = temp;
-
-                tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-                tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-                tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
-                return(stat);
-            }
-            if(mapping_block_end_pos < 0)
-            {
-                tng_block_destroy(&block);
-                tng_data->input_file = temp;
-
-                tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-                tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-                tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
-                return(TNG_FAILURE);
-            }
-            fseeko(tng_data->output_file, mapping_block_end_pos, SEEK_SET);
         }
-    }
-
-    /* Read all block headers until next frame set block or
-     * until the wanted block id is found */
-    stat = tng_block_header_read(tng_data, block);
-    while(file_pos < output_file_len &&
-            stat != TNG_CRITICAL &&
-            block->id != block_id &&
-            (is_particle_data != TNG_TRUE || block->id != TNG_PARTICLE_MAPPING) &&
-            block->id != TNG_TRAJECTORY_FRAME_SET &&
-            block->id != -1)
-    {
-        fseeko(tng_data->output_file, block->block_contents_size, SEEK_CUR);
-        file_pos = ftello(tng_data->output_file);
-        if(file_pos < output_file_len)
+        tng_block_destroy(&block);
+        if(stat == TNG_CRITICAL)
         {
-            stat = tng_block_header_read(tng_data, block);
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    file_pos, __FILE__, __LINE__);
+            return(stat);
         }
     }
-    if(stat == TNG_CRITICAL)
+    if(is_particle_data == TNG_TRUE)
+    {
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, block_id, &data);
+    }
+    if(stat != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-               file_pos, __FILE__, __LINE__);
-        tng_block_destroy(&block);
-        tng_data->input_file = temp;
-        tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-        tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-        tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
         return(stat);
     }
 
-    contents_size = block->block_contents_size;
-    header_size = block->header_contents_size;
+    stat = tng_gen_data_vector_get(tng_data, block_id, is_particle_data,
+                                   &current_values, &n_frames, stride_length,
+                                   n_particles, n_values_per_frame, type);
 
-    header_pos = ftello(tng_data->output_file) - header_size;
-    frame_set = &tng_data->current_trajectory_frame_set;
+    if(stat != TNG_SUCCESS || (is_particle_data && *n_particles == 0))
+    {
+        if(current_values)
+        {
+            free(current_values);
+        }
+        return(stat);
+    }
 
-    if(tng_file_input_numerical(tng_data, &datatype,
-                                 sizeof(datatype),
-                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    if(n_frames == 1 && n_frames < frame_set->n_frames)
     {
-        tng_block_destroy(&block);
-        return(TNG_CRITICAL);
+        tot_n_frames = 1;
     }
-    if(tng_file_input_numerical(tng_data, &dependency,
-                                 sizeof(dependency),
-                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    else
     {
-        tng_block_destroy(&block);
-        return(TNG_CRITICAL);
+        tot_n_frames = end_frame_nr - start_frame_nr + 1;
     }
-    data.datatype = datatype;
 
-    if(!(dependency & TNG_FRAME_DEPENDENT) ||
-       (is_particle_data == TNG_FALSE && dependency & TNG_PARTICLE_DEPENDENT) ||
-       (is_particle_data == TNG_TRUE && !(dependency & TNG_PARTICLE_DEPENDENT)))
+    switch(*type)
     {
-        tng_block_destroy(&block);
-        tng_data->input_file = temp;
-
-        tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-        tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-        tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
+    case TNG_CHAR_DATA:
         return(TNG_FAILURE);
+    case TNG_INT_DATA:
+        size = sizeof(int64_t);
+        break;
+    case TNG_FLOAT_DATA:
+        size = sizeof(float);
+        break;
+    case TNG_DOUBLE_DATA:
+    default:
+        size = sizeof(double);
     }
 
-    if(tng_file_input_numerical(tng_data, &sparse_data,
-                                 sizeof(sparse_data),
-                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
-    {
-        tng_block_destroy(&block);
-        return(TNG_CRITICAL);
-    }
+    n_frames_div = (tot_n_frames % *stride_length) ?
+                 tot_n_frames / *stride_length + 1:
+                 tot_n_frames / *stride_length;
 
-    if(tng_file_input_numerical(tng_data, &data.n_values_per_frame,
-                                 sizeof(data.n_values_per_frame),
-                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    full_data_len = n_frames_div * size * (*n_values_per_frame);
+    if(is_particle_data)
     {
-        tng_block_destroy(&block);
-        return(TNG_CRITICAL);
+        full_data_len *= (*n_particles);
     }
 
-    if(tng_file_input_numerical(tng_data, &data.codec_id,
-                                 sizeof(data.codec_id),
-                                 TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    temp = (char *)realloc(*values, full_data_len);
+    if(!temp)
     {
-        tng_block_destroy(&block);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(*values);
+        *values = 0;
         return(TNG_CRITICAL);
     }
 
-    if(data.codec_id != TNG_UNCOMPRESSED)
-    {
-        if(tng_file_input_numerical(tng_data, &data.compression_multiplier,
-                                     sizeof(data.compression_multiplier),
-                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
-        {
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
-    }
-    else
-    {
-        data.compression_multiplier = 1;
-    }
+    *values = temp;
 
-    if(sparse_data)
+    if( n_frames == 1 && n_frames < frame_set->n_frames)
     {
-        if(tng_file_input_numerical(tng_data, &data.first_frame_with_data,
-                                     sizeof(data.first_frame_with_data),
-                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        if(is_particle_data)
         {
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
+            memcpy(*values, current_values, size * (*n_particles) *
+                   (*n_values_per_frame));
         }
-
-        if(tng_file_input_numerical(tng_data, &data.stride_length,
-                                     sizeof(data.stride_length),
-                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        else
         {
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
+            memcpy(*values, current_values, size * (*n_values_per_frame));
         }
     }
     else
     {
-        data.first_frame_with_data = 0;
-        data.stride_length = 1;
-    }
-    data.n_frames = tng_data->current_trajectory_frame_set.n_frames;
-
-    if(is_particle_data == TNG_TRUE)
-    {
-        if(tng_file_input_numerical(tng_data, &num_first_particle,
-                                     sizeof(num_first_particle),
-                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
-        {
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
-        }
+        current_frame_pos = start_frame_nr - frame_set->first_frame;
 
-        if(tng_file_input_numerical(tng_data, &block_n_particles,
-                                     sizeof(block_n_particles),
-                                     TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+        frame_size = size * (*n_values_per_frame);
+        if(is_particle_data)
         {
-            tng_block_destroy(&block);
-            return(TNG_CRITICAL);
+            frame_size *= (*n_particles);
         }
-    }
-
-    tng_data->input_file = temp;
-
-    tng_data->first_trajectory_frame_set_input_file_pos = temp_first;
-    tng_data->last_trajectory_frame_set_input_file_pos = temp_last;
-    tng_data->current_trajectory_frame_set_input_file_pos = temp_current;
-
-    switch(data.datatype)
-    {
-        case(TNG_INT_DATA):
-            size = sizeof(int64_t);
-            break;
-        case(TNG_FLOAT_DATA):
-            size = sizeof(float);
-            break;
-        case(TNG_DOUBLE_DATA):
-            size = sizeof(double);
-            break;
-        default:
-            fprintf(stderr, "TNG library: Cannot calculate writing locations. %s: %d.\n", __FILE__,
-                   __LINE__);
-            tng_block_destroy(&block);
-            return(TNG_FAILURE);
-    }
-
-    n_values_per_frame = data.n_values_per_frame;
 
-    file_pos = (frame_nr - tng_max_i64(frame_set->first_frame,
-                               data.first_frame_with_data)) /
-                data.stride_length;
-    if(is_particle_data == TNG_TRUE)
-    {
-        file_pos *= block_n_particles * size * n_values_per_frame;
-    }
-    else
-    {
-        file_pos *= size * n_values_per_frame;
-    }
+        last_frame_pos = tng_min_i64(n_frames,
+                                     end_frame_nr - start_frame_nr);
 
-    if(file_pos > contents_size)
-    {
-        fprintf(stderr, "TNG library: Attempting to write outside the block. %s: %d\n", __FILE__,
-               __LINE__);
-        tng_block_destroy(&block);
-        return(TNG_FAILURE);
-    }
+        n_frames_div = current_frame_pos / *stride_length;
+        n_frames_div_2 = (last_frame_pos % *stride_length) ?
+                       last_frame_pos / *stride_length + 1:
+                       last_frame_pos / *stride_length;
+        n_frames_div_2 = tng_max_i64(1, n_frames_div_2 + 1);
 
-    fseeko(tng_data->output_file, file_pos, SEEK_CUR);
+        memcpy(*values, (char *)current_values + n_frames_div * frame_size,
+               n_frames_div_2 * frame_size);
 
-    if(is_particle_data == TNG_TRUE)
-    {
-        write_n_particles = val_n_particles;
-    }
-    else
-    {
-        write_n_particles = 1;
-    }
+        current_frame_pos += n_frames - current_frame_pos;
 
-    /* If the endianness is not big endian the data needs to be swapped */
-    if((data.datatype == TNG_INT_DATA ||
-        data.datatype == TNG_DOUBLE_DATA) &&
-       tng_data->output_endianness_swap_func_64)
-    {
-        copy = (char *)malloc(write_n_particles * n_values_per_frame * size);
-        memcpy(copy, values, write_n_particles * n_values_per_frame * size);
-        for(i = 0; i < write_n_particles * n_values_per_frame; i++)
+        while(current_frame_pos <= end_frame_nr - start_frame_nr)
         {
-            if(tng_data->output_endianness_swap_func_64(tng_data,
-                (uint64_t *) copy+i)
-                != TNG_SUCCESS)
+            stat = tng_frame_set_read_next(tng_data, hash_mode);
+            if(stat != TNG_SUCCESS)
             {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                        __FILE__, __LINE__);
+                if(current_values)
+                {
+                    free(current_values);
+                }
+                free(*values);
+                *values = 0;
+                return(stat);
             }
-        }
-        fwrite(copy, write_n_particles * n_values_per_frame, size,
-               tng_data->output_file);
-        free(copy);
-    }
-    else if(data.datatype == TNG_FLOAT_DATA &&
-            tng_data->output_endianness_swap_func_32)
-    {
-        copy = (char *)malloc(write_n_particles * n_values_per_frame * size);
-        memcpy(copy, values, write_n_particles * n_values_per_frame * size);
-        for(i = 0; i < write_n_particles * n_values_per_frame; i++)
-        {
-            if(tng_data->output_endianness_swap_func_32(tng_data,
-                (uint32_t *) copy+i)
-                != TNG_SUCCESS)
+
+            stat = tng_gen_data_vector_get(tng_data, block_id, is_particle_data,
+                                           &current_values, &n_frames,
+                                           stride_length, n_particles,
+                                           n_values_per_frame, type);
+
+            if(stat != TNG_SUCCESS)
             {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                        __FILE__, __LINE__);
+                if(current_values)
+                {
+                    free(current_values);
+                }
+                free(*values);
+                *values = 0;
+                return(stat);
             }
-        }
-        fwrite(copy, write_n_particles * n_values_per_frame, size,
-               tng_data->output_file);
-        free(copy);
-    }
 
-    else
-    {
-        fwrite(values, write_n_particles * n_values_per_frame, size, tng_data->output_file);
-    }
+            last_frame_pos = tng_min_i64(n_frames,
+                                         end_frame_nr - current_frame_pos);
 
-    fflush(tng_data->output_file);
+            n_frames_div = current_frame_pos / *stride_length;
+            n_frames_div_2 = (last_frame_pos % *stride_length) ?
+                           last_frame_pos / *stride_length + 1:
+                           last_frame_pos / *stride_length;
+            n_frames_div_2 = tng_max_i64(1, n_frames_div_2);
 
-    /* Update the number of written frames in the frame set. */
-    if(frame_nr - frame_set->first_frame + 1 > frame_set->n_written_frames)
-    {
-        frame_set->n_written_frames = frame_nr - frame_set->first_frame + 1;
+            memcpy(((char *)*values) + n_frames_div * frame_size,
+                   current_values,
+                   n_frames_div_2 * frame_size);
+
+            current_frame_pos += n_frames;
+        }
     }
 
-    /* If the last frame has been written update the hash */
-    if(hash_mode == TNG_USE_HASH && (frame_nr + data.stride_length -
-       data.first_frame_with_data) >=
-       frame_set->n_frames)
+    if(current_values)
     {
-        tng_md5_hash_update(tng_data, block, header_pos, header_pos +
-                            header_size);
+        free(current_values);
     }
 
-    tng_block_destroy(&block);
+    data->last_retrieved_frame = end_frame_nr;
 
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_frame_data_write
+
+tng_function_status DECLSPECDLLEXPORT tng_data_vector_interval_get
                 (const tng_trajectory_t tng_data,
-                 const int64_t frame_nr,
                  const int64_t block_id,
-                 const void *values,
-                 const char hash_mode)
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 void **values,
+                 int64_t *stride_length,
+                 int64_t *n_values_per_frame,
+                 char *type)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(frame_nr >= 0, "TNG library: frame_nr must be >= 0.");
-    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than the end_frame_nr.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    /* This is now just calling the generic data writing function. This
-     * function must keep its signature to let the API be backwards
-     * compatible. */
-    return(tng_frame_gen_data_write(tng_data, frame_nr, block_id,
-                                    TNG_FALSE, 0, 0, values, hash_mode));
+    return(tng_gen_data_vector_interval_get(tng_data, block_id, TNG_FALSE,
+                                            start_frame_nr, end_frame_nr,
+                                            hash_mode, values, 0, stride_length,
+                                            n_values_per_frame, type));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_frame_particle_data_write
+tng_function_status DECLSPECDLLEXPORT tng_particle_data_get
                 (const tng_trajectory_t tng_data,
-                 const int64_t frame_nr,
                  const int64_t block_id,
-                 const int64_t val_first_particle,
-                 const int64_t val_n_particles,
-                 const void *values,
-                 const char hash_mode)
+                 union data_values ****values,
+                 int64_t *n_frames,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(frame_nr >= 0, "TNG library: frame_nr must be >= 0.");
-    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
-    TNG_ASSERT(val_first_particle >= 0, "TNG library: val_first_particle must be >= 0.");
-    TNG_ASSERT(val_n_particles >= 0, "TNG library: val_n_particles must be >= 0.");
+    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    /* This is now just calling the generic data writing function. This
-     * function must keep its signature to let the API be backwards
-     * compatible. */
-    return(tng_frame_gen_data_write(tng_data, frame_nr, block_id,
-                                    TNG_TRUE, val_first_particle, val_n_particles,
-                                    values, hash_mode));
+    return(tng_gen_data_get(tng_data, block_id, TNG_TRUE, values, n_frames, n_particles,
+                            n_values_per_frame, type));
 }
 
-static tng_function_status tng_data_values_alloc
+tng_function_status DECLSPECDLLEXPORT tng_particle_data_vector_get
                 (const tng_trajectory_t tng_data,
-                 union data_values ***values,
-                 const int64_t n_frames,
-                 const int64_t n_values_per_frame,
-                 const char type)
+                 const int64_t block_id,
+                 void **values,
+                 int64_t *n_frames,
+                 int64_t *stride_length,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type)
 {
-    int64_t i;
-    tng_function_status stat;
-
-    if(n_frames <= 0 || n_values_per_frame <= 0)
-    {
-        return(TNG_FAILURE);
-    }
-
-    if(*values)
-    {
-        stat = tng_data_values_free(tng_data, *values, n_frames,
-                                    n_values_per_frame,
-                                    type);
-        if(stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot free particle data values. %s: %d\n",
-                   __FILE__, __LINE__);
-            return(stat);
-        }
-    }
-    *values = (union data_values **)malloc(sizeof(union data_values *) * n_frames);
-    if(!*values)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        return(TNG_CRITICAL);
-
-    }
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    for(i = 0; i < n_frames; i++)
-    {
-        (*values)[i] = (union data_values *)malloc(sizeof(union data_values) *
-                           n_values_per_frame);
-        if(!(*values)[i])
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            free(values);
-            values = 0;
-            return(TNG_CRITICAL);
-        }
-    }
-    return(TNG_SUCCESS);
+    return(tng_gen_data_vector_get(tng_data, block_id, TNG_TRUE, values,
+                                   n_frames, stride_length, n_particles,
+                                   n_values_per_frame, type));
 }
 
-/* FIXME: This needs ***values */
-tng_function_status DECLSPECDLLEXPORT tng_data_values_free
+tng_function_status DECLSPECDLLEXPORT tng_particle_data_interval_get
                 (const tng_trajectory_t tng_data,
-                 union data_values **values,
-                 const int64_t n_frames,
-                 const int64_t n_values_per_frame,
-                 const char type)
+                 const int64_t block_id,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
+                 union data_values ****values,
+                 int64_t *n_particles,
+                 int64_t *n_values_per_frame,
+                 char *type)
 {
-    int64_t i, j;
-    (void)tng_data;
-
-    if(values)
-    {
-        for(i = 0; i < n_frames; i++)
-        {
-            if(values[i])
-            {
-                if(type == TNG_CHAR_DATA)
-                {
-                    for(j = 0; j < n_values_per_frame; j++)
-                    {
-                        if(values[i][j].c)
-                        {
-                            free(values[i][j].c);
-                            values[i][j].c = 0;
-                        }
-                    }
-                }
-                free(values[i]);
-                values[i] = 0;
-            }
-        }
-        free(values);
-        values = 0;
-    }
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    return(TNG_SUCCESS);
+    return(tng_gen_data_interval_get(tng_data, block_id, TNG_TRUE, start_frame_nr,
+                                     end_frame_nr, hash_mode, values, n_particles,
+                                     n_values_per_frame, type));
 }
 
-static tng_function_status tng_particle_data_values_alloc
+/**
+ * @brief Read the contents of a data block of a non-particle data series
+ * and find the frames with data in an interval.
+ * @param tng_data is a trajectory data container.
+ * @param block is the block, whose header has just been read.
+ * @param start_frame_nr is the first frame of the interval.
+ * @param end_frame_nr is the last frame of the interval.
+ * @param series_block is set to the contents of the data block and the
+ * frames to extract from it.
+ * @param datatype is set to the type of the data.
+ * @param n_values is set to the number of values per frame.
+ * @details The contents are not uncompressed here, see
+ * tng_data_series_block_decode().
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the block does
+ * not contain non-particle data that can be extracted or TNG_CRITICAL (2) if
+ * a major error has occured.
+ */
+static tng_function_status tng_data_series_block_read
                 (const tng_trajectory_t tng_data,
-                 union data_values ****values,
-                 const int64_t n_frames,
-                 const int64_t n_particles,
-                 const int64_t n_values_per_frame,
-                 const char type)
+                 const tng_gen_block_t block,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 struct tng_data_series_block *series_block,
+                 char *datatype,
+                 int64_t *n_values)
 {
-    int64_t i, j;
-    tng_function_status stat;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    int64_t offset, first_frame_with_data, stride_length, n_frames, n_frames_div, last_value;
+    int size;
+    char dependency, sparse_data = 0;
+    char *contents;
 
-    if(n_particles == 0 || n_values_per_frame == 0)
+    /* The smallest possible meta information. */
+    if(block->block_contents_size < 2 + 2 * (int64_t)sizeof(int64_t))
     {
-        return(TNG_FAILURE);
+        fprintf(stderr, "TNG library: Data block (%s) too short. %s: %d\n",
+                block->name, __FILE__, __LINE__);
+        return(TNG_CRITICAL);
     }
 
-    if(*values)
-    {
-        stat = tng_particle_data_values_free(tng_data, *values, n_frames,
-                                             n_particles, n_values_per_frame,
-                                             type);
-        if(stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot free particle data values. %s: %d\n",
-                   __FILE__, __LINE__);
-            return(stat);
-        }
-    }
-    *values = (union data_values ***)malloc(sizeof(union data_values **) * n_frames);
-    if(!*values)
+    contents = (char *)malloc(block->block_contents_size);
+    if(!contents)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
                 __FILE__, __LINE__);
         return(TNG_CRITICAL);
-
+    }
+    if(tng_fread(tng_data, contents, block->block_contents_size, 1, tng_data->input_file) == 0)
+    {
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+        free(contents);
+        return(TNG_CRITICAL);
     }
 
-    for(i = 0; i < n_frames; i++)
+    /* The meta information is the same as read by
+     * tng_data_block_meta_information_read(). */
+    *datatype = contents[0];
+    dependency = contents[1];
+    offset = 2;
+    if(dependency & TNG_FRAME_DEPENDENT)
     {
-        (*values)[i] = (union data_values **)malloc(sizeof(union data_values *) *
-                           n_particles);
-        if(!(*values)[i])
+        sparse_data = contents[offset++];
+    }
+    tng_buffer_numerical_64_get(tng_data, n_values, contents + offset);
+    offset += sizeof(int64_t);
+    tng_buffer_numerical_64_get(tng_data, &series_block->codec_id, contents + offset);
+    offset += sizeof(int64_t);
+    if(series_block->codec_id != TNG_UNCOMPRESSED)
+    {
+        /* The multiplier is not used by the codecs of non-particle data. */
+        offset += sizeof(double);
+    }
+    if((dependency & TNG_FRAME_DEPENDENT) && sparse_data)
+    {
+        if(offset + 2 * (int64_t)sizeof(int64_t) > block->block_contents_size)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                    __FILE__, __LINE__);
-            free(*values);
-            *values = 0;
+            fprintf(stderr, "TNG library: Data block (%s) too short. %s: %d\n",
+                    block->name, __FILE__, __LINE__);
+            free(contents);
             return(TNG_CRITICAL);
         }
-        for(j = 0; j < n_particles; j++)
-        {
-            (*values)[i][j] = (union data_values *)malloc(sizeof(union data_values) *
-                                  n_values_per_frame);
-            if(!(*values)[i][j])
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                        __FILE__, __LINE__);
-                tng_particle_data_values_free(tng_data, *values, n_frames,
-                                              n_particles, n_values_per_frame,
-                                              type);
-                *values = 0;
-                return(TNG_CRITICAL);
-            }
-        }
+        tng_buffer_numerical_64_get(tng_data, &first_frame_with_data, contents + offset);
+        offset += sizeof(int64_t);
+        tng_buffer_numerical_64_get(tng_data, &stride_length, contents + offset);
+        offset += sizeof(int64_t);
+        n_frames = frame_set->n_frames - (first_frame_with_data - frame_set->first_frame);
     }
-    return(TNG_SUCCESS);
-}
-
-/* FIXME: This needs ****values */
-tng_function_status DECLSPECDLLEXPORT tng_particle_data_values_free
-                (const tng_trajectory_t tng_data,
-                 union data_values ***values,
-                 const int64_t n_frames,
-                 const int64_t n_particles,
-                 const int64_t n_values_per_frame,
-                 const char type)
-{
-    int64_t i, j, k;
-    (void)tng_data;
-
-    if(values)
+    else if(dependency & TNG_FRAME_DEPENDENT)
     {
-        for(i = 0; i < n_frames; i++)
-        {
-            if(values[i])
-            {
-                for(j = 0; j < n_particles; j++)
-                {
-                    if(type == TNG_CHAR_DATA)
-                    {
-                        for(k = 0; k < n_values_per_frame; k++)
-                        {
-                            if(values[i][j][k].c)
-                            {
-                                free(values[i][j][k].c);
-                                values[i][j][k].c = 0;
-                            }
-                        }
-                    }
-                    free(values[i][j]);
-                    values[i][j] = 0;
-                }
-                free(values[i]);
-                values[i] = 0;
-            }
-        }
-        free(values);
-        values = 0;
+        first_frame_with_data = frame_set->first_frame;
+        stride_length = 1;
+        n_frames = frame_set->n_frames;
+    }
+    else
+    {
+        first_frame_with_data = frame_set->first_frame;
+        stride_length = 1;
+        n_frames = 1;
     }
 
-    return(TNG_SUCCESS);
-}
-
-static tng_function_status tng_gen_data_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 const tng_bool is_particle_data,
-                 union data_values ****values,
-                 int64_t *n_frames,
-                 int64_t *n_particles,
-                 int64_t *n_values_per_frame,
-                 char *type)
-{
-    int64_t i, j, k, mapping, file_pos, i_step, block_index;
-    int size;
-    size_t len;
-    tng_data_t data;
-    tng_trajectory_frame_set_t frame_set;
-    tng_gen_block_t block;
-    char block_type_flag;
-    tng_function_status stat;
+    switch(*datatype)
+    {
+    case TNG_INT_DATA:
+        size = sizeof(int64_t);
+        break;
+    case TNG_FLOAT_DATA:
+        size = sizeof(float);
+        break;
+    case TNG_DOUBLE_DATA:
+        size = sizeof(double);
+        break;
+    case TNG_CHAR_DATA:
+    default:
+        free(contents);
+        return(TNG_FAILURE);
+    }
 
-    frame_set = &tng_data->current_trajectory_frame_set;
+    if((dependency & TNG_PARTICLE_DEPENDENT) || stride_length < 1 || *n_values < 1 ||
+       (series_block->codec_id != TNG_UNCOMPRESSED &&
+        series_block->codec_id != TNG_GZIP_COMPRESSION) ||
+       offset > block->block_contents_size)
+    {
+        free(contents);
+        return(TNG_FAILURE);
+    }
 
-    block_index = -1;
-    data = 0;
+    n_frames_div = (tng_max_i64(1, n_frames) + stride_length - 1) / stride_length;
 
-    if(is_particle_data == TNG_TRUE)
+    if(start_frame_nr <= first_frame_with_data)
     {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
+        series_block->first_value = 0;
     }
     else
     {
-        stat = tng_data_find(tng_data, block_id, &data);
+        series_block->first_value = (start_frame_nr - first_frame_with_data + stride_length - 1) /
+                                    stride_length;
     }
-
-    if(tng_data->current_trajectory_frame_set_input_file_pos > 0)
+    if(end_frame_nr < first_frame_with_data)
     {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
+        last_value = -1;
     }
     else
     {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+        last_value = tng_min_i64(n_frames_div - 1,
+                                 (end_frame_nr - first_frame_with_data) / stride_length);
     }
 
-    if(stat != TNG_SUCCESS)
-    {
-        tng_block_init(&block);
-        file_pos = ftello(tng_data->input_file);
-        /* Read all blocks until next frame set block */
-        stat = tng_block_header_read(tng_data, block);
-        while(file_pos < tng_data->input_file_len &&
-                stat != TNG_CRITICAL &&
-                block->id != TNG_TRAJECTORY_FRAME_SET &&
-                block->id != -1)
-        {
-            /* Use hash by default */
-            stat = tng_block_read_next(tng_data, block,
-                                    TNG_USE_HASH);
-            if(stat != TNG_CRITICAL)
-            {
-                file_pos = ftello(tng_data->input_file);
-                if(file_pos < tng_data->input_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
-            }
-        }
-        tng_block_destroy(&block);
-        if(stat == TNG_CRITICAL)
-        {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    file_pos, __FILE__, __LINE__);
-            return(stat);
-        }
+    series_block->contents = contents;
+    series_block->contents_len = block->block_contents_size;
+    series_block->data_offset = offset;
+    series_block->data_len = n_frames_div * size * (*n_values);
+    series_block->n_frames = tng_max_i64(0, last_value - series_block->first_value + 1);
+    series_block->first_frame_nr = first_frame_with_data +
+                                   series_block->first_value * stride_length;
+    series_block->stride_length = stride_length;
+    memcpy(series_block->md5_hash, block->md5_hash, TNG_MD5_HASH_LEN);
 
-        if(is_particle_data == TNG_TRUE)
-        {
-            for(i = 0; i < frame_set->n_particle_data_blocks; i++)
-            {
-                data = &frame_set->tr_particle_data[i];
-                if(data->block_id == block_id)
-                {
-                    block_index = i;
-                    block_type_flag = TNG_TRAJECTORY_BLOCK;
-                    break;
-                }
-            }
-        }
-        else
-        {
-            for(i = 0; i < frame_set->n_data_blocks; i++)
-            {
-                data = &frame_set->tr_data[i];
-                if(data->block_id == block_id)
-                {
-                    block_index = i;
-                    break;
-                }
-            }
-        }
-        if(block_index < 0)
-        {
-            return(TNG_FAILURE);
-        }
-    }
+    return(TNG_SUCCESS);
+}
 
-    if(is_particle_data == TNG_TRUE)
-    {
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK &&
-           tng_data->var_num_atoms_flag)
-        {
-            *n_particles = frame_set->n_particles;
-        }
-        else
+/**
+ * @brief Uncompress the contents of a data block of a non-particle data
+ * series and copy the frames to extract to the output.
+ * @param tng_data is a trajectory data container.
+ * @param series_block is the data block, as read by
+ * tng_data_series_block_read().
+ * @param datatype is the type of the data.
+ * @param n_values is the number of values per frame.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param values is the output array of all blocks.
+ * @param frame_nrs is the output array of the frame numbers of all blocks
+ * (or NULL).
+ * @details This does not change tng_data, so several blocks can be decoded
+ * concurrently.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_series_block_decode
+                (const tng_trajectory_t tng_data,
+                 struct tng_data_series_block *series_block,
+                 const char datatype,
+                 const int64_t n_values,
+                 const char hash_mode,
+                 char *values,
+                 int64_t *frame_nrs)
+{
+    int64_t i, frame_size, data_len, start_ticks;
+    int size;
+    char hash[TNG_MD5_HASH_LEN];
+    char *output;
+    md5_state_t md5_state;
+    tng_function_status stat = TNG_SUCCESS;
+
+    if(hash_mode == TNG_USE_HASH &&
+       strncmp(series_block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
+    {
+        md5_init(&md5_state);
+        tng_md5_append(tng_data, &md5_state, (md5_byte_t *)series_block->contents,
+                       series_block->contents_len);
+        md5_finish(&md5_state, (md5_byte_t *)hash);
+        if(strncmp(series_block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
         {
-            *n_particles = tng_data->n_particles;
+            fprintf(stderr, "TNG library: Data block contents corrupt. Hashes do not match. "
+                    "%s: %d\n", __FILE__, __LINE__);
         }
     }
 
-    *n_frames = tng_max_i64(1, data->n_frames);
-    *n_values_per_frame = data->n_values_per_frame;
-    *type = data->datatype;
+    size = datatype == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double);
+    frame_size = size * n_values;
 
-    if(is_particle_data == TNG_TRUE)
+    /* Move the data to the start of the buffer, which can then be replaced
+     * by the uncompressed data. */
+    data_len = series_block->contents_len - series_block->data_offset;
+    memmove(series_block->contents, series_block->contents + series_block->data_offset,
+            data_len);
+    if(series_block->codec_id == TNG_GZIP_COMPRESSION)
     {
-        if(*values == 0)
+        start_ticks = tng_statistics_timer_start(tng_data);
+        stat = tng_gzip_uncompress(tng_data, &series_block->contents, data_len,
+                                   series_block->data_len);
+        tng_statistics_timer_stop(tng_data, &tng_data->statistics.gzip_uncompress_ticks,
+                                  start_ticks);
+        if(stat != TNG_SUCCESS)
         {
-            if(tng_particle_data_values_alloc(tng_data, values, *n_frames,
-                                             *n_particles, *n_values_per_frame,
-                                             *type) != TNG_SUCCESS)
-            {
-                return(TNG_CRITICAL);
-            }
+            fprintf(stderr, "TNG library: Could not read gzipped block data. %s: %d\n", __FILE__,
+                    __LINE__);
+            return(TNG_CRITICAL);
         }
+        data_len = series_block->data_len;
+    }
+    if((series_block->first_value + series_block->n_frames) * frame_size > data_len)
+    {
+        fprintf(stderr, "TNG library: Data block too short. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
 
-        i_step = (*n_particles) * (*n_values_per_frame);
+    output = values + series_block->output_offset * frame_size;
+    memcpy(output, series_block->contents + series_block->first_value * frame_size,
+           series_block->n_frames * frame_size);
 
-        /* It's not very elegant to reuse so much of the code in the different case
-         * statements, but it's unnecessarily slow to have the switch-case block
-         * inside the for loops. */
-        switch(*type)
-        {
-        case TNG_CHAR_DATA:
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k = 0; k < *n_values_per_frame; k++)
-                    {
-                        len = strlen(data->strings[i][j][k]) + 1;
-                        (*values)[i][mapping][k].c = (char *)malloc(len);
-                        strncpy((*values)[i][mapping][k].c,
-                                data->strings[i][j][k], len);
-                    }
-                }
-            }
-            break;
-        case TNG_INT_DATA:
-            size = sizeof(int);
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k = 0; k < *n_values_per_frame; k++)
-                    {
-                        (*values)[i][mapping][k].i = *(int *)
-                                                     ((char *)data->values + size *
-                                                     (i * i_step + j *
-                                                      (*n_values_per_frame) + k));
-                    }
-                }
-            }
-            break;
-        case TNG_FLOAT_DATA:
-            size = sizeof(float);
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k = 0; k < *n_values_per_frame; k++)
-                    {
-                        (*values)[i][mapping][k].f = *(float *)
-                                                     ((char *)data->values + size *
-                                                     (i * i_step + j *
-                                                      (*n_values_per_frame) + k));
-                    }
-                }
-            }
-            break;
-        case TNG_DOUBLE_DATA:
-        default:
-            size = sizeof(double);
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k = 0; k < *n_values_per_frame; k++)
-                    {
-                        (*values)[i][mapping][k].d = *(double *)
-                                                     ((char *)data->values + size *
-                                                     (i * i_step + j *
-                                                      (*n_values_per_frame) + k));
-                    }
-                }
-            }
-        }
+    if(datatype == TNG_FLOAT_DATA)
+    {
+        stat = tng_swap_byte_order_array_32(tng_data, tng_data->input_endianness_swap_func_32,
+                                            output, series_block->n_frames * n_values);
     }
     else
     {
-        if(*(values[0]) == 0)
-        {
-            if(tng_data_values_alloc(tng_data, values[0], *n_frames,
-                                     *n_values_per_frame,
-                                     *type) != TNG_SUCCESS)
-            {
-                return(TNG_CRITICAL);
-            }
-        }
-        switch(*type)
+        stat = tng_swap_byte_order_array_64(tng_data, tng_data->input_endianness_swap_func_64,
+                                            output, series_block->n_frames * n_values);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                __FILE__, __LINE__);
+    }
+
+    if(frame_nrs)
+    {
+        for(i = 0; i < series_block->n_frames; i++)
         {
-        case TNG_CHAR_DATA:
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    len = strlen(data->strings[0][i][j]) + 1;
-                    (*values)[0][i][j].c = (char *)malloc(len);
-                    strncpy((*values)[0][i][j].c, data->strings[0][i][j], len);
-                }
-            }
-            break;
-        case TNG_INT_DATA:
-            size = sizeof(int);
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    (*values)[0][i][j].i = *(int *)((char *)data->values + size *
-                                                    (i*(*n_values_per_frame) + j));
-                }
-            }
-            break;
-        case TNG_FLOAT_DATA:
-            size = sizeof(float);
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    (*values)[0][i][j].f = *(float *)((char *)data->values + size *
-                                                   (i*(*n_values_per_frame) + j));
-                }
-            }
-            break;
-        case TNG_DOUBLE_DATA:
-        default:
-            size = sizeof(double);
-            for(i = 0; i < *n_frames; i++)
-            {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    (*values)[0][i][j].d = *(double *)((char *)data->values + size *
-                                                       (i*(*n_values_per_frame) + j));
-                }
-            }
+            frame_nrs[series_block->output_offset + i] = series_block->first_frame_nr +
+                                                         i * series_block->stride_length;
         }
     }
 
-    data->last_retrieved_frame = frame_set->first_frame + data->n_frames - 1;
-
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_data_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 union data_values ***values,
-                 int64_t *n_frames,
-                 int64_t *n_values_per_frame,
-                 char *type)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
-
-    return(tng_gen_data_get(tng_data, block_id, TNG_FALSE, &values, n_frames, 0,
-                            n_values_per_frame, type));
-}
-
-static tng_function_status tng_gen_data_vector_get
+tng_function_status DECLSPECDLLEXPORT tng_data_series_get
                 (const tng_trajectory_t tng_data,
                  const int64_t block_id,
-                 const tng_bool is_particle_data,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
                  void **values,
+                 int64_t **frame_nrs,
                  int64_t *n_frames,
-                 int64_t *stride_length,
-                 int64_t *n_particles,
                  int64_t *n_values_per_frame,
                  char *type)
 {
-    int64_t i, j, mapping, file_pos, i_step, full_data_len, n_frames_div;
-    int64_t block_index;
+    struct tng_data_series_block *series_blocks = 0, *temp_blocks;
+    int64_t i, n_series_blocks = 0, series_blocks_capacity = 0, file_pos, next_frame_set_pos;
+    int64_t block_n_values, tot_n_frames = 0;
     int size;
-    tng_data_t data;
+    char datatype;
     tng_trajectory_frame_set_t frame_set;
     tng_gen_block_t block;
     void *temp;
-    char block_type_flag;
     tng_function_status stat;
 
-    frame_set = &tng_data->current_trajectory_frame_set;
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than the end_frame_nr.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
+    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    block_index = -1;
-    data = 0;
+    *n_frames = 0;
 
-    if(is_particle_data == TNG_TRUE)
+    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
+    if(stat != TNG_SUCCESS)
     {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
+        return(stat);
     }
-    else
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    tng_block_init(&block);
+
+    /* The contents of the frame set block have already been read. */
+    tng_fseeko(tng_data, tng_data->input_file, tng_data->current_trajectory_frame_set_input_file_pos,
+               SEEK_SET);
+    stat = tng_block_header_read(tng_data, block);
+    if(stat == TNG_SUCCESS)
     {
-        stat = tng_data_find(tng_data, block_id, &data);
+        tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
     }
 
-    if(stat != TNG_SUCCESS)
+    /* Read the contents of the requested data block of each frame set. All
+     * other blocks, e.g. large particle data blocks, are skipped using only
+     * their headers. */
+    while(stat == TNG_SUCCESS && frame_set->first_frame <= end_frame_nr)
     {
-        tng_block_init(&block);
         file_pos = ftello(tng_data->input_file);
-        /* Read all blocks until next frame set block */
-        stat = tng_block_header_read(tng_data, block);
-        while(file_pos < tng_data->input_file_len &&
-                stat != TNG_CRITICAL &&
-                block->id != TNG_TRAJECTORY_FRAME_SET &&
-                block->id != -1)
+        while(stat == TNG_SUCCESS && file_pos < tng_data->input_file_len)
         {
-            /* Use hash by default */
-            stat = tng_block_read_next(tng_data, block,
-                                    TNG_USE_HASH);
-            if(stat != TNG_CRITICAL)
+            stat = tng_block_header_read(tng_data, block);
+            if(stat != TNG_SUCCESS || block->id == TNG_TRAJECTORY_FRAME_SET)
             {
-                file_pos = ftello(tng_data->input_file);
-                if(file_pos < tng_data->input_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
+                break;
+            }
+            file_pos += block->header_contents_size + block->block_contents_size;
+            if(block->id != block_id)
+            {
+                tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
+                continue;
+            }
+
+            temp_blocks = (struct tng_data_series_block *)
+                          tng_array_grow(series_blocks, &series_blocks_capacity,
+                                         n_series_blocks + 1,
+                                         sizeof(struct tng_data_series_block));
+            if(!temp_blocks)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                stat = TNG_CRITICAL;
+                break;
+            }
+            series_blocks = temp_blocks;
+
+            stat = tng_data_series_block_read(tng_data, block, start_frame_nr, end_frame_nr,
+                                              &series_blocks[n_series_blocks],
+                                              &datatype, &block_n_values);
+            if(stat != TNG_SUCCESS)
+            {
+                break;
+            }
+            if(n_series_blocks == 0)
+            {
+                *type = datatype;
+                *n_values_per_frame = block_n_values;
+            }
+            else if(datatype != *type || block_n_values != *n_values_per_frame)
+            {
+                fprintf(stderr, "TNG library: The data type or number of values of data block "
+                        "%" PRId64 " changes between frame sets. %s: %d\n", block_id,
+                        __FILE__, __LINE__);
+                free(series_blocks[n_series_blocks].contents);
+                stat = TNG_FAILURE;
+                break;
+            }
+            if(series_blocks[n_series_blocks].n_frames == 0)
+            {
+                free(series_blocks[n_series_blocks].contents);
+                continue;
             }
+            series_blocks[n_series_blocks].output_offset = tot_n_frames;
+            tot_n_frames += series_blocks[n_series_blocks].n_frames;
+            n_series_blocks++;
         }
-        tng_block_destroy(&block);
-        if(stat == TNG_CRITICAL)
+        if(stat != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    file_pos, __FILE__, __LINE__);
-            return(stat);
+            break;
         }
 
-        for(i = 0; i < frame_set->n_particle_data_blocks; i++)
+        next_frame_set_pos = frame_set->next_frame_set_file_pos;
+        if(next_frame_set_pos <= 0)
         {
-            data = &frame_set->tr_particle_data[i];
-            if(data->block_id == block_id)
+            /* After the last frame set of a file continue with the next
+             * file, if the trajectory is split into several files. */
+            if(tng_data->current_input_segment + 1 >= tng_data->n_input_segments)
+            {
+                break;
+            }
+            stat = tng_input_segment_activate(tng_data, tng_data->current_input_segment + 1);
+            if(stat != TNG_SUCCESS)
+            {
+                break;
+            }
+            next_frame_set_pos = tng_data->first_trajectory_frame_set_input_file_pos;
+            if(next_frame_set_pos <= 0)
             {
-                block_index = i;
                 break;
             }
         }
-        if(block_index < 0)
+        tng_fseeko(tng_data, tng_data->input_file, next_frame_set_pos, SEEK_SET);
+        stat = tng_block_header_read(tng_data, block);
+        if(stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
         {
-            return(TNG_FAILURE);
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    next_frame_set_pos, __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+            break;
         }
+        tng_data->current_trajectory_frame_set_input_file_pos = next_frame_set_pos;
+        stat = tng_block_read_next(tng_data, block, hash_mode);
     }
 
-    if(is_particle_data == TNG_TRUE)
+    tng_block_destroy(&block);
+
+    if(stat == TNG_SUCCESS && tot_n_frames == 0)
     {
-        if(tng_data->current_trajectory_frame_set_input_file_pos > 0)
+        stat = TNG_FAILURE;
+    }
+
+    if(stat == TNG_SUCCESS)
+    {
+        size = *type == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double);
+        temp = realloc(*values, size * (*n_values_per_frame) * tot_n_frames);
+        if(!temp)
         {
-            block_type_flag = TNG_TRAJECTORY_BLOCK;
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(*values);
+            *values = 0;
+            stat = TNG_CRITICAL;
         }
         else
         {
-            block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+            *values = temp;
         }
-
-       if(block_type_flag == TNG_TRAJECTORY_BLOCK &&
-          tng_data->var_num_atoms_flag)
+    }
+    if(stat == TNG_SUCCESS && frame_nrs)
+    {
+        temp = realloc(*frame_nrs, sizeof(int64_t) * tot_n_frames);
+        if(!temp)
         {
-            *n_particles = frame_set->n_particles;
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(*frame_nrs);
+            *frame_nrs = 0;
+            stat = TNG_CRITICAL;
         }
         else
         {
-            *n_particles = tng_data->n_particles;
+            *frame_nrs = (int64_t *)temp;
         }
     }
 
-    *type = data->datatype;
-
-    switch(*type)
+    if(stat == TNG_SUCCESS)
     {
-    case TNG_CHAR_DATA:
-        return(TNG_FAILURE);
-    case TNG_INT_DATA:
-        size = sizeof(int64_t);
-        break;
-    case TNG_FLOAT_DATA:
-        size = sizeof(float);
-        break;
-    case TNG_DOUBLE_DATA:
-    default:
-        size = sizeof(double);
+        stat = tng_statistics_threads_begin(tng_data);
     }
 
-    *n_frames = tng_max_i64(1, data->n_frames);
-    *n_values_per_frame = data->n_values_per_frame;
-    *stride_length = data->stride_length;
-
-    n_frames_div = (*n_frames % *stride_length) ?
-                   *n_frames / *stride_length + 1:
-                   *n_frames / *stride_length;
-
-    full_data_len = n_frames_div * size *
-                (*n_values_per_frame);
-    if(is_particle_data == TNG_TRUE)
+    if(stat == TNG_SUCCESS)
     {
-        full_data_len *= (*n_particles);
-    }
+        /* The blocks fill separate parts of the output, so they can be
+         * uncompressed concurrently. */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(i = 0; i < n_series_blocks; i++)
+        {
+            tng_function_status block_stat;
 
-    temp = (char *)realloc(*values, full_data_len);
-    if(!temp)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(*values);
-        *values = 0;
-        return(TNG_CRITICAL);
+            block_stat = tng_data_series_block_decode(tng_data, &series_blocks[i], *type,
+                                                      *n_values_per_frame, hash_mode,
+                                                      (char *)*values,
+                                                      frame_nrs ? *frame_nrs : 0);
+            if(block_stat != TNG_SUCCESS)
+            {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+                {
+                    if(block_stat > stat)
+                    {
+                        stat = block_stat;
+                    }
+                }
+            }
+        }
+        tng_statistics_threads_end(tng_data);
     }
 
-    *values = temp;
-
-    if(is_particle_data != TNG_TRUE || frame_set->n_mapping_blocks <= 0)
+    for(i = 0; i < n_series_blocks; i++)
     {
-        memcpy(*values, data->values, full_data_len);
+        free(series_blocks[i].contents);
     }
-    else
+    if(series_blocks)
     {
-        i_step = (*n_particles) * (*n_values_per_frame);
-        for(i = 0; i < *n_frames; i++)
-        {
-            for(j = 0; j < *n_particles; j++)
-            {
-                tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                memcpy(((char *)*values) + size * (i * i_step + mapping *
-                       (*n_values_per_frame)),
-                       (char *)data->values + size *
-                       (i * i_step + j * (*n_values_per_frame)),
-                       size * (*n_values_per_frame));
-            }
-        }
+        free(series_blocks);
     }
 
-    data->last_retrieved_frame = frame_set->first_frame + data->n_frames - 1;
+    if(stat == TNG_SUCCESS)
+    {
+        *n_frames = tot_n_frames;
+    }
 
-    return(TNG_SUCCESS);
+    return(stat);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_data_vector_get
+tng_function_status DECLSPECDLLEXPORT tng_particle_data_vector_interval_get
                 (const tng_trajectory_t tng_data,
                  const int64_t block_id,
+                 const int64_t start_frame_nr,
+                 const int64_t end_frame_nr,
+                 const char hash_mode,
                  void **values,
-                 int64_t *n_frames,
+                 int64_t *n_particles,
                  int64_t *stride_length,
                  int64_t *n_values_per_frame,
                  char *type)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
     TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
     TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
     TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    return(tng_gen_data_vector_get(tng_data, block_id, TNG_FALSE, values,
-                                   n_frames, stride_length, 0, n_values_per_frame,
-                                   type));
+    return(tng_gen_data_vector_interval_get(tng_data, block_id, TNG_TRUE,
+                                            start_frame_nr, end_frame_nr,
+                                            hash_mode, values, n_particles,
+                                            stride_length, n_values_per_frame,
+                                            type));
 }
 
-static tng_function_status tng_gen_data_interval_get
+tng_function_status DECLSPECDLLEXPORT tng_data_iterator_init
                 (const tng_trajectory_t tng_data,
                  const int64_t block_id,
-                 const tng_bool is_particle_data,
                  const int64_t start_frame_nr,
                  const int64_t end_frame_nr,
                  const char hash_mode,
-                 union data_values ****values,
+                 tng_data_iterator_t *iterator_p)
+{
+    tng_data_iterator_t iterator;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than the end_frame_nr.");
+    TNG_ASSERT(iterator_p, "TNG library: iterator_p must not be a NULL pointer.");
+
+    if(tng_input_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+
+    iterator = (tng_data_iterator_t)malloc(sizeof(struct tng_data_iterator));
+    if(!iterator)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        *iterator_p = 0;
+        return(TNG_CRITICAL);
+    }
+
+    iterator->block_id = block_id;
+    iterator->end_frame_nr = end_frame_nr;
+    iterator->next_frame_nr = start_frame_nr;
+    iterator->frame_set_file_pos = -1;
+    iterator->input_segment = -1;
+    iterator->has_data = TNG_FALSE;
+    iterator->hash_mode = hash_mode;
+    iterator->frame_values = 0;
+    iterator->frame_values_size = 0;
+
+    *iterator_p = iterator;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_iterator_next
+                (const tng_trajectory_t tng_data,
+                 const tng_data_iterator_t iterator,
+                 int64_t *frame_nr,
+                 const void **values,
                  int64_t *n_particles,
                  int64_t *n_values_per_frame,
                  char *type)
 {
-    int64_t i, j, k, mapping, n_frames, file_pos, current_frame_pos, i_step;
-    int64_t first_frame, block_index;
+    int64_t i, first_frame, stride_length, n_frames_div, frame_index, frame;
+    int64_t frame_size, mapping;
+    const int64_t *mapping_table;
     int size;
-    size_t len;
-    tng_data_t data;
+    tng_bool is_particle_data;
     tng_trajectory_frame_set_t frame_set;
-    tng_gen_block_t block;
-    char block_type_flag;
+    tng_data_t data;
+    char *frame_values;
+    void *temp;
     tng_function_status stat;
 
-    block_index = -1;
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(iterator, "TNG library: iterator must not be a NULL pointer.");
+    TNG_ASSERT(frame_nr, "TNG library: frame_nr must not be a NULL pointer.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
     frame_set = &tng_data->current_trajectory_frame_set;
-    first_frame = frame_set->first_frame;
-
-    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
-    if(stat != TNG_SUCCESS)
-    {
-        return(stat);
-    }
 
-    /* Do not re-read the frame set. */
-    if((is_particle_data == TNG_TRUE &&
-       (first_frame != frame_set->first_frame ||
-        frame_set->n_particle_data_blocks <= 0)) ||
-       (is_particle_data == TNG_FALSE &&
-       (first_frame != frame_set->first_frame ||
-        frame_set->n_data_blocks <= 0)))
+    while(iterator->next_frame_nr <= iterator->end_frame_nr)
     {
-        tng_block_init(&block);
-        file_pos = ftello(tng_data->input_file);
-        /* Read all blocks until next frame set block */
-        stat = tng_block_header_read(tng_data, block);
-        while(file_pos < tng_data->input_file_len &&
-                stat != TNG_CRITICAL &&
-                block->id != TNG_TRAJECTORY_FRAME_SET &&
-                block->id != -1)
+        /* When starting, or if another frame set has been read since the
+         * last call, find the frame set of the next frame. Otherwise continue
+         * with the next frame set when all frames of the current one have
+         * been visited. Only the requested data block (and the particle
+         * mapping blocks) of each frame set are read. */
+        if(iterator->frame_set_file_pos < 0 ||
+           iterator->frame_set_file_pos != tng_data->current_trajectory_frame_set_input_file_pos ||
+           iterator->input_segment != tng_data->current_input_segment)
         {
-            stat = tng_block_read_next(tng_data, block,
-                                    hash_mode);
-            if(stat != TNG_CRITICAL)
+            stat = tng_frame_set_of_frame_find(tng_data, iterator->next_frame_nr);
+            if(stat != TNG_SUCCESS)
             {
-                file_pos = ftello(tng_data->input_file);
-                if(file_pos < tng_data->input_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
+                return(stat);
             }
+            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data,
+                                                                      iterator->hash_mode,
+                                                                      iterator->block_id);
+        }
+        else if(iterator->next_frame_nr >= frame_set->first_frame + frame_set->n_frames)
+        {
+            if(frame_set->next_frame_set_file_pos <= 0 &&
+               tng_data->current_input_segment + 1 >= tng_data->n_input_segments)
+            {
+                break;
+            }
+            stat = tng_frame_set_read_next_only_data_from_block_id(tng_data,
+                                                                   iterator->hash_mode,
+                                                                   iterator->block_id);
+        }
+        else
+        {
+            stat = iterator->has_data ? TNG_SUCCESS : TNG_FAILURE;
         }
-        tng_block_destroy(&block);
         if(stat == TNG_CRITICAL)
         {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    file_pos, __FILE__, __LINE__);
             return(stat);
         }
-    }
+        iterator->frame_set_file_pos = tng_data->current_trajectory_frame_set_input_file_pos;
+        iterator->input_segment = tng_data->current_input_segment;
+        iterator->has_data = (stat == TNG_SUCCESS) ? TNG_TRUE : TNG_FALSE;
 
-    /* See if there is already a data block of this ID.
-     * Start checking the last read frame set */
-    if(is_particle_data == TNG_TRUE)
-    {
-        for(i = frame_set->n_particle_data_blocks; i-- ;)
+        if(iterator->next_frame_nr < frame_set->first_frame)
         {
-            data = &frame_set->tr_particle_data[i];
-            if(data->block_id == block_id)
-            {
-                block_index = i;
-                block_type_flag = TNG_TRAJECTORY_BLOCK;
-                break;
-            }
+            iterator->next_frame_nr = frame_set->first_frame;
         }
-    }
-    else
-    {
-        for(i = 0; i < frame_set->n_data_blocks; i++)
+
+        data = 0;
+        is_particle_data = TNG_TRUE;
+        if(iterator->has_data &&
+           tng_particle_data_find(tng_data, iterator->block_id, &data) != TNG_SUCCESS)
         {
-            data = &frame_set->tr_data[i];
-            if(data->block_id == block_id)
+            is_particle_data = TNG_FALSE;
+            if(tng_data_find(tng_data, iterator->block_id, &data) != TNG_SUCCESS)
             {
-                block_index = i;
-                break;
+                data = 0;
             }
         }
-    }
-
-    if(block_index < 0)
-    {
-        fprintf(stderr, "TNG library: Could not find particle data block with id %" PRId64 ". %s: %d\n",
-                block_id, __FILE__, __LINE__);
-        return(TNG_FAILURE);
-    }
+        /* Sparse data blocks are often not present in every frame set. */
+        if(!data)
+        {
+            iterator->next_frame_nr = frame_set->first_frame + frame_set->n_frames;
+            continue;
+        }
 
-    if(is_particle_data ==  TNG_TRUE)
-    {
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK &&
-           tng_data->var_num_atoms_flag)
+        if(data->dependency & TNG_FRAME_DEPENDENT)
         {
-            *n_particles = frame_set->n_particles;
+            first_frame = data->first_frame_with_data;
+            stride_length = tng_max_i64(1, data->stride_length);
+            n_frames_div = (tng_max_i64(1, data->n_frames) + stride_length - 1) / stride_length;
         }
         else
         {
-            *n_particles = tng_data->n_particles;
+            first_frame = frame_set->first_frame;
+            stride_length = tng_max_i64(1, frame_set->n_frames);
+            n_frames_div = 1;
         }
-    }
 
-    n_frames = end_frame_nr - start_frame_nr + 1;
-    *n_values_per_frame = data->n_values_per_frame;
-    *type = data->datatype;
-
-    if(*values == 0)
-    {
-        if(is_particle_data == TNG_TRUE)
+        if(iterator->next_frame_nr <= first_frame)
         {
-            if(tng_particle_data_values_alloc(tng_data, values, n_frames,
-                                             *n_particles, *n_values_per_frame,
-                                             *type) != TNG_SUCCESS)
-            {
-                return(TNG_CRITICAL);
-            }
+            frame_index = 0;
         }
         else
         {
-            if(tng_data_values_alloc(tng_data, *values, n_frames,
-                                     *n_values_per_frame,
-                                     *type) != TNG_SUCCESS)
-            {
-                return(TNG_CRITICAL);
-            }
+            frame_index = (iterator->next_frame_nr - first_frame + stride_length - 1) /
+                          stride_length;
         }
-    }
+        frame = first_frame + frame_index * stride_length;
 
-    current_frame_pos = start_frame_nr - frame_set->first_frame;
+        if(frame_index >= n_frames_div ||
+           frame >= frame_set->first_frame + frame_set->n_frames)
+        {
+            iterator->next_frame_nr = frame_set->first_frame + frame_set->n_frames;
+            continue;
+        }
+        if(frame > iterator->end_frame_nr)
+        {
+            break;
+        }
 
-    if(is_particle_data == TNG_TRUE)
-    {
-        i_step = (*n_particles) * (*n_values_per_frame);
-    }
-    else
-    {
-        i_step = (*n_values_per_frame);
-    }
-    /* It's not very elegant to reuse so much of the code in the different case
-     * statements, but it's unnecessarily slow to have the switch-case block
-     * inside the for loops. */
-    switch(*type)
-    {
-    case TNG_CHAR_DATA:
-        for(i=0; i<n_frames; i++)
+        *type = data->datatype;
+
+        switch(*type)
         {
-            if(current_frame_pos == frame_set->n_frames)
-            {
-                stat = tng_frame_set_read_next(tng_data, hash_mode);
-                if(stat != TNG_SUCCESS)
-                {
-                    return(stat);
-                }
-                current_frame_pos = 0;
-            }
-            if(is_particle_data == TNG_TRUE)
+        case TNG_CHAR_DATA:
+            return(TNG_FAILURE);
+        case TNG_INT_DATA:
+            size = sizeof(int64_t);
+            break;
+        case TNG_FLOAT_DATA:
+            size = sizeof(float);
+            break;
+        case TNG_DOUBLE_DATA:
+        default:
+            size = sizeof(double);
+        }
+
+        *n_values_per_frame = data->n_values_per_frame;
+        frame_size = size * data->n_values_per_frame;
+        if(is_particle_data == TNG_TRUE)
+        {
+            if(tng_data->var_num_atoms_flag)
             {
-                for(j = 0; j < *n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k = 0; k < *n_values_per_frame; k++)
-                    {
-                        len = strlen(data->strings[current_frame_pos][j][k]) + 1;
-                        (*values)[i][mapping][k].c = (char *)malloc(len);
-                        strncpy((*values)[i][mapping][k].c, data->strings[current_frame_pos][j][k], len);
-                    }
-                }
+                *n_particles = frame_set->n_particles;
             }
             else
             {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    len = strlen(data->strings[0][current_frame_pos][j]) + 1;
-                    (*values)[0][i][j].c = (char *)malloc(len);
-                    strncpy((*values)[0][i][j].c, data->strings[0][current_frame_pos][j], len);
-                }
+                *n_particles = tng_data->n_particles;
             }
-            current_frame_pos++;
+            frame_size *= *n_particles;
         }
-        break;
-    case TNG_INT_DATA:
-        size = sizeof(int);
-        for(i=0; i<n_frames; i++)
+        else
         {
-            if(current_frame_pos == frame_set->n_frames)
+            *n_particles = 0;
+        }
+
+        frame_values = (char *)data->values + frame_index * frame_size;
+
+        /* Particle data is translated to real particle numbering in a buffer
+         * holding only one frame. */
+        if(is_particle_data == TNG_TRUE && frame_set->n_mapping_blocks > 0)
+        {
+            if(tng_particle_mapping_table_get(frame_set, *n_particles,
+                                              &mapping_table) != TNG_SUCCESS)
             {
-                stat = tng_frame_set_read_next(tng_data, hash_mode);
-                if(stat != TNG_SUCCESS)
-                {
-                    return(stat);
-                }
-                current_frame_pos = 0;
+                return(TNG_CRITICAL);
             }
-            if(is_particle_data == TNG_TRUE)
+            temp = tng_array_grow(iterator->frame_values,
+                                  &iterator->frame_values_size,
+                                  frame_size, 1);
+            if(!temp)
             {
-                for(j = 0; j < *n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k = 0; k < *n_values_per_frame; k++)
-                    {
-                        (*values)[i][mapping][k].i = *(int *)
-                                                     ((char *)data->values + size *
-                                                      (current_frame_pos *
-                                                       i_step + j *
-                                                       (*n_values_per_frame) + k));
-                    }
-                }
-                current_frame_pos++;
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                        __FILE__, __LINE__);
+                return(TNG_CRITICAL);
             }
-            else
+            iterator->frame_values = temp;
+            for(i = 0; i < *n_particles; i++)
             {
-                for(j = 0; j < *n_values_per_frame; j++)
+                mapping = mapping_table ? mapping_table[i] : i;
+                if(mapping < 0 || mapping >= *n_particles)
                 {
-                    (*values)[0][i][j].i = *(int *)((char *)data->values + size *
-                                                (current_frame_pos *
-                                                 i_step + j));
+                    fprintf(stderr, "TNG library: Particle mapping %" PRId64 " is outside "
+                            "the %" PRId64 " particles of the frame set. %s: %d\n",
+                            mapping, *n_particles, __FILE__, __LINE__);
+                    return(TNG_CRITICAL);
                 }
+                memcpy((char *)iterator->frame_values + mapping * size * data->n_values_per_frame,
+                       frame_values + i * size * data->n_values_per_frame,
+                       size * data->n_values_per_frame);
             }
+            frame_values = (char *)iterator->frame_values;
         }
-        break;
-    case TNG_FLOAT_DATA:
-        size = sizeof(float);
-        for(i=0; i<n_frames; i++)
+
+        iterator->next_frame_nr = frame + 1;
+
+        *frame_nr = frame;
+        *values = frame_values;
+
+        return(TNG_SUCCESS);
+    }
+
+    return(TNG_FAILURE);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_iterator_destroy
+                (tng_data_iterator_t *iterator_p)
+{
+    TNG_ASSERT(iterator_p, "TNG library: iterator_p must not be a NULL pointer.");
+
+    if(!*iterator_p)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    if((*iterator_p)->frame_values)
+    {
+        free((*iterator_p)->frame_values);
+    }
+    free(*iterator_p);
+    *iterator_p = 0;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_data_get_stride_length
+                (const tng_trajectory_t tng_data,
+                 const int64_t block_id,
+                 int64_t frame,
+                 int64_t *stride_length)
+{
+    tng_function_status stat;
+    tng_data_t data;
+    int64_t orig_file_pos, file_pos;
+    int is_particle_data;
+
+    if(tng_data->current_trajectory_frame_set_input_file_pos <= 0)
+    {
+        frame = 0;
+    }
+
+    if(frame >= 0)
+    {
+        stat = tng_frame_set_of_frame_find(tng_data, frame);
+        if(stat != TNG_SUCCESS)
         {
-            if(current_frame_pos == frame_set->n_frames)
-            {
-                stat = tng_frame_set_read_next(tng_data, hash_mode);
-                if(stat != TNG_SUCCESS)
-                {
-                    return(stat);
-                }
-                current_frame_pos = 0;
-            }
-            if(is_particle_data == TNG_TRUE)
+            return(stat);
+        }
+    }
+    orig_file_pos = tng_data->current_trajectory_frame_set_input_file_pos;
+    stat = tng_data_find(tng_data, block_id, &data);
+    if(stat != TNG_SUCCESS)
+    {
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+        if(stat != TNG_SUCCESS)
+        {
+            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+            /* If no specific frame was required read until this data block is found */
+            if(frame < 0)
             {
-                for(j=0; j<*n_particles; j++)
+                file_pos = ftello(tng_data->input_file);
+                while(stat != TNG_SUCCESS && file_pos < tng_data->input_file_len)
                 {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k=0; k<*n_values_per_frame; k++)
-                    {
-                        (*values)[i][mapping][k].f = *(float *)
-                                                     ((char *)data->values + size *
-                                                      (current_frame_pos *
-                                                       i_step + j *
-                                                       (*n_values_per_frame) + k));
-                    }
+                    stat = tng_frame_set_read_next_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+                    file_pos = ftello(tng_data->input_file);
                 }
             }
-            else
+            if(stat != TNG_SUCCESS)
             {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    (*values)[0][i][j].f = *(float *)((char *)data->values + size *
-                                                   (current_frame_pos *
-                                                    i_step + j));
-                }
+                tng_reread_frame_set_at_file_pos(tng_data, orig_file_pos);
+
+                return(stat);
             }
-            current_frame_pos++;
-        }
-        break;
-    case TNG_DOUBLE_DATA:
-    default:
-        size = sizeof(double);
-        for(i=0; i<n_frames; i++)
-        {
-            if(current_frame_pos == frame_set->n_frames)
+            stat = tng_data_find(tng_data, block_id, &data);
+            if(stat != TNG_SUCCESS)
             {
-                stat = tng_frame_set_read_next(tng_data, hash_mode);
+                stat = tng_particle_data_find(tng_data, block_id, &data);
                 if(stat != TNG_SUCCESS)
                 {
+                    tng_reread_frame_set_at_file_pos(tng_data, orig_file_pos);
+
                     return(stat);
                 }
-                current_frame_pos = 0;
-            }
-            if(is_particle_data == TNG_TRUE)
-            {
-                for(j=0; j<*n_particles; j++)
-                {
-                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                    for(k=0; k<*n_values_per_frame; k++)
-                    {
-                        (*values)[i][mapping][k].d = *(double *)
-                                                     ((char *)data->values + size *
-                                                      (current_frame_pos *
-                                                       i_step + j *
-                                                       (*n_values_per_frame) + k));
-                    }
+                else
+                {
+                    is_particle_data = 1;
                 }
             }
             else
             {
-                for(j = 0; j < *n_values_per_frame; j++)
-                {
-                    (*values)[0][i][j].d = *(double *)((char *)data->values + size *
-                                                    (current_frame_pos *
-                                                     i_step + j));
-                }
+                is_particle_data = 0;
             }
-            current_frame_pos++;
+        }
+        else
+        {
+            is_particle_data = 1;
         }
     }
-
-    data->last_retrieved_frame = end_frame_nr;
+    else
+    {
+        is_particle_data = 0;
+    }
+    if(is_particle_data)
+    {
+        *stride_length = data->stride_length;
+    }
+    else
+    {
+        *stride_length = data->stride_length;
+    }
+    tng_reread_frame_set_at_file_pos(tng_data, orig_file_pos);
 
     return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_data_interval_get
+tng_function_status DECLSPECDLLEXPORT tng_time_get_str
                 (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 const int64_t start_frame_nr,
-                 const int64_t end_frame_nr,
-                 const char hash_mode,
-                 union data_values ***values,
-                 int64_t *n_values_per_frame,
-                 char *type)
+                 char *time)
 {
+    struct tm *time_data;
+    time_t secs;
+    int retval;
+
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    TNG_ASSERT(time, "TNG library: time must not be a NULL pointer");
 
-    return(tng_gen_data_interval_get(tng_data, block_id, TNG_FALSE, start_frame_nr,
-                                     end_frame_nr, hash_mode, &values, 0,
-                                     n_values_per_frame, type));
+    secs = tng_data->time;
+
+    time_data = localtime(&secs); /* Returns a statically allocated variable. */
+    retval = TNG_SNPRINTF(time, TNG_MAX_DATE_STR_LEN,
+             "%4d-%02d-%02d %02d:%02d:%02d",
+             time_data->tm_year+1900, time_data->tm_mon+1, time_data->tm_mday,
+             time_data->tm_hour, time_data->tm_min, time_data->tm_sec);
+
+    /* handle return value (also) to quiet a -Wformat-truncation warning */
+    return( (retval < 0) ? TNG_SUCCESS : TNG_FAILURE );
 }
 
-static tng_function_status tng_gen_data_vector_interval_get
+
+/**
+ * @brief Read the definition of a data block of the current frame set,
+ * i.e. its meta information, without reading its data.
+ * @param tng_data is a trajectory data container.
+ * @param block is the data block, whose header has just been read.
+ * @details The data block is added to the current frame set without any
+ * values, so that writing data of following frame sets uses the same
+ * settings (stride length, codec etc.).
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_definition_read
                 (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 const tng_bool is_particle_data,
-                 const int64_t start_frame_nr,
-                 const int64_t end_frame_nr,
-                 const char hash_mode,
-                 void **values,
-                 int64_t *n_particles,
-                 int64_t *stride_length,
-                 int64_t *n_values_per_frame,
-                 char *type)
+                 const tng_gen_block_t block)
 {
-    int64_t n_frames, tot_n_frames, n_frames_div, n_frames_div_2, first_frame;
-    int64_t file_pos, current_frame_pos, last_frame_pos, full_data_len, frame_size;
-    int size;
-    tng_trajectory_frame_set_t frame_set;
+    int64_t start_pos, n_values, codec_id, n_frames, first_frame_with_data;
+    int64_t stride_length, block_n_particles, num_first_particle;
+    double multiplier;
+    char datatype, dependency, sparse_data;
+    tng_bool is_particle_data;
     tng_data_t data;
-    tng_gen_block_t block;
-    void *current_values = 0, *temp;
     tng_function_status stat;
 
-    frame_set = &tng_data->current_trajectory_frame_set;
-    first_frame = frame_set->first_frame;
+    start_pos = ftello(tng_data->input_file);
 
-    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
+    if(tng_data_block_meta_information_read(tng_data,
+                                            &datatype,
+                                            &dependency, &sparse_data,
+                                            &n_values, &codec_id,
+                                            &first_frame_with_data,
+                                            &stride_length, &n_frames,
+                                            &num_first_particle,
+                                            &block_n_particles,
+                                            &multiplier,
+                                            TNG_SKIP_HASH,
+                                            0) == TNG_CRITICAL)
+    {
+        fprintf(stderr, "TNG library: Cannot read data block (%s) meta information. %s: %d\n",
+            block->name, __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    tng_fseeko(tng_data, tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+
+    is_particle_data = (dependency & TNG_PARTICLE_DEPENDENT) ? TNG_TRUE : TNG_FALSE;
+
+    stat = tng_gen_data_block_add(tng_data, block->id, is_particle_data, block->name,
+                                  datatype, TNG_TRAJECTORY_BLOCK, n_frames, n_values,
+                                  stride_length, tng_max_i64(0, num_first_particle),
+                                  block_n_particles, codec_id, 0);
     if(stat != TNG_SUCCESS)
     {
-        return(stat);
+        return(TNG_CRITICAL);
     }
 
-    /* Do not re-read the frame set and only need the requested block + particle mapping blocks. */
-    /* TODO: Test that blocks are read correctly now that now all of them are read at the same time. */
     if(is_particle_data == TNG_TRUE)
     {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
+        stat = tng_particle_data_find(tng_data, block->id, &data);
     }
     else
     {
-        stat = tng_data_find(tng_data, block_id, &data);
+        stat = tng_data_find(tng_data, block->id, &data);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
     }
 
-    if(first_frame != frame_set->first_frame ||
-       stat != TNG_SUCCESS)
+    /* No values are stored, so memory is allocated when data is added. */
+    data->n_frames = 0;
+    data->dependency = dependency;
+    data->compression_multiplier = multiplier;
+    data->first_frame_with_data = first_frame_with_data;
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Read the last frame set of the input file to prepare appending
+ * to the file.
+ * @param tng_data is a trajectory data container.
+ * @details The last frame set is found using the position stored in the
+ * general info block, or, if the file was not closed properly, by following
+ * the frame sets from there. Only the frame set block is checked using its
+ * md5 hash. Apart from the particle mappings only the definitions of its data
+ * blocks are read, see tng_data_block_definition_read().
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_tail_read
+                (const tng_trajectory_t tng_data)
+{
+    int64_t file_pos;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_gen_block_t block;
+    tng_function_status stat = TNG_SUCCESS;
+
+    file_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+    if(file_pos <= 0)
     {
-        tng_block_init(&block);
-        if(stat != TNG_SUCCESS)
-        {
-            fseeko(tng_data->input_file,
-                  tng_data->current_trajectory_frame_set_input_file_pos,
-                  SEEK_SET);
-            stat = tng_block_header_read(tng_data, block);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n",
-                        __FILE__, __LINE__);
-                return(stat);
-            }
+        return(TNG_SUCCESS);
+    }
 
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
-        }
-        file_pos = ftello(tng_data->input_file);
-        /* Read until next frame set block */
+    tng_block_init(&block);
+
+    while(file_pos > 0)
+    {
+        tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
         stat = tng_block_header_read(tng_data, block);
-        while(file_pos < tng_data->input_file_len &&
-            stat != TNG_CRITICAL &&
-            block->id != TNG_TRAJECTORY_FRAME_SET &&
-            block->id != -1)
-        {
-            if(block->id == block_id || block->id == TNG_PARTICLE_MAPPING)
-            {
-                stat = tng_block_read_next(tng_data, block,
-                                        hash_mode);
-                if(stat != TNG_CRITICAL)
-                {
-                    file_pos = ftello(tng_data->input_file);
-                    if(file_pos < tng_data->input_file_len)
-                    {
-                        stat = tng_block_header_read(tng_data, block);
-                    }
-                }
-            }
-            else
-            {
-                file_pos += block->block_contents_size + block->header_contents_size;
-                fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
-                if(file_pos < tng_data->input_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
-            }
-        }
-        tng_block_destroy(&block);
-        if(stat == TNG_CRITICAL)
+        if(stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
         {
             fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
                     file_pos, __FILE__, __LINE__);
-            return(stat);
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
         }
+        tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
+        tng_data->last_trajectory_frame_set_input_file_pos = file_pos;
+        stat = tng_block_read_next(tng_data, block, TNG_USE_HASH);
+        if(stat != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return(TNG_CRITICAL);
+        }
+        file_pos = frame_set->next_frame_set_file_pos;
     }
-    if(is_particle_data == TNG_TRUE)
-    {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
-    }
-    else
-    {
-        stat = tng_data_find(tng_data, block_id, &data);
-    }
-    if(stat != TNG_SUCCESS)
-    {
-        return(stat);
-    }
-
-    stat = tng_gen_data_vector_get(tng_data, block_id, is_particle_data,
-                                   &current_values, &n_frames, stride_length,
-                                   n_particles, n_values_per_frame, type);
 
-    if(stat != TNG_SUCCESS || (is_particle_data && *n_particles == 0))
+    file_pos = ftello(tng_data->input_file);
+    while(file_pos < tng_data->input_file_len)
     {
-        if(current_values)
+        stat = tng_block_header_read(tng_data, block);
+        if(stat != TNG_SUCCESS || block->id == TNG_TRAJECTORY_FRAME_SET ||
+           block->id == -1)
         {
-            free(current_values);
+            break;
         }
-        return(stat);
+        if(block->id == TNG_PARTICLE_MAPPING)
+        {
+            stat = tng_block_read_next(tng_data, block, TNG_SKIP_HASH);
+        }
+        else if(block->id >= TNG_TRAJ_BOX_SHAPE)
+        {
+            stat = tng_data_block_definition_read(tng_data, block);
+        }
+        if(stat == TNG_CRITICAL)
+        {
+            break;
+        }
+        file_pos += block->header_contents_size + block->block_contents_size;
+        tng_fseeko(tng_data, tng_data->input_file, file_pos, SEEK_SET);
     }
 
-    if(n_frames == 1 && n_frames < frame_set->n_frames)
-    {
-        tot_n_frames = 1;
-    }
-    else
-    {
-        tot_n_frames = end_frame_nr - start_frame_nr + 1;
-    }
+    tng_block_destroy(&block);
 
-    switch(*type)
+    if(stat == TNG_CRITICAL)
     {
-    case TNG_CHAR_DATA:
-        return(TNG_FAILURE);
-    case TNG_INT_DATA:
-        size = sizeof(int64_t);
-        break;
-    case TNG_FLOAT_DATA:
-        size = sizeof(float);
-        break;
-    case TNG_DOUBLE_DATA:
-    default:
-        size = sizeof(double);
+        fprintf(stderr, "TNG library: Cannot read block at pos %" PRId64 ". %s: %d\n",
+                file_pos, __FILE__, __LINE__);
+        return(stat);
     }
 
-    n_frames_div = (tot_n_frames % *stride_length) ?
-                 tot_n_frames / *stride_length + 1:
-                 tot_n_frames / *stride_length;
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open
+                (const char *filename,
+                 const char mode,
+                 tng_trajectory_t *tng_data_p)
+{
+    tng_function_status stat;
 
-    full_data_len = n_frames_div * size * (*n_values_per_frame);
-    if(is_particle_data)
+    TNG_ASSERT(filename, "TNG library: filename must not be a NULL pointer.");
+
+    if(mode != 'r' && mode != 'w' && mode != 'a')
     {
-        full_data_len *= (*n_particles);
+        return(TNG_FAILURE);
     }
 
-    temp = (char *)realloc(*values, full_data_len);
-    if(!temp)
+    if(tng_trajectory_init(tng_data_p) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                __FILE__, __LINE__);
-        free(*values);
-        *values = 0;
+        tng_trajectory_destroy(tng_data_p);
         return(TNG_CRITICAL);
     }
 
-    *values = temp;
-
-    if( n_frames == 1 && n_frames < frame_set->n_frames)
+    if(mode == 'w')
     {
-        if(is_particle_data)
-        {
-            memcpy(*values, current_values, size * (*n_particles) *
-                   (*n_values_per_frame));
-        }
-        else
+        stat = tng_output_file_set(*tng_data_p, filename);
+        return(stat);
+    }
+    /* When appending the same file handle is used both for reading and
+     * for writing. */
+    if(mode == 'a')
+    {
+        stat = tng_output_append_file_set(*tng_data_p, filename);
+        if(stat != TNG_SUCCESS)
         {
-            memcpy(*values, current_values, size * (*n_values_per_frame));
+            return(stat);
         }
     }
     else
     {
-        current_frame_pos = start_frame_nr - frame_set->first_frame;
-
-        frame_size = size * (*n_values_per_frame);
-        if(is_particle_data)
-        {
-            frame_size *= (*n_particles);
-        }
-
-        last_frame_pos = tng_min_i64(n_frames,
-                                     end_frame_nr - start_frame_nr);
+        tng_input_file_set(*tng_data_p, filename);
+    }
 
-        n_frames_div = current_frame_pos / *stride_length;
-        n_frames_div_2 = (last_frame_pos % *stride_length) ?
-                       last_frame_pos / *stride_length + 1:
-                       last_frame_pos / *stride_length;
-        n_frames_div_2 = tng_max_i64(1, n_frames_div_2 + 1);
+    /* Read the file headers */
+    tng_file_headers_read(*tng_data_p, TNG_USE_HASH);
 
-        memcpy(*values, (char *)current_values + n_frames_div * frame_size,
-               n_frames_div_2 * frame_size);
+    stat = tng_num_frame_sets_get(*tng_data_p, &(*tng_data_p)->n_trajectory_frame_sets);
 
-        current_frame_pos += n_frames - current_frame_pos;
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
 
-        while(current_frame_pos <= end_frame_nr - start_frame_nr)
+    if(mode == 'a')
+    {
+        /* The data of the last frame set is not needed for appending, so
+         * only its frame set block and block definitions are read. */
+        stat = tng_frame_set_tail_read(*tng_data_p);
+        if(stat != TNG_SUCCESS)
         {
-            stat = tng_frame_set_read_next(tng_data, hash_mode);
-            if(stat != TNG_SUCCESS)
-            {
-                if(current_values)
-                {
-                    free(current_values);
-                }
-                free(*values);
-                *values = 0;
-                return(stat);
-            }
+            fprintf(stderr, "TNG library: Cannot read frame set and related blocks. %s: %d\n",
+                   __FILE__, __LINE__);
+        }
 
-            stat = tng_gen_data_vector_get(tng_data, block_id, is_particle_data,
-                                           &current_values, &n_frames,
-                                           stride_length, n_particles,
-                                           n_values_per_frame, type);
+        (*tng_data_p)->first_trajectory_frame_set_output_file_pos =
+        (*tng_data_p)->first_trajectory_frame_set_input_file_pos;
+        (*tng_data_p)->last_trajectory_frame_set_output_file_pos =
+        (*tng_data_p)->last_trajectory_frame_set_input_file_pos;
+        (*tng_data_p)->current_trajectory_frame_set_output_file_pos =
+        (*tng_data_p)->current_trajectory_frame_set_input_file_pos;
 
-            if(stat != TNG_SUCCESS)
-            {
-                if(current_values)
-                {
-                    free(current_values);
-                }
-                free(*values);
-                *values = 0;
-                return(stat);
-            }
+        tng_fseeko(*tng_data_p, (*tng_data_p)->output_file, 0, SEEK_END);
 
-            last_frame_pos = tng_min_i64(n_frames,
-                                         end_frame_nr - current_frame_pos);
+        (*tng_data_p)->output_endianness_swap_func_32 = (*tng_data_p)->input_endianness_swap_func_32;
+        (*tng_data_p)->output_endianness_swap_func_64 = (*tng_data_p)->input_endianness_swap_func_64;
+    }
 
-            n_frames_div = current_frame_pos / *stride_length;
-            n_frames_div_2 = (last_frame_pos % *stride_length) ?
-                           last_frame_pos / *stride_length + 1:
-                           last_frame_pos / *stride_length;
-            n_frames_div_2 = tng_max_i64(1, n_frames_div_2);
+    return(stat);
+}
 
-            memcpy(((char *)*values) + n_frames_div * frame_size,
-                   current_values,
-                   n_frames_div_2 * frame_size);
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_segments_open
+                (const char **file_names,
+                 const int64_t n_files,
+                 const int64_t max_open_files,
+                 tng_trajectory_t *tng_data_p)
+{
+    tng_function_status stat;
 
-            current_frame_pos += n_frames;
-        }
+    TNG_ASSERT(file_names, "TNG library: file_names must not be a NULL pointer.");
+
+    if(tng_trajectory_init(tng_data_p) != TNG_SUCCESS)
+    {
+        tng_trajectory_destroy(tng_data_p);
+        return(TNG_CRITICAL);
     }
 
-    if(current_values)
+    stat = tng_input_file_segments_set(*tng_data_p, file_names, n_files, max_open_files);
+    if(stat != TNG_SUCCESS)
     {
-        free(current_values);
+        return(stat);
     }
 
-    data->last_retrieved_frame = end_frame_nr;
+    /* Read the file headers of the first file */
+    tng_file_headers_read(*tng_data_p, TNG_USE_HASH);
 
-    return(TNG_SUCCESS);
+    return(tng_num_frame_sets_get(*tng_data_p, &(*tng_data_p)->n_trajectory_frame_sets));
 }
 
-
-tng_function_status DECLSPECDLLEXPORT tng_data_vector_interval_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 const int64_t start_frame_nr,
-                 const int64_t end_frame_nr,
-                 const char hash_mode,
-                 void **values,
-                 int64_t *stride_length,
-                 int64_t *n_values_per_frame,
-                 char *type)
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_close
+                (tng_trajectory_t *tng_data_p)
 {
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than the end_frame_nr.");
-    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    tng_trajectory_frame_set_t frame_set;
 
-    return(tng_gen_data_vector_interval_get(tng_data, block_id, TNG_FALSE,
-                                            start_frame_nr, end_frame_nr,
-                                            hash_mode, values, 0, stride_length,
-                                            n_values_per_frame, type));
-}
+    if(tng_data_p == 0)
+    {
+        fprintf(stderr, "TNG library: Empty pointer to trajectory when attempting to close. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
 
-tng_function_status DECLSPECDLLEXPORT tng_particle_data_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 union data_values ****values,
-                 int64_t *n_frames,
-                 int64_t *n_particles,
-                 int64_t *n_values_per_frame,
-                 char *type)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
-    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    if(*tng_data_p == 0)
+    {
+        return(TNG_SUCCESS);
+    }
 
-    return(tng_gen_data_get(tng_data, block_id, TNG_TRUE, values, n_frames, n_particles,
-                            n_values_per_frame, type));
-}
+    frame_set = &(*tng_data_p)->current_trajectory_frame_set;
 
-tng_function_status DECLSPECDLLEXPORT tng_particle_data_vector_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 void **values,
-                 int64_t *n_frames,
-                 int64_t *stride_length,
-                 int64_t *n_particles,
-                 int64_t *n_values_per_frame,
-                 char *type)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
-    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    if(frame_set->n_unwritten_frames > 0)
+    {
+        frame_set->n_frames = frame_set->n_unwritten_frames;
+        tng_frame_set_write(*tng_data_p, TNG_USE_HASH);
+    }
 
-    return(tng_gen_data_vector_get(tng_data, block_id, TNG_TRUE, values,
-                                   n_frames, stride_length, n_particles,
-                                   n_values_per_frame, type));
+    return(tng_trajectory_destroy(tng_data_p));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_particle_data_interval_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 const int64_t start_frame_nr,
-                 const int64_t end_frame_nr,
-                 const char hash_mode,
-                 union data_values ****values,
-                 int64_t *n_particles,
-                 int64_t *n_values_per_frame,
-                 char *type)
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_frame_sets_copy
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 const int64_t first_frame,
+                 const int64_t last_frame,
+                 const int64_t frame_set_stride)
 {
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
-    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    int64_t i, frame, out_frame = 0;
+    tng_trajectory_frame_set_t frame_set_in, frame_set_out;
+    tng_function_status stat;
 
-    return(tng_gen_data_interval_get(tng_data, block_id, TNG_TRUE, start_frame_nr,
-                                     end_frame_nr, hash_mode, values, n_particles,
-                                     n_values_per_frame, type));
-}
+    TNG_ASSERT(tng_data_in, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(tng_data_out, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(first_frame >= 0, "TNG library: first_frame must be >= 0.");
+    TNG_ASSERT(frame_set_stride > 0, "TNG library: frame_set_stride must be > 0.");
 
-tng_function_status DECLSPECDLLEXPORT tng_particle_data_vector_interval_get
-                (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 const int64_t start_frame_nr,
-                 const int64_t end_frame_nr,
-                 const char hash_mode,
-                 void **values,
-                 int64_t *n_particles,
-                 int64_t *stride_length,
-                 int64_t *n_values_per_frame,
-                 char *type)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(start_frame_nr <= end_frame_nr, "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
-    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
-    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    frame_set_in = &tng_data_in->current_trajectory_frame_set;
+    frame_set_out = &tng_data_out->current_trajectory_frame_set;
 
-    return(tng_gen_data_vector_interval_get(tng_data, block_id, TNG_TRUE,
-                                            start_frame_nr, end_frame_nr,
-                                            hash_mode, values, n_particles,
-                                            stride_length, n_values_per_frame,
-                                            type));
+    /* Continue after the frames already in the output file, e.g. when it has
+     * been opened for appending. */
+    if(tng_data_out->last_trajectory_frame_set_output_file_pos > 0)
+    {
+        out_frame = frame_set_out->first_frame + frame_set_out->n_frames;
+    }
+
+    stat = tng_frame_set_of_frame_find(tng_data_in, first_frame);
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot find frame set of frame %" PRId64 ". %s: %d\n",
+                first_frame, __FILE__, __LINE__);
+        return(stat);
+    }
+
+    while(last_frame < 0 || frame_set_in->first_frame <= last_frame)
+    {
+        stat = tng_frame_set_raw_copy(tng_data_in, tng_data_out, out_frame, TNG_USE_HASH);
+        if(stat != TNG_SUCCESS)
+        {
+            return(stat);
+        }
+        out_frame += frame_set_in->n_frames;
+
+        /* Skip frame_set_stride - 1 frame sets. The frame sets are found
+         * from their frames, since they may be in different files. */
+        for(i = 0; i < frame_set_stride; i++)
+        {
+            frame = frame_set_in->first_frame + frame_set_in->n_frames;
+            stat = tng_frame_set_of_frame_find(tng_data_in, frame);
+            /* There are no more frame sets. */
+            if(stat == TNG_FAILURE)
+            {
+                return(TNG_SUCCESS);
+            }
+            if(stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot find frame set of frame %" PRId64 ". %s: %d\n",
+                        frame, __FILE__, __LINE__);
+                return(stat);
+            }
+        }
+    }
+
+    return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_data_get_stride_length
+/**
+ * @brief Copy a data block of a frame set that has been read to the current
+ * frame set of another trajectory, converting it to be written with another
+ * codec or data type.
+ * @param tng_data is the trajectory data container to copy to.
+ * @param src is the data block to copy.
+ * @param is_particle_data is TNG_TRUE if src is particle data.
+ * @param n_particles is the number of particles of the frame set.
+ * @param table translates the particle numbering of the values of src to the
+ * real particle numbering (see tng_particle_mapping_table_get()), or is NULL
+ * if the numbering is the same.
+ * @param codec_id is the codec to write positions and velocities with. Other
+ * data blocks only use it if it is TNG_UNCOMPRESSED or TNG_GZIP_COMPRESSION,
+ * otherwise they keep their codec.
+ * @param datatype is the type (TNG_FLOAT_DATA or TNG_DOUBLE_DATA) to store
+ * floating point data as. If it is 0 the data type is kept.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_transcode
                 (const tng_trajectory_t tng_data,
-                 const int64_t block_id,
-                 int64_t frame,
-                 int64_t *stride_length)
+                 const tng_data_t src,
+                 const tng_bool is_particle_data,
+                 const int64_t n_particles,
+                 const int64_t *table,
+                 const int64_t codec_id,
+                 const char datatype)
 {
-    tng_function_status stat;
+    int64_t i, j, k, n_frames, frame_alloc, n_values, n_block_particles, dest_particle;
+    int64_t src_index, dest_index;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
     tng_data_t data;
-    int64_t orig_file_pos, file_pos;
-    int is_particle_data;
+    char *src_str, **dest_str;
+    tng_function_status stat;
 
-    if(tng_data->current_trajectory_frame_set_input_file_pos <= 0)
+    if(is_particle_data == TNG_TRUE)
     {
-        frame = 0;
+        stat = tng_particle_data_find(tng_data, src->block_id, &data);
+    }
+    else
+    {
+        stat = tng_data_find(tng_data, src->block_id, &data);
     }
 
-    if(frame >= 0)
+    if(stat != TNG_SUCCESS)
     {
-        stat = tng_frame_set_of_frame_find(tng_data, frame);
+        if(is_particle_data == TNG_TRUE)
+        {
+            stat = tng_particle_data_block_create(tng_data, TNG_TRAJECTORY_BLOCK);
+            data = &frame_set->tr_particle_data[frame_set->n_particle_data_blocks - 1];
+        }
+        else
+        {
+            stat = tng_data_block_create(tng_data, TNG_TRAJECTORY_BLOCK);
+            data = &frame_set->tr_data[frame_set->n_data_blocks - 1];
+        }
         if(stat != TNG_SUCCESS)
         {
-            return(stat);
+            fprintf(stderr, "TNG library: Cannot create data block. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(TNG_CRITICAL);
+        }
+
+        data->block_id = src->block_id;
+        data->block_name = (char *)malloc(strlen(src->block_name) + 1);
+        if(!data->block_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                    __FILE__, __LINE__);
+            return(TNG_CRITICAL);
         }
+        strcpy(data->block_name, src->block_name);
+        data->datatype = src->datatype;
+        data->values = 0;
+        data->strings = 0;
+        data->n_frames = 0;
+        data->last_retrieved_frame = -1;
+    }
+
+    data->dependency = src->dependency;
+    data->first_frame_with_data = src->first_frame_with_data;
+    data->compression_multiplier = src->compression_multiplier;
+    if((datatype == TNG_FLOAT_DATA || datatype == TNG_DOUBLE_DATA) &&
+       (src->datatype == TNG_FLOAT_DATA || src->datatype == TNG_DOUBLE_DATA))
+    {
+        data->datatype = datatype;
+    }
+    else
+    {
+        data->datatype = src->datatype;
+    }
+    if(src->block_id == TNG_TRAJ_POSITIONS || src->block_id == TNG_TRAJ_VELOCITIES ||
+       codec_id == TNG_UNCOMPRESSED || codec_id == TNG_GZIP_COMPRESSION)
+    {
+        data->codec_id = codec_id;
+    }
+    else
+    {
+        data->codec_id = src->codec_id;
+    }
+
+    if(is_particle_data == TNG_TRUE)
+    {
+        n_block_particles = n_particles;
+        stat = tng_allocate_particle_data_mem(tng_data, data, src->n_frames,
+                                              src->stride_length, n_particles,
+                                              src->n_values_per_frame);
+    }
+    else
+    {
+        n_block_particles = 1;
+        stat = tng_allocate_data_mem(tng_data, data, src->n_frames,
+                                     src->stride_length, src->n_values_per_frame);
     }
-    orig_file_pos = tng_data->current_trajectory_frame_set_input_file_pos;
-    stat = tng_data_find(tng_data, block_id, &data);
     if(stat != TNG_SUCCESS)
     {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
-        if(stat != TNG_SUCCESS)
+        fprintf(stderr, "TNG library: Cannot allocate memory for data. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    n_frames = tng_max_i64(1, src->n_frames);
+    frame_alloc = (n_frames % data->stride_length) ? n_frames / data->stride_length + 1 :
+                  n_frames / data->stride_length;
+    n_values = src->n_values_per_frame;
+
+    /* The values are stored in the real particle numbering, since the
+     * particle mappings are not copied. */
+    for(i = 0; i < frame_alloc; i++)
+    {
+        for(j = 0; j < n_block_particles; j++)
         {
-            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            /* If no specific frame was required read until this data block is found */
-            if(frame < 0)
+            dest_particle = table ? table[j] : j;
+            src_index = (i * n_block_particles + j) * n_values;
+            dest_index = (i * n_block_particles + dest_particle) * n_values;
+            switch(src->datatype)
             {
-                file_pos = ftello(tng_data->input_file);
-                while(stat != TNG_SUCCESS && file_pos < tng_data->input_file_len)
+            case TNG_CHAR_DATA:
+                for(k = 0; k < n_values; k++)
                 {
-                    stat = tng_frame_set_read_next_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-                    file_pos = ftello(tng_data->input_file);
+                    if(is_particle_data == TNG_TRUE)
+                    {
+                        src_str = src->strings[i][j][k];
+                        dest_str = &data->strings[i][dest_particle][k];
+                    }
+                    else
+                    {
+                        src_str = src->strings[0][i][k];
+                        dest_str = &data->strings[0][i][k];
+                    }
+                    if(src_str)
+                    {
+                        *dest_str = (char *)malloc(strlen(src_str) + 1);
+                        if(!*dest_str)
+                        {
+                            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                                    __FILE__, __LINE__);
+                            return(TNG_CRITICAL);
+                        }
+                        strcpy(*dest_str, src_str);
+                    }
                 }
-            }
-            if(stat != TNG_SUCCESS)
-            {
-                tng_reread_frame_set_at_file_pos(tng_data, orig_file_pos);
-
-                return(stat);
-            }
-            stat = tng_data_find(tng_data, block_id, &data);
-            if(stat != TNG_SUCCESS)
-            {
-                stat = tng_particle_data_find(tng_data, block_id, &data);
-                if(stat != TNG_SUCCESS)
+                break;
+            case TNG_INT_DATA:
+                memcpy((int64_t *)data->values + dest_index,
+                       (int64_t *)src->values + src_index, sizeof(int64_t) * n_values);
+                break;
+            case TNG_FLOAT_DATA:
+                if(data->datatype == TNG_FLOAT_DATA)
                 {
-                    tng_reread_frame_set_at_file_pos(tng_data, orig_file_pos);
-
-                    return(stat);
+                    memcpy((float *)data->values + dest_index,
+                           (float *)src->values + src_index, sizeof(float) * n_values);
                 }
                 else
                 {
-                    is_particle_data = 1;
+                    for(k = 0; k < n_values; k++)
+                    {
+                        ((double *)data->values)[dest_index + k] =
+                        ((float *)src->values)[src_index + k];
+                    }
+                }
+                break;
+            case TNG_DOUBLE_DATA:
+            default:
+                if(data->datatype == TNG_DOUBLE_DATA)
+                {
+                    memcpy((double *)data->values + dest_index,
+                           (double *)src->values + src_index, sizeof(double) * n_values);
+                }
+                else
+                {
+                    for(k = 0; k < n_values; k++)
+                    {
+                        ((float *)data->values)[dest_index + k] =
+                        (float)((double *)src->values)[src_index + k];
+                    }
                 }
             }
-            else
-            {
-                is_particle_data = 0;
-            }
-        }
-        else
-        {
-            is_particle_data = 1;
         }
     }
+
+    return(TNG_SUCCESS);
+}
+
+/**
+ * @brief Read a frame set and encode its data blocks again, with another
+ * codec or data type.
+ * @param reader is the trajectory data container to read with.
+ * @param encoder is the trajectory data container to encode with. It has
+ * no output file and the molecular system and compression settings of the
+ * trajectory that is written.
+ * @param segment_nr is the index of the input file containing the frame set,
+ * if the trajectory is split into several input files.
+ * @param file_pos is the position of the frame set in the input file.
+ * @param codec_id is the codec to write positions and velocities with (see
+ * tng_data_block_transcode()).
+ * @param datatype is the type to store floating point data as, or 0 to keep
+ * the data type.
+ * @param contents is set to the encoded data blocks, which must be freed by
+ * the caller.
+ * @param len is set to the length of contents.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_transcode
+                (const tng_trajectory_t reader,
+                 const tng_trajectory_t encoder,
+                 const int64_t segment_nr,
+                 const int64_t file_pos,
+                 const int64_t codec_id,
+                 const char datatype,
+                 char **contents,
+                 int64_t *len)
+{
+    int64_t i, n_particles;
+    const int64_t *table;
+    tng_trajectory_frame_set_t frame_set = &reader->current_trajectory_frame_set;
+    tng_function_status stat;
+
+    *contents = 0;
+    *len = 0;
+
+    if(reader->n_input_segments > 0)
+    {
+        stat = tng_input_segment_activate(reader, segment_nr);
+    }
     else
     {
-        is_particle_data = 0;
+        stat = tng_input_file_init(reader);
     }
-    if(is_particle_data)
+    if(stat != TNG_SUCCESS)
     {
-        *stride_length = data->stride_length;
+        return(TNG_CRITICAL);
+    }
+    tng_fseeko(reader, reader->input_file, file_pos, SEEK_SET);
+    stat = tng_frame_set_read(reader, TNG_USE_HASH);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    if(reader->var_num_atoms_flag)
+    {
+        n_particles = frame_set->n_particles;
     }
     else
     {
-        *stride_length = data->stride_length;
+        n_particles = reader->n_particles;
+    }
+    stat = tng_particle_mapping_table_get(frame_set, n_particles, &table);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
     }
-    tng_reread_frame_set_at_file_pos(tng_data, orig_file_pos);
 
-    return(TNG_SUCCESS);
-}
+    tng_frame_set_new(encoder, frame_set->first_frame, frame_set->n_frames);
+    encoder->current_trajectory_frame_set.n_particles = frame_set->n_particles;
 
-tng_function_status DECLSPECDLLEXPORT tng_time_get_str
-                (const tng_trajectory_t tng_data,
-                 char *time)
-{
-    struct tm *time_data;
-    time_t secs;
-    int retval;
+    for(i = 0; i < frame_set->n_data_blocks && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_data_block_transcode(encoder, &frame_set->tr_data[i], TNG_FALSE,
+                                        n_particles, 0, codec_id, datatype);
+    }
+    for(i = 0; i < frame_set->n_particle_data_blocks && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_data_block_transcode(encoder, &frame_set->tr_particle_data[i], TNG_TRUE,
+                                        n_particles, table, codec_id, datatype);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(time, "TNG library: time must not be a NULL pointer");
+    return(tng_frame_set_encode(encoder, TNG_USE_HASH, TNG_FALSE, contents, len));
+}
 
-    secs = tng_data->time;
+/**
+ * @brief Append a frame set transcoded by tng_frame_set_transcode() to the
+ * output file.
+ * @param tng_data_out is the trajectory data container of the output file.
+ * @param reader is the trajectory data container that read the frame set.
+ * @param encoder is the trajectory data container that encoded the frame set.
+ * @param contents is the encoded data blocks of the frame set.
+ * @param len is the length of contents.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_transcoded_append
+                (const tng_trajectory_t tng_data_out,
+                 const tng_trajectory_t reader,
+                 const tng_trajectory_t encoder,
+                 const char *contents,
+                 const int64_t len)
+{
+    tng_function_status stat;
 
-    time_data = localtime(&secs); /* Returns a statically allocated variable. */
-    retval = TNG_SNPRINTF(time, TNG_MAX_DATE_STR_LEN,
-             "%4d-%02d-%02d %02d:%02d:%02d",
-             time_data->tm_year+1900, time_data->tm_mon+1, time_data->tm_mday,
-             time_data->tm_hour, time_data->tm_min, time_data->tm_sec);
+    stat = tng_frame_set_block_append(tng_data_out,
+                                      &reader->current_trajectory_frame_set,
+                                      reader->current_trajectory_frame_set.first_frame,
+                                      TNG_USE_HASH);
+    if(stat == TNG_SUCCESS &&
+       tng_fwrite(tng_data_out, contents, len, 1, tng_data_out->output_file) != 1)
+    {
+        fprintf(stderr, "TNG library: Could not write frame set. %s: %d\n",
+                __FILE__, __LINE__);
+        stat = TNG_CRITICAL;
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_write_finish(tng_data_out, TNG_USE_HASH);
+    }
+    /* Keep the compression algorithms that were determined, e.g. to store
+     * them in the file header. */
+    if(stat == TNG_SUCCESS && !tng_data_out->compress_algo_pos &&
+       encoder->compress_algo_pos)
+    {
+        stat = tng_compression_algorithm_set(tng_data_out, TNG_TRAJ_POSITIONS,
+                                             encoder->compress_algo_pos);
+    }
+    if(stat == TNG_SUCCESS && !tng_data_out->compress_algo_vel &&
+       encoder->compress_algo_vel)
+    {
+        stat = tng_compression_algorithm_set(tng_data_out, TNG_TRAJ_VELOCITIES,
+                                             encoder->compress_algo_vel);
+    }
 
-    /* handle return value (also) to quiet a -Wformat-truncation warning */
-    return( (retval < 0) ? TNG_SUCCESS : TNG_FAILURE );
+    return(stat);
 }
 
-
-tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open
-                (const char *filename,
-                 const char mode,
-                 tng_trajectory_t *tng_data_p)
+tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_transcode
+                (const tng_trajectory_t tng_data_in,
+                 const tng_trajectory_t tng_data_out,
+                 const int64_t codec_id,
+                 const char datatype)
 {
+    int64_t n_frame_sets, n_segment_frame_sets, n_segments, file_pos, i, j, k;
+    int64_t *frame_set_positions, *frame_set_segments;
+    tng_gen_block_t block;
     tng_function_status stat;
 
-    TNG_ASSERT(filename, "TNG library: filename must not be a NULL pointer.");
+    TNG_ASSERT(tng_data_in, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(tng_data_out, "TNG library: Trajectory container not properly setup.");
 
-    if(mode != 'r' && mode != 'w' && mode != 'a')
+    if(codec_id != TNG_UNCOMPRESSED && codec_id != TNG_XTC_COMPRESSION &&
+       codec_id != TNG_TNG_COMPRESSION && codec_id != TNG_GZIP_COMPRESSION)
+    {
+        fprintf(stderr, "TNG library: Codec not supported. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    if(datatype != 0 && datatype != TNG_FLOAT_DATA && datatype != TNG_DOUBLE_DATA)
     {
+        fprintf(stderr, "TNG library: Data type not supported. %s: %d\n", __FILE__, __LINE__);
         return(TNG_FAILURE);
     }
 
-    if(tng_trajectory_init(tng_data_p) != TNG_SUCCESS)
+    if(tng_data_out->n_molecules == 0)
     {
-        tng_trajectory_destroy(tng_data_p);
-        return(TNG_CRITICAL);
+        stat = tng_molecule_system_copy(tng_data_in, tng_data_out);
+        if(stat != TNG_SUCCESS)
+        {
+            return(stat);
+        }
     }
 
-    if(mode == 'w')
+    stat = tng_num_frame_sets_get(tng_data_in, &n_frame_sets);
+    if(stat != TNG_SUCCESS)
     {
-        stat = tng_output_file_set(*tng_data_p, filename);
         return(stat);
     }
-    tng_input_file_set(*tng_data_p, filename);
-
-    /* Read the file headers */
-    tng_file_headers_read(*tng_data_p, TNG_USE_HASH);
 
-    stat = tng_num_frame_sets_get(*tng_data_p, &(*tng_data_p)->n_trajectory_frame_sets);
+    frame_set_positions = (int64_t *)malloc(sizeof(int64_t) * (n_frame_sets > 0 ? n_frame_sets : 1));
+    frame_set_segments = (int64_t *)malloc(sizeof(int64_t) * (n_frame_sets > 0 ? n_frame_sets : 1));
+    if(!frame_set_positions || !frame_set_segments)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
+                __FILE__, __LINE__);
+        free(frame_set_positions);
+        free(frame_set_segments);
+        return(TNG_CRITICAL);
+    }
 
+    /* Find the positions of all frame sets in one pass, so that the threads
+     * can go directly to the frame sets they transcode. The frame sets of a
+     * trajectory split into several files are only linked within each file. */
+    tng_block_init(&block);
+    n_segments = tng_data_in->n_input_segments > 0 ? tng_data_in->n_input_segments : 1;
+    i = 0;
+    for(j = 0; j < n_segments && stat == TNG_SUCCESS; j++)
+    {
+        if(tng_data_in->n_input_segments > 0)
+        {
+            stat = tng_input_segment_activate(tng_data_in, j);
+            n_segment_frame_sets = tng_data_in->input_segments[j].n_frame_sets;
+        }
+        else
+        {
+            n_segment_frame_sets = n_frame_sets;
+        }
+        file_pos = tng_data_in->first_trajectory_frame_set_input_file_pos;
+        for(k = 0; k < n_segment_frame_sets && i < n_frame_sets && stat == TNG_SUCCESS;
+            k++, i++)
+        {
+            if(file_pos <= 0)
+            {
+                fprintf(stderr, "TNG library: Cannot find frame set %" PRId64 ". %s: %d\n",
+                        i, __FILE__, __LINE__);
+                stat = TNG_CRITICAL;
+                break;
+            }
+            frame_set_positions[i] = file_pos;
+            frame_set_segments[i] = j;
+            tng_fseeko(tng_data_in, tng_data_in->input_file, file_pos, SEEK_SET);
+            stat = tng_block_header_read(tng_data_in, block);
+            if(stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+            {
+                fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                        file_pos, __FILE__, __LINE__);
+                stat = TNG_CRITICAL;
+                break;
+            }
+            stat = tng_block_read_next(tng_data_in, block, TNG_SKIP_HASH);
+            tng_data_in->current_trajectory_frame_set_input_file_pos = file_pos;
+            file_pos = tng_data_in->current_trajectory_frame_set.next_frame_set_file_pos;
+        }
+    }
+    tng_block_destroy(&block);
+    if(stat == TNG_SUCCESS && i < n_frame_sets)
+    {
+        fprintf(stderr, "TNG library: Cannot find frame set %" PRId64 ". %s: %d\n",
+                i, __FILE__, __LINE__);
+        stat = TNG_CRITICAL;
+    }
     if(stat != TNG_SUCCESS)
     {
+        free(frame_set_positions);
+        free(frame_set_segments);
         return(stat);
     }
 
-    if(mode == 'a')
+    /* Each thread reads and encodes whole frame sets, using its own
+     * trajectory containers. The encoded frame sets are written in order. */
+#ifdef _OPENMP
+#pragma omp parallel private(i)
+#endif
     {
-        if((*tng_data_p)->output_file)
+        tng_trajectory_t reader = 0, encoder = 0;
+        tng_function_status local_stat;
+        char *contents;
+        int64_t len;
+
+        local_stat = tng_trajectory_init_from_src(tng_data_in, &reader);
+        if(local_stat == TNG_SUCCESS)
         {
-            fclose((*tng_data_p)->output_file);
+            local_stat = tng_trajectory_init_from_src(tng_data_out, &encoder);
         }
-        (*tng_data_p)->output_file = (*tng_data_p)->input_file;
-        fseeko((*tng_data_p)->input_file,
-                (*tng_data_p)->last_trajectory_frame_set_input_file_pos,
-                SEEK_SET);
-
-        stat = tng_frame_set_read(*tng_data_p, TNG_USE_HASH);
-        if(stat != TNG_SUCCESS)
+        if(local_stat == TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot read frame set and related blocks. %s: %d\n",
-                   __FILE__, __LINE__);
+            /* The encoder must never open the output file itself. */
+            free(encoder->output_file_path);
+            encoder->output_file_path = 0;
+            encoder->compression_precision = tng_data_out->compression_precision;
         }
-        (*tng_data_p)->output_file = 0;
 
-        (*tng_data_p)->first_trajectory_frame_set_output_file_pos =
-        (*tng_data_p)->first_trajectory_frame_set_input_file_pos;
-        (*tng_data_p)->last_trajectory_frame_set_output_file_pos =
-        (*tng_data_p)->last_trajectory_frame_set_input_file_pos;
-        (*tng_data_p)->current_trajectory_frame_set_output_file_pos =
-        (*tng_data_p)->current_trajectory_frame_set_input_file_pos;
-        if((*tng_data_p)->input_file)
+        /* The first frame set is transcoded by one thread before the others.
+         * The compression algorithms determined for it are then used by all
+         * encoders, so that the output does not depend on the number of
+         * threads. */
+#ifdef _OPENMP
+#pragma omp single
+#endif
         {
-            fclose((*tng_data_p)->input_file);
-            (*tng_data_p)->input_file = 0;
+            if(n_frame_sets > 0)
+            {
+                contents = 0;
+                len = 0;
+                if(local_stat == TNG_SUCCESS)
+                {
+                    local_stat = tng_frame_set_transcode(reader, encoder, frame_set_segments[0],
+                                                         frame_set_positions[0], codec_id,
+                                                         datatype, &contents, &len);
+                }
+                if(local_stat != TNG_SUCCESS)
+                {
+                    stat = local_stat;
+                }
+                else
+                {
+                    stat = tng_frame_set_transcoded_append(tng_data_out, reader, encoder,
+                                                           contents, len);
+                }
+                free(contents);
+            }
         }
-        if((*tng_data_p)->input_file_path)
+
+        if(local_stat == TNG_SUCCESS)
         {
-            free((*tng_data_p)->input_file_path);
-            (*tng_data_p)->input_file_path = 0;
+            if(!encoder->compress_algo_pos && tng_data_out->compress_algo_pos)
+            {
+                local_stat = tng_compression_algorithm_set(encoder, TNG_TRAJ_POSITIONS,
+                                                           tng_data_out->compress_algo_pos);
+            }
+            if(local_stat == TNG_SUCCESS && !encoder->compress_algo_vel &&
+               tng_data_out->compress_algo_vel)
+            {
+                local_stat = tng_compression_algorithm_set(encoder, TNG_TRAJ_VELOCITIES,
+                                                           tng_data_out->compress_algo_vel);
+            }
         }
-        tng_output_append_file_set(*tng_data_p, filename);
-
-        fseeko((*tng_data_p)->output_file, 0, SEEK_END);
-
-        (*tng_data_p)->output_endianness_swap_func_32 = (*tng_data_p)->input_endianness_swap_func_32;
-        (*tng_data_p)->output_endianness_swap_func_64 = (*tng_data_p)->input_endianness_swap_func_64;
-    }
-
-    return(stat);
-}
+        /* The algorithms of tng_data_out may change again when the frame
+         * sets are appended below. */
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
 
-tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_close
-                (tng_trajectory_t *tng_data_p)
-{
-    tng_trajectory_frame_set_t frame_set;
+#ifdef _OPENMP
+#pragma omp for ordered schedule(dynamic)
+#endif
+        for(i = 1; i < n_frame_sets; i++)
+        {
+            contents = 0;
+            len = 0;
+            if(local_stat == TNG_SUCCESS)
+            {
+                local_stat = tng_frame_set_transcode(reader, encoder, frame_set_segments[i],
+                                                     frame_set_positions[i], codec_id,
+                                                     datatype, &contents, &len);
+            }
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+            {
+                if(local_stat != TNG_SUCCESS)
+                {
+                    if(local_stat > stat)
+                    {
+                        stat = local_stat;
+                    }
+                }
+                else if(stat == TNG_SUCCESS)
+                {
+                    stat = tng_frame_set_transcoded_append(tng_data_out, reader, encoder,
+                                                           contents, len);
+                }
+            }
+            free(contents);
+        }
 
-    if(tng_data_p == 0)
-    {
-        fprintf(stderr, "TNG library: Empty pointer to trajectory when attempting to close. %s: %d\n",
-               __FILE__, __LINE__);
-        return(TNG_FAILURE);
-    }
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+        {
+            if(reader)
+            {
+                tng_statistics_merge(tng_data_in, reader);
+            }
+            if(encoder)
+            {
+                tng_statistics_merge(tng_data_out, encoder);
+            }
+        }
 
-    if(*tng_data_p == 0)
-    {
-        return(TNG_SUCCESS);
+        tng_trajectory_destroy(&encoder);
+        tng_trajectory_destroy(&reader);
     }
 
-    frame_set = &(*tng_data_p)->current_trajectory_frame_set;
-
-    if(frame_set->n_unwritten_frames > 0)
-    {
-        frame_set->n_frames = frame_set->n_unwritten_frames;
-        tng_frame_set_write(*tng_data_p, TNG_USE_HASH);
-    }
+    free(frame_set_positions);
+    free(frame_set_segments);
 
-    return(tng_trajectory_destroy(tng_data_p));
+    return(stat);
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_util_time_of_frame_get
@@ -15673,9 +22139,14 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read
     }
     if(data->last_retrieved_frame < 0)
     {
-        fseeko(tng_data->input_file,
-              tng_data->first_trajectory_frame_set_input_file_pos,
-              SEEK_SET);
+        if(tng_data->n_input_segments > 1 &&
+           tng_input_segment_activate(tng_data, 0) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+        tng_fseeko(tng_data, tng_data->input_file,
+                  tng_data->first_trajectory_frame_set_input_file_pos,
+                  SEEK_SET);
         stat = tng_frame_set_read(tng_data, TNG_USE_HASH);
         if(stat != TNG_SUCCESS)
         {
@@ -15837,9 +22308,14 @@ tng_function_status DECLSPECDLLEXPORT tng_util_non_particle_data_next_frame_read
     }
     if(data->last_retrieved_frame < 0)
     {
-        fseeko(tng_data->input_file,
-                tng_data->first_trajectory_frame_set_input_file_pos,
-                SEEK_SET);
+        if(tng_data->n_input_segments > 1 &&
+           tng_input_segment_activate(tng_data, 0) != TNG_SUCCESS)
+        {
+            return(TNG_CRITICAL);
+        }
+        tng_fseeko(tng_data, tng_data->input_file,
+                    tng_data->first_trajectory_frame_set_input_file_pos,
+                    SEEK_SET);
         stat = tng_frame_set_read(tng_data, TNG_USE_HASH);
         if(stat != TNG_SUCCESS)
         {
@@ -16061,168 +22537,27 @@ tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_read_range
     tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(box_shape, "TNG library: box_shape must not be a NULL pointer");
-    TNG_ASSERT(first_frame <= last_frame, "TNG library: first_frame must be lower or equal to last_frame.");
-    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
-
-    stat = tng_data_vector_interval_get(tng_data, TNG_TRAJ_BOX_SHAPE,
-                                        first_frame, last_frame,
-                                        TNG_USE_HASH,
-                                        (void **)box_shape,
-                                        stride_length,
-                                        &n_values_per_frame,
-                                        &type);
-
-    if(stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
-    {
-        return(TNG_FAILURE);
-    }
-
-    return(stat);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i,
-                 const int64_t n_values_per_frame,
-                 const int64_t block_id,
-                 const char *block_name,
-                 const char particle_dependency,
-                 const char compression)
-{
-    tng_trajectory_frame_set_t frame_set;
-    tng_data_t data;
-    int64_t n_particles, n_frames;
-    tng_function_status stat;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i >= 0, "TNG library: i (writing interval) must be >= 0.");
-
-    if(i <= 0)
-    {
-        fprintf(stderr, "TNG library: Cannot set writing frequency to %" PRId64 ". %s: %d\n",
-               i, __FILE__, __LINE__);
-        return(TNG_FAILURE);
-    }
-
-    frame_set = &tng_data->current_trajectory_frame_set;
-
-    if(!frame_set || tng_data->n_trajectory_frame_sets <= 0)
-    {
-        n_frames = tng_data->frame_set_n_frames;
-
-        stat = tng_frame_set_new(tng_data, 0, n_frames);
-        if(stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__,
-                __LINE__);
-            return(stat);
-        }
-    }
-    else
-    {
-        n_frames = frame_set->n_frames;
-    }
-
-    if(particle_dependency == TNG_PARTICLE_BLOCK_DATA)
-    {
-        tng_num_particles_get(tng_data, &n_particles);
-        if(n_particles <= 0)
-        {
-            return(TNG_FAILURE);
-        }
-
-        if(tng_particle_data_find(tng_data, block_id, &data)
-        != TNG_SUCCESS)
-        {
-            stat = tng_particle_data_block_add(tng_data, block_id,
-                                               block_name,
-                                               TNG_FLOAT_DATA,
-                                               TNG_TRAJECTORY_BLOCK,
-                                               n_frames, n_values_per_frame, i,
-                                               0, n_particles,
-                                               compression, 0);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Error %s adding data block. %s: %d\n", block_name,
-                       __FILE__, __LINE__);
-                return(stat);
-            }
-            data = &frame_set->tr_particle_data[frame_set->
-                                                  n_particle_data_blocks - 1];
-            stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
-                                                  i, n_particles,
-                                                  n_values_per_frame);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
-                       __FILE__, __LINE__);
-                return(stat);
-            }
-        }
-        else
-        {
-            if(data->stride_length != i)
-            {
-                data->stride_length = i;
-                stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
-                                                      i, n_particles,
-                                                      n_values_per_frame);
-                if(stat != TNG_SUCCESS)
-                {
-                    fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(stat);
-                }
-            }
-        }
-    }
-    else
+    TNG_ASSERT(box_shape, "TNG library: box_shape must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame, "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    stat = tng_data_vector_interval_get(tng_data, TNG_TRAJ_BOX_SHAPE,
+                                        first_frame, last_frame,
+                                        TNG_USE_HASH,
+                                        (void **)box_shape,
+                                        stride_length,
+                                        &n_values_per_frame,
+                                        &type);
+
+    if(stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
     {
-        if(tng_data_find(tng_data, block_id, &data) != TNG_SUCCESS)
-        {
-            stat = tng_data_block_add(tng_data, block_id, block_name,
-                                      TNG_FLOAT_DATA, TNG_TRAJECTORY_BLOCK,
-                                      n_frames, n_values_per_frame,
-                                      i, compression, 0);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Error %s adding data block. %s: %d\n", block_name,
-                       __FILE__, __LINE__);
-                return(stat);
-            }
-            data = &frame_set->tr_data[frame_set->
-                                          n_data_blocks - 1];
-            stat = tng_allocate_data_mem(tng_data, data, n_frames,
-                                         i, n_values_per_frame);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
-                       __FILE__, __LINE__);
-                return(stat);
-            }
-        }
-        else
-        {
-            if(data->stride_length != i)
-            {
-                data->stride_length = i;
-                stat = tng_allocate_data_mem(tng_data, data, n_frames,
-                                             i, n_values_per_frame);
-                if(stat != TNG_SUCCESS)
-                {
-                    fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
-                           __FILE__, __LINE__);
-                    return(stat);
-                }
-            }
-        }
+        return(TNG_FAILURE);
     }
 
-    return(TNG_SUCCESS);
+    return(stat);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_set
                 (const tng_trajectory_t tng_data,
                  const int64_t i,
                  const int64_t n_values_per_frame,
@@ -16268,7 +22603,6 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
     if(particle_dependency == TNG_PARTICLE_BLOCK_DATA)
     {
         tng_num_particles_get(tng_data, &n_particles);
-
         if(n_particles <= 0)
         {
             return(TNG_FAILURE);
@@ -16278,12 +22612,12 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
         != TNG_SUCCESS)
         {
             stat = tng_particle_data_block_add(tng_data, block_id,
-                                            block_name,
-                                            TNG_DOUBLE_DATA,
-                                            TNG_TRAJECTORY_BLOCK,
-                                            n_frames, n_values_per_frame, i,
-                                            0, n_particles,
-                                            compression, 0);
+                                               block_name,
+                                               TNG_FLOAT_DATA,
+                                               TNG_TRAJECTORY_BLOCK,
+                                               n_frames, n_values_per_frame, i,
+                                               0, n_particles,
+                                               compression, 0);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Error %s adding data block. %s: %d\n", block_name,
@@ -16304,7 +22638,19 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
         }
         else
         {
-            data->stride_length = i;
+            if(data->stride_length != i)
+            {
+                data->stride_length = i;
+                stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
+                                                      i, n_particles,
+                                                      n_values_per_frame);
+                if(stat != TNG_SUCCESS)
+                {
+                    fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
+                           __FILE__, __LINE__);
+                    return(stat);
+                }
+            }
         }
     }
     else
@@ -16312,7 +22658,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
         if(tng_data_find(tng_data, block_id, &data) != TNG_SUCCESS)
         {
             stat = tng_data_block_add(tng_data, block_id, block_name,
-                                      TNG_DOUBLE_DATA, TNG_TRAJECTORY_BLOCK,
+                                      TNG_FLOAT_DATA, TNG_TRAJECTORY_BLOCK,
                                       n_frames, n_values_per_frame,
                                       i, compression, 0);
             if(stat != TNG_SUCCESS)
@@ -16334,181 +22680,27 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
         }
         else
         {
-            data->stride_length = i;
+            if(data->stride_length != i)
+            {
+                data->stride_length = i;
+                stat = tng_allocate_data_mem(tng_data, data, n_frames,
+                                             i, n_values_per_frame);
+                if(stat != TNG_SUCCESS)
+                {
+                    fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
+                           __FILE__, __LINE__);
+                    return(stat);
+                }
+            }
         }
     }
 
-    return(TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_frequency_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i,
-                 const int64_t n_values_per_frame,
-                 const int64_t block_id,
-                 const char *block_name,
-                 const char particle_dependency,
-                 const char compression)
-{
-    fprintf(stderr, "TNG library: Using obsolete function tng_util_generic_write_frequency_set(). "
-           "See documentation. %s: %d", __FILE__, __LINE__);
-    return(tng_util_generic_write_interval_set(tng_data, i, n_values_per_frame,
-                                               block_id, block_name,
-                                               particle_dependency,
-                                               compression));
-}
-tng_function_status DECLSPECDLLEXPORT tng_util_pos_write_interval_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_set(tng_data, i, 3,
-                                               TNG_TRAJ_POSITIONS,
-                                               "POSITIONS",
-                                               TNG_PARTICLE_BLOCK_DATA,
-                                               TNG_TNG_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_pos_write_interval_double_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_double_set(tng_data, i, 3,
-                                                      TNG_TRAJ_POSITIONS,
-                                                      "POSITIONS",
-                                                      TNG_PARTICLE_BLOCK_DATA,
-                                                      TNG_TNG_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_pos_write_frequency_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    fprintf(stderr, "TNG library: Using obsolete function tng_util_pos_write_frequency_set(). "
-           "See documentation. %s: %d", __FILE__, __LINE__);
-    return(tng_util_pos_write_interval_set(tng_data, i));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_vel_write_interval_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_set(tng_data, i, 3,
-                                               TNG_TRAJ_VELOCITIES,
-                                               "VELOCITIES",
-                                               TNG_PARTICLE_BLOCK_DATA,
-                                               TNG_TNG_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_vel_write_interval_double_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_double_set(tng_data, i, 3,
-                                                      TNG_TRAJ_VELOCITIES,
-                                                      "VELOCITIES",
-                                                      TNG_PARTICLE_BLOCK_DATA,
-                                                      TNG_TNG_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_vel_write_frequency_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    fprintf(stderr, "TNG library: Using obsolete function tng_util_vel_write_frequency_set(). "
-           "See documentation. %s: %d", __FILE__, __LINE__);
-    return(tng_util_vel_write_interval_set(tng_data, i));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_force_write_interval_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_set(tng_data, i, 3,
-                                               TNG_TRAJ_FORCES,
-                                               "FORCES",
-                                               TNG_PARTICLE_BLOCK_DATA,
-                                               TNG_GZIP_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_force_write_interval_double_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_double_set(tng_data, i, 3,
-                                                      TNG_TRAJ_FORCES,
-                                                      "FORCES",
-                                                      TNG_PARTICLE_BLOCK_DATA,
-                                                      TNG_GZIP_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_force_write_frequency_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    fprintf(stderr, "TNG library: Using obsolete function tng_util_force_write_frequency_set(). "
-           "See documentation. %s: %d", __FILE__, __LINE__);
-    return(tng_util_force_write_interval_set(tng_data, i));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_write_interval_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_set(tng_data, i, 9,
-                                               TNG_TRAJ_BOX_SHAPE,
-                                               "BOX SHAPE",
-                                               TNG_NON_PARTICLE_BLOCK_DATA,
-                                               TNG_GZIP_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_write_interval_double_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
-
-    return(tng_util_generic_write_interval_double_set(tng_data, i, 9,
-                                                      TNG_TRAJ_BOX_SHAPE,
-                                                      "BOX SHAPE",
-                                                      TNG_NON_PARTICLE_BLOCK_DATA,
-                                                      TNG_GZIP_COMPRESSION));
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_write_frequency_set
-                (const tng_trajectory_t tng_data,
-                 const int64_t i)
-{
-    fprintf(stderr, "TNG library: Using obsolete function tng_util_box_shape_write_frequency_set(). "
-           "See documentation. %s: %d", __FILE__, __LINE__);
-    return(tng_util_box_shape_write_interval_set(tng_data, i));
+    return(TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_generic_write
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_interval_double_set
                 (const tng_trajectory_t tng_data,
-                 const int64_t frame_nr,
-                 const float *values,
+                 const int64_t i,
                  const int64_t n_values_per_frame,
                  const int64_t block_id,
                  const char *block_name,
@@ -16517,125 +22709,67 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write
 {
     tng_trajectory_frame_set_t frame_set;
     tng_data_t data;
-    int64_t n_particles = 0, n_frames, stride_length = 100, frame_pos;
-    int64_t last_frame;
-    int is_first_frame_flag = 0;
-    char block_type_flag;
+    int64_t n_particles, n_frames;
     tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer");
-
-    if(particle_dependency == TNG_PARTICLE_BLOCK_DATA)
-    {
-        tng_num_particles_get(tng_data, &n_particles);
-        TNG_ASSERT(n_particles > 0, "TNG library: There must be particles in the system to write particle data.");
-    }
+    TNG_ASSERT(i >= 0, "TNG library: i (writing interval) must be >= 0.");
 
-    if(values == 0)
+    if(i <= 0)
     {
+        fprintf(stderr, "TNG library: Cannot set writing frequency to %" PRId64 ". %s: %d\n",
+               i, __FILE__, __LINE__);
         return(TNG_FAILURE);
     }
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
-    if(frame_nr < 0)
-    {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
-        n_frames = stride_length = 1;
-    }
-    else
+    if(!frame_set || tng_data->n_trajectory_frame_sets <= 0)
     {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
+        n_frames = tng_data->frame_set_n_frames;
 
-        if(!frame_set || tng_data->n_trajectory_frame_sets <= 0)
-        {
-            stat = tng_frame_set_new(tng_data, 0, tng_data->frame_set_n_frames);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__,
-                    __LINE__);
-                return(stat);
-            }
-        }
-        last_frame = frame_set->first_frame +
-                     frame_set->n_frames - 1;
-        if(frame_nr > last_frame)
-        {
-            stat = tng_frame_set_write(tng_data, TNG_USE_HASH);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot write frame set.  %s: %d\n", __FILE__,
-                    __LINE__);
-                return(stat);
-            }
-            if(last_frame + tng_data->frame_set_n_frames < frame_nr)
-            {
-                last_frame = frame_nr - 1;
-            }
-            stat = tng_frame_set_new(tng_data, last_frame + 1,
-                                     tng_data->frame_set_n_frames);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__,
-                    __LINE__);
-                return(stat);
-            }
-        }
-        if(frame_set->n_unwritten_frames == 0)
+        stat = tng_frame_set_new(tng_data, 0, n_frames);
+        if(stat != TNG_SUCCESS)
         {
-            is_first_frame_flag = 1;
+            fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__,
+                __LINE__);
+            return(stat);
         }
-        frame_set->n_unwritten_frames = frame_nr -
-                                        frame_set->first_frame + 1;
-
+    }
+    else
+    {
         n_frames = frame_set->n_frames;
     }
 
     if(particle_dependency == TNG_PARTICLE_BLOCK_DATA)
     {
+        tng_num_particles_get(tng_data, &n_particles);
+
+        if(n_particles <= 0)
+        {
+            return(TNG_FAILURE);
+        }
+
         if(tng_particle_data_find(tng_data, block_id, &data)
         != TNG_SUCCESS)
         {
             stat = tng_particle_data_block_add(tng_data, block_id,
-                                               block_name,
-                                               TNG_FLOAT_DATA,
-                                               block_type_flag,
-                                               n_frames, n_values_per_frame,
-                                               stride_length,
-                                               0, n_particles,
-                                               compression, 0);
+                                            block_name,
+                                            TNG_DOUBLE_DATA,
+                                            TNG_TRAJECTORY_BLOCK,
+                                            n_frames, n_values_per_frame, i,
+                                            0, n_particles,
+                                            compression, 0);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Error %s adding data block. %s: %d\n", block_name,
                        __FILE__, __LINE__);
                 return(stat);
             }
-            if(block_type_flag == TNG_TRAJECTORY_BLOCK)
-            {
-                data = &frame_set->tr_particle_data[frame_set->
-                                                    n_particle_data_blocks - 1];
-            }
-            else
-            {
-                data = &tng_data->non_tr_particle_data[tng_data->
-                                                       n_particle_data_blocks - 1];
-            }
-            stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
-                                                  stride_length, n_particles,
-                                                  n_values_per_frame);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
-                       __FILE__, __LINE__);
-                return(stat);
-            }
-        }
-        /* FIXME: Here we must be able to handle modified n_particles as well. */
-        else if(n_frames > data->n_frames)
-        {
+            data = &frame_set->tr_particle_data[frame_set->
+                                                  n_particle_data_blocks - 1];
             stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
-                                                  data->stride_length, n_particles,
+                                                  i, n_particles,
                                                   n_values_per_frame);
             if(stat != TNG_SUCCESS)
             {
@@ -16644,29 +22778,9 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write
                 return(stat);
             }
         }
-
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK)
-        {
-            stride_length = data->stride_length;
-
-            if(is_first_frame_flag || data->first_frame_with_data < frame_set->first_frame)
-            {
-                data->first_frame_with_data = frame_nr;
-                frame_pos = 0;
-            }
-            else
-            {
-                frame_pos = (frame_nr - frame_set->first_frame) / stride_length;
-            }
-
-            memcpy((char *)data->values + sizeof(float) * frame_pos * n_particles *
-                   n_values_per_frame, values, sizeof(float) *
-                   n_particles * n_values_per_frame);
-        }
         else
         {
-            memcpy(data->values, values, sizeof(float) * n_particles *
-                   n_values_per_frame);
+            data->stride_length = i;
         }
     }
     else
@@ -16674,27 +22788,19 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write
         if(tng_data_find(tng_data, block_id, &data) != TNG_SUCCESS)
         {
             stat = tng_data_block_add(tng_data, block_id, block_name,
-                                      TNG_FLOAT_DATA, block_type_flag,
+                                      TNG_DOUBLE_DATA, TNG_TRAJECTORY_BLOCK,
                                       n_frames, n_values_per_frame,
-                                      stride_length, compression, 0);
+                                      i, compression, 0);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Error %s adding data block. %s: %d\n", block_name,
                        __FILE__, __LINE__);
                 return(stat);
             }
-            if(block_type_flag == TNG_TRAJECTORY_BLOCK)
-            {
-                data = &frame_set->tr_data[frame_set->
-                                              n_data_blocks - 1];
-            }
-            else
-            {
-                data = &tng_data->non_tr_data[tng_data->
-                                                 n_data_blocks - 1];
-            }
+            data = &frame_set->tr_data[frame_set->
+                                          n_data_blocks - 1];
             stat = tng_allocate_data_mem(tng_data, data, n_frames,
-                                         stride_length, n_values_per_frame);
+                                         i, n_values_per_frame);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
@@ -16702,78 +22808,233 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write
                 return(stat);
             }
         }
-        /* FIXME: Here we must be able to handle modified n_particles as well. */
-        else if(n_frames > data->n_frames)
+        else
         {
-            stat = tng_allocate_data_mem(tng_data, data, n_frames,
-                                         data->stride_length, n_values_per_frame);
-            if(stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Error allocating particle data memory. %s: %d\n",
-                       __FILE__, __LINE__);
-                return(stat);
-            }
+            data->stride_length = i;
         }
+    }
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_write_frequency_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression)
+{
+    fprintf(stderr, "TNG library: Using obsolete function tng_util_generic_write_frequency_set(). "
+           "See documentation. %s: %d", __FILE__, __LINE__);
+    return(tng_util_generic_write_interval_set(tng_data, i, n_values_per_frame,
+                                               block_id, block_name,
+                                               particle_dependency,
+                                               compression));
+}
+tng_function_status DECLSPECDLLEXPORT tng_util_pos_write_interval_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_set(tng_data, i, 3,
+                                               TNG_TRAJ_POSITIONS,
+                                               "POSITIONS",
+                                               TNG_PARTICLE_BLOCK_DATA,
+                                               TNG_TNG_COMPRESSION));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_pos_write_interval_double_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_double_set(tng_data, i, 3,
+                                                      TNG_TRAJ_POSITIONS,
+                                                      "POSITIONS",
+                                                      TNG_PARTICLE_BLOCK_DATA,
+                                                      TNG_TNG_COMPRESSION));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_pos_write_frequency_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    fprintf(stderr, "TNG library: Using obsolete function tng_util_pos_write_frequency_set(). "
+           "See documentation. %s: %d", __FILE__, __LINE__);
+    return(tng_util_pos_write_interval_set(tng_data, i));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_vel_write_interval_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_set(tng_data, i, 3,
+                                               TNG_TRAJ_VELOCITIES,
+                                               "VELOCITIES",
+                                               TNG_PARTICLE_BLOCK_DATA,
+                                               TNG_TNG_COMPRESSION));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_vel_write_interval_double_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_double_set(tng_data, i, 3,
+                                                      TNG_TRAJ_VELOCITIES,
+                                                      "VELOCITIES",
+                                                      TNG_PARTICLE_BLOCK_DATA,
+                                                      TNG_TNG_COMPRESSION));
+}
 
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK)
-        {
-            stride_length = data->stride_length;
+tng_function_status DECLSPECDLLEXPORT tng_util_vel_write_frequency_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    fprintf(stderr, "TNG library: Using obsolete function tng_util_vel_write_frequency_set(). "
+           "See documentation. %s: %d", __FILE__, __LINE__);
+    return(tng_util_vel_write_interval_set(tng_data, i));
+}
 
-            if(is_first_frame_flag || data->first_frame_with_data < frame_set->first_frame)
-            {
-                data->first_frame_with_data = frame_nr;
-                frame_pos = 0;
-            }
-            else
-            {
-                frame_pos = (frame_nr - frame_set->first_frame) / stride_length;
-            }
+tng_function_status DECLSPECDLLEXPORT tng_util_force_write_interval_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
 
-            memcpy((char *)data->values + sizeof(float) * frame_pos *
-                   n_values_per_frame, values, sizeof(float) *
-                   n_values_per_frame);
-        }
-        else
-        {
-            memcpy(data->values, values, sizeof(float) * n_values_per_frame);
-        }
-    }
+    return(tng_util_generic_write_interval_set(tng_data, i, 3,
+                                               TNG_TRAJ_FORCES,
+                                               "FORCES",
+                                               TNG_PARTICLE_BLOCK_DATA,
+                                               TNG_GZIP_COMPRESSION));
+}
 
-    return(TNG_SUCCESS);
+tng_function_status DECLSPECDLLEXPORT tng_util_force_write_interval_double_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_double_set(tng_data, i, 3,
+                                                      TNG_TRAJ_FORCES,
+                                                      "FORCES",
+                                                      TNG_PARTICLE_BLOCK_DATA,
+                                                      TNG_GZIP_COMPRESSION));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
+tng_function_status DECLSPECDLLEXPORT tng_util_force_write_frequency_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    fprintf(stderr, "TNG library: Using obsolete function tng_util_force_write_frequency_set(). "
+           "See documentation. %s: %d", __FILE__, __LINE__);
+    return(tng_util_force_write_interval_set(tng_data, i));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_write_interval_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_set(tng_data, i, 9,
+                                               TNG_TRAJ_BOX_SHAPE,
+                                               "BOX SHAPE",
+                                               TNG_NON_PARTICLE_BLOCK_DATA,
+                                               TNG_GZIP_COMPRESSION));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_write_interval_double_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(i > 0, "TNG library: i (writing interval) must be >= 0.");
+
+    return(tng_util_generic_write_interval_double_set(tng_data, i, 9,
+                                                      TNG_TRAJ_BOX_SHAPE,
+                                                      "BOX SHAPE",
+                                                      TNG_NON_PARTICLE_BLOCK_DATA,
+                                                      TNG_GZIP_COMPRESSION));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_write_frequency_set
+                (const tng_trajectory_t tng_data,
+                 const int64_t i)
+{
+    fprintf(stderr, "TNG library: Using obsolete function tng_util_box_shape_write_frequency_set(). "
+           "See documentation. %s: %d", __FILE__, __LINE__);
+    return(tng_util_box_shape_write_interval_set(tng_data, i));
+}
+
+/**
+ * @brief Find where the values of one frame of a data block are stored in
+ * memory, creating the data block, and the frame set, if required.
+ * @param tng_data is the trajectory to use.
+ * @param frame_nr is the frame number of the data. If frame_nr < 0 the
+ * values are non-trajectory data.
+ * @param datatype is the type of the values (TNG_FLOAT_DATA or
+ * TNG_DOUBLE_DATA). An existing data block must be of the same type.
+ * @param n_values_per_frame is the number of values to store per frame.
+ * @param block_id is the ID of the block.
+ * @param block_name is the name of the block. Only used if the data block is
+ * created.
+ * @param particle_dependency should be TNG_NON_PARTICLE_BLOCK_DATA (0) or
+ * TNG_PARTICLE_BLOCK_DATA (1).
+ * @param compression is the compression routine to use when writing the data.
+ * Only used if the data block is created.
+ * @param frame_values is set to point to the values of the frame.
+ * @param n_frame_values is set to the number of values of the frame, i.e.
+ * n_values_per_frame times the number of particles for particle data. If
+ * the particles of the frame set are mapped by one particle mapping only
+ * the mapped particles are counted.
+ * @details If frame_nr is beyond the current frame set that frame set is
+ * written and a new one is created. The frame is not counted as written to
+ * the frame set, see tng_util_frame_commit().
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_util_generic_frame_locate
                 (const tng_trajectory_t tng_data,
                  const int64_t frame_nr,
-                 const double *values,
+                 const char datatype,
                  const int64_t n_values_per_frame,
                  const int64_t block_id,
                  const char *block_name,
                  const char particle_dependency,
-                 const char compression)
+                 const char compression,
+                 void **frame_values,
+                 int64_t *n_frame_values)
 {
     tng_trajectory_frame_set_t frame_set;
     tng_data_t data;
     int64_t n_particles = 0, n_frames, stride_length = 100, frame_pos;
     int64_t last_frame;
     int is_first_frame_flag = 0;
+    size_t size;
     char block_type_flag;
     tng_function_status stat;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer");
-
     if(particle_dependency == TNG_PARTICLE_BLOCK_DATA)
     {
         tng_num_particles_get(tng_data, &n_particles);
         TNG_ASSERT(n_particles > 0, "TNG library: There must be particles in the system to write particle data.");
     }
 
-    if(values == 0)
-    {
-        return(TNG_FAILURE);
-    }
-
     frame_set = &tng_data->current_trajectory_frame_set;
 
     if(frame_nr < 0)
@@ -16823,12 +23084,18 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
         {
             is_first_frame_flag = 1;
         }
-        frame_set->n_unwritten_frames = frame_nr -
-                                        frame_set->first_frame + 1;
 
         n_frames = frame_set->n_frames;
-    }
 
+        /* If the particles of the frame set are mapped, e.g. to the particles
+         * handled by one process, only the values of the mapped particles are
+         * stored. */
+        if(particle_dependency == TNG_PARTICLE_BLOCK_DATA &&
+           frame_set->n_mapping_blocks == 1)
+        {
+            n_particles = frame_set->mappings[0].n_particles;
+        }
+    }
 
     if(particle_dependency == TNG_PARTICLE_BLOCK_DATA)
     {
@@ -16836,13 +23103,13 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
         != TNG_SUCCESS)
         {
             stat = tng_particle_data_block_add(tng_data, block_id,
-                                            block_name,
-                                            TNG_DOUBLE_DATA,
-                                            block_type_flag,
-                                            n_frames, n_values_per_frame,
-                                            stride_length,
-                                            0, n_particles,
-                                            compression, 0);
+                                               block_name,
+                                               datatype,
+                                               block_type_flag,
+                                               n_frames, n_values_per_frame,
+                                               stride_length,
+                                               0, n_particles,
+                                               compression, 0);
             if(stat != TNG_SUCCESS)
             {
                 fprintf(stderr, "TNG library: Error %s adding data block. %s: %d\n", block_name,
@@ -16857,7 +23124,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
             else
             {
                 data = &tng_data->non_tr_particle_data[tng_data->
-                                                    n_particle_data_blocks - 1];
+                                                       n_particle_data_blocks - 1];
             }
             stat = tng_allocate_particle_data_mem(tng_data, data, n_frames,
                                                   stride_length, n_particles,
@@ -16882,37 +23149,13 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
                 return(stat);
             }
         }
-
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK)
-        {
-            stride_length = data->stride_length;
-
-            if(is_first_frame_flag || data->first_frame_with_data < frame_set->first_frame)
-            {
-                data->first_frame_with_data = frame_nr;
-                frame_pos = 0;
-            }
-            else
-            {
-                frame_pos = (frame_nr - frame_set->first_frame) / stride_length;
-            }
-
-            memcpy((char *)data->values + sizeof(double) * frame_pos * n_particles *
-                   n_values_per_frame, values, sizeof(double) *
-                   n_particles * n_values_per_frame);
-        }
-        else
-        {
-            memcpy(data->values, values, sizeof(double) * n_particles *
-                   n_values_per_frame);
-        }
     }
     else
     {
         if(tng_data_find(tng_data, block_id, &data) != TNG_SUCCESS)
         {
             stat = tng_data_block_add(tng_data, block_id, block_name,
-                                      TNG_DOUBLE_DATA, block_type_flag,
+                                      datatype, block_type_flag,
                                       n_frames, n_values_per_frame,
                                       stride_length, compression, 0);
             if(stat != TNG_SUCCESS)
@@ -16952,30 +23195,181 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
                 return(stat);
             }
         }
+        n_particles = 1;
+    }
 
-        if(block_type_flag == TNG_TRAJECTORY_BLOCK)
-        {
-            stride_length = data->stride_length;
+    if(data->datatype != datatype)
+    {
+        fprintf(stderr, "TNG library: Data block %s is of another data type. %s: %d\n",
+                data->block_name, __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    size = datatype == TNG_FLOAT_DATA ? sizeof(float) : sizeof(double);
 
-            if(is_first_frame_flag || data->first_frame_with_data < frame_set->first_frame)
-            {
-                data->first_frame_with_data = frame_nr;
-                frame_pos = 0;
-            }
-            else
-            {
-                frame_pos = (frame_nr - frame_set->first_frame) / stride_length;
-            }
+    if(block_type_flag == TNG_TRAJECTORY_BLOCK)
+    {
+        stride_length = data->stride_length;
 
-            memcpy((char *)data->values + sizeof(double) * frame_pos *
-                   n_values_per_frame, values, sizeof(double) *
-                   n_values_per_frame);
+        if(is_first_frame_flag || data->first_frame_with_data < frame_set->first_frame)
+        {
+            data->first_frame_with_data = frame_nr;
+            frame_pos = 0;
         }
         else
         {
-            memcpy(data->values, values, sizeof(double) * n_values_per_frame);
+            frame_pos = (frame_nr - frame_set->first_frame) / stride_length;
         }
     }
+    else
+    {
+        frame_pos = 0;
+    }
+
+    *n_frame_values = n_particles * n_values_per_frame;
+    *frame_values = (char *)data->values + size * frame_pos * *n_frame_values;
+
+    return(TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_write
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const float *values,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression)
+{
+    void *frame_values;
+    int64_t n_frame_values;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer");
+
+    if(values == 0)
+    {
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_generic_frame_locate(tng_data, frame_nr, TNG_FLOAT_DATA,
+                                         n_values_per_frame, block_id, block_name,
+                                         particle_dependency, compression,
+                                         &frame_values, &n_frame_values);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    memcpy(frame_values, values, sizeof(float) * n_frame_values);
+
+    return(tng_util_frame_commit(tng_data, frame_nr));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const double *values,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression)
+{
+    void *frame_values;
+    int64_t n_frame_values;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer");
+
+    if(values == 0)
+    {
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_generic_frame_locate(tng_data, frame_nr, TNG_DOUBLE_DATA,
+                                         n_values_per_frame, block_id, block_name,
+                                         particle_dependency, compression,
+                                         &frame_values, &n_frame_values);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    memcpy(frame_values, values, sizeof(double) * n_frame_values);
+
+    return(tng_util_frame_commit(tng_data, frame_nr));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_frame_acquire
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression,
+                 float **values)
+{
+    int64_t n_frame_values;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer");
+
+    return(tng_util_generic_frame_locate(tng_data, frame_nr, TNG_FLOAT_DATA,
+                                         n_values_per_frame, block_id, block_name,
+                                         particle_dependency, compression,
+                                         (void **)values, &n_frame_values));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_frame_acquire
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr,
+                 const int64_t n_values_per_frame,
+                 const int64_t block_id,
+                 const char *block_name,
+                 const char particle_dependency,
+                 const char compression,
+                 double **values)
+{
+    int64_t n_frame_values;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer");
+
+    return(tng_util_generic_frame_locate(tng_data, frame_nr, TNG_DOUBLE_DATA,
+                                         n_values_per_frame, block_id, block_name,
+                                         particle_dependency, compression,
+                                         (void **)values, &n_frame_values));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_frame_commit
+                (const tng_trajectory_t tng_data,
+                 const int64_t frame_nr)
+{
+    tng_trajectory_frame_set_t frame_set;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    /* Non-trajectory data is not counted in frames. */
+    if(frame_nr < 0)
+    {
+        return(TNG_SUCCESS);
+    }
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    if(tng_data->n_trajectory_frame_sets <= 0 || frame_nr < frame_set->first_frame ||
+       frame_nr >= frame_set->first_frame + frame_set->n_frames)
+    {
+        fprintf(stderr, "TNG library: Frame %" PRId64 " is not in the current frame set. "
+                "%s: %d\n", frame_nr, __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    frame_set->n_unwritten_frames = frame_nr - frame_set->first_frame + 1;
 
     return(TNG_SUCCESS);
 }
@@ -17759,7 +24153,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_all_data_block_types_g
 
     orig_file_pos = ftello(tng_data->input_file);
 
-    fseeko(tng_data->input_file, 0, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, 0, SEEK_SET);
     file_pos = 0;
 
     *n_data_blocks = 0;
@@ -17774,10 +24168,10 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_all_data_block_types_g
 
         }
         file_pos += (block->block_contents_size + block->header_contents_size);
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        tng_fseeko(tng_data, tng_data->input_file, block->block_contents_size, SEEK_CUR);
     }
 
-    fseeko(tng_data->input_file, orig_file_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, orig_file_pos, SEEK_SET);
 
     return(TNG_SUCCESS);
 }
@@ -17827,23 +24221,23 @@ tng_function_status DECLSPECDLLEXPORT tng_util_num_frames_with_data_of_block_id_
 
     first_frame_set_file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
     curr_file_pos = ftello(tng_data->input_file);
-    fseeko(tng_data->input_file, first_frame_set_file_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, first_frame_set_file_pos, SEEK_SET);
 
     stat = tng_frame_set_n_frames_of_data_block_get(tng_data, block_id, &curr_n_frames);
 
     while(stat == TNG_SUCCESS && tng_data->current_trajectory_frame_set.next_frame_set_file_pos != -1)
     {
         *n_frames += curr_n_frames;
-        fseeko(tng_data->input_file,
-               tng_data->current_trajectory_frame_set.next_frame_set_file_pos,
-               SEEK_SET);
+        tng_fseeko(tng_data, tng_data->input_file,
+                   tng_data->current_trajectory_frame_set.next_frame_set_file_pos,
+                   SEEK_SET);
         stat = tng_frame_set_n_frames_of_data_block_get(tng_data, block_id, &curr_n_frames);
     }
     if(stat == TNG_SUCCESS)
     {
         *n_frames += curr_n_frames;
     }
-    fseeko(tng_data->input_file, curr_file_pos, SEEK_SET);
+    tng_fseeko(tng_data, tng_data->input_file, curr_file_pos, SEEK_SET);
     if(stat == TNG_CRITICAL)
     {
         return(TNG_CRITICAL);
@@ -23,176 +23,7 @@
 
 #define FUDGE 1.1 /* 10% off target precision is acceptable */
 
-static void keepinbox(int *val)
-{
-  while (val[0]>INTMAX1)
-    val[0]-=(INTMAX1-INTMIN1+1);
-  while (val[0]<INTMIN1)
-    val[0]+=(INTMAX1-INTMIN1+1);
-  while (val[1]>INTMAX2)
-    val[1]-=(INTMAX2-INTMIN2+1);
-  while (val[1]<INTMIN2)
-    val[1]+=(INTMAX2-INTMIN2+1);
-  while (val[2]>INTMAX3)
-    val[2]-=(INTMAX3-INTMIN3+1);
-  while (val[2]<INTMIN3)
-    val[2]+=(INTMAX3-INTMIN3+1);
-}
-
-static int intsintable[128]={
-0 , 3215 , 6423 , 9615 , 12785 , 15923 , 19023 , 22078 ,
-25079 , 28019 , 30892 , 33691 , 36409 , 39039 , 41574 , 44010 ,
-46340 , 48558 , 50659 , 52638 , 54490 , 56211 , 57796 , 59242 ,
-60546 , 61704 , 62713 , 63570 , 64275 , 64825 , 65219 , 65456 ,
-65535 , 65456 , 65219 , 64825 , 64275 , 63570 , 62713 , 61704 ,
-60546 , 59242 , 57796 , 56211 , 54490 , 52638 , 50659 , 48558 ,
-46340 , 44010 , 41574 , 39039 , 36409 , 33691 , 30892 , 28019 ,
-25079 , 22078 , 19023 , 15923 , 12785 , 9615 , 6423 , 3215 ,
-0 , -3215 , -6423 , -9615 , -12785 , -15923 , -19023 , -22078 ,
--25079 , -28019 , -30892 , -33691 , -36409 , -39039 , -41574 , -44010 ,
--46340 , -48558 , -50659 , -52638 , -54490 , -56211 , -57796 , -59242 ,
--60546 , -61704 , -62713 , -63570 , -64275 , -64825 , -65219 , -65456 ,
--65535 , -65456 , -65219 , -64825 , -64275 , -63570 , -62713 , -61704 ,
--60546 , -59242 , -57796 , -56211 , -54490 , -52638 , -50659 , -48558 ,
--46340 , -44010 , -41574 , -39039 , -36409 , -33691 , -30892 , -28019 ,
--25079 , -22078 , -19023 , -15923 , -12785 , -9615 , -6423 , -3215 ,
-};
-
-static int intsin(int i)
-{
-  int sign=1;
-  if (i<0)
-    {
-      i=0;
-      sign=-1;
-    }
-  return sign*intsintable[i%128];
-}
-
-static int intcos(int i)
-{
-  if (i<0)
-    i=0;
-  return intsin(i+32);
-}
-
-static void molecule(int *target,
-                     int *base,
-                     int length,
-                     int scale, int *direction,
-                     int flip,
-                     int iframe)
-{
-  int i;
-  for (i=0; i<length; i++)
-    {
-      int ifl=i;
-      if ((i==0) && (flip) && (length>1))
-        ifl=1;
-      else if ((i==1) && (flip) && (length>1))
-        ifl=0;
-      target[ifl*3]=base[0]+(intsin((i+iframe)*direction[0])*scale)/256;
-      target[ifl*3+1]=base[1]+(intcos((i+iframe)*direction[1])*scale)/256;
-      target[ifl*3+2]=base[2]+(intcos((i+iframe)*direction[2])*scale)/256;
-      keepinbox(target+ifl*3);
-    }
-}
-
-#ifndef FRAMESCALE
-#define FRAMESCALE 1
-#endif
-
-static void genibox(int *intbox, int iframe)
-{
-  int molecule_length=1;
-  int molpos[3];
-  int direction[3]={1,1,1};
-  int scale=1;
-  int flip=0;
-  int i=0;
-  molpos[0]=intsin(iframe*FRAMESCALE)/32;
-  molpos[1]=1+intcos(iframe*FRAMESCALE)/32;
-  molpos[2]=2+intsin(iframe*FRAMESCALE)/16;
-  keepinbox(molpos);
-  while (i<NATOMS)
-    {
-      int this_mol_length=molecule_length;
-      int dir;
-#ifdef REGULAR
-      this_mol_length=4;
-      flip=0;
-      scale=1;
-#endif
-      if (i+this_mol_length>NATOMS)
-        this_mol_length=NATOMS-i;
-      /* We must test the large rle as well. This requires special
-         sequencies to get triggered. So insert these from time to
-         time */
-#ifndef REGULAR
-      if ((i%10)==0)
-        {
-          int j;
-          intbox[i*3]=molpos[0];
-          intbox[i*3+1]=molpos[1];
-          intbox[i*3+2]=molpos[2];
-          for (j=1; j<this_mol_length; j++)
-            {
-              intbox[(i+j)*3]=intbox[(i+j-1)*3]+(INTMAX1-INTMIN1+1)/5;
-              intbox[(i+j)*3+1]=intbox[(i+j-1)*3+1]+(INTMAX2-INTMIN2+1)/5;
-              intbox[(i+j)*3+2]=intbox[(i+j-1)*3+2]+(INTMAX3-INTMIN3+1)/5;
-              keepinbox(intbox+(i+j)*3);
-            }
-        }
-      else
-#endif
-        molecule(intbox+i*3,molpos,this_mol_length,scale,direction,flip,iframe*FRAMESCALE);
-      i+=this_mol_length;
-      dir=1;
-      if (intsin(i*3)<0)
-        dir=-1;
-      molpos[0]+=dir*(INTMAX1-INTMIN1+1)/20;
-      dir=1;
-      if (intsin(i*5)<0)
-        dir=-1;
-      molpos[1]+=dir*(INTMAX2-INTMIN2+1)/20;
-      dir=1;
-      if (intsin(i*7)<0)
-        dir=-1;
-      molpos[2]+=dir*(INTMAX3-INTMIN3+1)/20;
-      keepinbox(molpos);
-
-      direction[0]=((direction[0]+1)%7)+1;
-      direction[1]=((direction[1]+1)%3)+1;
-      direction[2]=((direction[2]+1)%6)+1;
-
-      scale++;
-      if (scale>5)
-        scale=1;
-
-      molecule_length++;
-      if (molecule_length>30)
-        molecule_length=1;
-      if (i%9)
-        flip=1-flip;
-    }
-}
-
-static void genivelbox(int *intvelbox, int iframe)
-{
-  int i;
-  for (i=0; i<NATOMS; i++)
-    {
-#ifdef VELINTMUL
-      intvelbox[i*3]=((intsin((i+iframe*FRAMESCALE)*3))/10)*VELINTMUL+i;
-      intvelbox[i*3+1]=1+((intcos((i+iframe*FRAMESCALE)*5))/10)*VELINTMUL+i;
-      intvelbox[i*3+2]=2+((intsin((i+iframe*FRAMESCALE)*7)+intcos((i+iframe*FRAMESCALE)*9))/20)*VELINTMUL+i;
-#else
-      intvelbox[i*3]=((intsin((i+iframe*FRAMESCALE)*3))/10);
-      intvelbox[i*3+1]=1+((intcos((i+iframe*FRAMESCALE)*5))/10);
-      intvelbox[i*3+2]=2+((intsin((i+iframe*FRAMESCALE)*7)+intcos((i+iframe*FRAMESCALE)*9))/20);
-#endif
-    }
-}
+#include "generators.h"
 
 #ifndef STRIDE1
 #define STRIDE1 3
@@ -0,0 +1,636 @@
+/* This code is part of the tng binary trajectory format.
+ *
+ * Copyright (c) 2026, The GROMACS development team.
+ * Check out http://www.gromacs.org for more information.
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the Revised BSD License.
+ */
+
+/* Benchmarks of the TNG compression algorithms and of writing, reading and
+ * seeking in trajectories. The synthetic molecular systems of the
+ * compression testsuite are used as data. The results are written to stdout
+ * as comma separated values, one line per benchmark, with a header line:
+ *
+ * benchmark      pos_compress, pos_uncompress, pos_search, vel_compress,
+ *                vel_uncompress, vel_search, write, transcode, read or seek.
+ * initial_algorithm, algorithm
+ *                the TNG compression algorithms of the first frame and of
+ *                the other frames, "search" if the best algorithms were
+ *                searched for, or the codec of the trajectory file
+ *                (tng, gzip or none) for the file benchmarks.
+ * speed          the speed parameter of the TNG compression (0 is the
+ *                default of the library).
+ * n_atoms, n_frames
+ *                the number of atoms and frames processed per iteration.
+ * raw_bytes      the size of the data as single precision values.
+ * stored_bytes   the size of the compressed data or of the file.
+ * seconds        the time of one iteration.
+ * mb_per_s       raw_bytes / seconds, in 10^6 bytes per second.
+ * ns_per_atom    seconds per atom and frame, in nanoseconds. */
+
+#include "tng/tng_io.h"
+#include "compression/tng_compress.h"
+
+#ifdef USE_STD_INTTYPES_H
+#include <inttypes.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+/* Settings of the generators of the compression testsuite. The
+ * coordinates are integers in the range 0 - 10000. */
+static int n_atoms_generated = 1000;
+#define NATOMS n_atoms_generated
+#define INTMIN1 0
+#define INTMIN2 0
+#define INTMIN3 0
+#define INTMAX1 10000
+#define INTMAX2 10000
+#define INTMAX3 10000
+
+#include "compression/generators.h"
+
+#define POS_PRECISION 0.001
+#define VEL_PRECISION 0.001
+
+struct tng_benchmark_coding
+{
+    const char *initial_name;
+    const char *name;
+    int initial_coding;
+    int coding;
+};
+
+/* The position algorithms, which are only used for the frames after the
+ * first, are combined with a suitable algorithm for the first frame. */
+static const struct tng_benchmark_coding pos_codings[] =
+{
+    {"xtc2", "stopbit_inter", TNG_COMPRESS_ALGO_POS_XTC2, TNG_COMPRESS_ALGO_POS_STOPBIT_INTER},
+    {"xtc2", "triplet_inter", TNG_COMPRESS_ALGO_POS_XTC2, TNG_COMPRESS_ALGO_POS_TRIPLET_INTER},
+    {"triplet_intra", "triplet_intra", TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA, TNG_COMPRESS_ALGO_POS_TRIPLET_INTRA},
+    {"xtc2", "xtc2", TNG_COMPRESS_ALGO_POS_XTC2, TNG_COMPRESS_ALGO_POS_XTC2},
+    {"triplet_onetoone", "triplet_onetoone", TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE, TNG_COMPRESS_ALGO_POS_TRIPLET_ONETOONE},
+    {"bwlzh_intra", "bwlzh_inter", TNG_COMPRESS_ALGO_POS_BWLZH_INTRA, TNG_COMPRESS_ALGO_POS_BWLZH_INTER},
+    {"bwlzh_intra", "bwlzh_intra", TNG_COMPRESS_ALGO_POS_BWLZH_INTRA, TNG_COMPRESS_ALGO_POS_BWLZH_INTRA},
+    {"xtc3", "xtc3", TNG_COMPRESS_ALGO_POS_XTC3, TNG_COMPRESS_ALGO_POS_XTC3}
+};
+
+static const struct tng_benchmark_coding vel_codings[] =
+{
+    {"stopbit_onetoone", "stopbit_onetoone", TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE, TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE},
+    {"triplet_onetoone", "triplet_inter", TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE, TNG_COMPRESS_ALGO_VEL_TRIPLET_INTER},
+    {"triplet_onetoone", "triplet_onetoone", TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE, TNG_COMPRESS_ALGO_VEL_TRIPLET_ONETOONE},
+    {"stopbit_onetoone", "stopbit_inter", TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE, TNG_COMPRESS_ALGO_VEL_STOPBIT_INTER},
+    {"bwlzh_onetoone", "bwlzh_inter", TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE, TNG_COMPRESS_ALGO_VEL_BWLZH_INTER},
+    {"bwlzh_onetoone", "bwlzh_onetoone", TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE, TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE}
+};
+
+/* Wall clock time in seconds */
+static double tng_benchmark_time(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return((double)count.QuadPart / (double)frequency.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return(tv.tv_sec + tv.tv_usec * 1e-6);
+#endif
+}
+
+static void tng_benchmark_result_print(const char *benchmark,
+                                       const char *initial_algorithm,
+                                       const char *algorithm,
+                                       const int speed,
+                                       const int64_t n_atoms,
+                                       const int64_t n_frames,
+                                       const double stored_bytes,
+                                       const double seconds)
+{
+    double raw_bytes = (double)n_atoms * n_frames * 3 * sizeof(float);
+
+    printf("%s,%s,%s,%d,%"PRId64",%"PRId64",%.0f,%.0f,%.6g,%.6g,%.6g\n",
+           benchmark, initial_algorithm, algorithm, speed, n_atoms, n_frames,
+           raw_bytes, stored_bytes, seconds, raw_bytes / seconds * 1e-6,
+           seconds * 1e9 / ((double)n_atoms * n_frames));
+    fflush(stdout);
+}
+
+static char *tng_benchmark_compress(const int is_vel, const int search,
+                                    float *values, const int n_atoms,
+                                    const int n_frames, const int speed,
+                                    int *algo, int *n_bytes)
+{
+    if(is_vel)
+    {
+        if(search)
+        {
+            return(tng_compress_vel_float_find_algo(values, n_atoms, n_frames,
+                                                    (float)VEL_PRECISION, speed,
+                                                    algo, n_bytes));
+        }
+        return(tng_compress_vel_float(values, n_atoms, n_frames,
+                                      (float)VEL_PRECISION, speed, algo, n_bytes));
+    }
+    if(search)
+    {
+        return(tng_compress_pos_float_find_algo(values, n_atoms, n_frames,
+                                                (float)POS_PRECISION, speed,
+                                                algo, n_bytes));
+    }
+    return(tng_compress_pos_float(values, n_atoms, n_frames,
+                                  (float)POS_PRECISION, speed, algo, n_bytes));
+}
+
+/* Benchmark compressing and uncompressing values with one combination of
+ * algorithms, or searching for the best algorithms if coding is NULL. */
+static int tng_benchmark_coding_run(const int is_vel,
+                                    const struct tng_benchmark_coding *coding,
+                                    float *values, float *uncompressed,
+                                    const int n_atoms, const int n_frames,
+                                    const int speed, const double min_seconds)
+{
+    const char *prefix = is_vel ? "vel" : "pos";
+    const double precision = is_vel ? VEL_PRECISION : POS_PRECISION;
+    char benchmark[32];
+    char *data = 0;
+    int algo[4], n_bytes, n_iterations, i;
+    double start, seconds, max_diff = 0;
+
+    algo[0] = coding ? coding->initial_coding : -1;
+    algo[1] = -1;
+    algo[2] = coding ? coding->coding : -1;
+    algo[3] = -1;
+
+    /* Determine the parameters of the algorithms before the timing, so that
+     * only the compression itself is measured. */
+    if(coding)
+    {
+        data = tng_benchmark_compress(is_vel, 0, values, n_atoms, n_frames,
+                                      speed, algo, &n_bytes);
+        if(!data)
+        {
+            fprintf(stderr, "Cannot compress with %s %s.\n", prefix, coding->name);
+            return(1);
+        }
+        free(data);
+        data = 0;
+    }
+
+    n_iterations = 0;
+    start = tng_benchmark_time();
+    do
+    {
+        free(data);
+        if(!coding)
+        {
+            algo[0] = algo[1] = algo[2] = algo[3] = -1;
+        }
+        data = tng_benchmark_compress(is_vel, coding == 0, values, n_atoms,
+                                      n_frames, speed, algo, &n_bytes);
+        if(!data)
+        {
+            fprintf(stderr, "Cannot compress %s data.\n", prefix);
+            return(1);
+        }
+        n_iterations++;
+        seconds = tng_benchmark_time() - start;
+    } while(seconds < min_seconds);
+
+    sprintf(benchmark, "%s_%s", prefix, coding ? "compress" : "search");
+    tng_benchmark_result_print(benchmark, coding ? coding->initial_name : "search",
+                               coding ? coding->name : "search", speed,
+                               n_atoms, n_frames, n_bytes, seconds / n_iterations);
+    if(!coding)
+    {
+        free(data);
+        return(0);
+    }
+
+    n_iterations = 0;
+    start = tng_benchmark_time();
+    do
+    {
+        if(tng_compress_uncompress_float(data, uncompressed) != 0)
+        {
+            fprintf(stderr, "Cannot uncompress %s %s.\n", prefix, coding->name);
+            free(data);
+            return(1);
+        }
+        n_iterations++;
+        seconds = tng_benchmark_time() - start;
+    } while(seconds < min_seconds);
+    free(data);
+
+    for(i = 0; i < n_atoms * n_frames * 3; i++)
+    {
+        if(fabs(values[i] - uncompressed[i]) > max_diff)
+        {
+            max_diff = fabs(values[i] - uncompressed[i]);
+        }
+    }
+    /* Allow 10% more than half the precision, as the testsuite does. */
+    if(max_diff > precision * 0.5 * 1.1)
+    {
+        fprintf(stderr, "Uncompressed %s %s values differ by %g.\n", prefix,
+                coding->name, max_diff);
+        return(1);
+    }
+
+    sprintf(benchmark, "%s_uncompress", prefix);
+    tng_benchmark_result_print(benchmark, coding->initial_name, coding->name, speed,
+                               n_atoms, n_frames, n_bytes, seconds / n_iterations);
+
+    return(0);
+}
+
+static int tng_benchmark_codings(const int n_atoms, const int n_frames,
+                                 const double min_seconds)
+{
+    int *int_values;
+    float *pos, *vel, *uncompressed;
+    int i, j, speed, n_failed = 0;
+
+    int_values = malloc(sizeof(int) * n_atoms * 3);
+    pos = malloc(sizeof(float) * n_atoms * n_frames * 3);
+    vel = malloc(sizeof(float) * n_atoms * n_frames * 3);
+    uncompressed = malloc(sizeof(float) * n_atoms * n_frames * 3);
+    if(!int_values || !pos || !vel || !uncompressed)
+    {
+        fprintf(stderr, "Cannot allocate memory.\n");
+        free(int_values);
+        free(pos);
+        free(vel);
+        free(uncompressed);
+        return(1);
+    }
+
+    for(i = 0; i < n_frames; i++)
+    {
+        genibox(int_values, i);
+        for(j = 0; j < n_atoms * 3; j++)
+        {
+            pos[i * n_atoms * 3 + j] = (float)(int_values[j] * POS_PRECISION);
+        }
+        genivelbox(int_values, i);
+        for(j = 0; j < n_atoms * 3; j++)
+        {
+            vel[i * n_atoms * 3 + j] = (float)(int_values[j] * VEL_PRECISION);
+        }
+    }
+
+    for(speed = 1; speed <= 6; speed++)
+    {
+        for(i = 0; i < (int)(sizeof(pos_codings) / sizeof(pos_codings[0])); i++)
+        {
+            n_failed += tng_benchmark_coding_run(0, &pos_codings[i], pos, uncompressed,
+                                                 n_atoms, n_frames, speed, min_seconds);
+        }
+        n_failed += tng_benchmark_coding_run(0, 0, pos, uncompressed,
+                                             n_atoms, n_frames, speed, min_seconds);
+        for(i = 0; i < (int)(sizeof(vel_codings) / sizeof(vel_codings[0])); i++)
+        {
+            n_failed += tng_benchmark_coding_run(1, &vel_codings[i], vel, uncompressed,
+                                                 n_atoms, n_frames, speed, min_seconds);
+        }
+        n_failed += tng_benchmark_coding_run(1, 0, vel, uncompressed,
+                                             n_atoms, n_frames, speed, min_seconds);
+    }
+
+    free(int_values);
+    free(pos);
+    free(vel);
+    free(uncompressed);
+
+    return(n_failed);
+}
+
+static int64_t tng_benchmark_file_size(const char *file_name)
+{
+    tng_trajectory_t traj;
+    int64_t len = 0;
+
+    if(tng_util_trajectory_open(file_name, 'r', &traj) == TNG_SUCCESS)
+    {
+        tng_input_file_len_get(traj, &len);
+    }
+    tng_util_trajectory_close(&traj);
+
+    return(len);
+}
+
+static int tng_benchmark_write(const char *file_name, const int64_t n_atoms,
+                               const int64_t n_frames,
+                               const int64_t n_frames_per_frame_set)
+{
+    tng_trajectory_t traj;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    int *int_values;
+    float *pos;
+    int64_t i, j;
+    double start, seconds = 0;
+    tng_function_status stat = TNG_SUCCESS;
+
+    int_values = malloc(sizeof(int) * n_atoms * 3);
+    pos = malloc(sizeof(float) * n_atoms * 3);
+    if(!int_values || !pos)
+    {
+        fprintf(stderr, "Cannot allocate memory.\n");
+        free(int_values);
+        free(pos);
+        return(1);
+    }
+
+    start = tng_benchmark_time();
+    if(tng_util_trajectory_open(file_name, 'w', &traj) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "Cannot open %s.\n", file_name);
+        tng_util_trajectory_close(&traj);
+        free(int_values);
+        free(pos);
+        return(1);
+    }
+    tng_molecule_add(traj, "particle", &molecule);
+    tng_molecule_chain_add(traj, molecule, "P", &chain);
+    tng_chain_residue_add(traj, chain, "P", &residue);
+    tng_residue_atom_add(traj, residue, "P", "P", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_atoms);
+    tng_num_frames_per_frame_set_set(traj, n_frames_per_frame_set);
+    tng_compression_precision_set(traj, 1.0 / POS_PRECISION);
+    tng_util_pos_write_interval_set(traj, 1);
+    seconds += tng_benchmark_time() - start;
+
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        /* Only the writing is timed, not generating the positions. */
+        genibox(int_values, (int)i);
+        for(j = 0; j < n_atoms * 3; j++)
+        {
+            pos[j] = (float)(int_values[j] * POS_PRECISION);
+        }
+        start = tng_benchmark_time();
+        stat = tng_util_pos_write(traj, i, pos);
+        seconds += tng_benchmark_time() - start;
+    }
+
+    start = tng_benchmark_time();
+    tng_util_trajectory_close(&traj);
+    seconds += tng_benchmark_time() - start;
+
+    free(int_values);
+    free(pos);
+
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "Cannot write frame %"PRId64" to %s.\n", i - 1, file_name);
+        return(1);
+    }
+
+    tng_benchmark_result_print("write", "tng", "tng", 0, n_atoms, n_frames,
+                               (double)tng_benchmark_file_size(file_name), seconds);
+    return(0);
+}
+
+static int tng_benchmark_transcode(const char *src_file_name, const char *file_name,
+                                   const char *codec_name, const int64_t codec_id,
+                                   const int64_t n_atoms, const int64_t n_frames)
+{
+    tng_trajectory_t traj_in, traj_out;
+    double start, seconds;
+    tng_function_status stat;
+
+    start = tng_benchmark_time();
+    stat = tng_util_trajectory_open(src_file_name, 'r', &traj_in);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_open(file_name, 'w', &traj_out);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        tng_compression_precision_set(traj_out, 1.0 / POS_PRECISION);
+        stat = tng_util_trajectory_transcode(traj_in, traj_out, codec_id, TNG_FLOAT_DATA);
+    }
+    tng_util_trajectory_close(&traj_in);
+    tng_util_trajectory_close(&traj_out);
+    seconds = tng_benchmark_time() - start;
+
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "Cannot transcode %s to %s.\n", src_file_name, file_name);
+        return(1);
+    }
+
+    tng_benchmark_result_print("transcode", codec_name, codec_name, 0, n_atoms, n_frames,
+                               (double)tng_benchmark_file_size(file_name), seconds);
+    return(0);
+}
+
+static int tng_benchmark_read(const char *file_name, const char *codec_name,
+                              const int64_t n_atoms, const int64_t n_frames,
+                              const int64_t n_frames_per_frame_set)
+{
+    tng_trajectory_t traj;
+    float *pos = 0;
+    int64_t first_frame, last_frame, stride_length;
+    double start, seconds;
+    tng_function_status stat;
+
+    start = tng_benchmark_time();
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    /* Read one frame set at a time. */
+    for(first_frame = 0; first_frame < n_frames && stat == TNG_SUCCESS;
+        first_frame += n_frames_per_frame_set)
+    {
+        last_frame = first_frame + n_frames_per_frame_set - 1;
+        if(last_frame >= n_frames)
+        {
+            last_frame = n_frames - 1;
+        }
+        stat = tng_util_pos_read_range(traj, first_frame, last_frame, &pos,
+                                       &stride_length);
+    }
+    tng_util_trajectory_close(&traj);
+    seconds = tng_benchmark_time() - start;
+    free(pos);
+
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "Cannot read %s.\n", file_name);
+        return(1);
+    }
+
+    tng_benchmark_result_print("read", codec_name, codec_name, 0, n_atoms, n_frames,
+                               (double)tng_benchmark_file_size(file_name), seconds);
+    return(0);
+}
+
+static int tng_benchmark_seek(const char *file_name, const char *codec_name,
+                              const int64_t n_atoms, const int64_t n_frames,
+                              const int64_t n_seeks)
+{
+    tng_trajectory_t traj;
+    float *pos = 0;
+    int64_t i, frame = 0, stride_length;
+    /* The frames are chosen by a linear congruential generator, so that the
+     * same frames are read in every run. */
+    unsigned long lcg = 12345;
+    double start, seconds;
+    tng_function_status stat;
+
+    start = tng_benchmark_time();
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    for(i = 0; i < n_seeks && stat == TNG_SUCCESS; i++)
+    {
+        lcg = (lcg * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        frame = (int64_t)(lcg % (unsigned long)n_frames);
+        stat = tng_util_pos_read_range(traj, frame, frame, &pos, &stride_length);
+    }
+    tng_util_trajectory_close(&traj);
+    seconds = tng_benchmark_time() - start;
+    free(pos);
+
+    if(stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "Cannot read frame %"PRId64" of %s.\n", frame, file_name);
+        return(1);
+    }
+
+    tng_benchmark_result_print("seek", codec_name, codec_name, 0, n_atoms, n_seeks,
+                               (double)tng_benchmark_file_size(file_name), seconds);
+    return(0);
+}
+
+static int tng_benchmark_files(const char *file_name, const int64_t n_atoms,
+                               const int64_t n_frames,
+                               const int64_t n_frames_per_frame_set)
+{
+    const char *codec_names[3] = {"tng", "gzip", "none"};
+    const int64_t codec_ids[3] = {TNG_TNG_COMPRESSION, TNG_GZIP_COMPRESSION,
+                                  TNG_UNCOMPRESSED};
+    char *file_names[3];
+    int i, n_failed;
+
+    /* The gzipped and uncompressed trajectories are written next to the TNG
+     * compressed one, e.g. tng_benchmark.tng.gzip */
+    file_names[0] = (char *)file_name;
+    for(i = 1; i < 3; i++)
+    {
+        file_names[i] = malloc(strlen(file_name) + strlen(codec_names[i]) + 2);
+        strcpy(file_names[i], file_name);
+        strcat(file_names[i], ".");
+        strcat(file_names[i], codec_names[i]);
+    }
+
+    n_failed = tng_benchmark_write(file_name, n_atoms, n_frames, n_frames_per_frame_set);
+    for(i = 1; i < 3 && !n_failed; i++)
+    {
+        n_failed += tng_benchmark_transcode(file_name, file_names[i], codec_names[i],
+                                            codec_ids[i], n_atoms, n_frames);
+    }
+    for(i = 0; i < 3 && !n_failed; i++)
+    {
+        n_failed += tng_benchmark_read(file_names[i], codec_names[i], n_atoms, n_frames,
+                                       n_frames_per_frame_set);
+        n_failed += tng_benchmark_seek(file_names[i], codec_names[i], n_atoms, n_frames,
+                                       n_frames < 100 ? n_frames : 100);
+    }
+
+    for(i = 1; i < 3; i++)
+    {
+        free(file_names[i]);
+    }
+
+    return(n_failed);
+}
+
+int main(int argc, char **argv)
+{
+    const char *benchmarks = "all";
+    const char *file_name = "tng_benchmark.tng";
+    int64_t n_atoms = 1000, n_frames = 1000, n_frames_per_frame_set = 100;
+    double min_seconds = 0.2;
+    int n_failed = 0;
+
+    if(argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))
+    {
+        printf("Usage:\n");
+        printf("tng_benchmark [all, codec or file = %s] [n_atoms = %"PRId64"] "
+               "[n_frames = %"PRId64"] [n_frames_per_frame_set = %"PRId64"] "
+               "[min_seconds = %g] [file = %s]\n",
+               benchmarks, n_atoms, n_frames, n_frames_per_frame_set,
+               min_seconds, file_name);
+        printf("The compression algorithms are benchmarked on "
+               "n_frames_per_frame_set frames, repeated for at least "
+               "min_seconds. The file benchmarks write, read and seek in a "
+               "trajectory of n_frames frames.\n");
+        exit(0);
+    }
+    if(argc > 1)
+    {
+        benchmarks = argv[1];
+        if(strcmp(benchmarks, "all") != 0 && strcmp(benchmarks, "codec") != 0 &&
+           strcmp(benchmarks, "file") != 0)
+        {
+            printf("Unknown benchmark %s.\n", benchmarks);
+            exit(1);
+        }
+    }
+    if(argc > 2)
+    {
+        n_atoms = strtol(argv[2], 0, 10);
+    }
+    if(argc > 3)
+    {
+        n_frames = strtol(argv[3], 0, 10);
+    }
+    if(argc > 4)
+    {
+        n_frames_per_frame_set = strtol(argv[4], 0, 10);
+    }
+    if(argc > 5)
+    {
+        min_seconds = strtod(argv[5], 0);
+    }
+    if(argc > 6)
+    {
+        file_name = argv[6];
+    }
+    if(n_atoms <= 0 || n_frames <= 0 || n_frames_per_frame_set <= 0)
+    {
+        printf("The number of atoms and frames must be > 0.\n");
+        exit(1);
+    }
+
+    n_atoms_generated = (int)n_atoms;
+
+    printf("benchmark,initial_algorithm,algorithm,speed,n_atoms,n_frames,"
+           "raw_bytes,stored_bytes,seconds,mb_per_s,ns_per_atom\n");
+
+    if(strcmp(benchmarks, "file") != 0)
+    {
+        n_failed += tng_benchmark_codings((int)n_atoms, (int)n_frames_per_frame_set,
+                                          min_seconds);
+    }
+    if(strcmp(benchmarks, "codec") != 0)
+    {
+        n_failed += tng_benchmark_files(file_name, n_atoms, n_frames,
+                                        n_frames_per_frame_set);
+    }
+
+    return(n_failed ? 1 : 0);
+}
@@ -0,0 +1,248 @@
+/* This code is part of the tng binary trajectory format.
+ *
+ * Copyright (c) 2026, The GROMACS development team.
+ * Check out http://www.gromacs.org for more information.
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the Revised BSD License.
+ */
+
+#include "tng/tng_io.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+/* Test writing a trajectory collectively from several processes, each
+ * handling a part of the particles, e.g. using
+ * mpirun -np 4 bin/tests/tng_mpi_testing */
+
+#define COMPRESSION_PRECISION 1000
+
+static float tng_test_position(const int64_t particle, const int64_t frame,
+                               const int64_t dim)
+{
+    return((float)(particle % 97) * 0.1f + frame * 0.01f + dim);
+}
+
+static tng_function_status tng_test_mpi_write(const char *file_name,
+                                              const int64_t n_particles,
+                                              const int64_t n_frames,
+                                              const MPI_Comm comm)
+{
+    tng_trajectory_t traj;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    int rank, n_ranks;
+    int64_t first_particle, n_local_particles, i, j, k;
+    int64_t *mapping_table;
+    float *positions, box_shape[9];
+    tng_function_status stat = TNG_SUCCESS;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &n_ranks);
+
+    /* Only the first process writes the file headers and the non-particle
+     * data. The others only keep their frame sets in memory. */
+    if(rank == 0)
+    {
+        stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    }
+    else
+    {
+        stat = tng_trajectory_init(&traj);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+
+    stat = tng_util_pos_write_interval_set(traj, 1);
+    if(stat == TNG_SUCCESS && rank == 0)
+    {
+        stat = tng_util_box_shape_write_interval_set(traj, 1);
+    }
+
+    first_particle = n_particles * rank / n_ranks;
+    n_local_particles = n_particles * (rank + 1) / n_ranks - first_particle;
+    mapping_table = malloc(sizeof(int64_t) * n_local_particles);
+    for(i = 0; i < n_local_particles; i++)
+    {
+        mapping_table[i] = first_particle + i;
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_particle_mapping_add(traj, first_particle, n_local_particles,
+                                        mapping_table);
+    }
+    free(mapping_table);
+
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        if(i > 0 && i % 10 == 0)
+        {
+            stat = tng_frame_set_mpi_write(traj, comm, TNG_USE_HASH);
+            if(stat != TNG_SUCCESS)
+            {
+                break;
+            }
+        }
+        stat = tng_util_generic_frame_acquire(traj, i, 3, TNG_TRAJ_POSITIONS,
+                                              "POSITIONS", TNG_PARTICLE_BLOCK_DATA,
+                                              TNG_TNG_COMPRESSION, &positions);
+        if(stat != TNG_SUCCESS)
+        {
+            break;
+        }
+        for(j = 0; j < n_local_particles; j++)
+        {
+            for(k = 0; k < 3; k++)
+            {
+                positions[j * 3 + k] = tng_test_position(first_particle + j, i, k);
+            }
+        }
+        if(rank == 0)
+        {
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = j % 4 == 0 ? 10.0f + i : 0.0f;
+            }
+            stat = tng_util_box_shape_write(traj, i, box_shape);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_util_frame_commit(traj, i);
+        }
+    }
+    /* The last frame set is not full. */
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_mpi_write(traj, comm, TNG_USE_HASH);
+    }
+
+    if(rank == 0)
+    {
+        tng_util_trajectory_close(&traj);
+    }
+    else
+    {
+        tng_trajectory_destroy(&traj);
+    }
+
+    return(stat);
+}
+
+static tng_function_status tng_test_mpi_read(const char *file_name,
+                                             const int64_t n_particles,
+                                             const int64_t n_frames)
+{
+    tng_trajectory_t traj;
+    int64_t i, j, k, n_read_particles, n_read_frames, stride_len;
+    float *values = 0;
+    tng_function_status stat;
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    tng_num_particles_get(traj, &n_read_particles);
+    tng_num_frames_get(traj, &n_read_frames);
+    if(n_read_particles != n_particles || n_read_frames != n_frames)
+    {
+        printf("Unexpected number of particles or frames. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_pos_read_range(traj, i, i, &values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read positions. %s: %d\n", __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < n_particles && stat == TNG_SUCCESS; j++)
+        {
+            for(k = 0; k < 3; k++)
+            {
+                if(fabs(values[j * 3 + k] - tng_test_position(j, i, k)) >
+                   1.0 / COMPRESSION_PRECISION)
+                {
+                    printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                    stat = TNG_FAILURE;
+                    break;
+                }
+            }
+        }
+    }
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_box_shape_read_range(traj, i, i, &values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read box shape. %s: %d\n", __FILE__, __LINE__);
+            break;
+        }
+        if(values[0] != 10.0f + i)
+        {
+            printf("Unexpected box shape value. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+
+    free(values);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+int main(int argc, char **argv)
+{
+    const char *file_name = TNG_EXAMPLE_FILES_DIR "tng_test_mpi.tng";
+    int rank;
+    int64_t n_particles = 1000, n_frames = 25;
+    tng_function_status stat;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    stat = tng_test_mpi_write(file_name, n_particles, n_frames, MPI_COMM_WORLD);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if(rank == 0)
+    {
+        printf("Test MPI-IO writing:\t\t\t\t");
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_test_mpi_read(file_name, n_particles, n_frames);
+        }
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+        }
+        else
+        {
+            printf("Succeeded.\n");
+        }
+    }
+    MPI_Bcast(&stat, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    MPI_Finalize();
+
+    return(stat == TNG_SUCCESS ? 0 : 1);
+}
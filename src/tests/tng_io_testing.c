@@ -10,12 +10,17 @@
  */
 
 #include "tng/tng_io.h"
+#include "compression/tng_compress.h"
 
 #ifdef USE_STD_INTTYPES_H
 #include <inttypes.h>
 #endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <math.h>
 #include "tng/version.h"
@@ -135,8 +140,11 @@ static tng_function_status tng_test_molecules(tng_trajectory_t traj)
     tng_chain_t chain;
     tng_residue_t residue;
     tng_atom_t atom;
-    int64_t cnt, *bonds_to, *bonds_from;
+    int64_t i, cnt, *bonds_to, *bonds_from, ids[600], n_particles;
     char var_atoms, str[TNG_MAX_STR_LEN];
+    const char *names[600];
+    const int64_t *offsets, *neighbors;
+    const int32_t *offsets_32, *neighbors_32;
     tng_function_status stat;
 
     stat = tng_num_molecule_types_get(traj, &cnt);
@@ -357,6 +365,37 @@ static tng_function_status tng_test_molecules(tng_trajectory_t traj)
         return(stat);
     }
 
+    stat = tng_global_residue_ids_of_particles_get(traj, 0, 600, ids);
+    if(stat != TNG_SUCCESS || ids[0] != 0 || ids[3] != 1 || ids[599] != 199)
+    {
+        printf("Cannot get global residue ids of atoms. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    stat = tng_atom_names_of_particles_get(traj, 0, 600, names);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot get atom names of atoms. %s: %d\n",
+               __FILE__, __LINE__);
+        return(stat);
+    }
+    for(i = 0; i < 600; i++)
+    {
+        tng_atom_name_of_particle_nr_get(traj, i, str, TNG_MAX_STR_LEN);
+        if(strcmp(names[i], str) != 0)
+        {
+            printf("Atom names of atoms do not match. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(TNG_FAILURE);
+        }
+    }
+    if(tng_molecule_ids_of_particles_get(traj, 598, 3, ids) != TNG_FAILURE)
+    {
+        printf("Could get molecule ids of atoms outside the molecular system. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
     stat = tng_molecule_alloc(traj, &molecule_new);
     if(stat != TNG_SUCCESS)
     {
@@ -378,6 +417,51 @@ static tng_function_status tng_test_molecules(tng_trajectory_t traj)
                __FILE__, __LINE__);
         return(stat);
     }
+    /* Add residues to the first chain after residues have been added to the
+     * second chain. */
+    if(tng_molecule_chain_add(traj, molecule_new, "A", &chain) != TNG_SUCCESS ||
+       tng_chain_residue_add(traj, chain, "ALA", &residue) != TNG_SUCCESS ||
+       tng_molecule_chain_add(traj, molecule_new, "B", &chain) != TNG_SUCCESS ||
+       tng_chain_residue_add(traj, chain, "GLY", &residue) != TNG_SUCCESS ||
+       tng_residue_atom_add(traj, residue, "CA", "C", &atom) != TNG_SUCCESS)
+    {
+        printf("Cannot add chains to new molecule. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    tng_molecule_chain_find(traj, molecule_new, "A", -1, &chain);
+    for(i = 0; i < 20; i++)
+    {
+        if(tng_chain_residue_add(traj, chain, "SER", &residue) != TNG_SUCCESS)
+        {
+            printf("Cannot add residue to chain. %s: %d\n",
+                   __FILE__, __LINE__);
+            return(TNG_FAILURE);
+        }
+    }
+    tng_molecule_chain_find(traj, molecule_new, "B", -1, &chain);
+    stat = tng_chain_residue_of_index_get(traj, chain, 0, &residue);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot get residue in chain. %s: %d\n",
+               __FILE__, __LINE__);
+        return(stat);
+    }
+    tng_residue_name_get(traj, residue, str, TNG_MAX_STR_LEN);
+    if(strcmp(str, "GLY") != 0 ||
+       tng_residue_atom_of_index_get(traj, residue, 0, &atom) != TNG_SUCCESS)
+    {
+        printf("Residues of chain changed when adding residues to another chain. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    tng_atom_name_get(traj, atom, str, TNG_MAX_STR_LEN);
+    if(strcmp(str, "CA") != 0)
+    {
+        printf("Atoms of residue changed when adding residues to another chain. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
 
     stat = tng_molsystem_bonds_get(traj, &cnt, &bonds_from, &bonds_to);
     if(stat != TNG_SUCCESS || cnt != 400)
@@ -390,6 +474,36 @@ static tng_function_status tng_test_molecules(tng_trajectory_t traj)
     free(bonds_from);
     free(bonds_to);
 
+    stat = tng_molsystem_connectivity_get(traj, &n_particles, &offsets, &neighbors);
+    if(stat != TNG_SUCCESS || offsets[n_particles] != 2 * cnt ||
+       offsets[1] != 2 || neighbors[0] != 1 || neighbors[1] != 2 ||
+       offsets[2] != 3 || neighbors[2] != 0)
+    {
+        printf("Cannot get connectivity of molecule system. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    stat = tng_molsystem_connectivity_int32_get(traj, &n_particles, &offsets_32,
+                                                &neighbors_32);
+    if(stat != TNG_SUCCESS || offsets_32[n_particles] != 2 * cnt ||
+       neighbors_32[2 * cnt - 1] != neighbors[2 * cnt - 1])
+    {
+        printf("Cannot get 32 bit connectivity of molecule system. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    /* The connectivity must follow changes of the molecule counts. */
+    tng_molecule_find(traj, "water", -1, &molecule);
+    tng_molecule_cnt_set(traj, molecule, 199);
+    stat = tng_molsystem_connectivity_get(traj, &n_particles, &offsets, &neighbors);
+    if(stat != TNG_SUCCESS || offsets[n_particles] != 2 * cnt - 4)
+    {
+        printf("Connectivity not updated when changing molecule count. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    tng_molecule_cnt_set(traj, molecule, 200);
+
     return(TNG_SUCCESS);
 }
 
@@ -1327,6 +1441,12 @@ tng_function_status tng_test_append(tng_trajectory_t traj, const char hash_mode)
 tng_function_status tng_test_copy_container(tng_trajectory_t traj, const char hash_mode)
 {
     tng_trajectory_t dest;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    char str[TNG_MAX_STR_LEN];
+    int64_t cnt;
     tng_function_status stat;
 
     stat = tng_util_trajectory_open(TNG_EXAMPLE_FILES_DIR "tng_test.tng", 'r', &traj);
@@ -1349,6 +1469,36 @@ tng_function_status tng_test_copy_container(tng_trajectory_t traj, const char ha
         return(stat);
     }
 
+    /* Modifying the copied molecular system must not change the original. */
+    tng_molecule_find(dest, "water", -1, &molecule);
+    tng_molecule_chain_find(dest, molecule, "W", -1, &chain);
+    tng_chain_residue_find(dest, chain, "WAT", -1, &residue);
+    stat = tng_residue_atom_add(dest, residue, "HO3", "H", &atom);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot add atom to copied molecular system. %s: %d\n",
+               __FILE__, __LINE__);
+        return(stat);
+    }
+    tng_molecule_name_set(dest, molecule, "copy");
+    tng_molecule_find(dest, "copy", -1, &molecule);
+    tng_molecule_num_atoms_get(dest, molecule, &cnt);
+    if(cnt != 4)
+    {
+        printf("Copied molecular system not modified. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    if(tng_molecule_find(traj, "water", -1, &molecule) != TNG_SUCCESS ||
+       tng_molecule_num_atoms_get(traj, molecule, &cnt) != TNG_SUCCESS || cnt != 3 ||
+       tng_atom_name_of_particle_nr_get(traj, 2, str, TNG_MAX_STR_LEN) != TNG_SUCCESS ||
+       strcmp(str, "HO2") != 0)
+    {
+        printf("Original molecular system modified by modifying the copy. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
     stat = tng_util_trajectory_close(&traj);
     if(stat != TNG_SUCCESS)
     {
@@ -1359,129 +1509,2905 @@ tng_function_status tng_test_copy_container(tng_trajectory_t traj, const char ha
     return(stat);
 }
 
-int main()
+tng_function_status tng_test_compressed_positions(tng_trajectory_t traj,
+                                                  const char *file_name,
+                                                  const char codec,
+                                                  const int64_t keyframe_interval)
 {
-    tng_trajectory_t traj = 0;
-    char time_str[TNG_MAX_DATE_STR_LEN];
-    char version_str[TNG_MAX_STR_LEN];
-    char hash_mode = TNG_USE_HASH;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat;
+    struct tng_statistics statistics;
+    int64_t n_particles = 100, n_frames = 25, i, j, codec_id, stride_len;
+    float *positions, *read_positions = 0;
+    double multiplier;
 
-    tng_version(traj, version_str, TNG_MAX_STR_LEN);
-    printf("Test version control:\t\t\t\t");
-    if(strncmp(TNG_VERSION, version_str, TNG_MAX_STR_LEN) == 0)
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
     {
-        printf("Succeeded.\n");
+        printf("Cannot open trajectory. %s: %d\n",
+               __FILE__, __LINE__);
+        return(stat);
     }
-    else
+
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+    tng_compression_keyframe_interval_set(traj, keyframe_interval);
+    /* Only use a quarter of the particles to find the compression algorithm. */
+    tng_compression_algo_sample_set(traj, n_particles / 4);
+    tng_compression_algorithm_store_set(traj, TNG_TRUE);
+
+    stat = tng_util_generic_write_interval_set(traj, 1, 3, TNG_TRAJ_POSITIONS,
+                                               "POSITIONS", TNG_PARTICLE_BLOCK_DATA,
+                                               codec);
+    if(stat != TNG_SUCCESS)
     {
-        printf("Failed.\n");
+        printf("Cannot set writing interval. %s: %d\n",
+               __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(stat);
     }
 
-    printf("Test Init trajectory:\t\t\t\t");
-    if(tng_trajectory_init(&traj) != TNG_SUCCESS)
+    positions = malloc(sizeof(float) * n_frames * n_particles * 3);
+    if(!positions)
     {
-        tng_trajectory_destroy(&traj);
-        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
-        exit(1);
+        printf("Cannot allocate memory. %s: %d\n",
+               __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_CRITICAL);
     }
-    printf("Succeeded.\n");
-
-    tng_time_get_str(traj, time_str);
-
-    printf("Creation time: %s\n", time_str);
 
-    tng_input_file_set(traj, TNG_EXAMPLE_FILES_DIR "tng_example.tng");
-    tng_output_file_set(traj, TNG_EXAMPLE_FILES_DIR "tng_example_out.tng");
+    for(i = 0; i < n_frames; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[i * n_particles * 3 + j] = (float)(j % 97) * 0.137f + i * 0.01f;
+        }
+        stat = tng_util_pos_write(traj, i, positions + i * n_particles * 3);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot write positions. %s: %d\n",
+                   __FILE__, __LINE__);
+            free(positions);
+            tng_util_trajectory_close(&traj);
+            return(stat);
+        }
+    }
 
-    printf("Test Read and write file:\t\t\t");
-    if(tng_test_read_and_write_file(traj, hash_mode) != TNG_SUCCESS)
+    stat = tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
     {
-        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+        free(positions);
+        return(stat);
     }
-    else
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
     {
-        printf("Succeeded.\n");
+        free(positions);
+        return(stat);
     }
+    tng_statistics_enabled_set(traj, TNG_TRUE);
 
-    printf("Test Get data:\t\t\t\t\t");
-    if(tng_test_get_box_data(traj) != TNG_SUCCESS)
+    /* Read the frames one by one, which is what XTC compression and
+     * keyframes are meant for. */
+    for(i = n_frames - 1; i >= 0 && stat == TNG_SUCCESS; i--)
     {
-        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+        stat = tng_util_pos_read_range(traj, i, i, &read_positions, &stride_len);
+        if(stat != TNG_SUCCESS || stride_len != 1)
+        {
+            printf("Cannot read compressed positions. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(read_positions[j] - positions[i * n_particles * 3 + j]) >
+               1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n",
+                       __FILE__, __LINE__);
+                printf("Value: %f, expected value: %f\n", read_positions[j],
+                       positions[i * n_particles * 3 + j]);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
     }
-    else
+    free(positions);
+    if(read_positions)
     {
-        printf("Succeeded.\n");
+        free(read_positions);
     }
 
-    printf("Test Destroy and init trajectory:\t\t");
-    if(tng_trajectory_destroy(&traj) != TNG_SUCCESS ||
-       tng_trajectory_init(&traj) != TNG_SUCCESS)
+    /* Each frame is uncompressed on its own, without storing the frame sets. */
+    tng_statistics_get(traj, &statistics);
+    if(stat == TNG_SUCCESS && statistics.n_allocations != 0)
     {
-        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+        printf("Whole frame sets were read. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
     }
-    else
+
+    /* The multiplier gives the precision that the data was compressed with. */
+    if(stat == TNG_SUCCESS)
     {
-        printf("Succeeded.\n");
+        stat = tng_util_frame_current_compression_get(traj, TNG_TRAJ_POSITIONS,
+                                                      &codec_id, &multiplier);
+        if(stat != TNG_SUCCESS || codec_id != codec ||
+           fabs(multiplier - COMPRESSION_PRECISION) > 0.001)
+        {
+            printf("Unexpected compression. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
     }
 
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS)
+    {
+        return(TNG_FAILURE);
+    }
 
-    tng_output_file_set(traj, TNG_EXAMPLE_FILES_DIR "tng_test.tng");
+    return(stat);
+}
 
-    printf("Test Write and read file:\t\t\t");
-    if(tng_test_write_and_read_traj(&traj, hash_mode) != TNG_SUCCESS)
+/* Only positions can be XTC compressed. Other particle data written with
+ * XTC compression must be stored uncompressed instead, both when the values
+ * are encoded where they are stored (velocities) and when a zeroed copy is
+ * encoded because no values were added (forces). */
+tng_function_status tng_test_xtc_other_data(tng_trajectory_t traj,
+                                            const char *file_name)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat;
+    int64_t n_particles = 10, n_frames = 5, i, j, codec_id, stride_len;
+    float velocities[150], *read_values = 0;
+    double multiplier;
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
     {
-        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
     }
-    else
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, n_frames);
+    for(i = 0; i < n_frames * n_particles * 3; i++)
     {
-        printf("Succeeded.\n");
+        velocities[i] = (float)i * 0.37f;
     }
-
-    printf("Test Get particle data:\t\t\t\t");
-    if(tng_test_get_positions_data(traj, hash_mode) != TNG_SUCCESS)
+    stat = tng_file_headers_write(traj, TNG_USE_HASH);
+    if(stat == TNG_SUCCESS)
     {
-        printf("Failed. %s: %d\n",
-               __FILE__, __LINE__);
+        stat = tng_frame_set_new(traj, 0, n_frames);
     }
-    else
+    if(stat == TNG_SUCCESS)
     {
-        printf("Succeeded.\n");
+        stat = tng_particle_data_block_add(traj, TNG_TRAJ_VELOCITIES, "VELOCITIES",
+                                           TNG_FLOAT_DATA, TNG_TRAJECTORY_BLOCK,
+                                           n_frames, 3, 1, 0, n_particles,
+                                           TNG_XTC_COMPRESSION, velocities);
     }
-
-    printf("Test Destroy trajectory:\t\t\t");
-    if(tng_trajectory_destroy(&traj) != TNG_SUCCESS)
+    if(stat == TNG_SUCCESS)
     {
-        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
-        exit(1);
+        stat = tng_particle_data_block_add(traj, TNG_TRAJ_FORCES, "FORCES",
+                                           TNG_FLOAT_DATA, TNG_TRAJECTORY_BLOCK,
+                                           n_frames, 3, 1, 0, n_particles,
+                                           TNG_XTC_COMPRESSION, 0);
     }
-    else
+    if(stat == TNG_SUCCESS)
     {
-        printf("Succeeded.\n");
+        stat = tng_frame_set_write(traj, TNG_USE_HASH);
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot write XTC compressed data. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
     }
 
-    printf("Test Utility functions:\t\t\t\t");
-    if(tng_test_utility_functions(traj, hash_mode) != TNG_SUCCESS)
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
     {
-        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
-        exit(1);
+        return(stat);
     }
-    else
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
     {
-        printf("Succeeded.\n");
+        stat = tng_util_vel_read_range(traj, i, i, &read_values, &stride_len);
+        for(j = 0; j < n_particles * 3 && stat == TNG_SUCCESS; j++)
+        {
+            if(read_values[j] != velocities[i * n_particles * 3 + j])
+            {
+                printf("Unexpected velocity value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+            }
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_util_force_read_range(traj, i, i, &read_values, &stride_len);
+        }
+        for(j = 0; j < n_particles * 3 && stat == TNG_SUCCESS; j++)
+        {
+            if(read_values[j] != 0)
+            {
+                printf("Unexpected force value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+            }
+        }
     }
-
-    printf("Test Append:\t\t\t\t\t");
-    if(tng_test_append(traj, hash_mode) != TNG_SUCCESS)
+    if(stat == TNG_SUCCESS &&
+       (tng_util_frame_current_compression_get(traj, TNG_TRAJ_VELOCITIES, &codec_id,
+                                               &multiplier) != TNG_SUCCESS ||
+        codec_id != TNG_UNCOMPRESSED))
     {
-        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+        printf("Velocities not stored uncompressed. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
     }
-    else
+    if(read_values)
     {
-        printf("Succeeded.\n");
+        free(read_values);
     }
+    tng_util_trajectory_close(&traj);
 
-    printf("Test Copy trajectory container:\t\t\t");
-    if(tng_test_copy_container(traj, hash_mode) != TNG_SUCCESS)
+    return(stat);
+}
+
+/* Check that a single frame of a keyframe compressed file is read without
+ * uncompressing the whole frame set, and that frame ranges outside a TNG
+ * compressed block are rejected. */
+tng_function_status tng_test_single_frame_read(tng_trajectory_t traj,
+                                               const char *file_name)
+{
+    tng_function_status stat;
+    struct tng_statistics statistics;
+    int64_t n_particles, i = 13, j, stride_len;
+    int algo[4] = {-1, -1, -1, -1}, len;
+    float positions[3 * 3 * 2], read_frame[3 * 2], *read_positions = 0;
+    char *data;
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_statistics_enabled_set(traj, TNG_TRUE);
+    tng_num_particles_get(traj, &n_particles);
+
+    stat = tng_util_pos_read_range(traj, i, i, &read_positions, &stride_len);
+    if(stat != TNG_SUCCESS || stride_len != 1)
+    {
+        printf("Cannot read compressed positions. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    for(j = 0; j < n_particles * 3 && stat == TNG_SUCCESS; j++)
+    {
+        if(fabs(read_positions[j] - ((float)(j % 97) * 0.137f + i * 0.01f)) >
+           1.0 / COMPRESSION_PRECISION)
+        {
+            printf("Unexpected position value. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    /* Only the requested frame is returned, the frame set data is not stored. */
+    tng_statistics_get(traj, &statistics);
+    if(stat == TNG_SUCCESS && statistics.n_allocations != 0)
+    {
+        printf("The whole frame set was read. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    if(read_positions)
+    {
+        free(read_positions);
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        return(TNG_FAILURE);
+    }
+
+    for(j = 0; j < 3 * 3 * 2; j++)
+    {
+        positions[j] = (float)j * 0.1f;
+    }
+    data = tng_compress_pos_float(positions, 2, 3, 0.001f, 0, algo, &len);
+    if(!data)
+    {
+        printf("Cannot compress positions. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+    if(tng_compress_uncompress_frames_float(data, 1, 1, read_frame) != 0 ||
+       fabs(read_frame[5] - positions[11]) > 0.001)
+    {
+        printf("Cannot uncompress a single frame. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    if(tng_compress_uncompress_frames_float(data, 2, 2, read_frame) == 0 ||
+       tng_compress_uncompress_frames_float(data, -1, 1, read_frame) == 0)
+    {
+        printf("Frames outside the block not rejected. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    free(data);
+
+    return(stat);
+}
+
+/* Check that searching for the best compression algorithms of positions and
+ * velocities using several threads finds the same algorithms, and gives the
+ * same output, as a serial search. The candidate algorithms are compressed
+ * concurrently, also the slow BWLZH ones at the highest speed setting. */
+tng_function_status tng_test_compression_algo_threads(void)
+{
+    const int n_particles = 500, n_frames = 10, speeds[2] = {3, 6};
+    int serial_algo[4], parallel_algo[4], serial_len, parallel_len, i, k;
+    float *positions;
+    char *serial_data = 0, *parallel_data = 0;
+    unsigned int seed = 12345;
+    tng_function_status stat = TNG_SUCCESS;
+#ifdef _OPENMP
+    int n_threads = omp_get_max_threads();
+#endif
+
+    positions = malloc(sizeof(float) * n_frames * n_particles * 3);
+    if(!positions)
+    {
+        printf("Cannot allocate memory. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+    /* Irregular values, so that the coding parameters searched for matter. */
+    for(i = 0; i < n_frames * n_particles * 3; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        positions[i] = (float)(i % (n_particles * 3)) * 0.01f +
+                       (float)((seed >> 16) % 1000) * 0.0005f;
+    }
+
+    /* Positions and velocities at two speed settings. */
+    for(k = 0; k < 4 && stat == TNG_SUCCESS; k++)
+    {
+        serial_algo[0] = serial_algo[1] = serial_algo[2] = serial_algo[3] = -1;
+        parallel_algo[0] = parallel_algo[1] = parallel_algo[2] = parallel_algo[3] = -1;
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        serial_data = k % 2 == 0 ?
+            tng_compress_pos_float_find_algo(positions, n_particles, n_frames, 0.001f,
+                                             speeds[k / 2], serial_algo, &serial_len) :
+            tng_compress_vel_float_find_algo(positions, n_particles, n_frames, 0.001f,
+                                             speeds[k / 2], serial_algo, &serial_len);
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads > 1 ? n_threads : 4);
+#endif
+        if(serial_data)
+        {
+            parallel_data = k % 2 == 0 ?
+                tng_compress_pos_float_find_algo(positions, n_particles, n_frames, 0.001f,
+                                                 speeds[k / 2], parallel_algo, &parallel_len) :
+                tng_compress_vel_float_find_algo(positions, n_particles, n_frames, 0.001f,
+                                                 speeds[k / 2], parallel_algo, &parallel_len);
+        }
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#endif
+        if(!serial_data || !parallel_data)
+        {
+            printf("Cannot compress %s. %s: %d\n", k % 2 == 0 ? "positions" : "velocities",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+        else if(memcmp(serial_algo, parallel_algo, sizeof(serial_algo)) != 0 ||
+                serial_len != parallel_len ||
+                memcmp(serial_data, parallel_data, serial_len) != 0)
+        {
+            printf("Serial and parallel searches found different algorithms. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+        free(serial_data);
+        free(parallel_data);
+        serial_data = parallel_data = 0;
+    }
+
+    free(positions);
+
+    return(stat);
+}
+
+/* Check that the compression algorithm stored in the file header is read
+ * back and reused when appending frames to the file. */
+tng_function_status tng_test_stored_compression_algorithm(tng_trajectory_t traj,
+                                                          const char *file_name)
+{
+    tng_function_status stat;
+    int64_t n_particles, n_frames, i, j, stride_len, pos, header[3];
+    int algo[4], appended_algo[4];
+    float *positions, *read_positions = 0;
+    FILE *file;
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    stat = tng_compression_algorithm_get(traj, TNG_TRAJ_POSITIONS, algo);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS || algo[2] == -1 || algo[3] == -1)
+    {
+        printf("Compression algorithm not stored. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'a', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_num_particles_get(traj, &n_particles);
+    tng_num_frames_get(traj, &n_frames);
+
+    positions = malloc(sizeof(float) * n_particles * 3);
+    if(!positions)
+    {
+        printf("Cannot allocate memory. %s: %d\n",
+               __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_CRITICAL);
+    }
+
+    for(i = n_frames; i < n_frames + 10 && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(j % 97) * 0.137f + i * 0.01f;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+    }
+    if(tng_compression_algorithm_get(traj, TNG_TRAJ_POSITIONS, appended_algo) !=
+       TNG_SUCCESS || memcmp(algo, appended_algo, sizeof(algo)) != 0)
+    {
+        printf("Stored compression algorithm not reused. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        free(positions);
+        return(TNG_FAILURE);
+    }
+
+    /* The general info block must keep its layout, since other readers find
+     * the first frame set pointer 5 values before the end of the block. */
+    file = fopen(file_name, "rb");
+    if(!file || fread(header, sizeof(int64_t), 3, file) != 3 ||
+       header[2] != TNG_GENERAL_INFO ||
+       fseek(file, (long)(header[0] + header[1] - 5 * sizeof(int64_t)), SEEK_SET) != 0 ||
+       fread(&pos, sizeof(pos), 1, file) != 1 ||
+       fseek(file, (long)pos, SEEK_SET) != 0 ||
+       fread(header, sizeof(int64_t), 3, file) != 3 ||
+       header[2] != TNG_TRAJECTORY_FRAME_SET)
+    {
+        printf("Unexpected general info block. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    if(file)
+    {
+        fclose(file);
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        free(positions);
+        return(stat);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        free(positions);
+        return(stat);
+    }
+    stat = tng_util_pos_read_range(traj, n_frames + 9, n_frames + 9,
+                                   &read_positions, &stride_len);
+    if(stat == TNG_SUCCESS)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(read_positions[j] - positions[j]) > 1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n",
+                       __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    free(positions);
+    if(read_positions)
+    {
+        free(read_positions);
+    }
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+/* Check that uncompressed float and double data written as big endian is
+ * read back correctly. */
+tng_function_status tng_test_big_endian(tng_trajectory_t traj,
+                                        const char *file_name)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 10, n_frames = 15, i, j, stride_len, n_read, n_values;
+    float positions[30], *read_positions = 0;
+    double velocities[30];
+    void *read_velocities = 0;
+    char type;
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_output_file_endianness_set(traj, TNG_BIG_ENDIAN);
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_util_generic_write_interval_set(traj, 1, 3, TNG_TRAJ_POSITIONS, "POSITIONS",
+                                        TNG_PARTICLE_BLOCK_DATA, TNG_UNCOMPRESSED);
+    tng_util_generic_write_interval_double_set(traj, 1, 3, TNG_TRAJ_VELOCITIES,
+                                               "VELOCITIES", TNG_PARTICLE_BLOCK_DATA,
+                                               TNG_UNCOMPRESSED);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(i * 100 + j) * 0.25f;
+            velocities[j] = -(double)(i * 100 + j) * 0.125;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_util_vel_double_write(traj, i, velocities);
+        }
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot write big endian trajectory. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_pos_read_range(traj, i, i, &read_positions, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read big endian positions. %s: %d\n",
+                   __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(read_positions[j] != (float)(i * 100 + j) * 0.25f)
+            {
+                printf("Unexpected position value in big endian trajectory. %s: %d\n",
+                       __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_particle_data_vector_interval_get(traj, TNG_TRAJ_VELOCITIES, i, i,
+                                                     TNG_USE_HASH, &read_velocities,
+                                                     &n_read, &stride_len, &n_values,
+                                                     &type);
+        if(stat != TNG_SUCCESS || type != TNG_DOUBLE_DATA)
+        {
+            printf("Cannot read big endian velocities. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(((double *)read_velocities)[j] != -(double)(i * 100 + j) * 0.125)
+            {
+                printf("Unexpected velocity value in big endian trajectory. %s: %d\n",
+                       __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    if(read_positions)
+    {
+        free(read_positions);
+    }
+    if(read_velocities)
+    {
+        free(read_velocities);
+    }
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+tng_function_status tng_test_statistics(tng_trajectory_t traj,
+                                        const char *file_name)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat = TNG_SUCCESS;
+    struct tng_statistics statistics;
+    int64_t n_particles = 10, n_frames = 15, i, j, stride_len;
+    float positions[30], *read_positions = 0;
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_statistics_enabled_set(traj, TNG_TRUE);
+    tng_output_file_endianness_set(traj, TNG_BIG_ENDIAN);
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 5);
+    tng_util_generic_write_interval_set(traj, 1, 3, TNG_TRAJ_POSITIONS, "POSITIONS",
+                                        TNG_PARTICLE_BLOCK_DATA, TNG_GZIP_COMPRESSION);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(i * 100 + j) * 0.25f;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+    }
+    tng_statistics_get(traj, &statistics);
+    if(stat == TNG_SUCCESS && (statistics.bytes_written <= 0 || statistics.n_seeks <= 0 ||
+       statistics.n_allocations <= 0))
+    {
+        printf("Unexpected statistics of writing. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot write trajectory. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_statistics_enabled_set(traj, TNG_TRUE);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_pos_read_range(traj, i, i, &read_positions, &stride_len);
+        if(stat == TNG_SUCCESS && read_positions[0] != (float)(i * 100) * 0.25f)
+        {
+            printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_nr_find(traj, 1);
+    }
+    tng_statistics_get(traj, &statistics);
+    if(stat == TNG_SUCCESS && (statistics.bytes_read <= 0 || statistics.bytes_written != 0 ||
+       statistics.n_block_headers_read <= 0 || statistics.n_frame_sets_read < n_frames / 5 ||
+       statistics.n_frame_set_searches <= 0 || statistics.n_allocations <= 0 ||
+       statistics.md5_ticks < 0 || statistics.gzip_uncompress_ticks < 0 ||
+       statistics.byte_swap_ticks < 0))
+    {
+        printf("Unexpected statistics of reading. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+
+    tng_statistics_reset(traj);
+    tng_statistics_get(traj, &statistics);
+    if(stat == TNG_SUCCESS && (statistics.bytes_read != 0 || statistics.n_seeks != 0 ||
+       statistics.n_frame_sets_read != 0 || statistics.gzip_uncompress_ticks != 0))
+    {
+        printf("Statistics not reset. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+
+    /* Nothing is counted when the statistics are disabled. */
+    tng_statistics_enabled_set(traj, TNG_FALSE);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_nr_find(traj, 0);
+    }
+    tng_statistics_get(traj, &statistics);
+    if(stat == TNG_SUCCESS && (statistics.n_seeks != 0 || statistics.n_frame_set_searches != 0))
+    {
+        printf("Statistics counted when disabled. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+
+    if(read_positions)
+    {
+        free(read_positions);
+    }
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+tng_function_status tng_test_data_iterator(tng_trajectory_t traj,
+                                           const char *file_name)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_data_iterator_t iterator = 0;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 10, n_frames = 50, box_stride = 7, i, j, frame_nr;
+    int64_t n_read, n_values, n_frames_per_frame_set, stride_len;
+    float positions[30], box_shape[9], *read_positions = 0, *iterated_positions = 0;
+    const void *values;
+    char type;
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_util_generic_write_interval_set(traj, 1, 3, TNG_TRAJ_POSITIONS, "POSITIONS",
+                                        TNG_PARTICLE_BLOCK_DATA, TNG_UNCOMPRESSED);
+    tng_util_generic_write_interval_set(traj, box_stride, 9, TNG_TRAJ_BOX_SHAPE,
+                                        "BOX SHAPE", TNG_NON_PARTICLE_BLOCK_DATA,
+                                        TNG_UNCOMPRESSED);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(i * 100 + j) * 0.25f;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+        if(stat == TNG_SUCCESS && i % box_stride == 0)
+        {
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = (float)(i * 10 + j);
+            }
+            stat = tng_util_box_shape_write(traj, i, box_shape);
+        }
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot write sparse data trajectory. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    /* The box shape is only stored every box_stride frames. */
+    stat = tng_data_iterator_init(traj, TNG_TRAJ_BOX_SHAPE, 5, 45, TNG_USE_HASH,
+                                  &iterator);
+    for(i = box_stride; i <= 45 && stat == TNG_SUCCESS; i += box_stride)
+    {
+        stat = tng_data_iterator_next(traj, iterator, &frame_nr, &values, &n_read,
+                                      &n_values, &type);
+        if(stat != TNG_SUCCESS || frame_nr != i || n_read != 0 || n_values != 9 ||
+           type != TNG_FLOAT_DATA)
+        {
+            printf("Unexpected sparse data frame. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < 9; j++)
+        {
+            if(((const float *)values)[j] != (float)(i * 10 + j))
+            {
+                printf("Unexpected sparse data value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    if(stat == TNG_SUCCESS &&
+       tng_data_iterator_next(traj, iterator, &frame_nr, &values, &n_read,
+                              &n_values, &type) != TNG_FAILURE)
+    {
+        printf("Sparse data found after the end of the interval. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    tng_data_iterator_destroy(&iterator);
+
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_data_iterator_init(traj, TNG_TRAJ_POSITIONS, 8, 23, TNG_USE_HASH,
+                                      &iterator);
+    }
+    for(i = 8; i <= 23 && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_data_iterator_next(traj, iterator, &frame_nr, &values, &n_read,
+                                      &n_values, &type);
+        if(stat != TNG_SUCCESS || frame_nr != i || n_read != n_particles ||
+           n_values != 3 || type != TNG_FLOAT_DATA)
+        {
+            printf("Unexpected particle data frame. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(((const float *)values)[j] != (float)(i * 100 + j) * 0.25f)
+            {
+                printf("Unexpected particle data value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    tng_data_iterator_destroy(&iterator);
+    tng_util_trajectory_close(&traj);
+
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    /* The particles of this file are mapped. Compare with reading one frame at
+     * a time across a frame set boundary. */
+    stat = tng_util_trajectory_open(TNG_EXAMPLE_FILES_DIR "tng_test.tng", 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_num_frames_per_frame_set_get(traj, &n_frames_per_frame_set);
+    tng_num_particles_get(traj, &n_particles);
+    stat = tng_data_iterator_init(traj, TNG_TRAJ_POSITIONS, n_frames_per_frame_set - 2,
+                                  n_frames_per_frame_set + 1, TNG_USE_HASH, &iterator);
+    for(i = n_frames_per_frame_set - 2; i <= n_frames_per_frame_set + 1 &&
+        stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_data_iterator_next(traj, iterator, &frame_nr, &values, &n_read,
+                                      &n_values, &type);
+        if(stat != TNG_SUCCESS || frame_nr != i || n_read != n_particles)
+        {
+            printf("Unexpected mapped particle data frame. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        /* Copy the values, since the reading below changes the frame set. */
+        iterated_positions = realloc(iterated_positions, sizeof(float) * n_particles * 3);
+        if(!iterated_positions)
+        {
+            printf("Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+            break;
+        }
+        memcpy(iterated_positions, values, sizeof(float) * n_particles * 3);
+        stat = tng_util_pos_read_range(traj, i, i, &read_positions, &stride_len);
+        if(stat != TNG_SUCCESS ||
+           memcmp(iterated_positions, read_positions, sizeof(float) * n_particles * 3) != 0)
+        {
+            printf("Unexpected mapped particle data value. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    if(read_positions)
+    {
+        free(read_positions);
+    }
+    if(iterated_positions)
+    {
+        free(iterated_positions);
+    }
+    tng_data_iterator_destroy(&iterator);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+/* Append frames to a trajectory, of which only the last frame set header and
+ * data block definitions are read when opening it, and check that both the
+ * earlier and the appended data can be read back. */
+/* Iterate over particle data of a frame set with a particle mapping to a
+ * particle number outside the frame set, which must fail instead of writing
+ * outside the frame buffer. */
+tng_function_status tng_test_data_iterator_bad_mapping(tng_trajectory_t traj,
+                                                       const char *file_name)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_data_iterator_t iterator = 0;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 10, i, mapping[10], frame_nr, n_read, n_values;
+    float positions[60];
+    const void *values;
+    char type;
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    stat = tng_file_headers_write(traj, TNG_USE_HASH);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_new(traj, 0, 2);
+    }
+    for(i = 0; i < n_particles; i++)
+    {
+        mapping[i] = n_particles - 1 - i;
+    }
+    mapping[3] = 1000;
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_particle_mapping_add(traj, 0, n_particles, mapping);
+    }
+    for(i = 0; i < 60; i++)
+    {
+        positions[i] = (float)i;
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_particle_data_block_add(traj, TNG_TRAJ_POSITIONS, "POSITIONS",
+                                           TNG_FLOAT_DATA, TNG_TRAJECTORY_BLOCK,
+                                           2, 3, 1, 0, n_particles,
+                                           TNG_UNCOMPRESSED, positions);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_write(traj, TNG_USE_HASH);
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot write mapped trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    stat = tng_data_iterator_init(traj, TNG_TRAJ_POSITIONS, 0, 1, TNG_USE_HASH,
+                                  &iterator);
+    if(stat == TNG_SUCCESS &&
+       tng_data_iterator_next(traj, iterator, &frame_nr, &values, &n_read,
+                              &n_values, &type) != TNG_CRITICAL)
+    {
+        printf("Particle mapping outside the frame set not detected. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    tng_data_iterator_destroy(&iterator);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+/* Check that a gzip compressed data series spanning several frame sets,
+ * whose blocks are uncompressed concurrently when using OpenMP, is read
+ * correctly using one or several threads, and that the statistics counted
+ * by the threads are added up and reset. */
+tng_function_status tng_test_data_series(tng_trajectory_t traj,
+                                         const char *file_name)
+{
+    tng_function_status stat = TNG_SUCCESS;
+    struct tng_statistics statistics;
+    int64_t n_frames = 60, box_stride = 3, i, j, k, frame_nr, n_read = 0, n_values;
+    int64_t *frame_nrs = 0;
+    float box_shape[9];
+    void *values = 0;
+    char type;
+#ifdef _OPENMP
+    int n_threads = omp_get_max_threads();
+#endif
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_util_generic_write_interval_set(traj, box_stride, 9, TNG_TRAJ_BOX_SHAPE,
+                                        "BOX SHAPE", TNG_NON_PARTICLE_BLOCK_DATA,
+                                        TNG_GZIP_COMPRESSION);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i += box_stride)
+    {
+        for(j = 0; j < 9; j++)
+        {
+            box_shape[j] = (float)(i * 10 + j);
+        }
+        stat = tng_util_box_shape_write(traj, i, box_shape);
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot write data series trajectory. %s: %d\n",
+               __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_statistics_enabled_set(traj, TNG_TRUE);
+
+    for(k = 0; k < 2 && stat == TNG_SUCCESS; k++)
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(k == 0 ? (n_threads > 1 ? n_threads : 4) : 1);
+#endif
+        tng_statistics_reset(traj);
+        tng_statistics_get(traj, &statistics);
+        if(statistics.bytes_read != 0 || statistics.gzip_uncompress_ticks != 0 ||
+           statistics.md5_ticks != 0)
+        {
+            printf("Statistics not reset. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        stat = tng_data_series_get(traj, TNG_TRAJ_BOX_SHAPE, 5, 55, TNG_USE_HASH,
+                                   &values, &frame_nrs, &n_read, &n_values, &type);
+        tng_statistics_get(traj, &statistics);
+        if(stat == TNG_SUCCESS && (statistics.bytes_read <= 0 ||
+           statistics.gzip_uncompress_ticks < 0))
+        {
+            printf("Unexpected data series statistics. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+        if(stat != TNG_SUCCESS || n_read != 17 || n_values != 9 ||
+           type != TNG_FLOAT_DATA)
+        {
+            printf("Unexpected data series. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+        for(i = 0; i < n_read && stat == TNG_SUCCESS; i++)
+        {
+            frame_nr = (i + 2) * box_stride;
+            if(frame_nrs[i] != frame_nr)
+            {
+                printf("Unexpected data series frame. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+            }
+            for(j = 0; j < 9 && stat == TNG_SUCCESS; j++)
+            {
+                if(((float *)values)[i * 9 + j] != (float)(frame_nr * 10 + j))
+                {
+                    printf("Unexpected data series value. %s: %d\n", __FILE__, __LINE__);
+                    stat = TNG_FAILURE;
+                }
+            }
+        }
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    if(values)
+    {
+        free(values);
+    }
+    if(frame_nrs)
+    {
+        free(frame_nrs);
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS)
+    {
+        return(TNG_FAILURE);
+    }
+
+    return(stat);
+}
+
+tng_function_status tng_test_append_tail(tng_trajectory_t traj,
+                                         const char *file_name)
+{
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles, n_frames, box_stride = 7, i, j, frame_nr;
+    int64_t n_read, n_values, stride_len;
+    float positions[30], box_shape[9], *read_positions = 0;
+    int64_t *series_frame_nrs = 0;
+    void *series_values = 0;
+    char type;
+
+    stat = tng_util_trajectory_open(file_name, 'a', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_num_particles_get(traj, &n_particles);
+    tng_num_frames_get(traj, &n_frames);
+    if(n_particles != 10 || n_frames != 50)
+    {
+        printf("Unexpected trajectory to append to. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    for(i = n_frames; i < n_frames + 10 && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(i * 100 + j) * 0.25f;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+        if(stat == TNG_SUCCESS && i % box_stride == 0)
+        {
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = (float)(i * 10 + j);
+            }
+            stat = tng_util_box_shape_write(traj, i, box_shape);
+        }
+    }
+    if(tng_util_trajectory_close(&traj) != TNG_SUCCESS || stat != TNG_SUCCESS)
+    {
+        printf("Cannot append to trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_num_frames_get(traj, &n_frames);
+    if(n_frames != 60)
+    {
+        printf("Unexpected number of frames after appending. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_data_series_get(traj, TNG_TRAJ_BOX_SHAPE, 0, n_frames - 1,
+                                   TNG_USE_HASH, &series_values, &series_frame_nrs,
+                                   &n_read, &n_values, &type);
+        if(stat != TNG_SUCCESS || n_read != (n_frames - 1) / box_stride + 1 ||
+           n_values != 9 || type != TNG_FLOAT_DATA)
+        {
+            printf("Unexpected data series. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    for(i = 0; i < n_read && stat == TNG_SUCCESS; i++)
+    {
+        frame_nr = i * box_stride;
+        for(j = 0; j < 9; j++)
+        {
+            if(series_frame_nrs[i] != frame_nr ||
+               ((float *)series_values)[i * 9 + j] != (float)(frame_nr * 10 + j))
+            {
+                printf("Unexpected data series value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_pos_read_range(traj, 50, 59, &read_positions, &stride_len);
+        if(stat != TNG_SUCCESS || stride_len != 1)
+        {
+            printf("Cannot read positions. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    for(i = 0; i < 10 && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(read_positions[i * n_particles * 3 + j] != (float)((i + 50) * 100 + j) * 0.25f)
+            {
+                printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+
+    free(series_values);
+    free(series_frame_nrs);
+    free(read_positions);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+/* Store positions and box shapes directly in the memory of the trajectory,
+ * and check that they are written like values passed to the write
+ * functions. */
+tng_function_status tng_test_frame_acquire(tng_trajectory_t traj,
+                                           const char *file_name)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 50, n_frames = 25, i, j, stride_len;
+    float *positions, *box_shape, *read_values = 0;
+
+    stat = tng_util_trajectory_open(file_name, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+
+    if(tng_util_pos_write_interval_set(traj, 1) != TNG_SUCCESS ||
+       tng_util_box_shape_write_interval_set(traj, 1) != TNG_SUCCESS)
+    {
+        printf("Cannot set writing interval. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_generic_frame_acquire(traj, i, 3, TNG_TRAJ_POSITIONS,
+                                              "POSITIONS", TNG_PARTICLE_BLOCK_DATA,
+                                              TNG_TNG_COMPRESSION, &positions);
+        if(stat == TNG_SUCCESS)
+        {
+            for(j = 0; j < n_particles * 3; j++)
+            {
+                positions[j] = (float)(j % 89) * 0.113f + i * 0.02f;
+            }
+            stat = tng_util_generic_frame_acquire(traj, i, 9, TNG_TRAJ_BOX_SHAPE,
+                                                  "BOX SHAPE", TNG_NON_PARTICLE_BLOCK_DATA,
+                                                  TNG_GZIP_COMPRESSION, &box_shape);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = j % 4 == 0 ? 5.0f + i : 0.0f;
+            }
+            stat = tng_util_frame_commit(traj, i);
+        }
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot store frame values. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(stat);
+    }
+
+    stat = tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    stat = tng_util_trajectory_open(file_name, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_pos_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read positions. %s: %d\n", __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(read_values[j] - ((float)(j % 89) * 0.113f + i * 0.02f)) >
+               1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_box_shape_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read box shape. %s: %d\n", __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < 9; j++)
+        {
+            if(read_values[j] != (j % 4 == 0 ? 5.0f + i : 0.0f))
+            {
+                printf("Unexpected box shape value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+
+    free(read_values);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+tng_function_status tng_test_segments(tng_trajectory_t traj,
+                                      const char *file_names[3])
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 20, n_frames = 25, i, j, k, stride_len, frame_nr;
+    int64_t n_series_frames, n_values, *frame_nrs = 0;
+    float *positions, *read_values = 0, box_shape[9];
+    void *values = 0;
+    double frame_time;
+    char data_type;
+
+    positions = malloc(sizeof(float) * n_particles * 3);
+
+    /* Each file continues the frames of the previous one, as if the
+     * simulation was restarted. */
+    for(k = 0; k < 3 && stat == TNG_SUCCESS; k++)
+    {
+        stat = tng_util_trajectory_open(file_names[k], 'w', &traj);
+        if(stat != TNG_SUCCESS)
+        {
+            break;
+        }
+
+        tng_molecule_add(traj, "water", &molecule);
+        tng_molecule_chain_add(traj, molecule, "W", &chain);
+        tng_chain_residue_add(traj, chain, "WAT", &residue);
+        tng_residue_atom_add(traj, residue, "O", "O", &atom);
+        tng_molecule_cnt_set(traj, molecule, n_particles);
+        tng_num_frames_per_frame_set_set(traj, 10);
+        tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+
+        stat = tng_frame_set_new(traj, k * n_frames, 10);
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_util_pos_write_interval_set(traj, 1);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_util_box_shape_write_interval_set(traj, 1);
+        }
+        for(i = k * n_frames; i < (k + 1) * n_frames && stat == TNG_SUCCESS; i++)
+        {
+            for(j = 0; j < n_particles * 3; j++)
+            {
+                positions[j] = (float)(j % 37) * 0.17f + i * 0.03f;
+            }
+            stat = tng_util_pos_write(traj, i, positions);
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = j % 4 == 0 ? 5.0f + i : 0.0f;
+            }
+            if(stat == TNG_SUCCESS)
+            {
+                stat = tng_util_box_shape_write(traj, i, box_shape);
+            }
+        }
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot write positions. %s: %d\n", __FILE__, __LINE__);
+            tng_util_trajectory_close(&traj);
+            break;
+        }
+        stat = tng_util_trajectory_close(&traj);
+    }
+    free(positions);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    /* Keep at most two of the three files open. */
+    stat = tng_util_trajectory_segments_open(file_names, 3, 2, &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        tng_util_trajectory_close(&traj);
+        return(stat);
+    }
+
+    tng_num_frames_get(traj, &frame_nr);
+    if(frame_nr != 3 * n_frames)
+    {
+        printf("Unexpected number of frames. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    /* Read the frames in both directions, switching between the files. */
+    for(k = 0; k < 2 * 3 * n_frames && stat == TNG_SUCCESS; k++)
+    {
+        i = k < 3 * n_frames ? k : 6 * n_frames - 1 - k;
+        stat = tng_util_pos_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read positions of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(read_values[j] - ((float)(j % 37) * 0.17f + i * 0.03f)) >
+               1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    free(read_values);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    /* Read all frames in order. */
+    stat = tng_util_trajectory_segments_open(file_names, 3, 1, &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        tng_util_trajectory_close(&traj);
+        return(stat);
+    }
+    for(i = 0; i < 3 * n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_particle_data_next_frame_read(traj, TNG_TRAJ_POSITIONS, &values,
+                                                      &data_type, &frame_nr, &frame_time);
+        if(stat != TNG_SUCCESS || frame_nr != i || data_type != TNG_FLOAT_DATA)
+        {
+            printf("Cannot read the next frame (%" PRId64 "). %s: %d\n", i, __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(((float *)values)[j] - ((float)(j % 37) * 0.17f + i * 0.03f)) >
+               1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    if(stat == TNG_SUCCESS &&
+       tng_util_particle_data_next_frame_read(traj, TNG_TRAJ_POSITIONS, &values,
+                                              &data_type, &frame_nr, &frame_time) == TNG_SUCCESS)
+    {
+        printf("Read a frame after the last frame. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    free(values);
+    values = 0;
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    /* Read the box shape as a time series, all of it and then a range
+     * spanning a file boundary. */
+    stat = tng_util_trajectory_segments_open(file_names, 3, 2, &traj);
+    for(k = 0; k < 2 && stat == TNG_SUCCESS; k++)
+    {
+        i = k == 0 ? 0 : n_frames - 10;
+        stat = tng_data_series_get(traj, TNG_TRAJ_BOX_SHAPE, i,
+                                   k == 0 ? 3 * n_frames - 1 : 2 * n_frames + 4,
+                                   TNG_USE_HASH, &values, &frame_nrs, &n_series_frames,
+                                   &n_values, &data_type);
+        if(stat != TNG_SUCCESS || n_values != 9 || data_type != TNG_FLOAT_DATA ||
+           n_series_frames != (k == 0 ? 3 * n_frames : n_frames + 15))
+        {
+            printf("Cannot read the box shape series. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(frame_nr = 0; frame_nr < n_series_frames && stat == TNG_SUCCESS; frame_nr++)
+        {
+            if(frame_nrs[frame_nr] != i + frame_nr)
+            {
+                printf("Unexpected frame number. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+            for(j = 0; j < 9; j++)
+            {
+                if(((float *)values)[frame_nr * 9 + j] !=
+                   (j % 4 == 0 ? 5.0f + i + frame_nr : 0.0f))
+                {
+                    printf("Unexpected box shape value. %s: %d\n", __FILE__, __LINE__);
+                    stat = TNG_FAILURE;
+                    break;
+                }
+            }
+        }
+    }
+    free(values);
+    free(frame_nrs);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+tng_function_status tng_test_frame_sets_copy(tng_trajectory_t traj,
+                                             const char *filename,
+                                             const char *out_filename,
+                                             const char *next_filename)
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_trajectory_t out = 0;
+    tng_trajectory_frame_set_t frame_set;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 20, n_frames = 40, i, j, src_frame, stride_len, frame_nr;
+    int64_t pos = -1, bad_id = -1;
+    float *positions, box_shape[9], *read_values = 0;
+    const char *segment_names[2];
+    FILE *file;
+
+    stat = tng_util_trajectory_open(filename, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+
+    /* The box shape is only stored every second frame, so its data blocks
+     * contain the number of their first frame, which must be changed when
+     * copying them. */
+    if(tng_util_pos_write_interval_set(traj, 1) != TNG_SUCCESS ||
+       tng_util_box_shape_write_interval_set(traj, 2) != TNG_SUCCESS)
+    {
+        printf("Cannot set write intervals. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    positions = malloc(sizeof(float) * n_particles * 3);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(j % 37) * 0.17f + i * 0.03f;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+        if(stat == TNG_SUCCESS && i % 2 == 0)
+        {
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = j % 4 == 0 ? 5.0f + i : 0.0f;
+            }
+            stat = tng_util_box_shape_write(traj, i, box_shape);
+        }
+    }
+    free(positions);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot write trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
+    }
+
+    /* Copy every second frame set from frame 12 (frames 10-19 and 30-39) and
+     * then append the first frame set (frames 0-9). */
+    stat = tng_util_trajectory_open(filename, 'r', &traj);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_open(out_filename, 'w', &out);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_molecule_system_copy(traj, out);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_frame_sets_copy(traj, out, 12, n_frames - 1, 2);
+    }
+    tng_util_trajectory_close(&out);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_open(out_filename, 'a', &out);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_frame_sets_copy(traj, out, 0, 5, 1);
+    }
+    tng_util_trajectory_close(&out);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot copy frame sets. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
+    }
+
+    stat = tng_util_trajectory_open(out_filename, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        tng_util_trajectory_close(&traj);
+        return(stat);
+    }
+
+    tng_num_frames_get(traj, &frame_nr);
+    if(frame_nr != 30)
+    {
+        printf("Unexpected number of frames. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    for(i = 0; i < 30 && stat == TNG_SUCCESS; i++)
+    {
+        src_frame = i < 10 ? i + 10 : (i < 20 ? i + 20 : i - 20);
+        stat = tng_util_pos_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read positions of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(read_values[j] - ((float)(j % 37) * 0.17f + src_frame * 0.03f)) >
+               1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    free(read_values);
+    read_values = 0;
+
+    for(i = 0; i < 30 && stat == TNG_SUCCESS; i += 2)
+    {
+        src_frame = i < 10 ? i + 10 : (i < 20 ? i + 20 : i - 20);
+        stat = tng_util_box_shape_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS || stride_len != 2)
+        {
+            printf("Cannot read box shape of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < 9; j++)
+        {
+            if(read_values[j] != (j % 4 == 0 ? 5.0f + src_frame : 0.0f))
+            {
+                printf("Unexpected box shape value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    free(read_values);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    /* Continue the source in another file (frames 40-59). */
+    stat = tng_util_trajectory_open(next_filename, 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+    stat = tng_frame_set_new(traj, n_frames, 10);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_pos_write_interval_set(traj, 1);
+    }
+    positions = malloc(sizeof(float) * n_particles * 3);
+    for(i = n_frames; i < n_frames + 20 && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (float)(j % 37) * 0.17f + i * 0.03f;
+        }
+        stat = tng_util_pos_write(traj, i, positions);
+    }
+    free(positions);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot write trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
+    }
+
+    /* Open both files as one trajectory, and then overwrite the block ID of
+     * the second frame set of the second file, which is only opened when
+     * its frames are needed. Copying must then fail, instead of stopping as
+     * if the trajectory ended. */
+    segment_names[0] = filename;
+    segment_names[1] = next_filename;
+    stat = tng_util_trajectory_segments_open(segment_names, 2, 1, &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot open trajectory segments. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(stat);
+    }
+    stat = tng_util_trajectory_open(next_filename, 'r', &out);
+    if(stat == TNG_SUCCESS)
+    {
+        tng_current_frame_set_get(out, &frame_set);
+        stat = tng_frame_set_nr_find(out, 0);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_frame_set_next_frame_set_file_pos_get(out, frame_set, &pos);
+    }
+    tng_util_trajectory_close(&out);
+    file = stat == TNG_SUCCESS && pos > 0 ? fopen(next_filename, "r+b") : 0;
+    if(!file || fseek(file, (long)pos + 2 * sizeof(int64_t), SEEK_SET) != 0 ||
+       fwrite(&bad_id, sizeof(bad_id), 1, file) != 1)
+    {
+        printf("Cannot modify trajectory. %s: %d\n", __FILE__, __LINE__);
+        if(file)
+        {
+            fclose(file);
+        }
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+    fclose(file);
+
+    stat = tng_util_trajectory_open(out_filename, 'w', &out);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_molecule_system_copy(traj, out);
+    }
+    if(stat == TNG_SUCCESS &&
+       tng_util_trajectory_frame_sets_copy(traj, out, 0, -1, 1) != TNG_CRITICAL)
+    {
+        printf("Copied frame sets past a broken frame set. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    tng_util_trajectory_close(&out);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+/* Check that two files are identical from the first occurrence of marker
+ * in the first file, e.g. to skip the creation time in the file header. */
+static tng_function_status tng_test_files_compare(const char *filenames[2],
+                                                  const char *marker)
+{
+    FILE *file;
+    char *contents[2] = {0, 0};
+    long lens[2] = {0, 0}, pos;
+    size_t marker_len = strlen(marker);
+    int k;
+    tng_function_status stat = TNG_SUCCESS;
+
+    for(k = 0; k < 2 && stat == TNG_SUCCESS; k++)
+    {
+        file = fopen(filenames[k], "rb");
+        if(!file)
+        {
+            stat = TNG_CRITICAL;
+            break;
+        }
+        fseek(file, 0, SEEK_END);
+        lens[k] = ftell(file);
+        rewind(file);
+        contents[k] = malloc(lens[k] > 0 ? lens[k] : 1);
+        if(!contents[k] || fread(contents[k], 1, lens[k], file) != (size_t)lens[k])
+        {
+            stat = TNG_CRITICAL;
+        }
+        fclose(file);
+    }
+
+    if(stat == TNG_SUCCESS)
+    {
+        for(pos = 0; pos + (long)marker_len <= lens[0]; pos++)
+        {
+            if(memcmp(contents[0] + pos, marker, marker_len) == 0)
+            {
+                break;
+            }
+        }
+        if(lens[0] != lens[1] || pos + (long)marker_len > lens[0] ||
+           memcmp(contents[0] + pos, contents[1] + pos, lens[0] - pos) != 0)
+        {
+            stat = TNG_FAILURE;
+        }
+    }
+
+    free(contents[0]);
+    free(contents[1]);
+
+    return(stat);
+}
+
+/* Check that the connectivity of a molecular system with several molecule
+ * types, which are processed concurrently when using OpenMP, lists every bond
+ * for both atoms, and that it is the same using one or several threads. */
+/* Look up the topology of particles in a molecular system with molecule
+ * types of different sizes, so that the particles of the later types do
+ * not start at a multiple of their number of atoms. */
+tng_function_status tng_test_particle_lookups(void)
+{
+    tng_trajectory_t traj;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t i, j, ids[19], id;
+    const char *names[19];
+    char str[TNG_MAX_STR_LEN];
+    /* Three molecule types of 3, 2 and 5 atoms with counts 1, 3 and 2. */
+    const char *mol_names[3] = {"TRI", "DI", "PENTA"};
+    const char *atom_names[10] = {"T0", "T1", "T2", "D0", "D1",
+                                  "P0", "P1", "P2", "P3", "P4"};
+    const int64_t n_atoms[3] = {3, 2, 5}, cnts[3] = {1, 3, 2};
+    const int64_t mol_ids[3] = {10, 20, 30};
+    const char *expected_names[19] = {"T0", "T1", "T2",
+                                      "D0", "D1", "D0", "D1", "D0", "D1",
+                                      "P0", "P1", "P2", "P3", "P4",
+                                      "P0", "P1", "P2", "P3", "P4"};
+    const int64_t expected_mol[19] = {0, 0, 0, 1, 1, 1, 1, 1, 1,
+                                      2, 2, 2, 2, 2, 2, 2, 2, 2, 2};
+    const int64_t expected_res[19] = {0, 0, 0, 1, 1, 2, 2, 3, 3,
+                                      4, 4, 4, 5, 5, 6, 6, 6, 7, 7};
+
+    if(tng_trajectory_init(&traj) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+    for(i = 0, j = 0; i < 3 && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_molecule_w_id_add(traj, mol_names[i], mol_ids[i], &molecule);
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_molecule_chain_add(traj, molecule, "A", &chain);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_chain_residue_add(traj, chain, "R1", &residue);
+        }
+        for(; j < 10 && atom_names[j][0] == mol_names[i][0] && stat == TNG_SUCCESS; j++)
+        {
+            /* The largest molecule type has its last two atoms in a second
+             * residue. */
+            if(n_atoms[i] == 5 && atom_names[j][1] == '3')
+            {
+                stat = tng_chain_residue_add(traj, chain, "R2", &residue);
+            }
+            if(stat == TNG_SUCCESS)
+            {
+                stat = tng_residue_atom_add(traj, residue, atom_names[j], "C", &atom);
+            }
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_molecule_cnt_set(traj, molecule, cnts[i]);
+        }
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot create molecular system. %s: %d\n", __FILE__, __LINE__);
+        tng_trajectory_destroy(&traj);
+        return(stat);
+    }
+
+    stat = tng_atom_names_of_particles_get(traj, 0, 19, names);
+    for(i = 0; i < 19 && stat == TNG_SUCCESS; i++)
+    {
+        tng_atom_name_of_particle_nr_get(traj, i, str, TNG_MAX_STR_LEN);
+        if(strcmp(names[i], expected_names[i]) != 0 || strcmp(str, expected_names[i]) != 0)
+        {
+            printf("Unexpected atom name of particle %"PRId64". %s: %d\n",
+                   i, __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_molecule_ids_of_particles_get(traj, 0, 19, ids);
+    }
+    for(i = 0; i < 19 && stat == TNG_SUCCESS; i++)
+    {
+        tng_molecule_id_of_particle_nr_get(traj, i, &id);
+        if(ids[i] != mol_ids[expected_mol[i]] || id != ids[i])
+        {
+            printf("Unexpected molecule id of particle %"PRId64". %s: %d\n",
+                   i, __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_global_residue_ids_of_particles_get(traj, 0, 19, ids);
+    }
+    for(i = 0; i < 19 && stat == TNG_SUCCESS; i++)
+    {
+        tng_global_residue_id_of_particle_nr_get(traj, i, &id);
+        if(ids[i] != expected_res[i] || id != ids[i])
+        {
+            printf("Unexpected global residue id of particle %"PRId64". %s: %d\n",
+                   i, __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    /* A range starting in the middle of a molecule of a later type. */
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_residue_names_of_particles_get(traj, 11, 3, names);
+        if(stat == TNG_SUCCESS && (strcmp(names[0], "R1") != 0 ||
+           strcmp(names[1], "R2") != 0 || strcmp(names[2], "R2") != 0))
+        {
+            printf("Unexpected residue names of particles. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+
+    tng_trajectory_destroy(&traj);
+
+    return(stat);
+}
+
+tng_function_status tng_test_connectivity_threads(void)
+{
+    tng_trajectory_t traj;
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_bond_t bond;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t i, j, k, n_particles, n_bonds, *bonds_from = 0, *bonds_to = 0;
+    int64_t *parallel_offsets = 0, *parallel_neighbors = 0, found, from, to;
+    const int64_t *offsets, *neighbors;
+#ifdef _OPENMP
+    int n_threads = omp_get_max_threads();
+#endif
+
+    if(tng_trajectory_init(&traj) != TNG_SUCCESS)
+    {
+        return(TNG_CRITICAL);
+    }
+    /* Molecule types with different numbers of atoms and bonds. Every
+     * second type is a ring. */
+    for(i = 0; i < 8 && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_molecule_add(traj, "MOL", &molecule);
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_molecule_chain_add(traj, molecule, "A", &chain);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_chain_residue_add(traj, chain, "RES", &residue);
+        }
+        for(j = 0; j < i + 2 && stat == TNG_SUCCESS; j++)
+        {
+            stat = tng_residue_atom_add(traj, residue, "C", "C", &atom);
+        }
+        for(j = 0; j < i + 1 && stat == TNG_SUCCESS; j++)
+        {
+            stat = tng_molecule_bond_add(traj, molecule, j, j + 1, &bond);
+        }
+        if(stat == TNG_SUCCESS && i % 2 == 1)
+        {
+            stat = tng_molecule_bond_add(traj, molecule, 0, i + 1, &bond);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_molecule_cnt_set(traj, molecule, 3 * i + 1);
+        }
+    }
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot set up molecular system. %s: %d\n", __FILE__, __LINE__);
+        tng_trajectory_destroy(&traj);
+        return(stat);
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads > 1 ? n_threads : 4);
+#endif
+    stat = tng_molsystem_connectivity_get(traj, &n_particles, &offsets, &neighbors);
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_molsystem_bonds_get(traj, &n_bonds, &bonds_from, &bonds_to);
+    }
+    if(stat != TNG_SUCCESS || offsets[n_particles] != 2 * n_bonds)
+    {
+        printf("Cannot get connectivity of molecule system. %s: %d\n",
+               __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    /* The neighbours of each particle are sorted. */
+    for(i = 0; i < n_particles && stat == TNG_SUCCESS; i++)
+    {
+        for(j = offsets[i] + 1; j < offsets[i + 1]; j++)
+        {
+            if(neighbors[j - 1] >= neighbors[j])
+            {
+                printf("Neighbours not sorted. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    /* Each bond is listed for both of its atoms. */
+    for(i = 0; i < n_bonds && stat == TNG_SUCCESS; i++)
+    {
+        found = 0;
+        for(k = 0; k < 2; k++)
+        {
+            from = k == 0 ? bonds_from[i] : bonds_to[i];
+            to = k == 0 ? bonds_to[i] : bonds_from[i];
+            for(j = offsets[from]; j < offsets[from + 1]; j++)
+            {
+                if(neighbors[j] == to)
+                {
+                    found++;
+                    break;
+                }
+            }
+        }
+        if(found != 2)
+        {
+            printf("Bond missing in connectivity. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    free(bonds_from);
+    free(bonds_to);
+
+    if(stat == TNG_SUCCESS)
+    {
+        parallel_offsets = malloc(sizeof(int64_t) * (n_particles + 1));
+        parallel_neighbors = malloc(sizeof(int64_t) * (2 * n_bonds));
+        if(!parallel_offsets || !parallel_neighbors)
+        {
+            printf("Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+        }
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        memcpy(parallel_offsets, offsets, sizeof(int64_t) * (n_particles + 1));
+        memcpy(parallel_neighbors, neighbors, sizeof(int64_t) * (2 * n_bonds));
+
+        /* Changing a molecule count rebuilds the connectivity. */
+        tng_molecule_of_index_get(traj, 0, &molecule);
+        tng_molecule_cnt_set(traj, molecule, 1);
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        stat = tng_molsystem_connectivity_get(traj, &n_particles, &offsets, &neighbors);
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#endif
+        if(stat != TNG_SUCCESS ||
+           memcmp(parallel_offsets, offsets, sizeof(int64_t) * (n_particles + 1)) != 0 ||
+           memcmp(parallel_neighbors, neighbors, sizeof(int64_t) * (2 * n_bonds)) != 0)
+        {
+            printf("Serial and parallel connectivity differ. %s: %d\n",
+                   __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+    }
+    free(parallel_offsets);
+    free(parallel_neighbors);
+
+    tng_trajectory_destroy(&traj);
+
+    return(stat);
+}
+
+/* Check that writing frame sets whose data blocks are encoded by several
+ * threads gives the same file as encoding them using a single thread. */
+tng_function_status tng_test_concurrent_encode(tng_trajectory_t traj,
+                                               const char *filenames[2])
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 200, n_frames = 30, i, j, k, stride_len;
+    float *values, *read_values = 0, box_shape[9];
+#ifdef _OPENMP
+    int n_threads = omp_get_max_threads();
+#endif
+
+    values = malloc(sizeof(float) * n_particles * 3);
+    if(!values)
+    {
+        printf("Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_CRITICAL);
+    }
+
+    for(k = 0; k < 2 && stat == TNG_SUCCESS; k++)
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(k == 0 ? (n_threads > 1 ? n_threads : 4) : 1);
+#endif
+        stat = tng_util_trajectory_open(filenames[k], 'w', &traj);
+        if(stat != TNG_SUCCESS)
+        {
+            break;
+        }
+        tng_molecule_add(traj, "water", &molecule);
+        tng_molecule_chain_add(traj, molecule, "W", &chain);
+        tng_chain_residue_add(traj, chain, "WAT", &residue);
+        tng_residue_atom_add(traj, residue, "O", "O", &atom);
+        tng_molecule_cnt_set(traj, molecule, n_particles);
+        tng_num_frames_per_frame_set_set(traj, 10);
+        tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+
+        /* TNG compressed positions and velocities, gzipped forces and box
+         * shape, so that each frame set has several blocks to encode. */
+        if(tng_util_pos_write_interval_set(traj, 1) != TNG_SUCCESS ||
+           tng_util_vel_write_interval_set(traj, 1) != TNG_SUCCESS ||
+           tng_util_force_write_interval_set(traj, 2) != TNG_SUCCESS ||
+           tng_util_box_shape_write_interval_set(traj, 5) != TNG_SUCCESS)
+        {
+            printf("Cannot set write intervals. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+        }
+        for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+        {
+            for(j = 0; j < n_particles * 3; j++)
+            {
+                values[j] = (j % 41) * 0.23f + i * 0.02f;
+            }
+            stat = tng_util_pos_write(traj, i, values);
+            if(stat == TNG_SUCCESS)
+            {
+                stat = tng_util_vel_write(traj, i, values);
+            }
+            if(stat == TNG_SUCCESS && i % 2 == 0)
+            {
+                stat = tng_util_force_write(traj, i, values);
+            }
+            if(stat == TNG_SUCCESS && i % 5 == 0)
+            {
+                for(j = 0; j < 9; j++)
+                {
+                    box_shape[j] = j % 4 == 0 ? 3.0f + i : 0.0f;
+                }
+                stat = tng_util_box_shape_write(traj, i, box_shape);
+            }
+        }
+        if(tng_util_trajectory_close(&traj) != TNG_SUCCESS && stat == TNG_SUCCESS)
+        {
+            stat = TNG_FAILURE;
+        }
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot write trajectory. %s: %d\n", __FILE__, __LINE__);
+        free(values);
+        return(stat);
+    }
+    if(tng_test_files_compare(filenames, "TRAJECTORY FRAME SET") != TNG_SUCCESS)
+    {
+        printf("Concurrent and serial encoding differ. %s: %d\n", __FILE__, __LINE__);
+        free(values);
+        return(TNG_FAILURE);
+    }
+
+    stat = tng_util_trajectory_open(filenames[0], 'r', &traj);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i += 2)
+    {
+        stat = tng_util_force_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS || stride_len != 2)
+        {
+            printf("Cannot read forces of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+            stat = TNG_FAILURE;
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(read_values[j] != (j % 41) * 0.23f + i * 0.02f)
+            {
+                printf("Unexpected force value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    free(read_values);
+    free(values);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+tng_function_status tng_test_transcode(tng_trajectory_t traj,
+                                       const char *filenames[4])
+{
+    tng_molecule_t molecule;
+    tng_chain_t chain;
+    tng_residue_t residue;
+    tng_atom_t atom;
+    tng_trajectory_t out = 0;
+    tng_function_status stat = TNG_SUCCESS;
+    int64_t n_particles = 50, n_frames = 80, i, j, k, stride_len, codec_id;
+    double *positions, box_shape[9], factor, precision;
+    float *read_values = 0;
+#ifdef _OPENMP
+    int n_threads = omp_get_max_threads();
+#endif
+
+    stat = tng_util_trajectory_open(filenames[0], 'w', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_particles);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    tng_compression_precision_set(traj, COMPRESSION_PRECISION);
+
+    if(tng_util_pos_write_interval_double_set(traj, 1) != TNG_SUCCESS ||
+       tng_util_box_shape_write_interval_double_set(traj, 2) != TNG_SUCCESS)
+    {
+        printf("Cannot set write intervals. %s: %d\n", __FILE__, __LINE__);
+        tng_util_trajectory_close(&traj);
+        return(TNG_FAILURE);
+    }
+
+    positions = malloc(sizeof(double) * n_particles * 3);
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            positions[j] = (j % 37) * 0.17 + i * 0.03;
+        }
+        stat = tng_util_pos_double_write(traj, i, positions);
+        if(stat == TNG_SUCCESS && i % 2 == 0)
+        {
+            for(j = 0; j < 9; j++)
+            {
+                box_shape[j] = j % 4 == 0 ? 5.0 + i : 0.0;
+            }
+            stat = tng_util_box_shape_double_write(traj, i, box_shape);
+        }
+    }
+    free(positions);
+    tng_util_trajectory_close(&traj);
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot write trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
+    }
+
+    /* First convert the TNG compressed doubles to gzipped floats, and then
+     * back to TNG compression with a coarser precision. The last conversion
+     * is done again using a single thread, which must give the same file. */
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads > 1 ? n_threads : 4);
+#endif
+    for(k = 0; k < 3 && stat == TNG_SUCCESS; k++)
+    {
+#ifdef _OPENMP
+        if(k == 2)
+        {
+            omp_set_num_threads(1);
+        }
+#endif
+        stat = tng_util_trajectory_open(filenames[k < 2 ? k : 1], 'r', &traj);
+        if(stat == TNG_SUCCESS)
+        {
+            stat = tng_util_trajectory_open(filenames[k + 1], 'w', &out);
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            if(k == 0)
+            {
+                stat = tng_util_trajectory_transcode(traj, out, TNG_GZIP_COMPRESSION,
+                                                     TNG_FLOAT_DATA);
+            }
+            else
+            {
+                tng_compression_precision_set(out, 100);
+                stat = tng_util_trajectory_transcode(traj, out, TNG_TNG_COMPRESSION, 0);
+            }
+        }
+        tng_util_trajectory_close(&out);
+        tng_util_trajectory_close(&traj);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot transcode trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
+    }
+    if(tng_test_files_compare(filenames + 2, "TRAJECTORY FRAME SET") != TNG_SUCCESS)
+    {
+        printf("Parallel and serial transcoding differ. %s: %d\n", __FILE__, __LINE__);
+        return(TNG_FAILURE);
+    }
+
+    for(k = 1; k < 3 && stat == TNG_SUCCESS; k++)
+    {
+        precision = k == 1 ? 1.0 / COMPRESSION_PRECISION : 1.0 / 100 + 1.0 / COMPRESSION_PRECISION;
+        stat = tng_util_trajectory_open(filenames[k], 'r', &traj);
+        for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+        {
+            stat = tng_util_pos_read_range(traj, i, i, &read_values, &stride_len);
+            if(stat != TNG_SUCCESS)
+            {
+                printf("Cannot read positions of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+                break;
+            }
+            for(j = 0; j < n_particles * 3; j++)
+            {
+                if(fabs(read_values[j] - ((j % 37) * 0.17 + i * 0.03)) > precision)
+                {
+                    printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                    stat = TNG_FAILURE;
+                    break;
+                }
+            }
+        }
+        if(stat == TNG_SUCCESS)
+        {
+            tng_util_frame_current_compression_get(traj, TNG_TRAJ_POSITIONS, &codec_id, &factor);
+            if(codec_id != (k == 1 ? TNG_GZIP_COMPRESSION : TNG_TNG_COMPRESSION))
+            {
+                printf("Unexpected codec of positions. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+            }
+        }
+        free(read_values);
+        read_values = 0;
+
+        for(i = 0; i < n_frames && stat == TNG_SUCCESS; i += 2)
+        {
+            stat = tng_util_box_shape_read_range(traj, i, i, &read_values, &stride_len);
+            if(stat != TNG_SUCCESS || stride_len != 2)
+            {
+                printf("Cannot read box shape of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+            for(j = 0; j < 9; j++)
+            {
+                if(read_values[j] != (j % 4 == 0 ? 5.0f + i : 0.0f))
+                {
+                    printf("Unexpected box shape value. %s: %d\n", __FILE__, __LINE__);
+                    stat = TNG_FAILURE;
+                    break;
+                }
+            }
+        }
+        free(read_values);
+        read_values = 0;
+        tng_util_trajectory_close(&traj);
+    }
+
+    return(stat);
+}
+
+/* Transcode a trajectory split into several files (as written by
+ * tng_test_segments()), which must give all frames of all the files. */
+tng_function_status tng_test_transcode_segments(tng_trajectory_t traj,
+                                                const char *segment_names[3],
+                                                const char *filename)
+{
+    tng_trajectory_t out = 0;
+    tng_function_status stat;
+    int64_t n_particles = 20, n_frames = 75, n_frame_sets, i, j, stride_len;
+    float *read_values = 0;
+#ifdef _OPENMP
+    int n_threads = omp_get_max_threads();
+
+    omp_set_num_threads(n_threads > 1 ? n_threads : 4);
+#endif
+    /* Keep only one of the files open at a time. */
+    stat = tng_util_trajectory_segments_open(segment_names, 3, 1, &traj);
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_open(filename, 'w', &out);
+    }
+    if(stat == TNG_SUCCESS)
+    {
+        stat = tng_util_trajectory_transcode(traj, out, TNG_GZIP_COMPRESSION, 0);
+    }
+    tng_util_trajectory_close(&out);
+    tng_util_trajectory_close(&traj);
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    if(stat != TNG_SUCCESS)
+    {
+        printf("Cannot transcode trajectory. %s: %d\n", __FILE__, __LINE__);
+        return(stat);
+    }
+
+    stat = tng_util_trajectory_open(filename, 'r', &traj);
+    if(stat != TNG_SUCCESS)
+    {
+        return(stat);
+    }
+    if(tng_num_frame_sets_get(traj, &n_frame_sets) != TNG_SUCCESS || n_frame_sets != 9 ||
+       tng_num_frames_get(traj, &i) != TNG_SUCCESS || i != n_frames)
+    {
+        printf("Unexpected number of frames. %s: %d\n", __FILE__, __LINE__);
+        stat = TNG_FAILURE;
+    }
+    for(i = 0; i < n_frames && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_util_pos_read_range(traj, i, i, &read_values, &stride_len);
+        if(stat != TNG_SUCCESS)
+        {
+            printf("Cannot read positions of frame %" PRId64 ". %s: %d\n", i, __FILE__, __LINE__);
+            break;
+        }
+        for(j = 0; j < n_particles * 3; j++)
+        {
+            if(fabs(read_values[j] - ((float)(j % 37) * 0.17f + i * 0.03f)) >
+               1.0 / COMPRESSION_PRECISION)
+            {
+                printf("Unexpected position value. %s: %d\n", __FILE__, __LINE__);
+                stat = TNG_FAILURE;
+                break;
+            }
+        }
+    }
+    free(read_values);
+    tng_util_trajectory_close(&traj);
+
+    return(stat);
+}
+
+int main()
+{
+    tng_trajectory_t traj = 0;
+    char time_str[TNG_MAX_DATE_STR_LEN];
+    char version_str[TNG_MAX_STR_LEN];
+    char hash_mode = TNG_USE_HASH;
+    const char *segment_file_names[3] = {TNG_EXAMPLE_FILES_DIR "tng_test_segment_1.tng",
+                                         TNG_EXAMPLE_FILES_DIR "tng_test_segment_2.tng",
+                                         TNG_EXAMPLE_FILES_DIR "tng_test_segment_3.tng"};
+    const char *concurrent_encode_file_names[2] = {TNG_EXAMPLE_FILES_DIR "tng_test_concurrent_encode.tng",
+                                                   TNG_EXAMPLE_FILES_DIR "tng_test_serial_encode.tng"};
+    const char *transcode_file_names[4] = {TNG_EXAMPLE_FILES_DIR "tng_test_transcode_src.tng",
+                                           TNG_EXAMPLE_FILES_DIR "tng_test_transcode_gzip.tng",
+                                           TNG_EXAMPLE_FILES_DIR "tng_test_transcode.tng",
+                                           TNG_EXAMPLE_FILES_DIR "tng_test_transcode_serial.tng"};
+
+    tng_version(traj, version_str, TNG_MAX_STR_LEN);
+    printf("Test version control:\t\t\t\t");
+    if(strncmp(TNG_VERSION, version_str, TNG_MAX_STR_LEN) == 0)
+    {
+        printf("Succeeded.\n");
+    }
+    else
+    {
+        printf("Failed.\n");
+    }
+
+    printf("Test Init trajectory:\t\t\t\t");
+    if(tng_trajectory_init(&traj) != TNG_SUCCESS)
+    {
+        tng_trajectory_destroy(&traj);
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+        exit(1);
+    }
+    printf("Succeeded.\n");
+
+    tng_time_get_str(traj, time_str);
+
+    printf("Creation time: %s\n", time_str);
+
+    tng_input_file_set(traj, TNG_EXAMPLE_FILES_DIR "tng_example.tng");
+    tng_output_file_set(traj, TNG_EXAMPLE_FILES_DIR "tng_example_out.tng");
+
+    printf("Test Read and write file:\t\t\t");
+    if(tng_test_read_and_write_file(traj, hash_mode) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Get data:\t\t\t\t\t");
+    if(tng_test_get_box_data(traj) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Destroy and init trajectory:\t\t");
+    if(tng_trajectory_destroy(&traj) != TNG_SUCCESS ||
+       tng_trajectory_init(&traj) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+
+    tng_output_file_set(traj, TNG_EXAMPLE_FILES_DIR "tng_test.tng");
+
+    printf("Test Write and read file:\t\t\t");
+    if(tng_test_write_and_read_traj(&traj, hash_mode) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Get particle data:\t\t\t\t");
+    if(tng_test_get_positions_data(traj, hash_mode) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d\n",
+               __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Destroy trajectory:\t\t\t");
+    if(tng_trajectory_destroy(&traj) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+        exit(1);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Utility functions:\t\t\t\t");
+    if(tng_test_utility_functions(traj, hash_mode) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+        exit(1);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Append:\t\t\t\t\t");
+    if(tng_test_append(traj, hash_mode) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Copy trajectory container:\t\t\t");
+    if(tng_test_copy_container(traj, hash_mode) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test XTC compression:\t\t\t\t");
+    if(tng_test_compressed_positions(traj, TNG_EXAMPLE_FILES_DIR "tng_test_xtc.tng",
+                                     TNG_XTC_COMPRESSION, 0) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test XTC compression of other data:\t\t");
+    if(tng_test_xtc_other_data(traj, TNG_EXAMPLE_FILES_DIR "tng_test_xtc_other.tng") != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Keyframe compression:\t\t\t");
+    if(tng_test_compressed_positions(traj, TNG_EXAMPLE_FILES_DIR "tng_test_keyframes.tng",
+                                     TNG_TNG_COMPRESSION, 4) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Single frame read:\t\t\t\t");
+    if(tng_test_single_frame_read(traj, TNG_EXAMPLE_FILES_DIR "tng_test_keyframes.tng")
+       != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Compression algorithm search threads:\t");
+    if(tng_test_compression_algo_threads() != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Stored compression algorithm:\t\t");
+    if(tng_test_stored_compression_algorithm(traj, TNG_EXAMPLE_FILES_DIR
+                                             "tng_test_keyframes.tng") != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Big endian file:\t\t\t\t");
+    if(tng_test_big_endian(traj, TNG_EXAMPLE_FILES_DIR "tng_test_big_endian.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Data iterator:\t\t\t\t");
+    if(tng_test_data_iterator(traj, TNG_EXAMPLE_FILES_DIR "tng_test_data_iterator.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Data iterator with bad mapping:\t\t");
+    if(tng_test_data_iterator_bad_mapping(traj, TNG_EXAMPLE_FILES_DIR "tng_test_bad_mapping.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Data series:\t\t\t\t");
+    if(tng_test_data_series(traj, TNG_EXAMPLE_FILES_DIR "tng_test_data_series.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Append to the last frame set:\t\t");
+    if(tng_test_append_tail(traj, TNG_EXAMPLE_FILES_DIR "tng_test_data_iterator.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Frame acquire and commit:\t\t\t");
+    if(tng_test_frame_acquire(traj, TNG_EXAMPLE_FILES_DIR "tng_test_frame_acquire.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Reading a trajectory split into files:\t");
+    if(tng_test_segments(traj, segment_file_names) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Copying frame sets without recompression:\t");
+    if(tng_test_frame_sets_copy(traj, TNG_EXAMPLE_FILES_DIR "tng_test_copy_src.tng",
+                                TNG_EXAMPLE_FILES_DIR "tng_test_copy.tng",
+                                TNG_EXAMPLE_FILES_DIR "tng_test_copy_src_next.tng") != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Particle lookups:\t\t\t\t");
+    if(tng_test_particle_lookups() != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Connectivity using threads:\t\t");
+    if(tng_test_connectivity_threads() != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Concurrent encoding of data blocks:\t");
+    if(tng_test_concurrent_encode(traj, concurrent_encode_file_names) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Transcoding a trajectory:\t\t\t");
+    if(tng_test_transcode(traj, transcode_file_names) != TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Transcoding a split trajectory:\t\t");
+    if(tng_test_transcode_segments(traj, segment_file_names,
+                                   TNG_EXAMPLE_FILES_DIR "tng_test_transcode_segments.tng") !=
+       TNG_SUCCESS)
+    {
+        printf("Failed. %s: %d.\n", __FILE__, __LINE__);
+    }
+    else
+    {
+        printf("Succeeded.\n");
+    }
+
+    printf("Test Collecting I/O statistics:\t\t\t");
+    if(tng_test_statistics(traj, TNG_EXAMPLE_FILES_DIR "tng_test_statistics.tng") !=
+       TNG_SUCCESS)
     {
         printf("Failed. %s: %d.\n", __FILE__, __LINE__);
     }
@@ -0,0 +1,122 @@
+/* This code is part of the tng binary trajectory format.
+ *
+ *  The high-level API of the TNG API is used where appropriate.
+ *
+ * Copyright (c) 2026, The GROMACS development team.
+ * Check out http://www.gromacs.org for more information.
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the Revised BSD License.
+ */
+
+#include "tng/tng_io.h"
+
+#ifdef USE_STD_INTTYPES_H
+#include <inttypes.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Transcode a trajectory to another codec and/or data type. The frame sets
+ * are decoded and encoded in parallel if the TNG library is built with
+ * OpenMP (TNG_BUILD_OPENMP). */
+
+int main(int argc, char **argv)
+{
+    tng_trajectory_t traj_in, traj_out;
+    int64_t codec_id = TNG_TNG_COMPRESSION;
+    double precision = 0.001;
+    char datatype = 0;
+
+    if(argc <= 2)
+    {
+        printf("No file specified\n");
+        printf("Usage:\n");
+        printf("tng_transcode <input_file> <output_file> "
+               "[codec (none, gzip, tng or xtc) = tng] [precision = %g] "
+               "[data type (float or double) = unchanged]\n", precision);
+        exit(1);
+    }
+
+    if(argc > 3)
+    {
+        if(strcmp(argv[3], "none") == 0)
+        {
+            codec_id = TNG_UNCOMPRESSED;
+        }
+        else if(strcmp(argv[3], "gzip") == 0)
+        {
+            codec_id = TNG_GZIP_COMPRESSION;
+        }
+        else if(strcmp(argv[3], "tng") == 0)
+        {
+            codec_id = TNG_TNG_COMPRESSION;
+        }
+        else if(strcmp(argv[3], "xtc") == 0)
+        {
+            codec_id = TNG_XTC_COMPRESSION;
+        }
+        else
+        {
+            printf("Unknown codec %s.\n", argv[3]);
+            exit(1);
+        }
+    }
+    if(argc > 4)
+    {
+        precision = strtod(argv[4], 0);
+        if(precision <= 0)
+        {
+            printf("The precision must be > 0.\n");
+            exit(1);
+        }
+    }
+    if(argc > 5)
+    {
+        if(strcmp(argv[5], "float") == 0)
+        {
+            datatype = TNG_FLOAT_DATA;
+        }
+        else if(strcmp(argv[5], "double") == 0)
+        {
+            datatype = TNG_DOUBLE_DATA;
+        }
+        else
+        {
+            printf("Unknown data type %s.\n", argv[5]);
+            exit(1);
+        }
+    }
+
+    if(tng_util_trajectory_open(argv[1], 'r', &traj_in) != TNG_SUCCESS)
+    {
+        printf("Cannot open file %s.\n", argv[1]);
+        tng_util_trajectory_close(&traj_in);
+        exit(1);
+    }
+    if(tng_util_trajectory_open(argv[2], 'w', &traj_out) != TNG_SUCCESS)
+    {
+        printf("Cannot open file %s.\n", argv[2]);
+        tng_util_trajectory_close(&traj_in);
+        tng_util_trajectory_close(&traj_out);
+        exit(1);
+    }
+
+    tng_compression_precision_set(traj_out, 1.0 / precision);
+
+    if(tng_util_trajectory_transcode(traj_in, traj_out, codec_id, datatype) != TNG_SUCCESS)
+    {
+        printf("Cannot transcode %s to %s.\n", argv[1], argv[2]);
+        tng_util_trajectory_close(&traj_in);
+        tng_util_trajectory_close(&traj_out);
+        exit(1);
+    }
+
+    tng_util_trajectory_close(&traj_in);
+    tng_util_trajectory_close(&traj_out);
+
+    return(0);
+}